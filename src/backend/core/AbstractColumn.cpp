@@ -277,6 +277,20 @@ void AbstractColumn::setMasked(int row, bool mask) {
 	setMasked(Interval<int>(row,row), mask);
 }
 
+/**
+ * \brief Set several intervals masked with one undo command
+ *
+ * \param intervals the intervals
+ * \param mask true: mask, false: unmask
+ */
+void AbstractColumn::setMasked(const QList< Interval<int> >& intervals, bool mask) {
+	if (intervals.isEmpty())
+		return;
+
+	exec(new AbstractColumnSetMaskedCmd(m_abstract_column_private, intervals, mask),
+			"maskingAboutToChange", "maskingChanged", Q_ARG(const AbstractColumn*,this));
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //@}
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -93,6 +93,7 @@ class AbstractColumn : public AbstractAspect
 		void clearMasks();
 		void setMasked(Interval<int> i, bool mask = true);
 		void setMasked(int row, bool mask = true);
+		void setMasked(const QList< Interval<int> >& intervals, bool mask = true);
 
 		virtual QString formula(int row) const;
 		virtual QList< Interval<int> > formulaIntervals() const;
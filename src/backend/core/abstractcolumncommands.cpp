@@ -101,8 +101,8 @@ void AbstractColumnClearMasksCmd::undo()
  */
 
 /**
- * \var AbstractColumnSetMaskedCmd::m_interval
- * \brief The interval
+ * \var AbstractColumnSetMaskedCmd::m_intervals
+ * \brief The intervals
  */
 
 /**
@@ -124,7 +124,21 @@ void AbstractColumnClearMasksCmd::undo()
  * \brief Ctor
  */
 AbstractColumnSetMaskedCmd::AbstractColumnSetMaskedCmd(AbstractColumnPrivate * col, Interval<int> interval, bool masked, QUndoCommand * parent )
-: QUndoCommand( parent ), m_col(col), m_interval(interval), m_masked(masked)
+: QUndoCommand( parent ), m_col(col), m_masked(masked)
+{
+	m_intervals << interval;
+	if(masked)
+		setText(i18n("%1: mask cells", col->name()));
+	else
+		setText(i18n("%1: unmask cells", col->name()));
+	m_copied = false;
+}
+
+/**
+ * \brief Ctor for several intervals, e.g. all rows selected by a condition
+ */
+AbstractColumnSetMaskedCmd::AbstractColumnSetMaskedCmd(AbstractColumnPrivate * col, const QList< Interval<int> >& intervals, bool masked, QUndoCommand * parent )
+: QUndoCommand( parent ), m_col(col), m_intervals(intervals), m_masked(masked)
 {
 	if(masked)
 		setText(i18n("%1: mask cells", col->name()));
@@ -150,7 +164,8 @@ void AbstractColumnSetMaskedCmd::redo()
 		m_masking = m_col->m_masking;
 		m_copied = true;
 	}
-	m_col->m_masking.setValue(m_interval, m_masked);
+	foreach(const Interval<int>& interval, m_intervals)
+		m_col->m_masking.setValue(interval, m_masked);
 	emit m_col->owner()->dataChanged(m_col->owner());
 }
 
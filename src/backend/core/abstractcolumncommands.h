@@ -52,6 +52,7 @@ class AbstractColumnSetMaskedCmd : public QUndoCommand
 {
 public:
 	explicit AbstractColumnSetMaskedCmd(AbstractColumnPrivate * col, Interval<int> interval, bool masked, QUndoCommand * parent = 0 );
+	AbstractColumnSetMaskedCmd(AbstractColumnPrivate * col, const QList< Interval<int> >& intervals, bool masked, QUndoCommand * parent = 0 );
 	~AbstractColumnSetMaskedCmd();
 
 	virtual void redo();
@@ -59,7 +60,7 @@ public:
 
 private:
 	AbstractColumnPrivate * m_col;
-	Interval<int> m_interval;
+	QList< Interval<int> > m_intervals;
 	bool m_masked;
 	IntervalAttribute<bool> m_masking;
 	bool m_copied;
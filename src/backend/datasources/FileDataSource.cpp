@@ -27,16 +27,20 @@ Copyright	: (C) 2009-2015 Alexander Semke (alexander.semke@web.de)
 ***************************************************************************/
 
 #include "backend/datasources/FileDataSource.h"
+#include "backend/datasources/ImportCache.h"
+#include "backend/datasources/ImportJob.h"
 #include "backend/datasources/filters/AsciiFilter.h"
 #include "commonfrontend/spreadsheet/SpreadsheetView.h"
 #include "backend/core/Project.h"
 
 #include <QFileInfo>
 #include <QDateTime>
+#include <QTime>
 #include <QProcess>
 #include <QDir>
 #include <QMenu>
 #include <QFileSystemWatcher>
+#include <QTimer>
 
 #include <KIcon>
 #include <KAction>
@@ -50,11 +54,25 @@ Copyright	: (C) 2009-2015 Alexander Semke (alexander.semke@web.de)
 */
 
 FileDataSource::FileDataSource(AbstractScriptingEngine* engine, const QString& name, bool loading)
-     : Spreadsheet(engine, name, loading),m_fileType(Ascii),m_fileWatched(false),m_fileLinked(false),m_filter(0),m_fileSystemWatcher(0) {
+     : Spreadsheet(engine, name, loading),m_fileType(Ascii),m_fileWatched(false),m_fileLinked(false),m_filter(0),m_fileSystemWatcher(0),
+	m_refreshTimer(new QTimer(this)),m_refreshThread(0),m_staging(0),m_refreshRunning(false),m_refreshPending(false),
+	m_refreshAppends(false),m_refreshRows(-1) {
 	initActions();
+
+	//changes of the watched file often come in bursts (the writing application flushes several times),
+	//collect them and refresh only once the file was quiet for a short period
+	m_refreshTimer->setSingleShot(true);
+	m_refreshTimer->setInterval(250);
+	connect(m_refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
 }
 
 FileDataSource::~FileDataSource(){
+	//the filter is still in use in the worker thread, wait until the file is read
+	if (m_refreshThread) {
+		m_refreshThread->wait();
+		delete m_staging;
+	}
+
 	if (m_filter)
 		delete m_filter;
 
@@ -197,12 +215,158 @@ void FileDataSource::read(){
 	if (m_filter==0)
 		return;
 
-	m_filter->read(m_fileName, this);
+	//the filter is busy with a refresh, read again once the refresh is published
+	if (m_refreshRunning) {
+		m_refreshPending = true;
+		return;
+	}
+
+	//unchanged files imported before with the same settings are read from the import cache
+	AsciiFilter* asciiFilter = dynamic_cast<AsciiFilter*>(m_filter);
+	if (asciiFilter)
+		asciiFilter->setStartOffset(0);
+	m_refreshRows = -1;
+	if (!ImportCache::read(m_fileName, m_filter, this, AbstractFileFilter::Replace)) {
+		m_filter->read(m_fileName, this);
+		ImportCache::write(m_fileName, m_filter, this);
+		//a refresh continues behind the rows read now
+		m_refreshRows = rowCount();
+	}
 	watch();
 }
 
+/*!
+  called on changes of the watched file. The refresh is delayed until no further changes
+  are notified for the interval of \c m_refreshTimer. Notifications arriving while the previous
+  refresh is still being read are coalesced into one pending refresh.
+*/
 void FileDataSource::fileChanged() {
-	this->read();
+	if (m_refreshRunning) {
+		m_refreshPending = true;
+		return;
+	}
+
+	m_refreshTimer->start();
+}
+
+/*!
+  reads the watched file in a worker thread into a temporary spreadsheet.
+  The temporary spreadsheet is created here and moved to the worker thread, see ImportThread.
+  The data is published to the columns of the data source in publishRefresh().
+  For append-only ASCII files only the lines appended since the last read are read.
+*/
+void FileDataSource::refresh() {
+	if (m_fileName.isEmpty() || m_filter==0)
+		return;
+
+	if (m_refreshRunning) {
+		m_refreshPending = true;
+		return;
+	}
+
+	m_refreshRunning = true;
+	m_refreshPending = false;
+
+	//the file is continued behind the last line read if it only grew and the data source wasn't modified in the meantime
+	AsciiFilter* asciiFilter = dynamic_cast<AsciiFilter*>(m_filter);
+	m_refreshAppends = false;
+	if (asciiFilter) {
+		const qint64 offset = asciiFilter->endOffset();
+		m_refreshAppends = (offset > 0 && asciiFilter->endRow() == -1 && m_filter->samplingMode() == AbstractFileFilter::NoSampling
+			&& m_refreshRows == rowCount() && QFileInfo(m_fileName).size() >= offset);
+		asciiFilter->setStartOffset(m_refreshAppends ? offset : 0);
+	}
+
+	m_staging = new Spreadsheet(0, "staging", true);
+	m_staging->setUndoAware(false);
+	//the watched file changes all the time, its refreshes are not cached
+	m_refreshThread = new ImportThread(m_filter, m_fileName, QString(), m_staging, this);
+	m_staging->moveToThread(m_refreshThread);
+	connect(m_refreshThread, SIGNAL(finished()), this, SLOT(publishRefresh()));
+
+	//the progress of a refresh is not shown, the filter doesn't notify from the worker thread
+	m_filter->blockSignals(true);
+	m_refreshThread->start();
+}
+
+/*!
+  copies the data read in the worker thread to the columns of the data source, or appends it to them.
+  The columns notify about the changed data only after all of them were updated,
+  so the dependent curves are redrawn once per refresh and not once per column.
+  The refresh is considered running until the curves are retransformed, file changes notified
+  in the meantime are handled afterwards and not before the time needed for the retransform has passed.
+*/
+void FileDataSource::publishRefresh() {
+	m_refreshThread->wait();
+	delete m_refreshThread;
+	m_refreshThread = 0;
+	m_filter->blockSignals(false);
+
+	Spreadsheet* staging = m_staging;
+	m_staging = 0;
+
+	QTime timer;
+	timer.start();
+	if (staging) {
+		const QList<Column*> sourceColumns = staging->children<Column>();
+		//the file was not only appended to if the filter couldn't continue it, it is read completely again
+		const bool changed = m_refreshAppends && static_cast<AsciiFilter*>(m_filter)->endOffset() == -1;
+		if (changed) {
+			m_refreshPending = true;
+		} else if (m_refreshAppends) {
+			const int rows = sourceColumns.isEmpty() ? 0 : sourceColumns.first()->rowCount();
+			if (rows > 0) {
+				setUndoAware(false);
+				for (int i = 0; i < sourceColumns.size() && i < columnCount(); ++i) {
+					Column* column = child<Column>(i);
+					column->setUndoAware(false);
+					column->setSuppressDataChangedSignal(true);
+					column->replaceValues(m_refreshRows, *static_cast<QVector<double>*>(sourceColumns.at(i)->data()));
+					column->setComment(i18np("numerical data, %1 element", "numerical data, %1 elements", m_refreshRows + rows));
+					column->setUndoAware(true);
+					column->setSuppressDataChangedSignal(false);
+				}
+
+				for (int i = 0; i < sourceColumns.size() && i < columnCount(); ++i)
+					child<Column>(i)->setChanged();
+				setUndoAware(true);
+			}
+		} else {
+			QStringList names;
+			foreach (const Column* column, sourceColumns)
+				names << column->name();
+
+			setUndoAware(false);
+			resize(AbstractFileFilter::Replace, names, sourceColumns.size());
+
+			for (int i = 0; i < sourceColumns.size(); ++i) {
+				Column* column = child<Column>(i);
+				column->setUndoAware(false);
+				column->setSuppressDataChangedSignal(true);
+				column->copy(sourceColumns.at(i));
+				column->setComment(sourceColumns.at(i)->comment());
+				column->setUndoAware(true);
+				column->setSuppressDataChangedSignal(false);
+			}
+
+			for (int i = 0; i < sourceColumns.size(); ++i)
+				child<Column>(i)->setChanged();
+			setUndoAware(true);
+		}
+
+		m_refreshRows = changed ? -1 : rowCount();
+		delete staging;
+	}
+
+	watch();
+	m_refreshRunning = false;
+	m_refreshTimer->setInterval(qMax(250, timer.elapsed()));
+
+	//the file was changed again during the refresh
+	if (m_refreshPending) {
+		m_refreshPending = false;
+		m_refreshTimer->start();
+	}
 }
 
 void FileDataSource::watchToggled() {
@@ -35,6 +35,8 @@
 class AbstractFileFilter;
 class QFileSystemWatcher;
 class QAction;
+class QTimer;
+class ImportThread;
 
 class FileDataSource : public Spreadsheet {
 	Q_OBJECT
@@ -81,6 +83,15 @@ class FileDataSource : public Spreadsheet {
 		AbstractFileFilter* m_filter;
 		QFileSystemWatcher* m_fileSystemWatcher;
 
+		//refresh of the watched file
+		QTimer* m_refreshTimer;
+		ImportThread* m_refreshThread;
+		Spreadsheet* m_staging;
+		bool m_refreshRunning;
+		bool m_refreshPending;
+		bool m_refreshAppends;	//the running refresh reads the lines appended to the file only
+		int m_refreshRows;	//rows read from the file so far, -1 if the next refresh has to read the whole file
+
 		QAction* m_reloadAction;
 		QAction* m_toggleLinkAction;
 		QAction* m_toggleWatchAction;
@@ -92,6 +103,8 @@ class FileDataSource : public Spreadsheet {
 
 	private slots:
 		void fileChanged();
+		void refresh();
+		void publishRefresh();
 		void watchToggled();
 		void linkToggled();
 
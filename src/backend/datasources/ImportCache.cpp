@@ -0,0 +1,256 @@
+/***************************************************************************
+File                 : ImportCache.cpp
+Project              : LabPlot
+Description          : Cache of imported data files
+--------------------------------------------------------------------
+Copyright            : (C) 2017 by the LabPlot developers
+***************************************************************************/
+
+/***************************************************************************
+*                                                                         *
+*  This program is free software; you can redistribute it and/or modify   *
+*  it under the terms of the GNU General Public License as published by   *
+*  the Free Software Foundation; either version 2 of the License, or      *
+*  (at your option) any later version.                                    *
+*                                                                         *
+*  This program is distributed in the hope that it will be useful,        *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+*  GNU General Public License for more details.                           *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program; if not, write to the Free Software           *
+*   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+*   Boston, MA  02110-1301  USA                                           *
+*                                                                         *
+***************************************************************************/
+#include "ImportCache.h"
+#include "backend/spreadsheet/Spreadsheet.h"
+#include "backend/core/column/Column.h"
+#include "backend/datasources/filters/AsciiFilter.h"
+#include "backend/datasources/filters/BinaryFilter.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QXmlStreamWriter>
+#include <KGlobal>
+#include <KLocale>
+#include <KStandardDirs>
+
+#include <cmath>
+#include <cstring>
+
+/*!
+\class ImportCache
+\brief Cache of the columns imported from data files.
+
+The numeric columns of a spreadsheet imported from a file with the ASCII or the binary filter are
+stored in a binary columnar format in the cache directory. The settings of these filters contain
+the complete selection of the imported data, the other filters select datasets or variables not
+contained in their settings and are not cached. The cache file is identified by the path of the data file and
+the settings of the filter, the size and the modification time of the data file are checked
+when the cache is read. Reading an unchanged file again only copies the columns from the
+memory mapped cache file instead of parsing the data file.
+
+The cache files of a data file imported with other settings before are removed when a new cache file is
+written, the oldest files are removed if the cache directory is larger than 1 GiB.
+
+The cache file contains a header, the column names separated by '\0' and padded to 8 bytes
+and the values of the columns one after another as native doubles.
+
+\ingroup datasources
+*/
+
+/*!
+  reads the data of the file \c fileName imported with the filter \c filter from the cache to \c dataSource.
+  Returns \c false if the cache doesn't contain the data or if it is outdated.
+*/
+bool ImportCache::read(const QString& fileName, const AbstractFileFilter* filter, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode mode) {
+	Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
+	if (!spreadsheet || !isCached(filter))
+		return false;
+
+	const QFileInfo fileInfo(fileName);
+	if (fileInfo.size() < minimumFileSize)
+		return false;
+
+	QFile file(cacheFileName(fileName, filter));
+	if (!file.open(QIODevice::ReadOnly) || file.size() < (qint64)sizeof(Header))
+		return false;
+
+	const uchar* data = file.map(0, file.size());
+	if (!data)
+		return false;
+
+	Header header;
+	memcpy(&header, data, sizeof(Header));
+	const qint64 namesSize = (header.namesSize + 7) & ~7;
+	if (memcmp(header.magic, "LPIC", 4) || header.version != version
+		|| header.fileSize != fileInfo.size() || header.modified != fileInfo.lastModified().toMSecsSinceEpoch()
+		|| header.columns <= 0 || header.rows < 0
+		|| file.size() != (qint64)sizeof(Header) + namesSize + header.rows*header.columns*(qint64)sizeof(double)) {
+		file.unmap(const_cast<uchar*>(data));
+		return false;
+	}
+
+	const char* names = reinterpret_cast<const char*>(data) + sizeof(Header);
+	QStringList columnNames;
+	for (const char* name = names; name < names + header.namesSize; name += strlen(name) + 1)
+		columnNames << QString::fromUtf8(name);
+
+	QVector<QVector<double>*> dataPointers;
+	const int rows = header.rows;
+	const int cols = header.columns;
+	const int columnOffset = dataSource->create(dataPointers, mode, rows, cols, columnNames);
+	const char* values = names + namesSize;
+	for (int n = 0; n < cols; ++n)
+		memcpy(dataPointers[n]->data(), values + n*rows*sizeof(double), rows*sizeof(double));
+	file.unmap(const_cast<uchar*>(data));
+
+	const QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", rows);
+	for (int n = 0; n < cols; ++n) {
+		Column* column = spreadsheet->column(columnOffset+n);
+		column->setComment(comment);
+		column->setUndoAware(true);
+		if (mode == AbstractFileFilter::Replace) {
+			column->setSuppressDataChangedSignal(false);
+			column->setChanged();
+		}
+	}
+	spreadsheet->setUndoAware(true);
+
+	return true;
+}
+
+/*!
+  stores the columns of \c dataSource imported from the file \c fileName with the filter \c filter in the cache.
+  Only spreadsheets with numeric columns imported from files larger than 1 MiB are stored.
+*/
+void ImportCache::write(const QString& fileName, const AbstractFileFilter* filter, AbstractDataSource* dataSource) {
+	write(fileName, cacheFileName(fileName, filter), dataSource);
+}
+
+/*!
+  stores the columns of \c dataSource imported from the file \c fileName in the cache file \c cacheName
+  determined with cacheFileName() before. Doesn't use the filter and the cache directory,
+  can be called in the thread owning \c dataSource.
+*/
+void ImportCache::write(const QString& fileName, const QString& cacheName, AbstractDataSource* dataSource) {
+	Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
+	if (!spreadsheet || cacheName.isEmpty())
+		return;
+
+	const QFileInfo fileInfo(fileName);
+	if (fileInfo.size() < minimumFileSize)
+		return;
+
+	QVector<const QVector<double>*> columns;
+	QStringList names;
+	const int rows = AbstractFileFilter::numericColumns(dataSource, columns, names);
+	if (columns.isEmpty() || columns.size() != spreadsheet->columnCount())
+		return;
+
+	QByteArray namesData;
+	foreach (const QString& name, names) {
+		namesData.append(name.toUtf8());
+		namesData.append('\0');
+	}
+
+	Header header;
+	memcpy(header.magic, "LPIC", 4);
+	header.version = version;
+	header.fileSize = fileInfo.size();
+	header.modified = fileInfo.lastModified().toMSecsSinceEpoch();
+	header.rows = rows;
+	header.columns = columns.size();
+	header.namesSize = namesData.size();
+	namesData.append(QByteArray(((namesData.size() + 7) & ~7) - namesData.size(), '\0'));
+
+	// the cache is written to a temporary file first, an interrupted write never leaves an incomplete cache file
+	QFile file(cacheName + ".tmp");
+	if (!file.open(QIODevice::WriteOnly))
+		return;
+
+	bool ok = (file.write(reinterpret_cast<const char*>(&header), sizeof(Header)) == sizeof(Header));
+	ok = ok && (file.write(namesData) == namesData.size());
+	for (int n = 0; ok && n < columns.size(); ++n) {
+		const QVector<double>* column = columns.at(n);
+		const int size = qMin(column->size(), rows);
+		const qint64 bytes = size*sizeof(double);
+		ok = (file.write(reinterpret_cast<const char*>(column->constData()), bytes) == bytes);
+
+		// columns with less values are padded with NAN
+		if (ok && size < rows) {
+			const QVector<double> missing(rows - size, NAN);
+			const qint64 missingBytes = missing.size()*sizeof(double);
+			ok = (file.write(reinterpret_cast<const char*>(missing.constData()), missingBytes) == missingBytes);
+		}
+	}
+	file.close();
+
+	QFile::remove(cacheName);
+	if (!ok || !file.rename(cacheName)) {
+		file.remove();
+		return;
+	}
+
+	removeOutdated(cacheName);
+}
+
+/*!
+  removes the cache files of the same data file as \c cacheName and the oldest files
+  if the cache directory is larger than \c maximumCacheSize. \c cacheName itself is kept.
+*/
+void ImportCache::removeOutdated(const QString& cacheName) {
+	const QFileInfo cacheInfo(cacheName);
+	const QString prefix = cacheInfo.fileName().section('-', 0, 0) + '-';
+
+	// the newest files first, the temporary files of the caches being written are skipped
+	qint64 size = 0;
+	const QFileInfoList files = cacheInfo.dir().entryInfoList(QDir::Files, QDir::Time);
+	foreach (const QFileInfo& info, files) {
+		if (info.fileName() == cacheInfo.fileName() || info.suffix() == "tmp") {
+			size += info.size();
+			continue;
+		}
+
+		if (info.fileName().startsWith(prefix) || size + info.size() > maximumCacheSize)
+			QFile::remove(info.absoluteFilePath());
+		else
+			size += info.size();
+	}
+}
+
+/*!
+  returns \c true if the data imported with \c filter is cached. The settings of the filter identify the
+  imported data only for the ASCII and the binary filter, the dataset or variable selected in the other
+  filters is not part of their settings.
+*/
+bool ImportCache::isCached(const AbstractFileFilter* filter) {
+	return dynamic_cast<const AsciiFilter*>(filter) || dynamic_cast<const BinaryFilter*>(filter);
+}
+
+/*!
+  returns the name of the cache file for the data file \c fileName imported with the filter \c filter,
+  an empty string if the data imported with \c filter is not cached.
+  The name consists of the hash of the absolute path of the file and the hash of the type of the filter and its settings.
+*/
+QString ImportCache::cacheFileName(const QString& fileName, const AbstractFileFilter* filter) {
+	if (!isCached(filter))
+		return QString();
+
+	QByteArray settings;
+	QXmlStreamWriter writer(&settings);
+	filter->save(&writer);
+
+	const QByteArray path = QFileInfo(fileName).absoluteFilePath().toUtf8();
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(filter->metaObject()->className());
+	hash.addData(settings);
+
+	return KGlobal::dirs()->saveLocation("cache", "labplot/import/")
+		+ QCryptographicHash::hash(path, QCryptographicHash::Sha1).toHex() + '-' + hash.result().toHex();
+}
@@ -0,0 +1,61 @@
+/***************************************************************************
+    File                 : ImportCache.h
+    Project              : LabPlot
+    Description          : Cache of imported data files
+    --------------------------------------------------------------------
+    Copyright            : (C) 2017 by the LabPlot developers
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef IMPORTCACHE_H
+#define IMPORTCACHE_H
+
+#include "backend/datasources/filters/AbstractFileFilter.h"
+
+class AbstractDataSource;
+
+class ImportCache {
+	public:
+		static bool read(const QString& fileName, const AbstractFileFilter*, AbstractDataSource*, AbstractFileFilter::ImportMode);
+		static void write(const QString& fileName, const AbstractFileFilter*, AbstractDataSource*);
+		static void write(const QString& fileName, const QString& cacheName, AbstractDataSource*);
+		static QString cacheFileName(const QString& fileName, const AbstractFileFilter*);
+
+	private:
+		static bool isCached(const AbstractFileFilter*);
+		static void removeOutdated(const QString& cacheName);
+
+		struct Header {
+			char magic[4];
+			quint32 version;
+			qint64 fileSize;
+			qint64 modified;
+			qint64 rows;
+			qint32 columns;
+			qint32 namesSize;
+		};
+
+		static const quint32 version = 1;
+		static const qint64 minimumFileSize = 1024*1024;
+		static const qint64 maximumCacheSize = Q_INT64_C(1024)*1024*1024;
+};
+
+#endif
@@ -0,0 +1,221 @@
+/***************************************************************************
+File                 : ImportJob.cpp
+Project              : LabPlot
+Description          : Background import of a data file
+--------------------------------------------------------------------
+Copyright            : (C) 2017 by the LabPlot developers
+***************************************************************************/
+
+/***************************************************************************
+*                                                                         *
+*  This program is free software; you can redistribute it and/or modify   *
+*  it under the terms of the GNU General Public License as published by   *
+*  the Free Software Foundation; either version 2 of the License, or      *
+*  (at your option) any later version.                                    *
+*                                                                         *
+*  This program is distributed in the hope that it will be useful,        *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+*  GNU General Public License for more details.                           *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program; if not, write to the Free Software           *
+*   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+*   Boston, MA  02110-1301  USA                                           *
+*                                                                         *
+***************************************************************************/
+#include "ImportJob.h"
+#include "backend/datasources/ImportCache.h"
+#include "backend/datasources/filters/AbstractFileFilter.h"
+#include "backend/spreadsheet/Spreadsheet.h"
+#include "backend/core/column/Column.h"
+
+#include <QCoreApplication>
+#include <KLocale>
+
+#include <cmath>
+#include <cstring>
+
+/*!
+\class ImportJob
+\brief Imports a data file into a spreadsheet in a worker thread.
+
+The columns read replace the columns of the target or are appended or prepended to them, see AbstractFileFilter::ImportMode.
+
+The file is read with the filter into a staging spreadsheet that is not part of any project.
+The staging spreadsheet is created in the GUI thread, moved to the worker thread of the job for the import
+and moved back when the file was read, it is deleted in the GUI thread.
+The rows read so far are copied to the target spreadsheet in batches, so the user can look at the
+first rows while the remainder of the file is read. The columns of the target are filled without undo commands,
+the target is read-only until the job has finished. The import can be cancelled, the rows read
+until then remain in the target spreadsheet. The progress of the filter is throttled and forwarded
+by completed(). Several jobs run concurrently, each in its own thread.
+
+The job takes the ownership of the filter and deletes itself after finished() was emitted.
+Filters of libraries that are not thread-safe (HDF5, NetCDF) serialize the library calls of concurrent jobs,
+only the conversion of the values read runs in parallel.
+
+\ingroup datasources
+*/
+
+/*!
+\class ImportThread
+\brief Reads a data file with a filter into a staging spreadsheet.
+
+The staging spreadsheet is created in the GUI thread and moved to the thread before it is started.
+When the file was read completely, the thread stores the data in the import cache file \c cacheName.
+Afterwards it moves the staging spreadsheet back to the GUI thread,
+where its data is published and where it is deleted.
+
+\ingroup datasources
+*/
+ImportThread::ImportThread(AbstractFileFilter* filter, const QString& fileName, const QString& cacheName, Spreadsheet* staging, QObject* parent)
+	: QThread(parent), m_filter(filter), m_fileName(fileName), m_cacheName(cacheName), m_staging(staging) {
+}
+
+void ImportThread::run() {
+	m_filter->read(m_fileName, m_staging, AbstractFileFilter::Replace);
+	if (!m_filter->isCanceled())
+		ImportCache::write(m_fileName, m_cacheName, m_staging);
+	m_staging->moveToThread(QCoreApplication::instance()->thread());
+}
+
+ImportJob::ImportJob(AbstractFileFilter* filter, const QString& fileName, Spreadsheet* target, AbstractFileFilter::ImportMode mode) : QObject(),
+	m_filter(filter), m_fileName(fileName), m_target(target), m_mode(mode), m_staging(0), m_thread(0), m_columnsCreated(false),
+	m_columnOffset(0), m_publishedRows(0) {
+
+	//the job can be started later, the target is not modified in the meantime
+	m_target->setReadOnly(true);
+
+	m_publishTimer.setInterval(500);
+	connect(&m_publishTimer, SIGNAL(timeout()), this, SLOT(publishAvailableRows()));
+	connect(m_filter, SIGNAL(completed(int)), this, SIGNAL(completed(int)));
+}
+
+ImportJob::~ImportJob() {
+	delete m_filter;
+}
+
+/*!
+  starts reading the file in the worker thread.
+*/
+void ImportJob::start() {
+	m_staging = new Spreadsheet(0, "staging", true);
+	m_staging->setUndoAware(false);
+
+	//the name of the cache file depends on the filter and the cache directory, it is determined in the GUI thread
+	m_thread = new ImportThread(m_filter, m_fileName, ImportCache::cacheFileName(m_fileName, m_filter), m_staging, this);
+	m_staging->moveToThread(m_thread);
+	connect(m_thread, SIGNAL(finished()), this, SLOT(readFinished()));
+
+	m_publishTimer.start();
+	m_thread->start();
+}
+
+/*!
+  cancels the import, the rows read so far are kept.
+*/
+void ImportJob::cancel() {
+	m_filter->cancel();
+}
+
+/*!
+  copies the rows that were completely read since the last call to the target spreadsheet.
+  The filter signals available rows only after it has created the columns of the staging spreadsheet.
+*/
+void ImportJob::publishAvailableRows() {
+	const int rows = m_filter->availableRows();
+	if (rows > m_publishedRows)
+		publishRows(rows);
+}
+
+/*!
+  copies the rows from \c m_publishedRows to \c rows of the staging spreadsheet to the target spreadsheet.
+  The columns of the target are created with the first batch according to the import mode, the rows not read yet are empty.
+  The columns of the staging spreadsheet are created by the filter before any row is available, only
+  their data is modified in the worker thread afterwards. They are looked up once, with the first batch.
+*/
+void ImportJob::publishRows(int rows) {
+	if (!m_target || !m_staging)
+		return;
+
+	if (m_sourceColumns.isEmpty())
+		m_sourceColumns = m_staging->children<Column>();
+	if (m_sourceColumns.isEmpty())
+		return;
+
+	if (!m_columnsCreated) {
+		QStringList names;
+		foreach (const Column* column, m_sourceColumns)
+			names << column->name();
+
+		const int size = static_cast<const QVector<double>*>(m_sourceColumns.first()->data())->size();
+		QVector<QVector<double>*> dataPointers;
+		m_columnOffset = m_target->create(dataPointers, m_mode, size, m_sourceColumns.size(), names);
+		foreach (QVector<double>* vector, dataPointers)
+			vector->fill(NAN);
+		m_columnsCreated = true;
+	}
+
+	//the target could have been modified by the user in the meantime
+	if (m_target->columnCount() < m_columnOffset + m_sourceColumns.size())
+		return;
+
+	for (int n = 0; n < m_sourceColumns.size(); ++n) {
+		const QVector<double>* source = static_cast<const QVector<double>*>(m_sourceColumns.at(n)->data());
+		Column* column = m_target->column(m_columnOffset + n);
+		QVector<double>* vector = static_cast<QVector<double>*>(column->data());
+		const int count = qMin(rows, qMin(source->size(), vector->size())) - m_publishedRows;
+		if (count > 0)
+			memcpy(vector->data() + m_publishedRows, source->constData() + m_publishedRows, count*sizeof(double));
+
+		column->setSuppressDataChangedSignal(false);
+		column->setChanged();
+		column->setSuppressDataChangedSignal(true);
+	}
+	m_publishedRows = rows;
+}
+
+/*!
+  copies the remaining rows to the target spreadsheet after the worker thread has finished
+  and makes the target undo/redo-able again.
+  If the import was cancelled, the target is shrunk to the rows read until then.
+*/
+void ImportJob::readFinished() {
+	m_publishTimer.stop();
+	m_thread->wait();
+
+	const bool canceled = m_filter->isCanceled();
+	if (m_staging) {
+		if (canceled) {
+			publishAvailableRows();
+		} else {
+			const Column* first = m_staging->child<Column>(0);
+			if (first)
+				publishRows(static_cast<const QVector<double>*>(first->data())->size());
+		}
+	}
+
+	if (m_target && m_columnsCreated) {
+		//the other columns of the target are kept when appending or prepending, the rows not read remain empty then
+		if (canceled && m_mode == AbstractFileFilter::Replace)
+			m_target->setRowCount(m_publishedRows);
+
+		const QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", m_publishedRows);
+		const int columns = qMin(m_sourceColumns.size(), m_target->columnCount() - m_columnOffset);
+		for (int n = 0; n < columns; ++n) {
+			Column* column = m_target->column(m_columnOffset + n);
+			column->setComment(comment);
+			column->setUndoAware(true);
+			column->setSuppressDataChangedSignal(false);
+			column->setChanged();
+		}
+		m_target->setUndoAware(true);
+	}
+	if (m_target)
+		m_target->setReadOnly(false);
+
+	delete m_staging;
+	emit finished();
+	deleteLater();
+}
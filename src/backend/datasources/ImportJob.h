@@ -0,0 +1,92 @@
+/***************************************************************************
+    File                 : ImportJob.h
+    Project              : LabPlot
+    Description          : Background import of a data file
+    --------------------------------------------------------------------
+    Copyright            : (C) 2017 by the LabPlot developers
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef IMPORTJOB_H
+#define IMPORTJOB_H
+
+#include <QObject>
+#include <QString>
+#include <QPointer>
+#include <QTimer>
+#include <QThread>
+
+#include "backend/datasources/filters/AbstractFileFilter.h"
+
+class Spreadsheet;
+class Column;
+
+class ImportThread : public QThread {
+	public:
+		ImportThread(AbstractFileFilter*, const QString& fileName, const QString& cacheName, Spreadsheet* staging, QObject* parent);
+
+	protected:
+		virtual void run();
+
+	private:
+		AbstractFileFilter* m_filter;
+		QString m_fileName;
+		QString m_cacheName;
+		Spreadsheet* m_staging;
+};
+
+class ImportJob : public QObject {
+	Q_OBJECT
+
+	public:
+		ImportJob(AbstractFileFilter*, const QString& fileName, Spreadsheet*,
+			AbstractFileFilter::ImportMode mode = AbstractFileFilter::Replace);
+		~ImportJob();
+
+	public slots:
+		void start();
+		void cancel();
+
+	private:
+		void publishRows(int rows);
+
+		AbstractFileFilter* m_filter;
+		QString m_fileName;
+		QPointer<Spreadsheet> m_target;
+		AbstractFileFilter::ImportMode m_mode;
+		Spreadsheet* m_staging;
+		QList<Column*> m_sourceColumns;
+		QThread* m_thread;
+		bool m_columnsCreated;
+		int m_columnOffset;
+		int m_publishedRows;
+		QTimer m_publishTimer;
+
+	private slots:
+		void publishAvailableRows();
+		void readFinished();
+
+	signals:
+		void completed(int);
+		void finished();
+};
+
+#endif
@@ -26,3 +26,151 @@ Copyright            : (C) 2009-2013 Alexander Semke (alexander.semke@web.de)
  ***************************************************************************/
 
 #include "backend/datasources/filters/AbstractFileFilter.h"
+#include "backend/lib/XmlStreamReader.h"
+#include "backend/spreadsheet/Spreadsheet.h"
+#include "backend/matrix/Matrix.h"
+#include "backend/core/column/Column.h"
+
+#include <QMutex>
+#include <KLocale>
+
+Q_GLOBAL_STATIC(QMutex, fileLibraryMutex)
+
+/*!
+  returns the list of all supported sampling modes, see AbstractFileFilter::SamplingMode.
+*/
+QStringList AbstractFileFilter::samplingModes() {
+	return (QStringList() << i18n("all rows")
+		<< i18n("every k-th row")
+		<< i18n("random sample")
+		<< i18n("min/max envelope"));
+}
+
+/*!
+  sets the reduction of the rows applied during the import.
+  The data is reduced by the factor \c samplingFactor() inside of the reader,
+  only the reduced data is written to the data source.
+*/
+void AbstractFileFilter::setSamplingMode(const SamplingMode mode) {
+	m_samplingMode = mode;
+}
+
+AbstractFileFilter::SamplingMode AbstractFileFilter::samplingMode() const {
+	return m_samplingMode;
+}
+
+/*!
+  sets the sampling factor \c k: every k-th row, a random sample of 1/k of the rows
+  or the minimum and the maximum of buckets of k rows are imported.
+*/
+void AbstractFileFilter::setSamplingFactor(const int k) {
+	m_samplingFactor = qMax(k, 1);
+}
+
+int AbstractFileFilter::samplingFactor() const {
+	return m_samplingFactor;
+}
+
+/*!
+  collects the data of the numeric columns of the spreadsheet or of the columns of the matrix \c dataSource
+  in \c columns and their names in \c names for the export. Returns the number of rows.
+*/
+int AbstractFileFilter::numericColumns(AbstractDataSource* dataSource, QVector<const QVector<double>*>& columns, QStringList& names) {
+	Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
+	if (spreadsheet) {
+		for (int j = 0; j < spreadsheet->columnCount(); ++j) {
+			const Column* column = spreadsheet->column(j);
+			if (column->columnMode() != AbstractColumn::Numeric)
+				continue;
+			columns << static_cast<const QVector<double>*>(column->data());
+			names << column->name();
+		}
+		return spreadsheet->rowCount();
+	}
+
+	Matrix* matrix = dynamic_cast<Matrix*>(dataSource);
+	if (matrix) {
+		const QVector<QVector<double> >& data = matrix->data();
+		for (int j = 0; j < matrix->columnCount(); ++j) {
+			columns << &data.at(j);
+			names << QString::number(j+1);
+		}
+		return matrix->rowCount();
+	}
+
+	return 0;
+}
+
+/*!
+  returns the mutex serializing the calls of the HDF5 and NetCDF libraries, that are not thread-safe.
+  NetCDF-4 uses HDF5 internally, both libraries share the mutex. The filters lock it in every function
+  calling the libraries, the file content can be scanned, previewed and imported in different threads.
+*/
+QMutex* AbstractFileFilter::libraryMutex() {
+	return fileLibraryMutex();
+}
+
+/*!
+  aborts the current read. The readers supporting the cancellation stop after the current row or block of rows,
+  the values read so far remain in the data source. Can be called from any thread.
+*/
+void AbstractFileFilter::cancel() {
+	m_canceled.fetchAndStoreOrdered(1);
+}
+
+bool AbstractFileFilter::isCanceled() const {
+	return m_canceled != 0;
+}
+
+/*!
+  returns the number of leading rows of the data source that contain their final values during a read,
+  -1 as long as the columns of the data source were not created yet. Can be called from any thread,
+  the values of the returned rows are visible to the calling thread.
+*/
+int AbstractFileFilter::availableRows() const {
+	return m_availableRows.fetchAndAddAcquire(0);
+}
+
+/*!
+  prepares the progress notifications for a new read, to be called by the readers before the data source is modified.
+*/
+void AbstractFileFilter::resetProgress() const {
+	m_progress = -1;
+	m_availableRows.fetchAndStoreRelease(-1);
+}
+
+/*!
+  notifies about the progress of the read, \c row of \c rows rows were processed.
+  completed() is emitted only if the percentage has changed and not for every row.
+*/
+void AbstractFileFilter::setProgress(int row, int rows) const {
+	const int progress = (rows > 0) ? (int)(100LL*row/rows) : 100;
+	if (progress != m_progress) {
+		m_progress = progress;
+		emit completed(progress);
+	}
+}
+
+/*!
+  publishes the number of leading rows of the data source that contain their final values.
+*/
+void AbstractFileFilter::setAvailableRows(int rows) const {
+	m_availableRows.fetchAndStoreRelease(rows);
+}
+
+void AbstractFileFilter::saveSamplingAttributes(QXmlStreamWriter* writer) const {
+	writer->writeAttribute("samplingMode", QString::number(m_samplingMode));
+	writer->writeAttribute("samplingFactor", QString::number(m_samplingFactor));
+}
+
+/*!
+  reads the sampling settings. The attributes are optional, projects created
+  before the sampling was introduced import all rows.
+*/
+void AbstractFileFilter::loadSamplingAttributes(const QXmlStreamAttributes& attribs) {
+	QString str = attribs.value("samplingMode").toString();
+	m_samplingMode = str.isEmpty() ? NoSampling : (SamplingMode)str.toInt();
+
+	str = attribs.value("samplingFactor").toString();
+	m_samplingFactor = str.isEmpty() ? 1 : qMax(str.toInt(), 1);
+}
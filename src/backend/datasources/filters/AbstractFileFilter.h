@@ -29,21 +29,39 @@ Copyright            : (C) 2009-2013 Alexander Semke (alexander.semke@web.de)
 #define ABSTRACTFILEFILTER_H
 
 #include <QObject>
+#include <QAtomicInt>
+#include <QStringList>
+#include <QVector>
 
 class AbstractDataSource;
 class XmlStreamReader;
 class QXmlStreamWriter;
+class QXmlStreamAttributes;
+class QMutex;
 
 class AbstractFileFilter : public QObject {
 	Q_OBJECT
 
 	public:
-        AbstractFileFilter() {}
+		AbstractFileFilter() : m_samplingMode(NoSampling), m_samplingFactor(1), m_canceled(0), m_progress(-1), m_availableRows(-1) {}
 		virtual ~AbstractFileFilter() {}
 		enum ImportMode {Append, Prepend, Replace};
-		
+		enum SamplingMode {NoSampling, EveryKthRow, RandomSample, MinMaxEnvelope};
+
+		static QStringList samplingModes();
+		void setSamplingMode(const SamplingMode);
+		SamplingMode samplingMode() const;
+		void setSamplingFactor(const int);
+		int samplingFactor() const;
+
 		virtual void read(const QString& fileName, AbstractDataSource* dataSource, ImportMode mode = Replace) = 0;
 		virtual void write(const QString& fileName, AbstractDataSource* dataSource) = 0;
+		static int numericColumns(AbstractDataSource*, QVector<const QVector<double>*>& columns, QStringList& names);
+		static QMutex* libraryMutex();
+
+		void cancel();
+		bool isCanceled() const;
+		int availableRows() const;
 
 		virtual void loadFilterSettings(const QString& filterName) = 0;
 		virtual void saveFilterSettings(const QString& filterName) const = 0;
@@ -51,6 +69,21 @@ class AbstractFileFilter : public QObject {
 		virtual void save(QXmlStreamWriter*) const = 0;
 		virtual bool load(XmlStreamReader*) = 0;
 
+	protected:
+		void saveSamplingAttributes(QXmlStreamWriter*) const;
+		void loadSamplingAttributes(const QXmlStreamAttributes&);
+		void resetProgress() const;
+		void setProgress(int row, int rows) const;
+		void setAvailableRows(int rows) const;
+
+		SamplingMode m_samplingMode;
+		int m_samplingFactor;
+
+	private:
+		QAtomicInt m_canceled;
+		mutable int m_progress;
+		mutable QAtomicInt m_availableRows;
+
 	signals:
 		void completed(int) const; //!< int ranging from 0 to 100 notifies about the status of a read/write process		
 };
@@ -28,15 +28,24 @@ Copyright            : (C) 2009-2015 Alexander Semke (alexander.semke@web.de)
 ***************************************************************************/
 #include "backend/datasources/filters/AsciiFilter.h"
 #include "backend/datasources/filters/AsciiFilterPrivate.h"
+#include "backend/datasources/filters/PipelinedDevice.h"
+#include "backend/datasources/filters/RowSampler.h"
 #include "backend/datasources/FileDataSource.h"
 #include "backend/core/column/Column.h"
+#include "backend/core/datatypes/Double2StringFilter.h"
 #include "backend/lib/macros.h"
 
 #include <QTextStream>
+#include <QFile>
+#include <QLocale>
+#include <QQueue>
+#include <QThread>
+#include <QtConcurrentRun>
 #include <KLocale>
 #include <KFilterDev>
 
 #include <cmath>
+#include <cstring>
 
  /*!
 	\class AsciiFilter
@@ -120,12 +129,15 @@ int AsciiFilter::columnNumber(const QString & fileName) {
 	QString line;
 	QStringList lineStringList;
 
-	QIODevice *device = KFilterDev::deviceForFile(fileName);
-	if (!device->open(QIODevice::ReadOnly))
+	QIODevice *device = PipelinedDevice::deviceForFile(fileName);
+	if (!device->open(QIODevice::ReadOnly)) {
+		delete device;
 		return 0;
+	}
 
 	QTextStream in(device);
 	line = in.readLine();
+	delete device;
 	lineStringList = line.split(QRegExp("\\s+")); //TODO
 	return lineStringList.size();
 }
@@ -136,9 +148,11 @@ int AsciiFilter::columnNumber(const QString & fileName) {
 */
 size_t AsciiFilter::lineNumber(const QString & fileName) {
 	//TODO: compare the speed of this function with the speed of wc from GNU-coreutils.
-	QIODevice *device = KFilterDev::deviceForFile(fileName);
-	if (!device->open(QIODevice::ReadOnly))
+	QIODevice *device = PipelinedDevice::deviceForFile(fileName);
+	if (!device->open(QIODevice::ReadOnly)) {
+		delete device;
 		return 0;
+	}
 
 	QTextStream in(device);
 	size_t rows = 0;
@@ -146,6 +160,7 @@ size_t AsciiFilter::lineNumber(const QString & fileName) {
 		in.readLine();
 		rows++;
 	}
+	delete device;
 
 	return rows;
 }
@@ -246,6 +261,26 @@ int AsciiFilter::endColumn() const{
 	return d->endColumn;
 }
 
+/*!
+  sets the byte offset of the first line to read. If not 0, only the complete lines behind this offset
+  are read to the data source, e.g. to refresh an append-only file with the offset returned by endOffset().
+*/
+void AsciiFilter::setStartOffset(const qint64 o) {
+	d->startOffset = o;
+}
+
+qint64 AsciiFilter::startOffset() const {
+	return d->startOffset;
+}
+
+/*!
+  returns the byte offset behind the last line read to a data source. -1, if the read can't be continued
+  there: for compressed files, if the last line was incomplete or the content before the start offset has changed.
+*/
+qint64 AsciiFilter::endOffset() const {
+	return d->endOffset;
+}
+
 //#####################################################################
 //################### Private implementation ##########################
 //#####################################################################
@@ -260,7 +295,9 @@ AsciiFilterPrivate::AsciiFilterPrivate(AsciiFilter* owner) : q(owner),
 	startRow(1),
 	endRow(-1),
 	startColumn(1),
-	endColumn(-1) {
+	endColumn(-1),
+	startOffset(0),
+	endOffset(-1) {
 }
 
 /*!
@@ -268,10 +305,16 @@ AsciiFilterPrivate::AsciiFilterPrivate(AsciiFilter* owner) : q(owner),
     Uses the settings defined in the data source.
 */
 QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode mode, int lines) {
-	QIODevice *device = KFilterDev::deviceForFile(fileName);
+	QIODevice *device = PipelinedDevice::deviceForFile(fileName);
 	QList<QStringList> dataStrings;
-	if (!device->open(QIODevice::ReadOnly))
+	if (!device->open(QIODevice::ReadOnly)) {
+		delete device;
 		return dataStrings << (QStringList() << QString());
+	}
+
+	//the end offset of the previous read is kept for a refresh that reads behind it
+	if (dataSource != NULL && startOffset == 0)
+		endOffset = -1;
 
 	QTextStream in(device);
 
@@ -288,6 +331,7 @@ QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, Abstra
 				if (dataSource != NULL)
 					dataSource->clear();
 			}
+			delete device;
 			return dataStrings << (QStringList() << QString());
 		}
 
@@ -300,6 +344,7 @@ QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, Abstra
 			if (dataSource != NULL)
 				dataSource->clear();
 		}
+		delete device;
 		return dataStrings << (QStringList() << QString());
 	}
 
@@ -351,6 +396,13 @@ QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, Abstra
 
 	//qDebug()<<"	vector names ="<<vectorNameList;
 
+	//refresh of an append-only file: the header is parsed as before, the rows are read behind the start offset only
+	if (dataSource != NULL && startOffset > 0) {
+		readAppended(device, dataSource, separator, vectorNameList, endColumn - startColumn + 1);
+		delete device;
+		return dataStrings;
+	}
+
 	int actualRows = AsciiFilter::lineNumber(fileName);	// data rows
 	int actualEndRow;
 	if (endRow == -1)
@@ -377,23 +429,27 @@ QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, Abstra
 	int columnOffset = 0; // indexes the "start column" in the spreadsheet. Starting from this column the data will be imported.
 	QVector<QVector<double>*> dataPointers;	// pointers to the actual data containers
 
+	//the rows are reduced while reading, only the sample is stored in the data source
+	RowSampler sampler(q, actualRows);
+	q->resetProgress();
 	if (dataSource != NULL)
-		columnOffset = dataSource->create(dataPointers, mode, actualRows, actualCols, vectorNameList);
+		columnOffset = dataSource->create(dataPointers, mode, sampler.rows(), actualCols, vectorNameList);
 
 	//header: import the values in the first line, if they were not used as the header (as the names for the columns)
 	bool isNumber;
 	if (!headerEnabled) {
 		QStringList lineString;
-		for (int n=0; n < actualCols; n++) {
+		const bool used = (dataSource == NULL || sampler.nextRow());
+		for (int n=0; used && n < actualCols; n++) {
 			if (n < lineStringList.size()) {
 				const double value = lineStringList.at(n).toDouble(&isNumber);
 				if (dataSource != NULL)
-					isNumber ? dataPointers[n]->operator[](0) = value : dataPointers[n]->operator[](0) = NAN;
+					sampler.setValue(dataPointers[n], isNumber ? value : NAN);
 				else
 					isNumber ? lineString << QString::number(value) : lineString << QLatin1String("NAN");
 			} else {
 				if (dataSource != NULL)
-					dataPointers[n]->operator[](0) = NAN;
+					sampler.setValue(dataPointers[n], NAN);
 				else
 					lineString << QLatin1String("NAN");
 			}
@@ -404,6 +460,9 @@ QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, Abstra
 
 	//Read the remainder of the file.
 	for (int i=currentRow; i < qMin(lines,actualRows); i++) {
+		if (q->isCanceled())
+			break;
+
 		line = in.readLine();
 
 		if (simplifyWhitespacesEnabled)
@@ -418,6 +477,12 @@ QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, Abstra
 			continue;
 		}
 
+		//rows not contained in the sample are not parsed at all
+		if (dataSource != NULL && !sampler.nextRow()) {
+			currentRow++;
+			continue;
+		}
+
 		lineStringList = line.split(separator, QString::SplitBehavior(skipEmptyParts));
 
 		// TODO : read strings (comments) or datetime too
@@ -426,12 +491,12 @@ QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, Abstra
 			if (n < lineStringList.size()) {
 				const double value = lineStringList.at(n).toDouble(&isNumber);
 				if (dataSource != NULL)
-					isNumber ? dataPointers[n]->operator[](currentRow) = value : dataPointers[n]->operator[](currentRow) = NAN;
+					sampler.setValue(dataPointers[n], isNumber ? value : NAN);
 				else
 					isNumber ? lineString += QString::number(value) : lineString += QString("NAN");
 			} else {
 				if (dataSource != NULL)
-					dataPointers[n]->operator[](currentRow) = NAN;
+					sampler.setValue(dataPointers[n], NAN);
 				else
 					lineString += QLatin1String("NAN");
 			}
@@ -439,18 +504,27 @@ QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, Abstra
 
 		dataStrings << lineString;
 		currentRow++;
-		emit q->completed(100*currentRow/actualRows);
+		q->setProgress(currentRow, actualRows);
+		if (dataSource != NULL)
+			q->setAvailableRows(sampler.completedRows());
 	}
+	if (dataSource != NULL)
+		setEndOffset(device, q->isCanceled() ? -1 : in.pos());
+	delete device;
 
 	if (!dataSource)
 		return dataStrings;
 
+	if (!q->isCanceled())
+		q->setAvailableRows(sampler.rows());
+
 	//make everything undo/redo-able again
 	//set the comments for each of the columns
 	Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
 	if (spreadsheet) {
 		//TODO: generalize to different data types
-		QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", headerEnabled ? currentRow : currentRow+1);
+		const int rows = sampler.isActive() ? sampler.rows() : (headerEnabled ? currentRow : currentRow+1);
+		QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", rows);
 		for (int n=startColumn; n <= endColumn; n++) {
 			Column* column = spreadsheet->column(columnOffset+n-startColumn);
 			column->setComment(comment);
@@ -475,6 +549,77 @@ QList<QStringList> AsciiFilterPrivate::readData(const QString & fileName, Abstra
 	return dataStrings;
 }
 
+/*!
+  reads the complete lines behind \c startOffset of \c device to \c dataSource. The columns are created
+  with the separator and the names determined from the header as for the whole file.
+  Nothing is read if the content before \c startOffset has changed, endOffset is -1 then.
+*/
+void AsciiFilterPrivate::readAppended(QIODevice* device, AbstractDataSource* dataSource, const QString& separator,
+		const QStringList& vectorNames, int cols) {
+	const QByteArray tail = endTail;
+	endOffset = -1;
+	endTail.clear();
+	if (device->isSequential() || !device->seek(startOffset - tail.size()) || device->read(tail.size()) != tail)
+		return;
+
+	//an incomplete last line is read with the next refresh
+	QByteArray appended = device->readAll();
+	appended.truncate(appended.lastIndexOf('\n') + 1);
+
+	QList<QStringList> rows;
+	QTextStream in(appended);
+	while (!in.atEnd()) {
+		QString line = in.readLine();
+		if (simplifyWhitespacesEnabled)
+			line = line.simplified();
+		if (line.isEmpty() || line.startsWith(commentCharacter))
+			continue;
+
+		rows << line.split(separator, QString::SplitBehavior(skipEmptyParts));
+	}
+
+	QVector<QVector<double>*> dataPointers;
+	dataSource->create(dataPointers, AbstractFileFilter::Replace, rows.size(), cols, vectorNames);
+	bool isNumber;
+	for (int i = 0; i < rows.size(); ++i) {
+		const QStringList& lineStringList = rows.at(i);
+		for (int n = 0; n < cols; ++n) {
+			const double value = (n < lineStringList.size()) ? lineStringList.at(n).toDouble(&isNumber) : NAN;
+			dataPointers[n]->operator[](i) = (n < lineStringList.size() && isNumber) ? value : NAN;
+		}
+	}
+
+	Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
+	if (spreadsheet) {
+		for (int n = 0; n < cols; ++n) {
+			Column* column = spreadsheet->column(n);
+			column->setUndoAware(true);
+			column->setSuppressDataChangedSignal(false);
+		}
+		spreadsheet->setUndoAware(true);
+	}
+
+	endOffset = startOffset + appended.size();
+	endTail = (tail + appended).right(tailSize);
+}
+
+/*!
+  remembers the byte offset \c pos behind the last line read from \c device and the bytes before it.
+  A refresh can't continue at \c pos for compressed files and if the last line read is incomplete.
+*/
+void AsciiFilterPrivate::setEndOffset(QIODevice* device, qint64 pos) {
+	endOffset = -1;
+	endTail.clear();
+	if (pos <= 0 || device->isSequential() || !device->seek(qMax(Q_INT64_C(0), pos - tailSize)))
+		return;
+
+	const QByteArray tail = device->read(pos - device->pos());
+	if (tail.endsWith('\n')) {
+		endOffset = pos;
+		endTail = tail;
+	}
+}
+
 /*!
     reads the content of the file \c fileName to the data source \c dataSource.
 */
@@ -486,9 +631,166 @@ void AsciiFilterPrivate::read(const QString & fileName, AbstractDataSource* data
     writes the content of \c dataSource to the file \c fileName.
 */
 void AsciiFilterPrivate::write(const QString & fileName, AbstractDataSource* dataSource) {
-	Q_UNUSED(fileName);
-	Q_UNUSED(dataSource);
-	//TODO
+	Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
+	if (!spreadsheet) {
+		DEBUG("AsciiFilter::write(): only spreadsheets can be exported");
+		return;
+	}
+
+	//files with the extension .gz are compressed while writing
+	QIODevice* device;
+	if (fileName.endsWith(QLatin1String(".gz"), Qt::CaseInsensitive))
+		device = KFilterDev::deviceForFile(fileName, "application/x-gzip", true);
+	else
+		device = new QFile(fileName);
+	if (!device->open(QIODevice::WriteOnly)) {
+		delete device;
+		return;
+	}
+
+	QString sep = separatingCharacter;
+	if (sep == QLatin1String("auto"))
+		sep = QLatin1String("TAB");
+	sep = sep.replace(QLatin1String("TAB"), QLatin1String("\t"), Qt::CaseInsensitive);
+	sep = sep.replace(QLatin1String("SPACE"), QLatin1String(" "), Qt::CaseInsensitive);
+	const QByteArray separator = sep.toUtf8();
+
+	//numeric and text columns are read directly, numeric values are formatted with the format and the digits
+	//of the output filter of the column. The other columns are converted with their string filters.
+	//The string filters are not thread-safe, the rows are formatted in parallel only without such columns.
+	const int cols = spreadsheet->columnCount();
+	const int rows = spreadsheet->rowCount();
+	QVector<const Column*> columns;
+	QVector<QPair<char, int> > formats;
+	bool parallel = true;
+	for (int j = 0; j < cols; ++j) {
+		const Column* column = spreadsheet->column(j);
+		columns << column;
+		if (column->columnMode() == AbstractColumn::Numeric) {
+			const Double2StringFilter* filter = static_cast<Double2StringFilter*>(column->outputFilter());
+			formats << qMakePair(filter->numericFormat(), filter->numDigits());
+		} else {
+			formats << qMakePair('g', 0);
+			if (column->columnMode() != AbstractColumn::Text)
+				parallel = false;
+		}
+	}
+
+	//export header (column names)
+	if (headerEnabled) {
+		QByteArray header;
+		for (int j = 0; j < cols; ++j) {
+			header.append(columns.at(j)->name().toUtf8());
+			if (j != cols-1)
+				header.append(separator);
+		}
+		header.append('\n');
+		device->write(header);
+	}
+
+	//export values: the blocks of rows are formatted in parallel and written in their order.
+	//At most two blocks per thread are pending to limit the memory used.
+	const int blockRows = 16384;
+	if (!parallel) {
+		for (int i = 0; i < rows; i += blockRows) {
+			device->write(formatRows(columns, formats, separator, i, qMin(i + blockRows, rows)));
+			emit q->completed(100*qMin(i + blockRows, rows)/rows);
+		}
+	} else {
+		const int maxPending = 2*QThread::idealThreadCount();
+		QQueue<QFuture<QByteArray> > pending;
+		int next = 0, written = 0;
+		while (next < rows || !pending.isEmpty()) {
+			while (next < rows && pending.size() < maxPending) {
+				pending.enqueue(QtConcurrent::run(this, &AsciiFilterPrivate::formatRows, columns, formats, separator, next, qMin(next + blockRows, rows)));
+				next += blockRows;
+			}
+
+			device->write(pending.dequeue().result());
+			written = qMin(written + blockRows, rows);
+			emit q->completed(100*written/rows);
+		}
+	}
+
+	device->close();
+	delete device;
+}
+
+/*!
+    formats the rows \c first to \c last-1 of the columns \c columns separated by \c separator.
+    Numeric values are formatted with the numeric format and the digits in \c formats and the decimal point
+    of the locale, invalid values are exported as empty fields.
+    The values are formatted with qsnprintf() directly into the output, no group separators are written.
+*/
+QByteArray AsciiFilterPrivate::formatRows(const QVector<const Column*>& columns, const QVector<QPair<char, int> >& formats,
+		const QByteArray& separator, int first, int last) const {
+	//the C library formats with '.', other decimal points of the locale are replaced
+	const QLocale locale;
+	char decimalPoint = locale.decimalPoint().toLatin1();
+	if (locale.language() == QLocale::C || decimalPoint == 0)
+		decimalPoint = '.';
+
+	const int cols = columns.size();
+	QVector<const char*> printfFormats(cols);
+	for (int j = 0; j < cols; ++j) {
+		switch (formats.at(j).first) {
+		case 'e':
+			printfFormats[j] = "%.*e";
+			break;
+		case 'E':
+			printfFormats[j] = "%.*E";
+			break;
+		case 'f':
+			printfFormats[j] = "%.*f";
+			break;
+		case 'G':
+			printfFormats[j] = "%.*G";
+			break;
+		default:
+			printfFormats[j] = "%.*g";
+		}
+	}
+
+	QByteArray out;
+	out.reserve((last - first)*cols*12);
+	char buffer[512];
+	for (int i = first; i < last; ++i) {
+		for (int j = 0; j < cols; ++j) {
+			const Column* column = columns.at(j);
+			if (i < column->rowCount()) {
+				switch (column->columnMode()) {
+				case AbstractColumn::Numeric: {
+					const double value = column->valueAt(i);
+					if (value != value)
+						break;
+
+					int length = qsnprintf(buffer, sizeof(buffer), printfFormats.at(j), formats.at(j).second, value);
+					if (length < 0)
+						break;
+					length = qMin(length, (int)sizeof(buffer) - 1);
+					if (decimalPoint != '.') {
+						char* point = static_cast<char*>(memchr(buffer, '.', length));
+						if (point)
+							*point = decimalPoint;
+					}
+					out.append(buffer, length);
+					break;
+				}
+				case AbstractColumn::Text:
+					out.append(column->textAt(i).toUtf8());
+					break;
+				default:
+					out.append(column->asStringColumn()->textAt(i).toUtf8());
+				}
+			}
+
+			if (j != cols-1)
+				out.append(separator);
+		}
+		out.append('\n');
+	}
+
+	return out;
 }
 
 //##############################################################################
@@ -511,6 +813,7 @@ void AsciiFilter::save(QXmlStreamWriter* writer) const {
 	writer->writeAttribute( "endRow", QString::number(d->endRow) );
 	writer->writeAttribute( "startColumn", QString::number(d->startColumn) );
 	writer->writeAttribute( "endColumn", QString::number(d->endColumn) );
+	saveSamplingAttributes(writer);
 	writer->writeEndElement();
 }
 
@@ -525,6 +828,7 @@ bool AsciiFilter::load(XmlStreamReader* reader) {
 
 	QString attributeWarning = i18n("Attribute '%1' missing or empty, default value is used");
 	QXmlStreamAttributes attribs = reader->attributes();
+	loadSamplingAttributes(attribs);
 
 	QString str = attribs.value("commentCharacter").toString();
 	if (str.isEmpty())
@@ -87,6 +87,9 @@ class AsciiFilter : public AbstractFileFilter{
 	int startColumn() const;
 	void setEndColumn(const int);
 	int endColumn() const;
+	void setStartOffset(const qint64);
+	qint64 startOffset() const;
+	qint64 endOffset() const;
 
 	virtual void save(QXmlStreamWriter*) const;
 	virtual bool load(XmlStreamReader*);
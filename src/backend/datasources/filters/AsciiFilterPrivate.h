@@ -30,6 +30,8 @@
 #define ASCIIFILTERPRIVATE_H
 
 class AbstractDataSource;
+class Column;
+class QIODevice;
 
 class AsciiFilterPrivate {
 
@@ -56,8 +58,17 @@ class AsciiFilterPrivate {
 		int startColumn;
 		int endColumn;
 
+		qint64 startOffset;	// byte offset of the first line to read on a refresh, 0 to read the whole file
+		qint64 endOffset;	// byte offset behind the last complete line read, -1 if unknown
+		QByteArray endTail;	// bytes before endOffset, to detect a changed file
+		static const int tailSize = 256;
+
 	private:
 		void clearDataSource(AbstractDataSource*) const;
+		void readAppended(QIODevice*, AbstractDataSource*, const QString& separator, const QStringList& vectorNames, int cols);
+		void setEndOffset(QIODevice*, qint64 pos);
+		QByteArray formatRows(const QVector<const Column*>& columns, const QVector<QPair<char, int> >& formats,
+			const QByteArray& separator, int first, int last) const;
 };
 
 #endif
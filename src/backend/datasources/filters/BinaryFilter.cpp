@@ -26,14 +26,18 @@ Copyright            : (C) 2015-2017 by Stefan Gerlach (stefan.gerlach@uni.kn)
 ***************************************************************************/
 #include "backend/datasources/filters/BinaryFilter.h"
 #include "backend/datasources/filters/BinaryFilterPrivate.h"
+#include "backend/datasources/filters/BinaryRecord.h"
+#include "backend/datasources/filters/PipelinedDevice.h"
+#include "backend/datasources/filters/RowSampler.h"
 #include "backend/datasources/FileDataSource.h"
 #include "backend/core/column/Column.h"
 
-#include <QDataStream>
+#include <QFile>
+#include <QVarLengthArray>
 #include <QDebug>
 #include <KLocale>
-#include <KFilterDev>
 #include <cmath>
+#include <limits>
 
  /*!
 	\class BinaryFilter
@@ -97,26 +101,31 @@ int BinaryFilter::dataSize(BinaryFilter::DataType type) {
 
 /*!
   returns the number of rows (length of vectors) in the file \c fileName.
+  Compressed files are decompressed for this, the import counts their rows while reading them.
 */
 long BinaryFilter::rowNumber(const QString & fileName, const int vectors, const BinaryFilter::DataType type) {
-	QIODevice *device = KFilterDev::deviceForFile(fileName);
-	if (!device->open(QIODevice::ReadOnly))
-		return 0;
-
-	QDataStream in(device);
-	long rows=0;
-	while (!in.atEnd()) {
-		// one row
-		for (int i=0; i < vectors; ++i) {
-			for (int j=0; j < BinaryFilter::dataSize(type); ++j) {
-				qint8 tmp;
-				in >> tmp;
-			}
+	QIODevice *device = PipelinedDevice::deviceForFile(fileName);
+
+	//the size of uncompressed files is known without reading them
+	qint64 bytes = 0;
+	QFile* file = qobject_cast<QFile*>(device);
+	if (file) {
+		bytes = file->size();
+	} else {
+		if (!device->open(QIODevice::ReadOnly)) {
+			delete device;
+			return 0;
 		}
-		rows++;
+
+		QByteArray block;
+		do {
+			block = device->read(PipelinedDevice::blockSize);
+			bytes += block.size();
+		} while (!block.isEmpty());
 	}
+	delete device;
 
-	return rows;
+	return bytes/(vectors*BinaryFilter::dataSize(type));
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -192,6 +201,29 @@ int BinaryFilter::skipBytes() const {
 	return d->skipBytes;
 }
 
+/*!
+  sets the layout of structured records. Each field of a record is imported into a separate column.
+  If the list is empty, the file is read as \c vectors interleaved values of the type \c dataType.
+*/
+void BinaryFilter::setRecordFields(const QList<BinaryFilter::RecordField>& fields) {
+	d->recordFields = fields;
+}
+
+QList<BinaryFilter::RecordField> BinaryFilter::recordFields() const {
+	return d->recordFields;
+}
+
+/*!
+  sets the size of a record in bytes. If \c 0, the records are assumed to be packed without padding.
+*/
+void BinaryFilter::setRecordSize(const int s) {
+	d->recordSize = s;
+}
+
+int BinaryFilter::recordSize() const {
+	return d->recordSize;
+}
+
 void BinaryFilter::setAutoModeEnabled(bool b) {
 	d->autoModeEnabled = b;
 }
@@ -204,7 +236,8 @@ bool BinaryFilter::isAutoModeEnabled() const {
 //#####################################################################
 
 BinaryFilterPrivate::BinaryFilterPrivate(BinaryFilter* owner) :
-	q(owner), vectors(2), dataType(BinaryFilter::INT8), byteOrder(BinaryFilter::LittleEndian), skipStartBytes(0), startRow(1), endRow(-1), skipBytes(0) {
+	q(owner), vectors(2), dataType(BinaryFilter::INT8), byteOrder(BinaryFilter::LittleEndian), skipStartBytes(0), startRow(1), endRow(-1), skipBytes(0),
+	recordSize(0), autoModeEnabled(true) {
 }
 
 /*!
@@ -214,50 +247,85 @@ BinaryFilterPrivate::BinaryFilterPrivate(BinaryFilter* owner) :
 QList<QStringList> BinaryFilterPrivate::readData(const QString & fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode mode, int lines) {
 	QList<QStringList> dataStrings;
 
-	QIODevice *device = KFilterDev::deviceForFile(fileName);
-	if (! device->open(QIODevice::ReadOnly))
+	//map uncompressed files into memory, compressed files are decompressed and decoded block by block
+	QIODevice* device = PipelinedDevice::deviceForFile(fileName);
+	if (! device->open(QIODevice::ReadOnly)) {
+		delete device;
 		return dataStrings << (QStringList() << i18n("could not open device"));
+	}
 
-	QDataStream in(device);
+	//a row is either a record of fields or one value per vector
+	const bool records = !recordFields.isEmpty();
+	qint64 rowSize = (qint64)BinaryFilter::dataSize(dataType)*vectors;
+	QStringList vectorNames;
+	if (records) {
+		//the fields must be contained in the record, the last record is read up to the end of the file otherwise
+		qint64 fieldsSize = 0;
+		for (int n = 0; n < recordFields.size(); ++n) {
+			const BinaryFilter::RecordField& field = recordFields.at(n);
+			if (field.offset < 0) {
+				if (dataSource != NULL)
+					dataSource->clear();
+				delete device;
+				return dataStrings << (QStringList() << i18n("invalid offset of the record field %1", n+1));
+			}
+			fieldsSize = qMax(fieldsSize, (qint64)field.offset + BinaryFilter::dataSize(field.type));
+			vectorNames << (field.name.isEmpty() ? i18n("Field %1", n+1) : field.name);
+		}
+
+		rowSize = (recordSize == 0) ? fieldsSize : recordSize;
+		if (rowSize < fieldsSize) {
+			if (dataSource != NULL)
+				dataSource->clear();
+			delete device;
+			return dataStrings << (QStringList() << i18n("record size %1 is smaller than the record fields (%2 bytes)", recordSize, fieldsSize));
+		}
+	}
+	const int actualCols = records ? recordFields.size() : vectors;
 
-	if (byteOrder == BinaryFilter::BigEndian)
-		in.setByteOrder(QDataStream::BigEndian);
-	else if (byteOrder == BinaryFilter::LittleEndian)
-		in.setByteOrder(QDataStream::LittleEndian);
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+	const bool swap = (byteOrder == BinaryFilter::LittleEndian);
+#else
+	const bool swap = (byteOrder == BinaryFilter::BigEndian);
+#endif
 
-	int numRows=BinaryFilter::rowNumber(fileName,vectors,dataType);
+	const char* data = 0;
+	QFile* file = qobject_cast<QFile*>(device);
+	if (file && file->size() > 0)
+		data = (const char*)file->map(0, file->size());
+	const bool mapped = (data != 0);
+
+	qint64 numRows = 0;
+	QVector<QVector<double> > streamedRows;
+	if (mapped) {
+		if (skipStartBytes < file->size())
+			numRows = (file->size() - skipStartBytes)/rowSize;
+	} else {
+		//the rows of compressed files are counted in the same pass that decodes them.
+		//the preview and a selected end row don't need the rest of the file.
+		qint64 lastRow = endRow;
+		if (dataSource == NULL && lines != -1 && (lastRow == -1 || lastRow > startRow - 1 + lines))
+			lastRow = startRow - 1 + lines;
+		numRows = streamRows(device, rowSize, lastRow, swap, streamedRows);
+	}
 
 	// catch case that skipStartBytes or startRow is bigger than file
-	if (skipStartBytes >= BinaryFilter::dataSize(dataType)*vectors*numRows || startRow > numRows) {
+	if (numRows < 1 || startRow > numRows) {
 		if (dataSource != NULL)
 			dataSource->clear();
+		if (mapped)
+			file->unmap((uchar*)data);
+		delete device;
 		return dataStrings << (QStringList() << i18n("data selection empty"));
 	}
 
-	// skip bytes at start
-	for (int i = 0; i < skipStartBytes; i++) {
-		qint8 tmp;
-		in >> tmp;
-	}
-
-	// skip until start row
-	for (int i = 0; i < (startRow-1)*vectors; ++i) {
-		for (int j = 0; j < BinaryFilter::dataSize(dataType); ++j) {
-			qint8 tmp;
-			in >> tmp;
-		}
-	}
-
 	// set range of rows
 	int actualRows;
-	if (endRow == -1)
+	if (endRow == -1 || endRow > numRows)
 		actualRows = numRows-startRow+1;
-	else if (endRow > numRows-startRow+1)
-		actualRows = numRows;
 	else
 		actualRows = endRow-startRow+1;
-	int actualCols = vectors;
-	if (lines == -1)
+	if (lines == -1 || lines > actualRows)
 		lines = actualRows;
 #ifndef NDEBUG
 	qDebug()<<"	numRows ="<<numRows;
@@ -268,121 +336,98 @@ QList<QStringList> BinaryFilterPrivate::readData(const QString & fileName, Abstr
 	qDebug()<<"	lines ="<<lines;
 #endif
 
+	//the rows are reduced while reading, only the sample is stored in the data source
+	RowSampler sampler(q, actualRows);
+	q->resetProgress();
+
 	QVector<QVector<double>*> dataPointers;
 	int columnOffset = 0;
-	if (dataSource != NULL)
-		columnOffset = dataSource->create(dataPointers, mode, actualRows, actualCols);
-
-	// read data
-	for (int i = 0; i < qMin(actualRows, lines); i++) {
-		QStringList lineString;
-		for (int n = 0; n < actualCols; n++) {
-			switch (dataType) {
-			case BinaryFilter::INT8: {
-				qint8 value;
-				in >> value;
-				if (dataSource != NULL)
-					dataPointers[n]->operator[](i) = value;
-				else
-					lineString << QString::number(value);
-				break;
-			}
-			case BinaryFilter::INT16: {
-				qint16 value;
-				in >> value;
-				if (dataSource != NULL)
-					dataPointers[n]->operator[](i) = value;
-				else
-					lineString << QString::number(value);
-				break;
-			}
-			case BinaryFilter::INT32: {
-				qint32 value;
-				in >> value;
-				if (dataSource != NULL)
-					dataPointers[n]->operator[](i) = value;
-				else
-					lineString << QString::number(value);
-				break;
-			}
-			case BinaryFilter::INT64: {
-				qint64 value;
-				in >> value;
-				if (dataSource != NULL)
-					dataPointers[n]->operator[](i) = value;
-				else
-					lineString << QString::number(value);
-				break;
-			}
-			case BinaryFilter::UINT8: {
-				quint8 value;
-				in >> value;
-				if (dataSource != NULL)
-					dataPointers[n]->operator[](i) = value;
-				else
-					lineString << QString::number(value);
-				break;
-			}
-			case BinaryFilter::UINT16: {
-				quint16 value;
-				in >> value;
-				if (dataSource != NULL)
-					dataPointers[n]->operator[](i) = value;
-				else
-					lineString << QString::number(value);
-				break;
-			}
-			case BinaryFilter::UINT32: {
-				quint32 value;
-				in >> value;
-				if (dataSource != NULL)
-					dataPointers[n]->operator[](i) = value;
-				else
-					lineString << QString::number(value);
-				break;
-			}
-			case BinaryFilter::UINT64: {
-				quint64 value;
-				in >> value;
-				if (dataSource != NULL)
-					dataPointers[n]->operator[](i) = value;
-				else
-					lineString << QString::number(value);
-				break;
-			}
-			case BinaryFilter::REAL32: {
-				float value;
-				in >> value;
-				if (dataSource != NULL)
-					dataPointers[n]->operator[](i) = value;
-				else
-					lineString << QString::number(value);
+	if (dataSource != NULL) {
+		columnOffset = dataSource->create(dataPointers, mode, sampler.rows(), actualCols, vectorNames);
+	} else {
+		//preview: read into temporary vectors
+		for (int n = 0; n < actualCols; n++)
+			dataPointers.push_back(new QVector<double>(lines));
+	}
+
+	// seek directly to the first row
+	const char* src = mapped ? data + skipStartBytes + (startRow-1)*rowSize : 0;
+
+	// read data in blocks of rows.
+	// the fields of a record are extracted one after another from a block that still resides in the cache
+	const int blockRows = records ? 1 << 12 : 1 << 16;
+	if (dataSource != NULL && sampler.isActive()) {
+		// reduced import: only the values of the sampled rows are read
+		const int valueSize = BinaryFilter::dataSize(dataType);
+		for (int i = 0; i < actualRows; i++) {
+			if (i % blockRows == 0 && q->isCanceled())
 				break;
-			}
-			case BinaryFilter::REAL64: {
+			if (!sampler.nextRow())
+				continue;
+
+			for (int n = 0; n < actualCols; ++n) {
 				double value;
-				in >> value;
-				if (dataSource != NULL)
-					dataPointers[n]->operator[](i) = value;
+				if (!mapped)
+					value = streamedRows.at(n).at(i);
+				else if (records)
+					BinaryRecord::readField(recordFields.at(n).type, src + i*rowSize + recordFields.at(n).offset, 0, 1, rowSize, swap, &value);
 				else
-					lineString << QString::number(value);
-				break;
+					BinaryRecord::readField(dataType, src + i*rowSize + n*valueSize, 0, 1, rowSize, swap, &value);
+				sampler.setValue(dataPointers[n], value);
 			}
+
+			if (i % blockRows == 0) {
+				q->setProgress(i, actualRows);
+				q->setAvailableRows(sampler.completedRows());
 			}
 		}
-		dataStrings << lineString;
-		emit q->completed(100*i/actualRows);
+	} else if (!mapped) {
+		//the decoded rows are shared with the columns, nothing is copied
+		for (int n = 0; n < actualCols; ++n) {
+			streamedRows[n].resize(lines);
+			*dataPointers[n] = streamedRows.at(n);
+		}
+		q->setProgress(lines, actualRows);
+		q->setAvailableRows(lines);
+	} else {
+		QVarLengthArray<double*, 16> dest(actualCols);
+		for (int i = 0; i < lines; i += blockRows) {
+			if (q->isCanceled())
+				break;
+
+			const int rows = qMin(blockRows, lines - i);
+			for (int n = 0; n < actualCols; ++n)
+				dest[n] = dataPointers[n]->data() + i;
+			readRows(src + i*rowSize, rows, rowSize, swap, dest.data());
+			q->setProgress(i+rows, actualRows);
+			q->setAvailableRows(i+rows);
+		}
 	}
 
-	if (!dataSource)
+	if (mapped)
+		file->unmap((uchar*)data);
+	delete device;
+
+	if (!dataSource) {
+		for (int i = 0; i < lines; i++) {
+			QStringList lineString;
+			for (int n = 0; n < actualCols; n++)
+				lineString << QString::number(dataPointers[n]->at(i));
+			dataStrings << lineString;
+		}
+		qDeleteAll(dataPointers);
 		return dataStrings;
+	}
+
+	if (!q->isCanceled())
+		q->setAvailableRows(sampler.rows());
 
 	//make everything undo/redo-able again
 	//set the comments for each of the columns
 	Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
 	if (spreadsheet) {
 		Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
-		QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", actualRows);
+		QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", sampler.rows());
 		for (int n=0; n < actualCols; n++) {
 			Column* column = spreadsheet->column(columnOffset+n);
 			column->setComment(comment);
@@ -406,6 +451,140 @@ QList<QStringList> BinaryFilterPrivate::readData(const QString & fileName, Abstr
 	return dataStrings;
 }
 
+/*!
+  reads the rows of the sequential (compressed) \c device in blocks, skips \c skipStartBytes and the rows before \c startRow
+  and decodes the other rows into \c columns. Reads up to the row \c lastRow, or the whole file if \c lastRow is -1.
+  Returns the number of rows read including the skipped ones.
+*/
+qint64 BinaryFilterPrivate::streamRows(QIODevice* device, qint64 rowSize, qint64 lastRow, bool swap, QVector<QVector<double> >& columns) const {
+	const int cols = recordFields.isEmpty() ? vectors : recordFields.size();
+	columns.resize(cols);
+
+	qint64 skip = skipStartBytes;
+	while (skip > 0) {
+		const qint64 bytes = device->read(qMin(skip, (qint64)PipelinedDevice::blockSize)).size();
+		if (bytes == 0)
+			return 0;
+		skip -= bytes;
+	}
+
+	const qint64 blockRows = qMax((qint64)1, PipelinedDevice::blockSize/rowSize);
+	QByteArray block;
+	QVarLengthArray<double*, 16> dest(cols);
+	qint64 rows = 0;
+	int decodedRows = 0;
+	while (lastRow == -1 || rows < lastRow) {
+		if (q->isCanceled())
+			break;
+
+		//complete rows only, the device might deliver less than requested
+		const qint64 size = rowSize*((lastRow == -1) ? blockRows : qMin(blockRows, lastRow - rows));
+		block.resize(size);
+		qint64 bytes = 0;
+		while (bytes < size) {
+			const qint64 n = device->read(block.data() + bytes, size - bytes);
+			if (n <= 0)
+				break;
+			bytes += n;
+		}
+
+		const qint64 blockRowsRead = bytes/rowSize;
+		const qint64 skippedRows = qBound((qint64)0, startRow - 1 - rows, blockRowsRead);
+		const int n = (int)(blockRowsRead - skippedRows);
+		if (n > 0) {
+			for (int j = 0; j < cols; ++j) {
+				columns[j].resize(decodedRows + n);
+				dest[j] = columns[j].data() + decodedRows;
+			}
+			readRows(block.constData() + skippedRows*rowSize, n, rowSize, swap, dest.data());
+			decodedRows += n;
+		}
+		rows += blockRowsRead;
+
+		//end of file
+		if (bytes < size)
+			break;
+	}
+
+	return rows;
+}
+
+/*!
+  decodes \c rows rows of \c rowSize bytes at \c src into the arrays \c dest, one array per vector or record field.
+*/
+void BinaryFilterPrivate::readRows(const char* src, int rows, qint64 rowSize, bool swap, double* const* dest) const {
+	if (!recordFields.isEmpty()) {
+		for (int n = 0; n < recordFields.size(); ++n) {
+			const BinaryFilter::RecordField& field = recordFields.at(n);
+			BinaryRecord::readField(field.type, src + field.offset, 0, rows, rowSize, swap, dest[n]);
+		}
+		return;
+	}
+
+	switch (dataType) {
+	case BinaryFilter::INT8:
+		readVectors<qint8>(src, rows, swap, dest);
+		break;
+	case BinaryFilter::INT16:
+		readVectors<qint16>(src, rows, swap, dest);
+		break;
+	case BinaryFilter::INT32:
+		readVectors<qint32>(src, rows, swap, dest);
+		break;
+	case BinaryFilter::INT64:
+		readVectors<qint64>(src, rows, swap, dest);
+		break;
+	case BinaryFilter::UINT8:
+		readVectors<quint8>(src, rows, swap, dest);
+		break;
+	case BinaryFilter::UINT16:
+		readVectors<quint16>(src, rows, swap, dest);
+		break;
+	case BinaryFilter::UINT32:
+		readVectors<quint32>(src, rows, swap, dest);
+		break;
+	case BinaryFilter::UINT64:
+		readVectors<quint64>(src, rows, swap, dest);
+		break;
+	case BinaryFilter::REAL32:
+		readVectors<float>(src, rows, swap, dest);
+		break;
+	case BinaryFilter::REAL64:
+		readVectors<double>(src, rows, swap, dest);
+		break;
+	}
+}
+
+/*!
+  reads \c rows rows from the memory at \c src and de-interleaves the values into the arrays \c dest.
+  The values are of type \c T, \c swap specifies whether the byte order of the values has to be reversed.
+*/
+template <typename T>
+void BinaryFilterPrivate::readVectors(const char* src, int rows, bool swap, double* const* dest) const {
+	if (!swap) {
+		deinterleave<T>(src, rows, dest);
+		return;
+	}
+
+	//reverse the byte order of the whole block before the values are de-interleaved
+	QByteArray block(src, (qint64)rows*vectors*sizeof(T));
+	BinaryRecord::swapBytes(block.data(), (qint64)rows*vectors, sizeof(T));
+	deinterleave<T>(block.constData(), rows, dest);
+}
+
+template <typename T>
+void BinaryFilterPrivate::deinterleave(const char* src, int rows, double* const* dest) const {
+	//the rows are accessed sequentially
+	const char* p = src;
+	for (int i = 0; i < rows; ++i) {
+		for (int n = 0; n < vectors; ++n) {
+			T value;
+			memcpy(&value, p, sizeof(T));
+			dest[n][i] = value;
+			p += sizeof(T);
+		}
+	}
+}
 
 void BinaryFilterPrivate::read(const QString & fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode mode) {
 	readData(fileName,dataSource,mode);
@@ -415,9 +594,101 @@ void BinaryFilterPrivate::read(const QString & fileName, AbstractDataSource* dat
     writes the content of \c dataSource to the file \c fileName.
 */
 void BinaryFilterPrivate::write(const QString & fileName, AbstractDataSource* dataSource) {
-	Q_UNUSED(fileName);
-	Q_UNUSED(dataSource);
-	//TODO
+	QVector<const QVector<double>*> columns;
+	QStringList names;
+	const int rows = AbstractFileFilter::numericColumns(dataSource, columns, names);
+	const int cols = columns.size();
+	if (cols == 0)
+		return;
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly)) {
+		qDebug() << "BinaryFilter::write(): can't open the file" << fileName;
+		return;
+	}
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+	const bool swap = (byteOrder == BinaryFilter::LittleEndian);
+#else
+	const bool swap = (byteOrder == BinaryFilter::BigEndian);
+#endif
+
+	// the values of all columns are written row by row in blocks of about 4 MiB
+	const int rowSize = cols*BinaryFilter::dataSize(dataType);
+	const int blockRows = qMax(1, 4*1024*1024/rowSize);
+	QByteArray buffer;
+	for (int i = 0; i < rows; i += blockRows) {
+		const int n = qMin(blockRows, rows - i);
+		buffer.resize(n*rowSize);
+		char* dest = buffer.data();
+
+#define WRITE_VECTORS(T) \
+		writeVectors<T>(columns, i, n, dest);
+
+		switch (dataType) {
+		case BinaryFilter::INT8:
+			WRITE_VECTORS(qint8);
+			break;
+		case BinaryFilter::INT16:
+			WRITE_VECTORS(qint16);
+			break;
+		case BinaryFilter::INT32:
+			WRITE_VECTORS(qint32);
+			break;
+		case BinaryFilter::INT64:
+			WRITE_VECTORS(qint64);
+			break;
+		case BinaryFilter::UINT8:
+			WRITE_VECTORS(quint8);
+			break;
+		case BinaryFilter::UINT16:
+			WRITE_VECTORS(quint16);
+			break;
+		case BinaryFilter::UINT32:
+			WRITE_VECTORS(quint32);
+			break;
+		case BinaryFilter::UINT64:
+			WRITE_VECTORS(quint64);
+			break;
+		case BinaryFilter::REAL32:
+			WRITE_VECTORS(float);
+			break;
+		case BinaryFilter::REAL64:
+			WRITE_VECTORS(double);
+			break;
+		}
+#undef WRITE_VECTORS
+		if (swap)
+			BinaryRecord::swapBytes(dest, (qint64)n*cols, BinaryFilter::dataSize(dataType));
+
+		if (file.write(buffer) != buffer.size()) {
+			qDebug() << "BinaryFilter::write(): error writing the file" << fileName;
+			break;
+		}
+		emit q->completed(100*(i + n)/rows);
+	}
+}
+
+/*!
+  interleaves the rows \c first to \c first+rows-1 of the columns \c columns to \c dest converted to the type \c T.
+  Missing values are written as 0 for integer types.
+*/
+template <typename T>
+void BinaryFilterPrivate::writeVectors(const QVector<const QVector<double>*>& columns, int first, int rows, char* dest) const {
+	const int cols = columns.size();
+	for (int j = 0; j < cols; ++j) {
+		const QVector<double>* column = columns.at(j);
+		const int available = qBound(0, column->size() - first, rows);
+		const double* src = column->constData() + first;
+		char* p = dest + j*sizeof(T);
+
+		for (int i = 0; i < rows; ++i) {
+			const double v = (i < available) ? src[i] : NAN;
+			const T value = (std::numeric_limits<T>::is_integer && v != v) ? T(0) : static_cast<T>(v);
+			memcpy(p, &value, sizeof(T));
+			p += cols*sizeof(T);
+		}
+	}
 }
 
 //##############################################################################
@@ -437,6 +708,11 @@ void BinaryFilter::save(QXmlStreamWriter* writer) const {
 	writer->writeAttribute("endRow", QString::number(d->endRow) );
 	writer->writeAttribute("skipStartBytes", QString::number(d->skipStartBytes) );
 	writer->writeAttribute("skipBytes", QString::number(d->skipBytes) );
+	if (!d->recordFields.isEmpty()) {
+		writer->writeAttribute("recordFields", BinaryRecord::fieldsToString(d->recordFields));
+		writer->writeAttribute("recordSize", QString::number(d->recordSize) );
+	}
+	saveSamplingAttributes(writer);
 	writer->writeEndElement();
 }
 
@@ -451,6 +727,7 @@ bool BinaryFilter::load(XmlStreamReader* reader) {
 
 	QString attributeWarning = i18n("Attribute '%1' missing or empty, default value is used");
 	QXmlStreamAttributes attribs = reader->attributes();
+	loadSamplingAttributes(attribs);
 
 	// read attributes
 	QString str = attribs.value("vectors").toString();
@@ -501,5 +778,10 @@ bool BinaryFilter::load(XmlStreamReader* reader) {
 	else
 		d->skipBytes = str.toInt();
 
+	//structured records are optional
+	d->recordFields = BinaryRecord::fieldsFromString(attribs.value("recordFields").toString());
+	if (!d->recordFields.isEmpty())
+		d->recordSize = attribs.value("recordSize").toString().toInt();
+
 	return true;
 }
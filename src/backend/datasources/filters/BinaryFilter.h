@@ -38,6 +38,15 @@ class BinaryFilter : public AbstractFileFilter{
 	enum DataType{INT8,INT16,INT32,INT64,UINT8,UINT16,UINT32,UINT64,REAL32,REAL64};
 	enum ByteOrder{LittleEndian, BigEndian};
 
+	// field of a structured record, imported into a separate column
+	struct RecordField {
+		RecordField() : type(REAL64), offset(0) {}
+		RecordField(DataType t, int o, const QString& n = QString()) : type(t), offset(o), name(n) {}
+		DataType type;
+		int offset;	// offset of the field in the record in bytes
+		QString name;
+	};
+
 	BinaryFilter();
 	~BinaryFilter();
 
@@ -73,6 +82,11 @@ class BinaryFilter : public AbstractFileFilter{
 	void setSkipBytes(const int);
 	int skipBytes() const;
 
+	void setRecordFields(const QList<BinaryFilter::RecordField>&);
+	QList<BinaryFilter::RecordField> recordFields() const;
+	void setRecordSize(const int);
+	int recordSize() const;
+
 	void setAutoModeEnabled(const bool);
 	bool isAutoModeEnabled() const;
 
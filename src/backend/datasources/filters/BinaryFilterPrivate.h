@@ -28,6 +28,7 @@ Copyright            : (C) 2015 Stefan Gerlach (stefan.gerlach@uni.kn)
 #define BINARYFILTERPRIVATE_H
 
 class AbstractDataSource;
+class QIODevice;
 
 class BinaryFilterPrivate {
 
@@ -49,10 +50,21 @@ class BinaryFilterPrivate {
 		int endRow;		// end row to (value*vectors) read
 		int skipBytes;		// bytes to skip after each value
 
+		QList<BinaryFilter::RecordField> recordFields;	// layout of structured records, vectors and dataType are not used if not empty
+		int recordSize;		// size of a record in bytes, the packed size of recordFields is used if 0
+
 		bool autoModeEnabled;
 
 	private:
 		void clearDataSource(AbstractDataSource*) const;
+		qint64 streamRows(QIODevice*, qint64 rowSize, qint64 lastRow, bool swap, QVector<QVector<double> >& columns) const;
+		void readRows(const char* src, int rows, qint64 rowSize, bool swap, double* const* dest) const;
+		template <typename T>
+		void readVectors(const char* src, int rows, bool swap, double* const* dest) const;
+		template <typename T>
+		void deinterleave(const char* src, int rows, double* const* dest) const;
+		template <typename T>
+		void writeVectors(const QVector<const QVector<double>*>& columns, int first, int rows, char* dest) const;
 };
 
 #endif
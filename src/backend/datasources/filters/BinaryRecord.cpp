@@ -0,0 +1,201 @@
+/***************************************************************************
+File                 : BinaryRecord.cpp
+Project              : LabPlot
+Description          : Fields of structured records in binary files
+--------------------------------------------------------------------
+Copyright            : (C) 2017 by the LabPlot developers
+***************************************************************************/
+
+/***************************************************************************
+*                                                                         *
+*  This program is free software; you can redistribute it and/or modify   *
+*  it under the terms of the GNU General Public License as published by   *
+*  the Free Software Foundation; either version 2 of the License, or      *
+*  (at your option) any later version.                                    *
+*                                                                         *
+*  This program is distributed in the hope that it will be useful,        *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+*  GNU General Public License for more details.                           *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program; if not, write to the Free Software           *
+*   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+*   Boston, MA  02110-1301  USA                                           *
+*                                                                         *
+***************************************************************************/
+#include "BinaryRecord.h"
+#include <QStringList>
+#include <QVarLengthArray>
+#include <QtEndian>
+#include <cstring>
+
+/*!
+\class BinaryRecord
+\brief Extraction and serialization of the fields of structured records in binary files.
+
+A record consists of fields of different data types at fixed offsets, the records follow each other
+with a constant stride. Each field is imported into a separate column.
+
+\ingroup datasources
+*/
+
+/*!
+  reads the field of type \c type of \c rows records starting at record \c first to \c dest.
+  \c src points to the field in the first record, \c stride is the size of a record in bytes.
+*/
+void BinaryRecord::readField(BinaryFilter::DataType type, const char* src, int first, int rows, qint64 stride, bool swap, double* dest) {
+#define READ_FIELD(T) \
+	if (swap) \
+		readField<T, true>(src, first, rows, stride, dest); \
+	else \
+		readField<T, false>(src, first, rows, stride, dest);
+
+	switch (type) {
+	case BinaryFilter::INT8:
+		READ_FIELD(qint8);
+		break;
+	case BinaryFilter::INT16:
+		READ_FIELD(qint16);
+		break;
+	case BinaryFilter::INT32:
+		READ_FIELD(qint32);
+		break;
+	case BinaryFilter::INT64:
+		READ_FIELD(qint64);
+		break;
+	case BinaryFilter::UINT8:
+		READ_FIELD(quint8);
+		break;
+	case BinaryFilter::UINT16:
+		READ_FIELD(quint16);
+		break;
+	case BinaryFilter::UINT32:
+		READ_FIELD(quint32);
+		break;
+	case BinaryFilter::UINT64:
+		READ_FIELD(quint64);
+		break;
+	case BinaryFilter::REAL32:
+		READ_FIELD(float);
+		break;
+	case BinaryFilter::REAL64:
+		READ_FIELD(double);
+		break;
+	}
+#undef READ_FIELD
+}
+
+template <typename T, bool swap>
+void BinaryRecord::readField(const char* src, int first, int rows, qint64 stride, double* dest) {
+	const char* p = src + first*stride;
+	dest += first;
+
+	if (!swap) {
+		for (int i = 0; i < rows; ++i) {
+			T value;
+			memcpy(&value, p, sizeof(T));
+			dest[i] = value;
+			p += stride;
+		}
+		return;
+	}
+
+	//gather the field of all records, the byte order of the whole block is reversed at once
+	QVarLengthArray<T, 1024> block(rows);
+	for (int i = 0; i < rows; ++i) {
+		memcpy(block.data() + i, p, sizeof(T));
+		p += stride;
+	}
+	swapBytes((char*)block.data(), rows, sizeof(T));
+	for (int i = 0; i < rows; ++i)
+		dest[i] = block[i];
+}
+
+/*!
+  reverses the byte order of \c count consecutive values of \c size bytes at \c data.
+*/
+void BinaryRecord::swapBytes(char* data, qint64 count, int size) {
+	switch (size) {
+	case 2:
+		swapBlock<quint16>(data, count);
+		break;
+	case 4:
+		swapBlock<quint32>(data, count);
+		break;
+	case 8:
+		swapBlock<quint64>(data, count);
+		break;
+	}
+}
+
+template <typename T>
+void BinaryRecord::swapBlock(char* data, qint64 count) {
+	for (qint64 i = 0; i < count; ++i) {
+		T value;
+		memcpy(&value, data + i*sizeof(T), sizeof(T));
+		value = qbswap(value);
+		memcpy(data + i*sizeof(T), &value, sizeof(T));
+	}
+}
+
+/*!
+  returns the layout \c fields as a list of \c type:offset:name separated by \c ;.
+  The characters \c :, \c ; and \c % in the names are escaped.
+*/
+QString BinaryRecord::fieldsToString(const QList<BinaryFilter::RecordField>& fields) {
+	QStringList list;
+	foreach (const BinaryFilter::RecordField& field, fields)
+		list << QString::number(field.type) + ':' + QString::number(field.offset) + ':' + escapeName(field.name);
+
+	return list.join(";");
+}
+
+/*!
+  parses a layout created with fieldsToString(). Invalid fields are skipped.
+*/
+QList<BinaryFilter::RecordField> BinaryRecord::fieldsFromString(const QString& str) {
+	QList<BinaryFilter::RecordField> fields;
+	foreach (const QString& fieldString, str.split(';', QString::SkipEmptyParts)) {
+		const QStringList parts = fieldString.split(':');
+		if (parts.size() < 2)
+			continue;
+
+		bool typeOk, offsetOk;
+		const int type = parts.at(0).toInt(&typeOk);
+		const int offset = parts.at(1).toInt(&offsetOk);
+		if (!typeOk || !offsetOk || type < BinaryFilter::INT8 || type > BinaryFilter::REAL64)
+			continue;
+
+		//names of older projects were written unescaped
+		fields << BinaryFilter::RecordField((BinaryFilter::DataType)type, offset, unescapeName(parts.mid(2).join(":")));
+	}
+
+	return fields;
+}
+
+QString BinaryRecord::escapeName(const QString& name) {
+	QString str = name;
+	str.replace('%', "%25");
+	str.replace(':', "%3A");
+	str.replace(';', "%3B");
+	return str;
+}
+
+QString BinaryRecord::unescapeName(const QString& str) {
+	QString name;
+	for (int i = 0; i < str.size(); ++i) {
+		if (str.at(i) == '%' && i + 2 < str.size()) {
+			bool ok;
+			const ushort c = str.mid(i + 1, 2).toUShort(&ok, 16);
+			if (ok) {
+				name += QChar(c);
+				i += 2;
+				continue;
+			}
+		}
+		name += str.at(i);
+	}
+
+	return name;
+}
@@ -0,0 +1,50 @@
+/***************************************************************************
+    File                 : BinaryRecord.h
+    Project              : LabPlot
+    Description          : Fields of structured records in binary files
+    --------------------------------------------------------------------
+    Copyright            : (C) 2017 by the LabPlot developers
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef BINARYRECORD_H
+#define BINARYRECORD_H
+
+#include "backend/datasources/filters/BinaryFilter.h"
+
+class BinaryRecord {
+	public:
+		static void readField(BinaryFilter::DataType, const char* src, int first, int rows, qint64 stride, bool swap, double* dest);
+		static void swapBytes(char* data, qint64 count, int size);
+
+		static QString fieldsToString(const QList<BinaryFilter::RecordField>&);
+		static QList<BinaryFilter::RecordField> fieldsFromString(const QString&);
+
+	private:
+		template <typename T, bool swap>
+		static void readField(const char* src, int first, int rows, qint64 stride, double* dest);
+		template <typename T>
+		static void swapBlock(char* data, qint64 count);
+		static QString escapeName(const QString&);
+		static QString unescapeName(const QString&);
+};
+
+#endif
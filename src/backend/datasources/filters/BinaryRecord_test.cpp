@@ -0,0 +1,152 @@
+/***************************************************************************
+    File                 : BinaryRecord_test.cpp
+    Project              : LabPlot
+    Description          : Tests of the extraction of record fields
+    --------------------------------------------------------------------
+    Copyright            : (C) 2017 by the LabPlot developers
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "BinaryRecord.h"
+
+/* record of the test file: int16 at 0, padding, double at 8, uint32 at 16, padding to 24 bytes */
+static const int recordSize = 24;
+static const int records = 5;
+
+/* writes the value v with sizeof(T) bytes to p, in reversed byte order if swap is set */
+template <typename T>
+static void put(char* p, T v, bool swap) {
+	char bytes[sizeof(T)];
+	memcpy(bytes, &v, sizeof(T));
+	for (unsigned int j = 0; j < sizeof(T); ++j)
+		p[j] = swap ? bytes[sizeof(T) - 1 - j] : bytes[j];
+}
+
+static void createRecords(char* data, bool swap) {
+	memset(data, 0x55, records*recordSize);
+	for (int i = 0; i < records; ++i) {
+		char* record = data + i*recordSize;
+		put<qint16>(record, -100*i, swap);
+		put<double>(record + 8, 0.25 + i, swap);
+		put<quint32>(record + 16, 4000000000u + i, swap);
+	}
+}
+
+static int check(const char* name, const double* v, const double* expected, int n) {
+	printf("%s:", name);
+	int failed = 0;
+	for (int i = 0; i < n; ++i) {
+		printf(" %.10g", v[i]);
+		failed |= (v[i] != expected[i]);
+	}
+
+	printf(failed ? "\tFAILED\n" : "\tOK\n");
+	return failed;
+}
+
+static int checkFields(bool swap) {
+	char data[records*recordSize];
+	createRecords(data, swap);
+
+	int failed = 0;
+	double v[records];
+	BinaryRecord::readField(BinaryFilter::INT16, data, 0, records, recordSize, swap, v);
+	const double int16Values[] = {0, -100, -200, -300, -400};
+	failed += check(swap ? "int16 field (swapped)" : "int16 field", v, int16Values, records);
+
+	BinaryRecord::readField(BinaryFilter::REAL64, data + 8, 0, records, recordSize, swap, v);
+	const double doubleValues[] = {0.25, 1.25, 2.25, 3.25, 4.25};
+	failed += check(swap ? "real64 field (swapped)" : "real64 field", v, doubleValues, records);
+
+	//the rows starting at the second record are written starting at v[1]
+	v[0] = -1;
+	BinaryRecord::readField(BinaryFilter::UINT32, data + 16, 1, records - 1, recordSize, swap, v);
+	const double uint32Values[] = {-1, 4000000001., 4000000002., 4000000003., 4000000004.};
+	failed += check(swap ? "uint32 field from 2nd record (swapped)" : "uint32 field from 2nd record", v, uint32Values, records);
+
+	return failed;
+}
+
+static int checkSwap() {
+	//a block of values in reversed byte order is restored by swapping it
+	const int count = 7;
+	char data[count*sizeof(double)];
+	for (int i = 0; i < count; ++i)
+		put<double>(data + i*sizeof(double), 1.5*i - 2, true);
+	BinaryRecord::swapBytes(data, count, sizeof(double));
+
+	double v[count], expected[count];
+	memcpy(v, data, sizeof(v));
+	for (int i = 0; i < count; ++i)
+		expected[i] = 1.5*i - 2;
+	int failed = check("real64 block (swapped)", v, expected, count);
+
+	char data16[count*sizeof(qint16)];
+	for (int i = 0; i < count; ++i)
+		put<qint16>(data16 + i*sizeof(qint16), -300*i, true);
+	BinaryRecord::swapBytes(data16, count, sizeof(qint16));
+	for (int i = 0; i < count; ++i) {
+		qint16 value;
+		memcpy(&value, data16 + i*sizeof(qint16), sizeof(qint16));
+		v[i] = value;
+		expected[i] = -300*i;
+	}
+	failed += check("int16 block (swapped)", v, expected, count);
+
+	return failed;
+}
+
+static int checkLayout() {
+	QList<BinaryFilter::RecordField> fields;
+	fields << BinaryFilter::RecordField(BinaryFilter::INT16, 0, "x")
+		<< BinaryFilter::RecordField(BinaryFilter::REAL64, 8, "a:b;c 100%")
+		<< BinaryFilter::RecordField(BinaryFilter::UINT32, 16);
+
+	const QString str = BinaryRecord::fieldsToString(fields);
+	const QList<BinaryFilter::RecordField> fields2 = BinaryRecord::fieldsFromString(str);
+	int failed = (fields2.size() != fields.size());
+	for (int i = 0; i < fields.size() && !failed; ++i)
+		failed = (fields2.at(i).type != fields.at(i).type || fields2.at(i).offset != fields.at(i).offset
+				|| fields2.at(i).name != fields.at(i).name);
+	printf("layout \"%s\"\t%s\n", str.toLatin1().constData(), failed ? "FAILED" : "OK");
+
+	//unescaped names of older projects and invalid fields
+	const QList<BinaryFilter::RecordField> old = BinaryRecord::fieldsFromString("9:8:time:s;x:0:invalid;1:2:y");
+	const int oldFailed = (old.size() != 2 || old.at(0).name != "time:s" || old.at(1).type != BinaryFilter::INT16
+				|| old.at(1).offset != 2 || old.at(1).name != "y");
+	printf("layout of older projects\t%s\n", oldFailed ? "FAILED" : "OK");
+
+	return failed + oldFailed;
+}
+
+int main() {
+	int failed = 0;
+	failed += checkFields(false);
+	failed += checkFields(true);
+	failed += checkSwap();
+	failed += checkLayout();
+
+	printf("%d test(s) failed\n", failed);
+	return failed;
+}
@@ -27,6 +27,7 @@ Copyright            : (C) 2016 by Fabian Kristof (fkristofszabolcs@gmail.com)
 
 #include "FITSFilter.h"
 #include "FITSFilterPrivate.h"
+#include "backend/datasources/filters/RowSampler.h"
 #include "backend/datasources/FileDataSource.h"
 #include "backend/core/column/Column.h"
 #include "backend/core/datatypes/Double2StringFilter.h"
@@ -39,6 +40,8 @@ Copyright            : (C) 2016 by Fabian Kristof (fkristofszabolcs@gmail.com)
 #include <QHeaderView>
 #include <QTableWidgetItem>
 #include <QFile>
+#include <QThread>
+#include <QtConcurrentRun>
 #include <KIcon>
 
 /*! \class FITSFilter
@@ -305,10 +308,8 @@ QList<QStringList> FITSFilterPrivate::readCHDU(const QString &fileName, Abstract
 		int bitpix;
 		int naxis;
 		int maxdim = 2;
-		long naxes[2];
+		long naxes[2] = {1, 1};
 
-		long pixelCount;
-		double* data;
 		if (fits_get_img_param(fitsFile, maxdim,&bitpix, &naxis, naxes, &status)) {
 			printError(status);
 			return dataStrings << (QStringList() << QString());
@@ -326,64 +327,110 @@ QList<QStringList> FITSFilterPrivate::readCHDU(const QString &fileName, Abstract
 				lines = actualRows;
 		}
 
-		pixelCount = lines * actualCols;
-		data = new double[pixelCount];
-
-		if (!data) {
-			qDebug() << i18n("Not enough memory for data");
-			return dataStrings << (QStringList() << QString());
-		}
-
-		if (fits_read_img(fitsFile, TDOUBLE, 1, pixelCount, NULL, data, NULL, &status)) {
-			printError(status);
-			return dataStrings << (QStringList() << QString("Error"));
-		}
-
-		QVector<QVector<double>*> dataPointers;
-
 		if (endRow != -1) {
 			if (!noDataSource)
-				lines = endRow;
+				lines = qMin((long)endRow, actualRows);
 		}
 		if (endColumn != -1)
-			actualCols = endColumn;
-		if (noDataSource)
-			dataStrings.reserve(lines);
-
-		int i = 0;
-		int j = 0;
-		if (startRow != 1)
-			i = startRow;
-		if (startColumn != 1)
-			j = startColumn;
-
-		const int jstart = j;
+			actualCols = qMin((long)endColumn, naxes[0]);
+
+		//only the section [firstRow, lines] x [firstColumn, lastColumn] of the image is read
+		const long firstRow = qMax(startRow, 1);
+		const long firstColumn = qMax(startColumn, 1);
+		const long lastColumn = actualCols;
+		const long rows = lines - firstRow + 1;
+		actualCols = lastColumn - firstColumn + 1;
+		if (rows <= 0 || actualCols <= 0) {
+			fits_close_file(fitsFile, &status);
+			return dataStrings;
+		}
 
+		QVector<QVector<double>*> dataPointers;
+		RowSampler sampler(q, rows);
 		if (!noDataSource) {
-			dataPointers.reserve(actualCols - j);
-			columnOffset = dataSource->create(dataPointers, importMode, lines - i, actualCols - j);
+			dataPointers.reserve(actualCols);
+			columnOffset = dataSource->create(dataPointers, importMode, sampler.rows(), actualCols);
 		}
-		int ii = 0;
-		for (; i < lines; ++i) {
-			int jj = 0;
-			QStringList line;
-			line.reserve(actualCols);
-			for (; j < actualCols; ++j) {
-				if (noDataSource)
-					line << QString::number(data[i*naxes[0] +j]);
-				else
-					dataPointers[jj++]->operator [](ii) = data[i* naxes[0] + j];
+
+		int compressedStatus = 0;
+		if (noDataSource) {
+			dataStrings.reserve(rows);
+			double* data = new double[rows * actualCols];
+			if (readImageRows(fitsFile, firstRow, lines, firstColumn, lastColumn, 1, data, &status))
+				printError(status);
+			for (long i = 0; i < rows; ++i) {
+				QStringList line;
+				line.reserve(actualCols);
+				for (int j = 0; j < actualCols; ++j)
+					line << QString::number(data[i*actualCols + j]);
+				dataStrings << line;
 			}
-			dataStrings << line;
-			j = jstart;
-			ii++;
-		}
+			delete[] data;
+		} else if (!sampler.isActive() && fits_is_reentrant() && QThread::idealThreadCount() > 1
+				&& fits_is_compressed_image(fitsFile, &compressedStatus)) {
+			//tile compressed image: the sections of the image are decompressed in parallel,
+			//each with its own handle of the file. The sections start at the tile boundaries.
+			long tileRows = 1;
+			int keyStatus = 0;
+			fits_read_key(fitsFile, TLONG, "ZTILE2", &tileRows, NULL, &keyStatus);
+			tileRows = qMax(tileRows, 1L);
+
+			const int sections = QThread::idealThreadCount();
+			long sectionRows = (rows + sections - 1) / sections;
+			sectionRows = ((sectionRows + tileRows - 1) / tileRows) * tileRows;
+			DEBUG("FITS compressed image: tile rows =" << tileRows << "section rows =" << sectionRows);
+
+			QList<QFuture<bool> > futures;
+			for (long row = 0; row < rows; row += sectionRows) {
+				ImageSection section;
+				section.firstRow = firstRow + row;
+				section.lastRow = qMin(row + sectionRows, rows) + firstRow - 1;
+				section.firstColumn = firstColumn;
+				section.lastColumn = lastColumn;
+				section.outputRow = row;
+				futures << QtConcurrent::run(readImageSection, fileName, section, dataPointers);
+			}
+			for (int i = 0; i < futures.size(); ++i) {
+				if (!futures[i].result())
+					qDebug() << i18n("Error reading the section %1 of the image", i + 1);
+				emit q->completed(100 * (i + 1) / futures.size());
+			}
+		} else {
+			//the image is read in blocks of rows directly to the columns.
+			//If every k-th row is imported, only these rows are read.
+			const bool strided = sampler.isActive() && q->samplingMode() == AbstractFileFilter::EveryKthRow;
+			const bool direct = !sampler.isActive() || strided;
+			const long step = strided ? q->samplingFactor() : 1;
+			const long outputRows = direct ? sampler.rows() : rows;
+			const long blockSize = qMin(imageBlockRows(actualCols), outputRows);
+			double* data = new double[blockSize * actualCols];
+
+			for (long row = 0; row < outputRows; row += blockSize) {
+				const long n = qMin(blockSize, outputRows - row);
+				const long first = firstRow + row * step;
+				if (readImageRows(fitsFile, first, first + (n - 1) * step, firstColumn, lastColumn, step, data, &status)) {
+					printError(status);
+					break;
+				}
 
-		delete[] data;
+				if (direct)
+					copyImageRows(data, n, actualCols, dataPointers, row);
+				else {
+					for (long i = 0; i < n; ++i) {
+						if (!sampler.nextRow())
+							continue;
+						for (int j = 0; j < actualCols; ++j)
+							sampler.setValue(dataPointers[j], data[i*actualCols + j]);
+					}
+				}
+				emit q->completed(100 * (row + n) / outputRows);
+			}
+			delete[] data;
+		}
 
 		Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
 		if (spreadsheet) {
-			const QString& comment = i18np("numerical data, %1 element", "numerical data, %1 elements", actualRows);
+			const QString& comment = i18np("numerical data, %1 element", "numerical data, %1 elements", sampler.rows());
 			for (int n = 0; n < actualCols; n++) {
 				Column* column = spreadsheet->column(columnOffset + n);
 				column->setComment(comment);
@@ -473,6 +520,7 @@ QList<QStringList> FITSFilterPrivate::readCHDU(const QString &fileName, Abstract
 			if (startColumn != 0)
 				c = startColumn;
 		}
+		const int firstTableCol = c;
 		QList<int> matrixNumericColumnIndices;
 		for (; c <= actualCols; ++c) {
 			fits_get_coltype(fitsFile, c, &datatype, NULL, NULL, &status);
@@ -515,6 +563,14 @@ QList<QStringList> FITSFilterPrivate::readCHDU(const QString &fileName, Abstract
 
 		if (noDataSource)
 			*okToMatrix = matrixNumericColumnIndices.isEmpty() ? false : true;
+
+		//the values of the table are appended row by row, the envelope is not available for tables
+		//since it requires the minimum and maximum of the text columns, every k-th row is used instead
+		AbstractFileFilter::SamplingMode samplingMode = q->samplingMode();
+		if (samplingMode == AbstractFileFilter::MinMaxEnvelope)
+			samplingMode = AbstractFileFilter::EveryKthRow;
+		RowSampler sampler(samplingMode, q->samplingFactor(), lines - qMax(startRow, 1) + 1);
+
 		if (!noDataSource) {
 			Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
 			if(spreadsheet) {
@@ -526,10 +582,10 @@ QList<QStringList> FITSFilterPrivate::readCHDU(const QString &fileName, Abstract
 
 				if (importMode == AbstractFileFilter::Replace) {
 					spreadsheet->clear();
-					spreadsheet->setRowCount(lines - startRrow);
+					spreadsheet->setRowCount(sampler.rows());
 				} else {
-					if (spreadsheet->rowCount() < (lines - startRrow))
-						spreadsheet->setRowCount(lines - startRrow);
+					if (spreadsheet->rowCount() < sampler.rows())
+						spreadsheet->setRowCount(sampler.rows());
 				}
 				for (int n = 0; n < actualCols - startCol; n++) {
 					if (columnNumericTypes.at(n)) {
@@ -549,12 +605,11 @@ QList<QStringList> FITSFilterPrivate::readCHDU(const QString &fileName, Abstract
 				stringDataPointers.squeeze();
 			} else {
 				numericDataPointers.reserve(matrixNumericColumnIndices.size());
-				columnOffset = dataSource->create(numericDataPointers, importMode, lines - startRrow, matrixNumericColumnIndices.size());
+				columnOffset = dataSource->create(numericDataPointers, importMode, sampler.rows(), matrixNumericColumnIndices.size());
 			}
 			numericDataPointers.squeeze();
 		}
 
-		char* array = new char[1000];	//TODO: why 1000?
 		int row = 1;
 		if (startRow != 1) {
 			if (startRow != 0)
@@ -570,42 +625,19 @@ QList<QStringList> FITSFilterPrivate::readCHDU(const QString &fileName, Abstract
 		if (dynamic_cast<Matrix*>(dataSource)) {
 			coll = matrixNumericColumnIndices.first();
 			actualCols = matrixNumericColumnIndices.last();
-			if (importMode == AbstractFileFilter::Replace) {
-				for (int i = 0; i < numericDataPointers.size(); ++i)
-					numericDataPointers[i]->clear();
-			}
 			isMatrix = true;
 		}
 
-		for (; row <= lines; ++row) {
-			int numericixd = 0;
-			int stringidx = 0;
-			QStringList line;
-			line.reserve(actualCols-coll);
-			for (int col = coll; col <= actualCols; ++col) {
-				if (isMatrix) {
-					if (!matrixNumericColumnIndices.contains(col))
-						continue;
-				}
-				if(fits_read_col_str(fitsFile, col, row, 1, 1, NULL, &array, NULL, &status)) {
-					printError(status);
-				}
-				if (!noDataSource) {
-					const QString& str = QString::fromLatin1(array);
-					if (str.isEmpty()) {
-						if (columnNumericTypes.at(col-1))
-							numericDataPointers[numericixd++]->push_back(0);
-						else
-							stringDataPointers[stringidx++]->append(QLatin1String("NULL"));
-					} else {
-						if (columnNumericTypes.at(col-1))
-							numericDataPointers[numericixd++]->push_back(str.toDouble());
-						else {
-							if (!stringDataPointers.isEmpty())
-								stringDataPointers[stringidx++]->operator <<( str.simplified());
-						}
+		if (noDataSource) {
+			//preview: the first rows are read cell by cell
+			char* array = new char[1000];	//TODO: why 1000?
+			for (; row <= lines; ++row) {
+				QStringList line;
+				line.reserve(actualCols-coll);
+				for (int col = coll; col <= actualCols; ++col) {
+					if(fits_read_col_str(fitsFile, col, row, 1, 1, NULL, &array, NULL, &status)) {
+						printError(status);
 					}
-				} else {
 					QString tmpColstr = QString::fromLatin1(array);
 					tmpColstr = tmpColstr.simplified();
 					if (tmpColstr.isEmpty())
@@ -613,11 +645,94 @@ QList<QStringList> FITSFilterPrivate::readCHDU(const QString &fileName, Abstract
 					else
 						line << tmpColstr;
 				}
+				dataStrings << line;
+			}
+			delete[] array;
+		} else {
+			//the table is read column by column in blocks of the optimal number of rows.
+			//Numeric scalar columns are read as doubles, CFITSIO applies TZERO and TSCALE,
+			//the other columns are read block-wise as strings.
+			QVector<int> tableColumns;
+			QVector<int> bulkTypes;		//data type of the numeric scalar columns, 0 for the columns read as strings
+			QVector<long> widths;		//number of elements (vector columns) or the display width (string columns)
+			QVector<QVector<double>*> numericTargets;
+			QVector<QStringList*> stringTargets;
+			int numericidx = 0;
+			int stringidx = 0;
+			for (int col = coll; col <= actualCols; ++col) {
+				if (isMatrix && !matrixNumericColumnIndices.contains(col))
+					continue;
+
+				int typecode;
+				long repeat;
+				fits_get_eqcoltype(fitsFile, col, &typecode, &repeat, NULL, &status);
+				int width;
+				fits_get_col_display_width(fitsFile, col, &width, &status);
+				tableColumns << col;
+				bulkTypes << (repeat == 1 && isBulkType(typecode) ? typecode : 0);
+				widths << (typecode != TSTRING && repeat > 1 ? -repeat : width);
+
+				if (isMatrix || columnNumericTypes.at(col - firstTableCol)) {
+					QVector<double>* datap = numericDataPointers[numericidx++];
+					datap->resize(sampler.rows());
+					numericTargets << datap;
+					stringTargets << 0;
+				} else {
+					QStringList* list = stringDataPointers[stringidx++];
+					list->clear();
+					list->reserve(sampler.rows());
+					numericTargets << 0;
+					stringTargets << list;
+				}
 			}
-			dataStrings << line;
-		}
 
-		delete[] array;
+			long blockSize = 0;
+			fits_get_rowsize(fitsFile, &blockSize, &status);
+			blockSize = qMax(blockSize, 1L);
+			DEBUG("FITS table block size =" << blockSize << "rows");
+
+			const int totalRows = lines - row + 1;
+			QVector<QVector<double> > numericBlocks(tableColumns.size());
+			QVector<QStringList> stringBlocks(tableColumns.size());
+			int outputRow = 0;
+			for (; row <= lines; row += blockSize) {
+				const long rows = qMin(blockSize, (long)(lines - row + 1));
+
+				for (int k = 0; k < tableColumns.size(); ++k) {
+					if (bulkTypes.at(k)) {
+						numericBlocks[k].resize(rows);
+						readColumnBlock(tableColumns.at(k), row, rows, numericBlocks[k].data(), &status);
+					} else
+						stringBlocks[k] = readColumnStrings(tableColumns.at(k), widths.at(k), row, rows, &status);
+				}
+
+				for (long i = 0; i < rows; ++i) {
+					//rows not contained in the sample are skipped
+					if (!sampler.nextRow())
+						continue;
+
+					for (int k = 0; k < tableColumns.size(); ++k) {
+						if (bulkTypes.at(k)) {
+							numericTargets[k]->operator[](outputRow) = numericBlocks.at(k).at(i);
+							continue;
+						}
+
+						const QString& str = stringBlocks.at(k).at(i);
+						if (numericTargets.at(k))
+							numericTargets[k]->operator[](outputRow) = str.isEmpty() ? 0 : str.toDouble();
+						else
+							stringTargets[k]->append(str.isEmpty() ? QLatin1String("NULL") : str.simplified());
+					}
+					++outputRow;
+				}
+
+				if (status) {
+					printError(status);
+					status = 0;
+				}
+				emit q->completed(100 * (row + rows - qMax(startRow, 1)) / totalRows);
+			}
+		}
 
 		if (!noDataSource) {
 			Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
@@ -659,6 +774,135 @@ QList<QStringList> FITSFilterPrivate::readCHDU(const QString &fileName, Abstract
 	return dataStrings;
 }
 
+#ifdef HAVE_FITS
+/*!
+ * \brief Returns the number of image rows with \a columns pixels to be read at once (about 4 MiB)
+ */
+long FITSFilterPrivate::imageBlockRows(long columns) {
+	return qMax(1L, 4 * 1024 * 1024 / (long)(qMax(columns, 1L) * sizeof(double)));
+}
+
+/*!
+ * \brief Reads the pixels of every \a rowStep-th row from \a firstRow to \a lastRow and of the columns
+ * \a firstColumn to \a lastColumn of the current image HDU of \a file row by row to \a data
+ * \return true on error
+ */
+bool FITSFilterPrivate::readImageRows(fitsfile* file, long firstRow, long lastRow, long firstColumn, long lastColumn,
+		long rowStep, double* data, int* status) {
+	long fpixel[2] = {firstColumn, firstRow};
+	long lpixel[2] = {lastColumn, lastRow};
+	long inc[2] = {1, rowStep};
+	return fits_read_subset(file, TDOUBLE, fpixel, lpixel, inc, NULL, data, NULL, status);
+}
+
+/*!
+ * \brief Copies \a rows rows with \a columns pixels in \a data to the columns \a dataPointers starting at the row \a outputRow
+ */
+void FITSFilterPrivate::copyImageRows(const double* data, long rows, long columns, const QVector<QVector<double>*>& dataPointers, long outputRow) {
+	for (long j = 0; j < columns; ++j) {
+		double* dest = dataPointers[j]->data() + outputRow;
+		const double* src = data + j;
+		for (long i = 0; i < rows; ++i, src += columns)
+			dest[i] = *src;
+	}
+}
+
+/*!
+ * \brief Reads the section \a section of the image in \a fileName to the columns \a dataPointers.
+ * Opens its own handle of the file and can be called in a worker thread.
+ * \return false on error
+ */
+bool FITSFilterPrivate::readImageSection(const QString& fileName, const ImageSection& section, QVector<QVector<double>*> dataPointers) {
+	const long firstRow = section.firstRow;
+	const long lastRow = section.lastRow;
+	const long firstColumn = section.firstColumn;
+	const long lastColumn = section.lastColumn;
+	const long outputRow = section.outputRow;
+
+	int status = 0;
+	fitsfile* file;
+	if (fits_open_file(&file, fileName.toLatin1(), READONLY, &status))
+		return false;
+
+	const long columns = lastColumn - firstColumn + 1;
+	const long blockSize = imageBlockRows(columns);
+	double* data = new double[qMin(blockSize, lastRow - firstRow + 1) * columns];
+	for (long row = firstRow; row <= lastRow && !status; row += blockSize) {
+		const long last = qMin(row + blockSize - 1, lastRow);
+		if (!readImageRows(file, row, last, firstColumn, lastColumn, 1, data, &status))
+			copyImageRows(data, last - row + 1, columns, dataPointers, outputRow + row - firstRow);
+	}
+	delete[] data;
+
+	const bool ok = (status == 0);
+	status = 0;
+	fits_close_file(file, &status);
+	return ok;
+}
+
+/*!
+ * \brief Returns whether the table columns of the equivalent type \a typecode are read as doubles
+ */
+bool FITSFilterPrivate::isBulkType(int typecode) {
+	switch (typecode) {
+	case TBYTE:
+	case TSBYTE:
+	case TSHORT:
+	case TUSHORT:
+	case TINT:
+	case TUINT:
+	case TLONG:
+	case TULONG:
+	case TLONGLONG:
+	case TFLOAT:
+	case TDOUBLE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*!
+ * \brief Reads \a rows values of the scalar numeric column \a col starting at the row \a firstRow to \a dest.
+ * The values are read as doubles, CFITSIO converts them and applies the scaling (TZERO, TSCALE) of the column.
+ */
+void FITSFilterPrivate::readColumnBlock(int col, long firstRow, long rows, double* dest, int* status) {
+	fits_read_col(fitsFile, TDOUBLE, col, firstRow, 1, rows, NULL, dest, NULL, status);
+}
+
+/*!
+ * \brief Reads \a rows values of the column \a col starting at the row \a firstRow as strings
+ * \param width the display width of the column, or the negative number of elements for numeric vector columns
+ * of which only the first element is read
+ */
+QStringList FITSFilterPrivate::readColumnStrings(int col, long width, long firstRow, long rows, int* status) {
+	QStringList strings;
+	strings.reserve(rows);
+
+	if (width < 0) {
+		char* array = new char[FLEN_VALUE];
+		for (long i = 0; i < rows; ++i) {
+			fits_read_col_str(fitsFile, col, firstRow + i, 1, 1, NULL, &array, NULL, status);
+			strings << QString::fromLatin1(array);
+		}
+		delete[] array;
+		return strings;
+	}
+
+	char* data = new char[rows * (width + 1)];
+	char** array = new char*[rows];
+	for (long i = 0; i < rows; ++i)
+		array[i] = data + i * (width + 1);
+	fits_read_col_str(fitsFile, col, firstRow, 1, rows, NULL, array, NULL, status);
+	for (long i = 0; i < rows; ++i)
+		strings << QString::fromLatin1(array[i]);
+	delete[] array;
+	delete[] data;
+
+	return strings;
+}
+#endif
+
 /*!
  * \brief Export from data source \a dataSource to file \a fileName
  * \param fileName the name of the file to be exported to
@@ -67,6 +67,21 @@ private:
     void printError(int status) const;
 
 #ifdef HAVE_FITS
+    static long imageBlockRows(long columns);
+    static bool readImageRows(fitsfile*, long firstRow, long lastRow, long firstColumn, long lastColumn, long rowStep, double* data, int* status);
+    static void copyImageRows(const double* data, long rows, long columns, const QVector<QVector<double>*>& dataPointers, long outputRow);
+    struct ImageSection {
+        long firstRow;
+        long lastRow;
+        long firstColumn;
+        long lastColumn;
+        long outputRow;
+    };
+    static bool readImageSection(const QString& fileName, const ImageSection&, QVector<QVector<double>*> dataPointers);
+    static bool isBulkType(int typecode);
+    void readColumnBlock(int col, long firstRow, long rows, double* dest, int* status);
+    QStringList readColumnStrings(int col, long width, long firstRow, long rows, int* status);
+
     fitsfile* fitsFile;
 #endif
 
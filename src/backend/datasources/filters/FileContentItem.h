@@ -0,0 +1,54 @@
+/***************************************************************************
+    File                 : FileContentItem.h
+    Project              : LabPlot
+    Description          : Item of the content of a HDF or NetCDF file
+    --------------------------------------------------------------------
+    Copyright            : (C) 2017 by the LabPlot developers
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef FILECONTENTITEM_H
+#define FILECONTENTITEM_H
+
+#include <QStringList>
+#include <QVector>
+
+/*!
+  describes an object of a HDF or NetCDF file (group, data set, variable, attribute, ...) found when the
+  content of the file is scanned. The items are collected in a worker thread without using any widget or icon,
+  the tree widget items are created from them in the GUI thread.
+*/
+struct FileContentItem {
+	FileContentItem() : parent(-1), flags(Qt::ItemIsEnabled), highlighted(false), expandable(false) {}
+	FileContentItem(int p, const QStringList& t, const QString& i, Qt::ItemFlags f = Qt::ItemIsEnabled)
+		: parent(p), texts(t), icon(i), flags(f), highlighted(false), expandable(false) {}
+
+	int parent;		//!< index of the parent item in the scanned content, -1 for the top level items
+	QStringList texts;	//!< texts of the columns of the tree
+	QString icon;		//!< name of the icon
+	Qt::ItemFlags flags;
+	bool highlighted;	//!< the item is a data set or variable that can be imported
+	bool expandable;	//!< the members or attributes of the item are scanned when it is expanded
+};
+
+typedef QVector<FileContentItem> FileContent;
+
+#endif
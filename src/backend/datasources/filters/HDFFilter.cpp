@@ -33,14 +33,14 @@ Copyright            : (C) 2017 Alexander Semke (alexander.semke@web.de)
 
 #include "backend/datasources/filters/HDFFilter.h"
 #include "backend/datasources/filters/HDFFilterPrivate.h"
+#include "backend/datasources/filters/RowSampler.h"
 #include "backend/datasources/FileDataSource.h"
 #include "backend/core/column/Column.h"
 
 #include <QFile>
 #include <QDebug>
-#include <QTreeWidgetItem>
+#include <QMutexLocker>
 #include <KLocale>
-#include <KIcon>
 #include <cmath>
 
 /*!
@@ -57,10 +57,18 @@ HDFFilter::~HDFFilter() {
 }
 
 /*!
-  parses the content of the file \c fileName.
+  parses the content of the file \c fileName into \c content.
 */
-void HDFFilter::parse(const QString & fileName, QTreeWidgetItem* rootItem) {
-	d->parse(fileName, rootItem);
+void HDFFilter::parse(const QString & fileName, FileContent& content) {
+	d->parse(fileName, content);
+}
+
+/*!
+  scans the members of the group \c groupName into \c content, the members are top level items of \c content.
+  The content of the sub groups is only scanned on demand, call this function when the group is expanded.
+*/
+void HDFFilter::parseGroup(const QString & fileName, const QString& groupName, FileContent& content) {
+	d->parseGroup(fileName, groupName, content);
 }
 
 /*!
@@ -141,12 +149,23 @@ int HDFFilter::endColumn() const {
 	return d->endColumn;
 }
 
+/*!
+  sets the deflate compression level (1-9) of the data sets written by write(), 0 disables the compression.
+*/
+void HDFFilter::setCompressionLevel(const int level) {
+	d->compressionLevel = level;
+}
+
+int HDFFilter::compressionLevel() const {
+	return d->compressionLevel;
+}
+
 //#####################################################################
 //################### Private implementation ##########################
 //#####################################################################
 
 HDFFilterPrivate::HDFFilterPrivate(HDFFilter* owner) :
-	q(owner),currentDataSetName(""),startRow(1), endRow(-1), startColumn(1), endColumn(-1), status(0) {
+	q(owner),currentDataSetName(""),startRow(1), endRow(-1), startColumn(1), endColumn(-1), compressionLevel(0), status(0) {
 }
 
 #ifdef HAVE_HDF5
@@ -294,24 +313,96 @@ QStringList HDFFilterPrivate::readHDFCompound(hid_t tid) {
 	return dataString;
 }
 
+/*!
+  returns the number of rows to read at once from the data set \c dataset, \c rowSize is the size of a row in bytes.
+  The blocks are about 4 MiB large. For chunked data sets the number of rows is a multiple of the number of rows in a chunk,
+  \c chunkRows is set to this number (1 for data sets that are not chunked).
+*/
+hsize_t HDFFilterPrivate::blockRows(hid_t dataset, size_t rowSize, hsize_t& chunkRows) {
+	hsize_t rows = qMax((hsize_t)1, (hsize_t)(4*1024*1024/qMax(rowSize, (size_t)1)));
+	chunkRows = 1;
+
+	hid_t pid = H5Dget_create_plist(dataset);
+	handleError((int)pid, "H5Dget_create_plist");
+	if (H5D_CHUNKED == H5Pget_layout(pid)) {
+		hsize_t chunk_dims[H5S_MAX_RANK];
+		int rank_chunk = H5Pget_chunk(pid, H5S_MAX_RANK, chunk_dims);
+		handleError(rank_chunk, "H5Pget_chunk");
+		if (rank_chunk > 0 && chunk_dims[0] > 0) {
+			chunkRows = chunk_dims[0];
+			rows = qMax(chunkRows, rows - rows % chunkRows);
+		}
+	}
+	H5Pclose(pid);
+
+	return rows;
+}
+
+/*!
+  reads the rows \c startRow to \c endRow (at most \c lines rows) of the one dimensional data set \c dataset.
+  Only the selected rows are read with a hyperslab selection, in blocks aligned to the chunks of the data set.
+  The rows of a block are available in \c dataPointer when the block was converted, if \c publish is set
+  their number is published after every block. To be called with the library mutex locked, the mutex is released
+  while a block is converted.
+*/
 template <typename T>
-QStringList HDFFilterPrivate::readHDFData1D(hid_t dataset, hid_t type, int rows, int lines, QVector<double> *dataPointer) {
+QStringList HDFFilterPrivate::readHDFData1D(hid_t dataset, hid_t type, int rows, int lines, QVector<double> *dataPointer, bool publish) {
 	DEBUG("readHDFData1D() rows =" << rows << "lines =" << lines);
 	QStringList dataString;
 
-	// we read all rows of data
-	T* data = (T*) malloc(rows*sizeof(T));
-
-	status = H5Dread(dataset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
-	handleError(status, "H5Dread");
+	const int lastRow = qMin(endRow == -1 ? rows : qMin(endRow, rows), lines+startRow-1);
+	const hsize_t count = qMax(lastRow-startRow+1, 0);
 	DEBUG(" startRow =" << startRow << "endRow =" << endRow);
 	DEBUG("dataPointer =" << dataPointer);
-	for (int i = startRow-1; i < qMin(endRow, lines+startRow-1); i++) {
-		if (dataPointer != NULL)	// read to data source
-			dataPointer->operator[](i-startRow+1) = data[i];
-		else				// for preview
-			dataString << QString::number(static_cast<double>(data[i]));
+	if (count == 0)
+		return dataString;
+
+	hsize_t chunkRows;
+	const hsize_t blockSize = qMin(blockRows(dataset, sizeof(T), chunkRows), count);
+	T* data = (T*) malloc(blockSize*sizeof(T));
+
+	hid_t dataspace = H5Dget_space(dataset);
+	handleError((int)dataspace, "H5Dget_space");
+	RowSampler sampler(q, count);
+
+	hsize_t start = startRow-1;
+	const hsize_t end = start + count;
+	while (start < end) {
+		if (dataPointer != NULL && q->isCanceled())
+			break;
+
+		// the first block ends at a chunk boundary, all further blocks start at one
+		const hsize_t offset = start % chunkRows;
+		const hsize_t n = qMin(blockSize > offset ? blockSize - offset : blockSize, end - start);
+		status = H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, &start, NULL, &n, NULL);
+		handleError(status, "H5Sselect_hyperslab");
+		hid_t memspace = H5Screate_simple(1, &n, NULL);
+		handleError((int)memspace, "H5Screate_simple");
+
+		status = H5Dread(dataset, type, memspace, dataspace, H5P_DEFAULT, data);
+		handleError(status, "H5Dread");
+		H5Sclose(memspace);
+
+		// the conversion doesn't use the library, other readers can use it in the meantime
+		AbstractFileFilter::libraryMutex()->unlock();
+		for (hsize_t i = 0; i < n; i++) {
+			if (dataPointer != NULL) {	// read to data source
+				if (sampler.nextRow())
+					sampler.setValue(dataPointer, data[i]);
+			} else				// for preview
+				dataString << QString::number(static_cast<double>(data[i]));
+		}
+		AbstractFileFilter::libraryMutex()->lock();
+		start += n;
+
+		if (dataPointer != NULL) {
+			q->setProgress(start - (startRow-1), count);
+			if (publish)
+				q->setAvailableRows(sampler.completedRows());
+		}
 	}
+
+	H5Sclose(dataspace);
 	free(data);
 
 	return dataString;
@@ -321,13 +412,19 @@ QStringList HDFFilterPrivate::readHDFCompoundData1D(hid_t dataset, hid_t tid, in
 	int members = H5Tget_nmembers(tid);
 	handleError(members, "H5Tget_nmembers");
 
+	// number of rows in the selection
+	const int count = qMax(qMin(endRow == -1 ? rows : qMin(endRow, rows), lines+startRow-1) - startRow + 1, 0);
+
 	QStringList dataString;
 	if (dataPointer[0] == NULL) {
-		for (int i = 0; i < qMin(rows, lines); i++)
+		for (int i = 0; i < count; i++)
 			dataString <<  QLatin1String("(");
 	}
 
 	for (int m = 0; m < members; m++) {
+		if (dataPointer[0] != NULL && q->isCanceled())
+			break;
+
 		hid_t mtype = H5Tget_member_type(tid, m);
 		handleError((int)mtype, "H5Tget_member_type");
 		size_t msize = H5Tget_size(mtype);
@@ -343,67 +440,66 @@ QStringList HDFFilterPrivate::readHDFCompoundData1D(hid_t dataset, hid_t tid, in
 
 		QStringList mdataString;
 		if (H5Tequal(mtype, H5T_STD_I8LE) || H5Tequal(mtype, H5T_STD_I8BE)) {
-				mdataString = readHDFData1D<int8_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+				mdataString = readHDFData1D<int8_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 		} else if (H5Tequal(mtype, H5T_NATIVE_CHAR)) {
 			switch (sizeof(H5T_NATIVE_CHAR)) {
 			case 1:
-				mdataString = readHDFData1D<int8_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+				mdataString = readHDFData1D<int8_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 				break;
 			case 2:
-				mdataString = readHDFData1D<int16_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+				mdataString = readHDFData1D<int16_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 				break;
 			case 4:
-				mdataString = readHDFData1D<int32_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+				mdataString = readHDFData1D<int32_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 				break;
 			case 8:
-				mdataString = readHDFData1D<int64_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+				mdataString = readHDFData1D<int64_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 				break;
 			}
 		} else if (H5Tequal(mtype, H5T_STD_U8LE) || H5Tequal(mtype, H5T_STD_U8BE)) {
-				mdataString = readHDFData1D<uint8_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+				mdataString = readHDFData1D<uint8_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 		} else if (H5Tequal(mtype, H5T_NATIVE_UCHAR)) {
 			switch (sizeof(H5T_NATIVE_UCHAR)) {
 			case 1:
-				mdataString = readHDFData1D<uint8_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+				mdataString = readHDFData1D<uint8_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 				break;
 			case 2:
-				mdataString = readHDFData1D<uint16_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+				mdataString = readHDFData1D<uint16_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 				break;
 			case 4:
-				mdataString = readHDFData1D<uint32_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+				mdataString = readHDFData1D<uint32_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 				break;
 			case 8:
-				mdataString = readHDFData1D<uint64_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+				mdataString = readHDFData1D<uint64_t>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 				break;
 			}
 		} else if (H5Tequal(mtype, H5T_STD_I16LE) || H5Tequal(mtype, H5T_STD_I16BE) || H5Tequal(mtype, H5T_NATIVE_SHORT))
-			mdataString = readHDFData1D<short>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+			mdataString = readHDFData1D<short>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 		else if (H5Tequal(mtype, H5T_STD_U16LE) || H5Tequal(mtype, H5T_STD_U16BE) || H5Tequal(mtype, H5T_NATIVE_SHORT))
-			mdataString = readHDFData1D<unsigned short>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+			mdataString = readHDFData1D<unsigned short>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 		else if (H5Tequal(mtype, H5T_STD_I32LE) || H5Tequal(mtype, H5T_STD_I32BE) || H5Tequal(mtype, H5T_NATIVE_INT))
-			mdataString = readHDFData1D<int>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+			mdataString = readHDFData1D<int>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 		else if (H5Tequal(mtype, H5T_STD_U32LE) || H5Tequal(mtype, H5T_STD_U32BE) || H5Tequal(mtype, H5T_NATIVE_UINT))
-			mdataString = readHDFData1D<unsigned int>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+			mdataString = readHDFData1D<unsigned int>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 		else if (H5Tequal(mtype, H5T_NATIVE_LONG))
-			mdataString = readHDFData1D<long>(dataset, ctype, rows, lines, dataP);
+			mdataString = readHDFData1D<long>(dataset, ctype, rows, lines, dataP, false);
 		else if (H5Tequal(mtype, H5T_NATIVE_ULONG))
-			mdataString = readHDFData1D<unsigned long>(dataset, ctype, rows, lines, dataP);
+			mdataString = readHDFData1D<unsigned long>(dataset, ctype, rows, lines, dataP, false);
 		else if (H5Tequal(mtype, H5T_STD_I64LE) || H5Tequal(mtype, H5T_STD_I64BE) || H5Tequal(mtype, H5T_NATIVE_LLONG))
-			mdataString = readHDFData1D<long long>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+			mdataString = readHDFData1D<long long>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 		else if (H5Tequal(mtype, H5T_STD_U64LE) || H5Tequal(mtype, H5T_STD_U64BE) || H5Tequal(mtype, H5T_NATIVE_ULLONG))
-			mdataString = readHDFData1D<unsigned long long>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+			mdataString = readHDFData1D<unsigned long long>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 		else if (H5Tequal(mtype, H5T_IEEE_F32LE) || H5Tequal(mtype, H5T_IEEE_F32BE))
-			mdataString = readHDFData1D<float>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+			mdataString = readHDFData1D<float>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 		else if (H5Tequal(mtype, H5T_IEEE_F64LE) || H5Tequal(mtype, H5T_IEEE_F64BE))
-			mdataString = readHDFData1D<double>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP);
+			mdataString = readHDFData1D<double>(dataset, H5Tget_native_type(ctype, H5T_DIR_DEFAULT), rows, lines, dataP, false);
 		else if (H5Tequal(mtype, H5T_NATIVE_LDOUBLE))
-			mdataString = readHDFData1D<long double>(dataset, ctype, rows, lines, dataP);
+			mdataString = readHDFData1D<long double>(dataset, ctype, rows, lines, dataP, false);
 		else {
 			if (dataP != NULL) {
-				for (int i = startRow-1; i < qMin(endRow, lines+startRow-1); i++)
-					dataP->operator[](i-startRow+1) = 0;
+				dataP->fill(0);
 			} else {
-				for (int i = 0; i < qMin(rows, lines); i++)
+				for (int i = 0; i < count; i++)
 					mdataString << QLatin1String("_");
 			}
 			H5T_class_t mclass = H5Tget_member_class(tid, m);
@@ -412,7 +508,7 @@ QStringList HDFFilterPrivate::readHDFCompoundData1D(hid_t dataset, hid_t tid, in
 		}
 
 		if (dataPointer[0] == NULL) {
-			for (int i = 0; i < qMin(rows, lines); i++) {
+			for (int i = 0; i < count; i++) {
 				dataString[i] +=  mdataString[i];
 				if (m < members-1)
 					dataString[i] += QLatin1String(",");
@@ -423,39 +519,83 @@ QStringList HDFFilterPrivate::readHDFCompoundData1D(hid_t dataset, hid_t tid, in
 	}
 
 	if (dataPointer[0] == NULL) {
-		for (int i = 0; i < qMin(rows, lines); i++)
+		for (int i = 0; i < count; i++)
 			dataString[i] +=  QLatin1String(")");
 	}
 
 	return dataString;
 }
 
+/*!
+  reads the rows \c startRow to \c endRow (at most \c lines rows) and the columns \c startColumn to \c endColumn
+  of the two dimensional data set \c dataset. Only the selected window is read with a hyperslab selection,
+  in blocks of rows aligned to the chunks of the data set. The number of rows available in \c dataPointer
+  is published after every block. To be called with the library mutex locked, the mutex is released
+  while a block is converted.
+*/
 template <typename T>
 QList<QStringList> HDFFilterPrivate::readHDFData2D(hid_t dataset, hid_t type, int rows, int cols, int lines, QVector< QVector<double>* >& dataPointer) {
 	DEBUG("readHDFData2D() rows =" << rows << "cols =" << cols << "lines =" << lines);
 	QList<QStringList> dataStrings;
 
-	T** data = (T**) malloc(rows*sizeof(T*));
-	data[0] = (T*) malloc(cols*rows*sizeof(T));
-	for (int i = 1; i < rows; i++)
-		data[i] = data[0]+i*cols;
-
-	status = H5Dread(dataset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, &data[0][0]);
-	handleError(status,"H5Dread");
-
-	for (int i = 0; i < qMin(rows, lines); i++) {
-		QStringList line;
-		line.reserve(cols);
-		for (int j = 0; j < cols; j++) {
-			if (dataPointer[0] != NULL)
-				dataPointer[j-startColumn+1]->operator[](i-startRow+1) = data[i][j];
-			else {
-				line << QString::number(static_cast<double>(data[i][j]));
+	const hsize_t rowCount = qMax(qMin(endRow == -1 ? rows : qMin(endRow, rows), lines+startRow-1) - startRow + 1, 0);
+	const hsize_t columnCount = qMax((endColumn == -1 ? cols : qMin(endColumn, cols)) - startColumn + 1, 0);
+	if (rowCount == 0 || columnCount == 0)
+		return dataStrings;
+
+	hsize_t chunkRows;
+	const hsize_t blockSize = qMin(blockRows(dataset, columnCount*sizeof(T), chunkRows), rowCount);
+	T* data = (T*) malloc(blockSize*columnCount*sizeof(T));
+
+	hid_t dataspace = H5Dget_space(dataset);
+	handleError((int)dataspace, "H5Dget_space");
+	RowSampler sampler(q, rowCount);
+
+	hsize_t start[2] = {(hsize_t)startRow-1, (hsize_t)startColumn-1};
+	const hsize_t end = start[0] + rowCount;
+	while (start[0] < end) {
+		if (dataPointer[0] != NULL && q->isCanceled())
+			break;
+
+		// the first block ends at a chunk boundary, all further blocks start at one
+		const hsize_t offset = start[0] % chunkRows;
+		hsize_t count[2] = {qMin(blockSize > offset ? blockSize - offset : blockSize, end - start[0]), columnCount};
+		status = H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, start, NULL, count, NULL);
+		handleError(status, "H5Sselect_hyperslab");
+		hid_t memspace = H5Screate_simple(2, count, NULL);
+		handleError((int)memspace, "H5Screate_simple");
+
+		status = H5Dread(dataset, type, memspace, dataspace, H5P_DEFAULT, data);
+		handleError(status, "H5Dread");
+		H5Sclose(memspace);
+
+		// the conversion doesn't use the library, other readers can use it in the meantime
+		AbstractFileFilter::libraryMutex()->unlock();
+		for (hsize_t i = 0; i < count[0]; i++) {
+			const T* row = data + i*columnCount;
+			if (dataPointer[0] != NULL) {
+				if (!sampler.nextRow())
+					continue;
+				for (hsize_t j = 0; j < columnCount; j++)
+					sampler.setValue(dataPointer[j], row[j]);
+			} else {
+				QStringList line;
+				line.reserve(columnCount);
+				for (hsize_t j = 0; j < columnCount; j++)
+					line << QString::number(static_cast<double>(row[j]));
+				dataStrings << line;
 			}
 		}
-		dataStrings << line;
+		AbstractFileFilter::libraryMutex()->lock();
+		start[0] += count[0];
+
+		if (dataPointer[0] != NULL) {
+			q->setProgress(start[0] - (startRow-1), rowCount);
+			q->setAvailableRows(sampler.completedRows());
+		}
 	}
-	free(data[0]);
+
+	H5Sclose(dataspace);
 	free(data);
 
 	QDEBUG(dataStrings);
@@ -469,10 +609,14 @@ QList<QStringList> HDFFilterPrivate::readHDFCompoundData2D(hid_t dataset, hid_t
 	handleError(members, "H5Tget_nmembers");
 	DEBUG("members =" << members);
 
+	// size of the selected window
+	const int rowCount = qMax(qMin(endRow == -1 ? rows : qMin(endRow, rows), lines+startRow-1) - startRow + 1, 0);
+	const int columnCount = qMax((endColumn == -1 ? cols : qMin(endColumn, cols)) - startColumn + 1, 0);
+
 	QList<QStringList> dataStrings;
-	for (int i = 0; i < qMin(rows, lines); i++) {
+	for (int i = 0; i < rowCount; i++) {
 		QStringList lineStrings;
-		for (int j = 0; j < cols; j++)
+		for (int j = 0; j < columnCount; j++)
 			lineStrings << QLatin1String("(");
 		dataStrings << lineStrings;
 	}
@@ -549,9 +693,9 @@ QList<QStringList> HDFFilterPrivate::readHDFCompoundData2D(hid_t dataset, hid_t
 		else if (H5Tequal(mtype, H5T_NATIVE_LDOUBLE))
 			mdataStrings = readHDFData2D<long double>(dataset, ctype, rows, cols, lines, dummy);
 		else {
-			for (int i = 0; i < qMin(rows, lines); i++) {
+			for (int i = 0; i < rowCount; i++) {
 				QStringList lineString;
-				for (int j = 0; j < cols; j++)
+				for (int j = 0; j < columnCount; j++)
 					lineString << QLatin1String("_");
 				mdataStrings << lineString;
 			}
@@ -562,8 +706,8 @@ QList<QStringList> HDFFilterPrivate::readHDFCompoundData2D(hid_t dataset, hid_t
 		status = H5Tclose(ctype);
 		handleError(status, "H5Tclose");
 
-		for (int i = 0; i < qMin(rows, lines); i++) {
-			for (int j = 0; j < cols; j++) {
+		for (int i = 0; i < rowCount; i++) {
+			for (int j = 0; j < columnCount; j++) {
 				dataStrings[i][j] += mdataStrings[i][j];
 				if (m < members-1)
 					dataStrings[i][j] += QLatin1String(",");
@@ -571,8 +715,8 @@ QList<QStringList> HDFFilterPrivate::readHDFCompoundData2D(hid_t dataset, hid_t
 		}
 	}
 
-	for (int i = 0; i < qMin(rows, lines); i++) {
-		for (int j = 0; j < cols; j++)
+	for (int i = 0; i < rowCount; i++) {
+		for (int j = 0; j < columnCount; j++)
 			dataStrings[i][j] += QLatin1String(")");
 	}
 
@@ -1011,7 +1155,7 @@ QStringList HDFFilterPrivate::readHDFPropertyList(hid_t pid) {
 	return props;
 }
 
-void HDFFilterPrivate::scanHDFDataType(hid_t tid, char *dataSetName, QTreeWidgetItem* parentItem) {
+void HDFFilterPrivate::scanHDFDataType(hid_t tid, char *dataSetName, FileContent& content, int parent) {
 	QStringList typeProps = readHDFDataType(tid);
 
 	QString attr = scanHDFAttrs(tid).join(" ");
@@ -1020,13 +1164,11 @@ void HDFFilterPrivate::scanHDFDataType(hid_t tid, char *dataSetName, QTreeWidget
 	status = H5Iget_name(tid, link, MAXNAMELENGTH);
 	handleError(status, "H5Iget_name");
 
-	QTreeWidgetItem* dataTypeItem = new QTreeWidgetItem(QStringList()<<QString(dataSetName)<<QString(link)<<i18n("data type")<<typeProps.join("")<<attr);
-	dataTypeItem->setIcon(0, KIcon("accessories-calculator"));
-	dataTypeItem->setFlags(Qt::ItemIsEnabled);
-	parentItem->addChild(dataTypeItem);
+	content << FileContentItem(parent, QStringList()<<QString(dataSetName)<<QString(link)<<i18n("data type")<<typeProps.join("")<<attr,
+		"accessories-calculator");
 }
 
-void HDFFilterPrivate::scanHDFDataSet(hid_t did, char *dataSetName, QTreeWidgetItem* parentItem) {
+void HDFFilterPrivate::scanHDFDataSet(hid_t did, char *dataSetName, FileContent& content, int parent) {
 	QString attr = scanHDFAttrs(did).join("");
 
 	char link[MAXNAMELENGTH];
@@ -1080,32 +1222,25 @@ void HDFFilterPrivate::scanHDFDataSet(hid_t did, char *dataSetName, QTreeWidgetI
 	handleError((int)pid, "H5Dget_create_plist");
 	dataSetProps << ", " << readHDFPropertyList(pid).join("");
 
-	QTreeWidgetItem* dataSetItem = new QTreeWidgetItem(QStringList()<<QString(dataSetName)<<QString(link)<<i18n("data set")<<dataSetProps.join("")<<attr);
-	dataSetItem->setIcon(0, KIcon("x-office-spreadsheet"));
-	for (int i = 0; i < dataSetItem->columnCount(); i++) {
-		if (rows > 0 && cols > 0 && regs > 0) {
-			dataSetItem->setBackground(i, QColor(192,255,192));
-			dataSetItem->setForeground(i, Qt::black);
-			dataSetItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-		}
-		else
-			dataSetItem->setFlags(Qt::NoItemFlags);
+	FileContentItem dataSetItem(parent, QStringList()<<QString(dataSetName)<<QString(link)<<i18n("data set")<<dataSetProps.join("")<<attr,
+		"x-office-spreadsheet", Qt::NoItemFlags);
+	if (rows > 0 && cols > 0 && regs > 0) {
+		dataSetItem.flags = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+		dataSetItem.highlighted = true;
 	}
-	parentItem->addChild(dataSetItem);
+	content << dataSetItem;
 }
 
-void HDFFilterPrivate::scanHDFLink(hid_t gid, char *linkName, QTreeWidgetItem* parentItem) {
+void HDFFilterPrivate::scanHDFLink(hid_t gid, char *linkName, FileContent& content, int parent) {
 	char target[MAXNAMELENGTH];
 	status = H5Gget_linkval(gid, linkName, MAXNAMELENGTH, target) ;
 	handleError(status, "H5Gget_linkval");
 
-	QTreeWidgetItem* linkItem = new QTreeWidgetItem(QStringList()<<QString(linkName) << i18n("symbolic link") << i18n("link to") + QString(target));
-	linkItem->setIcon(0, KIcon("emblem-symbolic-link"));
-	linkItem->setFlags(Qt::ItemIsEnabled);
-	parentItem->addChild(linkItem);
+	content << FileContentItem(parent, QStringList()<<QString(linkName) << i18n("symbolic link") << i18n("link to") + QString(target),
+		"emblem-symbolic-link");
 }
 
-void HDFFilterPrivate::scanHDFGroup(hid_t gid, char *groupName, QTreeWidgetItem* parentItem) {
+void HDFFilterPrivate::scanHDFGroup(hid_t gid, char *groupName, FileContent& content, int parent, bool recursive) {
 
 	//check for hard link
 	H5G_stat_t statbuf;
@@ -1113,10 +1248,7 @@ void HDFFilterPrivate::scanHDFGroup(hid_t gid, char *groupName, QTreeWidgetItem*
 	handleError(status, "H5Gget_objinfo");
 	if (statbuf.nlink > 1) {
 		if (multiLinkList.contains(statbuf.objno[0])) {
-			QTreeWidgetItem* objectItem = new QTreeWidgetItem(QStringList()<<QString(groupName) << i18n("hard link"));
-			objectItem->setIcon(0, KIcon("link"));
-			objectItem->setFlags(Qt::ItemIsEnabled);
-			parentItem->addChild(objectItem);
+			content << FileContentItem(parent, QStringList()<<QString(groupName) << i18n("hard link"), "link");
 			return;
 		} else {
 			multiLinkList.append(statbuf.objno[0]);
@@ -1132,11 +1264,20 @@ void HDFFilterPrivate::scanHDFGroup(hid_t gid, char *groupName, QTreeWidgetItem*
 
 	QString attr = scanHDFAttrs(gid).join(" ");
 
-	QTreeWidgetItem* groupItem = new QTreeWidgetItem(QStringList() << QString(groupName) << QString(link) << QLatin1String("group ")<<attr);
-	groupItem->setIcon(0, KIcon("folder"));
-	groupItem->setFlags(Qt::ItemIsEnabled);
-	parentItem->addChild(groupItem);
+	FileContentItem groupItem(parent, QStringList() << QString(groupName) << QString(link) << QLatin1String("group ")<<attr, "folder");
 
+	//the members of sub groups are scanned when the group is expanded, see scanHDFGroupMembers()
+	groupItem.expandable = !recursive;
+	content << groupItem;
+	if (recursive)
+		scanHDFGroupMembers(gid, content, content.size() - 1);
+}
+
+/*!
+  scans the members of the group \c gid and adds them to \c content as children of the item \c parent.
+  Sub groups are added without their members.
+*/
+void HDFFilterPrivate::scanHDFGroupMembers(hid_t gid, FileContent& content, int parent) {
 	hsize_t numObj;
 	status = H5Gget_num_objs(gid, &numObj);
 	handleError(status, "H5Gget_num_objs");
@@ -1150,13 +1291,13 @@ void HDFFilterPrivate::scanHDFGroup(hid_t gid, char *groupName, QTreeWidgetItem*
 		handleError(otype, "H5Gget_objtype_by_idx");
 		switch (otype) {
 		case H5G_LINK: {
-				scanHDFLink(gid, memberName, groupItem);
+				scanHDFLink(gid, memberName, content, parent);
 				break;
 			}
 		case H5G_GROUP: {
 				hid_t grpid = H5Gopen(gid, memberName, H5P_DEFAULT);
 				handleError((int)grpid, "H5Gopen");
-				scanHDFGroup(grpid, memberName, groupItem);
+				scanHDFGroup(grpid, memberName, content, parent, false);
 				status = H5Gclose(grpid);
 				handleError(status, "H5Gclose");
 				break;
@@ -1164,7 +1305,7 @@ void HDFFilterPrivate::scanHDFGroup(hid_t gid, char *groupName, QTreeWidgetItem*
 		case H5G_DATASET: {
 				hid_t dsid = H5Dopen(gid, memberName, H5P_DEFAULT);
 				handleError((int)dsid, "H5Dopen");
-				scanHDFDataSet(dsid, memberName, groupItem);
+				scanHDFDataSet(dsid, memberName, content, parent);
 				status = H5Dclose(dsid);
 				handleError(status, "H5Dclose");
 				break;
@@ -1172,15 +1313,13 @@ void HDFFilterPrivate::scanHDFGroup(hid_t gid, char *groupName, QTreeWidgetItem*
 		case H5G_TYPE: {
 				hid_t tid = H5Topen(gid, memberName, H5P_DEFAULT);
 				handleError((int)tid, "H5Topen");
-				scanHDFDataType(tid, memberName, groupItem);
+				scanHDFDataType(tid, memberName, content, parent);
 				status = H5Tclose(tid);
 				handleError(status, "H5Tclose");
 				break;
 			}
 		default:
-			QTreeWidgetItem* objectItem = new QTreeWidgetItem(QStringList() << QString(memberName) << i18n("unknown"));
-			objectItem->setFlags(Qt::ItemIsEnabled);
-			groupItem->addChild(objectItem);
+			content << FileContentItem(parent, QStringList() << QString(memberName) << i18n("unknown"), QString());
 			break;
 		}
 	}
@@ -1188,11 +1327,12 @@ void HDFFilterPrivate::scanHDFGroup(hid_t gid, char *groupName, QTreeWidgetItem*
 #endif
 
 /*!
-    parses the content of the file \c fileName and fill the tree using rootItem.
+    parses the content of the file \c fileName into \c content, the root group is the only top level item.
 */
-void HDFFilterPrivate::parse(const QString & fileName, QTreeWidgetItem* rootItem) {
+void HDFFilterPrivate::parse(const QString & fileName, FileContent& content) {
 	DEBUG("HDFFilterPrivate::parse()");
 #ifdef HAVE_HDF5
+	QMutexLocker locker(AbstractFileFilter::libraryMutex());
 	QByteArray bafileName = fileName.toLatin1();
 	DEBUG("fileName = " << bafileName.data());
 	//TODO: H5Fopen() crashes on Windows!
@@ -1202,7 +1342,7 @@ void HDFFilterPrivate::parse(const QString & fileName, QTreeWidgetItem* rootItem
 	hid_t group = H5Gopen(file, rootName, H5P_DEFAULT);
 	handleError((int)group, "H5Gopen", rootName);
 	// CRASHES multiLinkList.clear();
-	scanHDFGroup(group, rootName, rootItem);
+	scanHDFGroup(group, rootName, content, -1);
 	status = H5Gclose(group);
 	handleError(status, "H5Gclose", "");
 	status = H5Fclose(file);
@@ -1210,7 +1350,31 @@ void HDFFilterPrivate::parse(const QString & fileName, QTreeWidgetItem* rootItem
 #else
 	DEBUG("HDF not available");
 	Q_UNUSED(fileName)
-	Q_UNUSED(rootItem)
+	Q_UNUSED(content)
+#endif
+}
+
+/*!
+    scans the members of the group \c groupName into \c content.
+*/
+void HDFFilterPrivate::parseGroup(const QString & fileName, const QString& groupName, FileContent& content) {
+#ifdef HAVE_HDF5
+	QMutexLocker locker(AbstractFileFilter::libraryMutex());
+	QByteArray bafileName = fileName.toLatin1();
+	hid_t file = H5Fopen(bafileName.data(), H5F_ACC_RDONLY, H5P_DEFAULT);
+	handleError((int)file, "H5Fopen", fileName);
+	QByteArray baGroupName = groupName.toLatin1();
+	hid_t group = H5Gopen(file, baGroupName.data(), H5P_DEFAULT);
+	handleError((int)group, "H5Gopen", groupName);
+	scanHDFGroupMembers(group, content, -1);
+	status = H5Gclose(group);
+	handleError(status, "H5Gclose", "");
+	status = H5Fclose(file);
+	handleError(status, "H5Fclose", "");
+#else
+	Q_UNUSED(fileName)
+	Q_UNUSED(groupName)
+	Q_UNUSED(content)
 #endif
 }
 
@@ -1229,6 +1393,10 @@ QList<QStringList> HDFFilterPrivate::readCurrentDataSet(const QString & fileName
 	QDEBUG(" current data set =" << currentDataSetName);
 
 #ifdef HAVE_HDF5
+	QMutexLocker locker(AbstractFileFilter::libraryMutex());
+	if (dataSource != NULL)
+		q->resetProgress();
+
 	QByteArray bafileName = fileName.toLatin1();
 	hid_t file = H5Fopen(bafileName.data(), H5F_ACC_RDONLY, H5P_DEFAULT);
 	handleError((int)file, "H5Fopen", fileName);
@@ -1318,7 +1486,7 @@ QList<QStringList> HDFFilterPrivate::readCurrentDataSet(const QString & fileName
 				<< ", rows:" << rows << " max:" << maxSize;
 #endif
 			if (dataSource != NULL)
-				columnOffset = dataSource->create(dataPointers, mode, actualRows, actualCols);
+				columnOffset = dataSource->create(dataPointers, mode, RowSampler(q, actualRows).rows(), actualCols);
 
 			QStringList dataString;	// data saved in a list
 			switch (dclass) {
@@ -1436,7 +1604,7 @@ QList<QStringList> HDFFilterPrivate::readCurrentDataSet(const QString & fileName
 					if (dataSource != NULL) {
 						// re-create data pointer
 						dataPointers.clear();
-						dataSource->create(dataPointers, mode, actualRows, members);
+						dataSource->create(dataPointers, mode, RowSampler(q, actualRows).rows(), members);
 					} else
 						dataStrings << readHDFCompound(dtype);
 					dataString = readHDFCompoundData1D(dataset, dtype, rows, lines, dataPointers);
@@ -1494,7 +1662,7 @@ QList<QStringList> HDFFilterPrivate::readCurrentDataSet(const QString & fileName
 #endif
 
 			if (dataSource != NULL)
-				columnOffset = dataSource->create(dataPointers, mode, actualRows, actualCols);
+				columnOffset = dataSource->create(dataPointers, mode, RowSampler(q, actualRows).rows(), actualCols);
 
 			// read data
 			switch (dclass) {
@@ -1621,15 +1789,20 @@ QList<QStringList> HDFFilterPrivate::readCurrentDataSet(const QString & fileName
 	handleError(status, "H5Dclose");
 	status = H5Fclose(file);
 	handleError(status, "H5Fclose");
+	locker.unlock();
 
 	if (!dataSource)
 		return dataStrings;
 
+	// all rows are available, the members of compound data sets are read one after another
+	if (!q->isCanceled())
+		q->setAvailableRows(RowSampler(q, actualRows).rows());
+
 	// make everything undo/redo-able again
 	// set column comments in spreadsheet
 	Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
 	if (spreadsheet) {
-		QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", actualRows);
+		QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", RowSampler(q, actualRows).rows());
 		for (int n = 0; n < actualCols; n++) {
 			Column* column = spreadsheet->column(columnOffset+n);
 			column->setComment(comment);
@@ -1680,10 +1853,99 @@ void HDFFilterPrivate::read(const QString & fileName, AbstractDataSource* dataSo
     writes the content of \c dataSource to the file \c fileName.
 */
 void HDFFilterPrivate::write(const QString & fileName, AbstractDataSource* dataSource) {
+#ifdef HAVE_HDF5
+	QVector<const QVector<double>*> columns;
+	QStringList names;
+	const int rows = AbstractFileFilter::numericColumns(dataSource, columns, names);
+	if (columns.isEmpty() || rows == 0)
+		return;
+
+	QMutexLocker locker(AbstractFileFilter::libraryMutex());
+	QByteArray bafileName = fileName.toLatin1();
+	hid_t file = H5Fcreate(bafileName.data(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	handleError((int)file, "H5Fcreate", fileName);
+	if (file < 0)
+		return;
+
+	// the data sets are chunked with 64k rows per chunk and compressed if a compression level is set.
+	// Missing values are filled with NAN.
+	const hsize_t chunkRows = qMin(rows, 65536);
+	const double fillValue = NAN;
+	hid_t pid = H5Pcreate(H5P_DATASET_CREATE);
+	handleError((int)pid, "H5Pcreate");
+	H5Pset_fill_value(pid, H5T_NATIVE_DOUBLE, &fillValue);
+
+	Matrix* matrix = dynamic_cast<Matrix*>(dataSource);
+	if (matrix) {
+		// the matrix is written to one two dimensional data set column by column
+		hsize_t dims[2] = {(hsize_t)rows, (hsize_t)columns.size()};
+		hsize_t chunk[2] = {chunkRows, 1};
+		H5Pset_chunk(pid, 2, chunk);
+		if (compressionLevel > 0)
+			H5Pset_deflate(pid, compressionLevel);
+
+		hid_t space = H5Screate_simple(2, dims, NULL);
+		handleError((int)space, "H5Screate_simple");
+		QByteArray baName = matrix->name().replace('/', '_').toLatin1();
+		hid_t dataset = H5Dcreate2(file, baName.data(), H5T_NATIVE_DOUBLE, space, H5P_DEFAULT, pid, H5P_DEFAULT);
+		handleError((int)dataset, "H5Dcreate2", matrix->name());
+		for (int j = 0; j < columns.size(); ++j) {
+			writeHDFColumn(dataset, space, j, rows, columns.at(j));
+			emit q->completed(100*(j+1)/columns.size());
+		}
+		H5Dclose(dataset);
+		H5Sclose(space);
+	} else {
+		// every numeric column of the spreadsheet is written to a one dimensional data set
+		hsize_t dims = rows;
+		hsize_t chunk = chunkRows;
+		H5Pset_chunk(pid, 1, &chunk);
+		if (compressionLevel > 0)
+			H5Pset_deflate(pid, compressionLevel);
+
+		hid_t space = H5Screate_simple(1, &dims, NULL);
+		handleError((int)space, "H5Screate_simple");
+		for (int j = 0; j < columns.size(); ++j) {
+			QByteArray baName = QString(names.at(j)).replace('/', '_').toLatin1();
+			hid_t dataset = H5Dcreate2(file, baName.data(), H5T_NATIVE_DOUBLE, space, H5P_DEFAULT, pid, H5P_DEFAULT);
+			handleError((int)dataset, "H5Dcreate2", names.at(j));
+			writeHDFColumn(dataset, space, 0, rows, columns.at(j));
+			H5Dclose(dataset);
+			emit q->completed(100*(j+1)/columns.size());
+		}
+		H5Sclose(space);
+	}
+
+	H5Pclose(pid);
+	status = H5Fclose(file);
+	handleError(status, "H5Fclose", fileName);
+#else
 	Q_UNUSED(fileName);
 	Q_UNUSED(dataSource);
-	//TODO
+#endif
+}
+
+#ifdef HAVE_HDF5
+/*!
+    writes the values of \c column (at most \c rows) with one H5Dwrite() call to the data set \c dataset.
+    For two dimensional data sets the values are written to the column \c col.
+*/
+void HDFFilterPrivate::writeHDFColumn(hid_t dataset, hid_t fileSpace, int col, int rows, const QVector<double>* column) {
+	const hsize_t count[2] = {(hsize_t)qMin(column->size(), rows), 1};
+	if (count[0] == 0 || dataset < 0)
+		return;
+
+	const hsize_t start[2] = {0, (hsize_t)col};
+	status = H5Sselect_hyperslab(fileSpace, H5S_SELECT_SET, start, NULL, count, NULL);
+	handleError(status, "H5Sselect_hyperslab");
+	hid_t memSpace = H5Screate_simple(1, count, NULL);
+	handleError((int)memSpace, "H5Screate_simple");
+
+	status = H5Dwrite(dataset, H5T_NATIVE_DOUBLE, memSpace, fileSpace, H5P_DEFAULT, column->constData());
+	handleError(status, "H5Dwrite");
+	H5Sclose(memSpace);
 }
+#endif
 
 //##############################################################################
 //##################  Serialization/Deserialization  ###########################
@@ -1694,6 +1956,7 @@ void HDFFilterPrivate::write(const QString & fileName, AbstractDataSource* dataS
  */
 void HDFFilter::save(QXmlStreamWriter* writer) const {
 	writer->writeStartElement("hdfFilter");
+	saveSamplingAttributes(writer);
 	writer->writeEndElement();
 }
 
@@ -1708,5 +1971,6 @@ bool HDFFilter::load(XmlStreamReader* reader) {
 
 	QString attributeWarning = i18n("Attribute '%1' missing or empty, default value is used");
 	QXmlStreamAttributes attribs = reader->attributes();
+	loadSamplingAttributes(attribs);
 	return true;
 }
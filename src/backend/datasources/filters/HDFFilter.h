@@ -28,9 +28,9 @@ Copyright            : (C) 2015 Stefan Gerlach (stefan.gerlach@uni.kn)
 #define HDFFILTER_H
 
 #include "backend/datasources/filters/AbstractFileFilter.h"
+#include "backend/datasources/filters/FileContentItem.h"
 #include <QStringList>
 
-class QTreeWidgetItem;
 class HDFFilterPrivate;
 
 class HDFFilter : public AbstractFileFilter {
@@ -40,7 +40,8 @@ public:
 	HDFFilter();
 	~HDFFilter();
 
-	void parse(const QString& fileName, QTreeWidgetItem* rootItem);
+	void parse(const QString& fileName, FileContent& content);
+	void parseGroup(const QString& fileName, const QString& groupName, FileContent& content);
 	void read(const QString& fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode importMode=AbstractFileFilter::Replace);
 	QList <QStringList> readCurrentDataSet(const QString& fileName, AbstractDataSource* dataSource, bool& ok, AbstractFileFilter::ImportMode importMode=AbstractFileFilter::Replace, int lines=-1);
 	void write(const QString& fileName, AbstractDataSource*);
@@ -59,6 +60,8 @@ public:
 	int startColumn() const;
 	void setEndColumn(const int);
 	int endColumn() const;
+	void setCompressionLevel(const int);
+	int compressionLevel() const;
 
 	virtual void save(QXmlStreamWriter*) const;
 	virtual bool load(XmlStreamReader*);
@@ -27,6 +27,7 @@ Copyright            : (C) 2015 Stefan Gerlach (stefan.gerlach@uni.kn)
 #ifndef HDFFILTERPRIVATE_H
 #define HDFFILTERPRIVATE_H
 
+#include "backend/datasources/filters/FileContentItem.h"
 #include <QList>
 #ifdef HAVE_HDF5
 #include <hdf5.h>
@@ -39,7 +40,8 @@ class HDFFilterPrivate {
 	public:
 		explicit HDFFilterPrivate(HDFFilter*);
 
-		void parse(const QString & fileName, QTreeWidgetItem* rootItem);
+		void parse(const QString & fileName, FileContent& content);
+		void parseGroup(const QString & fileName, const QString& groupName, FileContent& content);
 		void read(const QString & fileName, AbstractDataSource* dataSource,
 					AbstractFileFilter::ImportMode importMode = AbstractFileFilter::Replace);
 		QList <QStringList> readCurrentDataSet(const QString & fileName, AbstractDataSource* dataSource, bool &ok, AbstractFileFilter::ImportMode importMode=AbstractFileFilter::Replace, int lines=-1);
@@ -52,6 +54,7 @@ class HDFFilterPrivate {
 		int endRow;
 		int startColumn;
 		int endColumn;
+		int compressionLevel;
 
 	private:
 		int status;
@@ -64,7 +67,9 @@ class HDFFilterPrivate {
 		QString translateHDFType(hid_t);
 		QString translateHDFClass(H5T_class_t);
 		QStringList readHDFCompound(hid_t tid);
-		template <typename T> QStringList readHDFData1D(hid_t dataset, hid_t type, int rows, int lines, QVector<double> *dataPointer=NULL);
+		hsize_t blockRows(hid_t dataset, size_t rowSize, hsize_t& chunkRows);
+		void writeHDFColumn(hid_t dataset, hid_t fileSpace, int col, int rows, const QVector<double>* column);
+		template <typename T> QStringList readHDFData1D(hid_t dataset, hid_t type, int rows, int lines, QVector<double> *dataPointer=NULL, bool publish=true);
 		QStringList readHDFCompoundData1D(hid_t dataset, hid_t tid, int rows, int lines,QVector< QVector<double>* >& dataPointer);
 		template <typename T> QList <QStringList> readHDFData2D(hid_t dataset, hid_t ctype, int rows, int cols, int lines, QVector< QVector<double>* >& dataPointer);
 		QList<QStringList> readHDFCompoundData2D(hid_t dataset, hid_t tid, int rows, int cols, int lines);
@@ -72,10 +77,11 @@ class HDFFilterPrivate {
 		QStringList scanHDFAttrs(hid_t oid);
 		QStringList readHDFDataType(hid_t tid);
 		QStringList readHDFPropertyList(hid_t pid);
-		void scanHDFDataType(hid_t tid, char *dataTypeName,  QTreeWidgetItem* parentItem);
-		void scanHDFLink(hid_t gid, char *linkName,  QTreeWidgetItem* parentItem);
-		void scanHDFDataSet(hid_t dsid, char *dataSetName,  QTreeWidgetItem* parentItem);
-		void scanHDFGroup(hid_t gid, char *groupName, QTreeWidgetItem* parentItem);
+		void scanHDFDataType(hid_t tid, char *dataTypeName, FileContent& content, int parent);
+		void scanHDFLink(hid_t gid, char *linkName, FileContent& content, int parent);
+		void scanHDFDataSet(hid_t dsid, char *dataSetName, FileContent& content, int parent);
+		void scanHDFGroup(hid_t gid, char *groupName, FileContent& content, int parent, bool recursive = true);
+		void scanHDFGroupMembers(hid_t gid, FileContent& content, int parent);
 #endif
 };
 
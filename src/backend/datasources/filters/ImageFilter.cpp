@@ -30,6 +30,10 @@ Copyright            : (C) 2015 by Stefan Gerlach (stefan.gerlach@uni.kn)
 #include "backend/core/column/Column.h"
 
 #include <QFile>
+#include <QImage>
+#include <QRect>
+#include <QThread>
+#include <QtConcurrentRun>
 #include <QTextStream>
 #include <QDebug>
 #include <KLocale>
@@ -149,27 +153,33 @@ void ImageFilterPrivate::read(const QString & fileName, AbstractDataSource* data
 	int cols = image.width();
 	int rows = image.height();
 
-	// set range of rows
-	if (endColumn == -1)
-		endColumn = cols;
-	if (endRow == -1)
-		endRow = rows;
+	// set range of rows, the range is limited to the size of the image.
+	// the settings of the filter are kept, they apply to the next image again
+	const int lastColumn = (endColumn == -1 || endColumn > cols) ? cols : endColumn;
+	const int lastRow = (endRow == -1 || endRow > rows) ? rows : endRow;
+	const int firstColumn = qMax(startColumn, 1);
+	const int firstRow = qMax(startRow, 1);
+	if (firstColumn > lastColumn || firstRow > lastRow) {
+		qDebug()<<"empty range of rows or columns in image"<<fileName;
+		return;
+	}
+	const QRect range(firstColumn-1, firstRow-1, lastColumn-firstColumn+1, lastRow-firstRow+1);
 	int actualCols=0, actualRows=0;
 
 	switch (importFormat) {
 	case ImageFilter::MATRIX: {
-		actualCols = endColumn-startColumn+1;
-		actualRows = endRow-startRow+1;
+		actualCols = range.width();
+		actualRows = range.height();
 		break;
 	}
 	case ImageFilter::XYZ: {
 		actualCols = 3;
-		actualRows = (endColumn-startColumn+1)*(endRow-startRow+1);
+		actualRows = range.width()*range.height();
 		break;
 	}
 	case ImageFilter::XYRGB: {
 		actualCols = 5;
-		actualRows = (endColumn-startColumn+1)*(endRow-startRow+1);
+		actualRows = range.width()*range.height();
 		break;
 	}
 	}
@@ -191,52 +201,41 @@ void ImageFilterPrivate::read(const QString & fileName, AbstractDataSource* data
 	}
 
 	// read data
-	switch (importFormat) {
-	case ImageFilter::MATRIX: {
-		for (int i=0; i<actualRows; i++) {
-			for ( int j=0; j<actualCols; j++ ) {
-				double value=qGray(image.pixel(j+startColumn-1,i+startRow-1));
-				dataPointers[j]->operator[](i) = value;
-			}
-			emit q->completed(100*i/actualRows);
+	// the pixels are read directly from the scan lines of the image converted to 32 bit RGB
+	if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32)
+		image = image.convertToFormat(QImage::Format_RGB32);
+
+	// the raw pointers to the columns are obtained here, the rows are written in parallel
+	QVector<double*> columns;
+	columns.reserve(actualCols);
+	for (int n = 0; n < actualCols; ++n)
+		columns << dataPointers[n]->data();
+
+	q->resetProgress();
+	const int pixels = range.width()*range.height();
+	const int sections = (pixels > 1<<18) ? qMin(QThread::idealThreadCount(), range.height()) : 1;
+	if (sections <= 1) {
+		// the progress is reported for blocks of about 64k pixels
+		const int blockRows = qMax(1, (1<<16)/range.width());
+		for (int i = range.top(); i <= range.bottom(); i += blockRows) {
+			const int last = qMin(i+blockRows, range.bottom()+1);
+			readRows(image, range, i, last, columns);
+			q->setProgress(last-range.top(), range.height());
 		}
-		break;
-	}
-	case ImageFilter::XYZ: {
-		int currentRow=0;
-		for (int i=startRow-1; i<endRow; i++) {
-			for ( int j=startColumn-1; j<endColumn; j++ ) {
-				QRgb color=image.pixel(j, i);
-				dataPointers[0]->operator[](currentRow) = i+1;
-				dataPointers[1]->operator[](currentRow) = j+1;
-				dataPointers[2]->operator[](currentRow) = qGray(color);
-				currentRow++;
-			}
-			emit q->completed(100*i/actualRows);
+	} else {
+		const int sectionRows = (range.height() + sections-1)/sections;
+		QList<QFuture<void> > futures;
+		for (int i = range.top(); i <= range.bottom(); i += sectionRows)
+			futures << QtConcurrent::run(this, &ImageFilterPrivate::readRows, image, range, i, qMin(i+sectionRows, range.bottom()+1), columns);
+		for (int i = 0; i < futures.size(); ++i) {
+			futures[i].waitForFinished();
+			q->setProgress(i+1, futures.size());
 		}
-		break;
-	}
-	case ImageFilter::XYRGB: {
-		int currentRow=0;
-		for (int i=startRow-1; i<endRow; i++) {
-			for ( int j=startColumn-1; j<endColumn; j++ ) {
-				QRgb color=image.pixel(j, i);
-				dataPointers[0]->operator[](currentRow) = i+1;
-				dataPointers[1]->operator[](currentRow) = j+1;
-				dataPointers[2]->operator[](currentRow) = qRed(color);
-				dataPointers[3]->operator[](currentRow) = qGreen(color);
-				dataPointers[4]->operator[](currentRow) = qBlue(color);
-				currentRow++;
-			}
-			emit q->completed(100*i/actualRows);
-		}
-		break;
-	}
 	}
 
 	Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
 	if (spreadsheet) {
-		QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", rows);
+		QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", actualRows);
 		for ( int n=0; n<actualCols; n++ ) {
 			Column* column = spreadsheet->column(columnOffset+n);
 			column->setComment(comment);
@@ -258,6 +257,56 @@ void ImageFilterPrivate::read(const QString & fileName, AbstractDataSource* data
 	}
 }
 
+/*!
+    reads the rows \c firstRow to \c lastRow-1 (zero based) of the 32 bit RGB image \c image to the columns \c columns.
+    \c range is the imported part of the image, its first row is written to the first row of the columns.
+    Only reads the scan lines of the image and can be called in parallel for disjoint row ranges.
+*/
+void ImageFilterPrivate::readRows(const QImage& image, const QRect& range, int firstRow, int lastRow, const QVector<double*>& columns) const {
+	const int width = range.width();
+
+	for (int i = firstRow; i < lastRow; i++) {
+		const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(i)) + range.left();
+		const int row = i-range.top();
+
+		switch (importFormat) {
+		case ImageFilter::MATRIX: {
+			for (int j = 0; j < width; j++)
+				columns[j][row] = qGray(line[j]);
+			break;
+		}
+		case ImageFilter::XYZ: {
+			const int offset = row*width;
+			double* x = columns[0] + offset;
+			double* y = columns[1] + offset;
+			double* z = columns[2] + offset;
+			for (int j = 0; j < width; j++) {
+				x[j] = i+1;
+				y[j] = range.left()+1+j;
+				z[j] = qGray(line[j]);
+			}
+			break;
+		}
+		case ImageFilter::XYRGB: {
+			const int offset = row*width;
+			double* x = columns[0] + offset;
+			double* y = columns[1] + offset;
+			double* r = columns[2] + offset;
+			double* g = columns[3] + offset;
+			double* b = columns[4] + offset;
+			for (int j = 0; j < width; j++) {
+				x[j] = i+1;
+				y[j] = range.left()+1+j;
+				r[j] = qRed(line[j]);
+				g[j] = qGreen(line[j]);
+				b[j] = qBlue(line[j]);
+			}
+			break;
+		}
+		}
+	}
+}
+
 /*!
     writes the content of \c dataSource to the file \c fileName.
 */
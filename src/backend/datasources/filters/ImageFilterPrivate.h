@@ -28,6 +28,8 @@ Copyright            : (C) 2015 Stefan Gerlach (stefan.gerlach@uni.kn)
 #define IMAGEFILTERPRIVATE_H
 
 class AbstractDataSource;
+class QImage;
+class QRect;
 
 class ImageFilterPrivate {
 
@@ -49,6 +51,7 @@ class ImageFilterPrivate {
 
 	private:
 		void clearDataSource(AbstractDataSource*) const;
+		void readRows(const QImage&, const QRect& range, int firstRow, int lastRow, const QVector<double*>& columns) const;
 };
 
 #endif
@@ -26,14 +26,15 @@ Copyright            : (C) 2015-2017 by Stefan Gerlach (stefan.gerlach@uni.kn)
 ***************************************************************************/
 #include "backend/datasources/filters/NetCDFFilter.h"
 #include "backend/datasources/filters/NetCDFFilterPrivate.h"
+#include "backend/datasources/filters/RowSampler.h"
 #include "backend/datasources/FileDataSource.h"
 #include "backend/core/column/Column.h"
 
 #include <QFile>
 #include <QTextStream>
 #include <QDebug>
+#include <QMutexLocker>
 #include <KLocale>
-#include <KIcon>
 #include <cmath>
 
 /*!
@@ -50,10 +51,18 @@ NetCDFFilter::~NetCDFFilter() {
 }
 
 /*!
-  parses the content of the file \c fileName.
+  parses the content of the file \c fileName into \c content.
 */
-void NetCDFFilter::parse(const QString & fileName, QTreeWidgetItem* rootItem) {
-	d->parse(fileName, rootItem);
+void NetCDFFilter::parse(const QString & fileName, FileContent& content) {
+	d->parse(fileName, content);
+}
+
+/*!
+  scans the attributes of the variable \c varName into \c content, the attributes are top level items of \c content.
+  The attributes of the variables are only scanned on demand, call this function when the variable is expanded.
+*/
+void NetCDFFilter::parseVar(const QString & fileName, const QString& varName, FileContent& content) {
+	d->parseVar(fileName, varName, content);
 }
 
 /*!
@@ -203,7 +212,7 @@ QString NetCDFFilterPrivate::translateDataType(nc_type type) {
 	return typeString;
 }
 
-QString NetCDFFilterPrivate::scanAttrs(int ncid, int varid, int attid, QTreeWidgetItem* parentItem) {
+QString NetCDFFilterPrivate::scanAttrs(int ncid, int varid, int attid, FileContent* content, int parent) {
 	char name[NC_MAX_NAME + 1];
 
 	int nattr, nstart = 0;
@@ -332,7 +341,7 @@ QString NetCDFFilterPrivate::scanAttrs(int ncid, int varid, int attid, QTreeWidg
 			valueString << "not supported";
 		}
 
-		if (parentItem != NULL) {
+		if (content != NULL) {
 			QString typeName;
 			if (varid == NC_GLOBAL)
 				typeName = i18n("global attribute");
@@ -343,17 +352,15 @@ QString NetCDFFilterPrivate::scanAttrs(int ncid, int varid, int attid, QTreeWidg
 			}
 			QStringList props;
 			props << translateDataType(type) << " (" << QString::number(len) << ")";
-			QTreeWidgetItem *attrItem = new QTreeWidgetItem(QStringList() << QString(name) << typeName << props.join("") << valueString.join(", "));
-			attrItem->setIcon(0, QIcon(KIcon("accessories-calculator")));
-			attrItem->setFlags(Qt::ItemIsEnabled);
-			parentItem->addChild(attrItem);
+			*content << FileContentItem(parent, QStringList() << QString(name) << typeName << props.join("") << valueString.join(", "),
+				"accessories-calculator");
 		}
 	}
 
 	return valueString.join("\n");
 }
 
-void NetCDFFilterPrivate::scanDims(int ncid, int ndims, QTreeWidgetItem* parentItem) {
+void NetCDFFilterPrivate::scanDims(int ncid, int ndims, FileContent& content, int parent) {
 	int ulid;
 	status = nc_inq_unlimdim(ncid, &ulid);
 	handleError(status, "nc_inq_att");
@@ -370,14 +377,11 @@ void NetCDFFilterPrivate::scanDims(int ncid, int ndims, QTreeWidgetItem* parentI
 		QString value;
 		if (i == ulid)
 			value = i18n("unlimited");
-		QTreeWidgetItem *attrItem = new QTreeWidgetItem(QStringList() << QString(name) << i18n("dimension") << props.join("") << value);
-		attrItem->setIcon(0, QIcon(KIcon("accessories-calculator")));
-		attrItem->setFlags(Qt::ItemIsEnabled);
-		parentItem->addChild(attrItem);
+		content << FileContentItem(parent, QStringList() << QString(name) << i18n("dimension") << props.join("") << value, "accessories-calculator");
 	}
 }
 
-void NetCDFFilterPrivate::scanVars(int ncid, int nvars, QTreeWidgetItem* parentItem) {
+void NetCDFFilterPrivate::scanVars(int ncid, int nvars, FileContent& content, int parent) {
 	char name[NC_MAX_NAME + 1];
 	nc_type type;
 	int ndims, nattrs;
@@ -403,26 +407,122 @@ void NetCDFFilterPrivate::scanVars(int ncid, int nvars, QTreeWidgetItem* parentI
 		}
 		props << ")";
 
-		QTreeWidgetItem *varItem = new QTreeWidgetItem(QStringList() << QString(name) << i18n("variable") << props.join("") << "");
-		varItem->setIcon(0, QIcon(KIcon("x-office-spreadsheet")));
-		varItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-		// highlight item
-		for (int c = 0; c < varItem->columnCount(); c++) {
-			varItem->setBackground(c, QColor(192, 255, 192));
-			varItem->setForeground(c, Qt::black);
-		}
-		parentItem->addChild(varItem);
+		FileContentItem varItem(parent, QStringList() << QString(name) << i18n("variable") << props.join("") << "",
+			"x-office-spreadsheet", Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+		varItem.highlighted = true;
+		//the attributes are scanned when the variable is expanded, see parseVar()
+		varItem.expandable = (nattrs > 0);
+		content << varItem;
+	}
+}
+
+/*!
+  returns the number of rows of a variable with \c rowSize bytes per row to be read at once (about 4 MiB).
+  For chunked variables the number of rows is a multiple of the rows in one chunk, returned in \c chunkRows.
+*/
+size_t NetCDFFilterPrivate::blockRows(int ncid, int varid, int ndims, size_t rowSize, size_t& chunkRows) {
+	size_t rows = qMax((size_t)1, 4*1024*1024/qMax(rowSize, (size_t)1));
+	chunkRows = 1;
+
+	int storage;
+	size_t* chunkSizes = (size_t *) malloc(ndims * sizeof(size_t));
+	status = nc_inq_var_chunking(ncid, varid, &storage, chunkSizes);
+	handleError(status, "nc_inq_var_chunking");
+	if (status == NC_NOERR && storage == NC_CHUNKED && chunkSizes[0] > 0) {
+		chunkRows = chunkSizes[0];
+		rows = qMax(chunkRows, rows - rows % chunkRows);
+	}
+	free(chunkSizes);
+
+	return rows;
+}
+
+/*!
+  reads the hyperslab defined by \c start, \c count and \c stride of the one or two dimensional variable \c varid
+  in its native type \c type into \c buffer and converts the values to the columns \c columns.
+  \c buffer has to hold count[0]*count[1] values of eight bytes.
+  To be called with the library mutex locked, the mutex is released while the values are converted.
+*/
+void NetCDFFilterPrivate::readBlock(int ncid, int varid, nc_type type, int ndims, const size_t* start, const size_t* count,
+		const ptrdiff_t* stride, void* buffer, double** columns) {
+	const size_t cols = (ndims == 2) ? count[1] : 1;
+
+	// double values of one dimensional variables are read without conversion
+	if (type == NC_DOUBLE && cols == 1) {
+		status = nc_get_vars_double(ncid, varid, start, count, stride, columns[0]);
+		handleError(status, "nc_get_vars_double");
+		return;
+	}
+
+#define READ_BLOCK(T, function) \
+	status = function(ncid, varid, start, count, stride, (T*)buffer); \
+	handleError(status, #function); \
+	AbstractFileFilter::libraryMutex()->unlock(); \
+	convertBlock<T>((const T*)buffer, count[0], cols, columns); \
+	AbstractFileFilter::libraryMutex()->lock();
+
+	switch (type) {
+	case NC_BYTE:
+		READ_BLOCK(signed char, nc_get_vars_schar);
+		break;
+	case NC_UBYTE:
+		READ_BLOCK(unsigned char, nc_get_vars_uchar);
+		break;
+	case NC_SHORT:
+		READ_BLOCK(short, nc_get_vars_short);
+		break;
+	case NC_USHORT:
+		READ_BLOCK(unsigned short, nc_get_vars_ushort);
+		break;
+	case NC_INT:
+		READ_BLOCK(int, nc_get_vars_int);
+		break;
+	case NC_UINT:
+		READ_BLOCK(unsigned int, nc_get_vars_uint);
+		break;
+	case NC_INT64:
+		READ_BLOCK(long long, nc_get_vars_longlong);
+		break;
+	case NC_UINT64:
+		READ_BLOCK(unsigned long long, nc_get_vars_ulonglong);
+		break;
+	case NC_FLOAT:
+		READ_BLOCK(float, nc_get_vars_float);
+		break;
+	default:
+		READ_BLOCK(double, nc_get_vars_double);
+	}
+#undef READ_BLOCK
+}
 
-		scanAttrs(ncid, i, -1, varItem);
+/*!
+  converts the \c rows x \c cols values in \c src (row major) to the columns \c columns.
+*/
+template <typename T>
+void NetCDFFilterPrivate::convertBlock(const T* src, size_t rows, size_t cols, double** columns) {
+	if (cols == 1) {
+		double* dest = columns[0];
+		for (size_t i = 0; i < rows; ++i)
+			dest[i] = src[i];
+		return;
+	}
+
+	for (size_t j = 0; j < cols; ++j) {
+		double* dest = columns[j];
+		const T* p = src + j;
+		for (size_t i = 0; i < rows; ++i, p += cols)
+			dest[i] = *p;
 	}
 }
 #endif
 
 /*!
-    parses the content of the file \c fileName and fill the tree using rootItem.
+    parses the content of the file \c fileName into \c content.
+    The global attributes, the dimensions and the variables are the children of three top level items.
 */
-void NetCDFFilterPrivate::parse(const QString & fileName, QTreeWidgetItem* rootItem) {
+void NetCDFFilterPrivate::parse(const QString & fileName, FileContent& content) {
 #ifdef HAVE_NETCDF
+	QMutexLocker locker(AbstractFileFilter::libraryMutex());
 	QByteArray bafileName = fileName.toLatin1();
 
 	int ncid;
@@ -434,31 +534,55 @@ void NetCDFFilterPrivate::parse(const QString & fileName, QTreeWidgetItem* rootI
 	handleError(status, "nc_inq");
 	DEBUG(" nattr/ndims/nvars =" << nattr << ndims << nvars);
 
-	QTreeWidgetItem *attrItem = new QTreeWidgetItem(QStringList() << QString(i18n("Attributes")));
-	attrItem->setIcon(0, QIcon(KIcon("folder")));
-	attrItem->setFlags(Qt::ItemIsEnabled);
-	rootItem->addChild(attrItem);
-	scanAttrs(ncid, NC_GLOBAL, -1, attrItem);
-
-	QTreeWidgetItem *dimItem = new QTreeWidgetItem(QStringList() << QString(i18n("Dimensions")));
-	dimItem->setIcon(0, QIcon(KIcon("folder")));
-	dimItem->setFlags(Qt::ItemIsEnabled);
-	rootItem->addChild(dimItem);
-	scanDims(ncid, ndims, dimItem);
-
-	QTreeWidgetItem *varItem = new QTreeWidgetItem(QStringList() << QString(i18n("Variables")));
-	varItem->setIcon(0, QIcon(KIcon("folder")));
-	varItem->setFlags(Qt::ItemIsEnabled);
-	rootItem->addChild(varItem);
-	scanVars(ncid, nvars, varItem);
+	content << FileContentItem(-1, QStringList() << QString(i18n("Attributes")), "folder");
+	scanAttrs(ncid, NC_GLOBAL, -1, &content, content.size() - 1);
+
+	content << FileContentItem(-1, QStringList() << QString(i18n("Dimensions")), "folder");
+	scanDims(ncid, ndims, content, content.size() - 1);
+
+	content << FileContentItem(-1, QStringList() << QString(i18n("Variables")), "folder");
+	scanVars(ncid, nvars, content, content.size() - 1);
+
+	status = nc_close(ncid);
+	handleError(status, "nc_close");
 #else
 	Q_UNUSED(fileName)
-	Q_UNUSED(rootItem)
+	Q_UNUSED(content)
+#endif
+}
+
+/*!
+    scans the attributes of the variable \c varName into \c content.
+*/
+void NetCDFFilterPrivate::parseVar(const QString & fileName, const QString& varName, FileContent& content) {
+#ifdef HAVE_NETCDF
+	QMutexLocker locker(AbstractFileFilter::libraryMutex());
+	QByteArray bafileName = fileName.toLatin1();
+	int ncid;
+	status = nc_open(bafileName.data(), NC_NOWRITE, &ncid);
+	handleError(status, "nc_open");
+	if (status != NC_NOERR)
+		return;
+
+	int varid;
+	QByteArray baVarName = varName.toLatin1();
+	status = nc_inq_varid(ncid, baVarName.data(), &varid);
+	handleError(status, "nc_inq_varid");
+	if (status == NC_NOERR)
+		scanAttrs(ncid, varid, -1, &content, -1);
+
+	status = nc_close(ncid);
+	handleError(status, "nc_close");
+#else
+	Q_UNUSED(fileName)
+	Q_UNUSED(varName)
+	Q_UNUSED(content)
 #endif
 }
 
 QString NetCDFFilterPrivate::readAttribute(const QString & fileName, const QString & name, const QString & varName) {
 #ifdef HAVE_NETCDF
+	QMutexLocker locker(AbstractFileFilter::libraryMutex());
 	int ncid;
 	QByteArray bafileName = fileName.toLatin1();
 	status = nc_open(bafileName.data(), NC_NOWRITE, &ncid);
@@ -480,7 +604,10 @@ QString NetCDFFilterPrivate::readAttribute(const QString & fileName, const QStri
 	status = nc_inq_attid(ncid, varid, baName.data(), &attid);
 	handleError(status, "nc_inq_attid");
 
-	return scanAttrs(ncid, varid, attid);
+	const QString value = scanAttrs(ncid, varid, attid);
+	status = nc_close(ncid);
+	handleError(status, "nc_close");
+	return value;
 #else
 	Q_UNUSED(fileName)
 	Q_UNUSED(name)
@@ -500,6 +627,10 @@ QList<QStringList> NetCDFFilterPrivate::readCurrentVar(const QString & fileName,
 	QDEBUG(" current variable =" << currentVarName);
 
 #ifdef HAVE_NETCDF
+	QMutexLocker locker(AbstractFileFilter::libraryMutex());
+	if (dataSource != NULL)
+		q->resetProgress();
+
 	int ncid;
 	QByteArray bafileName = fileName.toLatin1();
 	status = nc_open(bafileName.data(), NC_NOWRITE, &ncid);
@@ -545,23 +676,8 @@ QList<QStringList> NetCDFFilterPrivate::readCurrentVar(const QString & fileName,
 			DEBUG("act rows/cols" << actualRows << actualCols);
 
 			if (dataSource != NULL)
-				columnOffset = dataSource->create(dataPointers, mode, actualRows, actualCols);
-
-			double* data = 0;
-			if (dataSource)
-				data = dataPointers[0]->data();
-			else
-				data = (double *)malloc(actualRows * sizeof(double));
-
-			size_t start = startRow-1, count = actualRows;
-			status = nc_get_vara_double(ncid, varid, &start, &count, data);
-			handleError(status, "nc_get_vara_double");
-
-			if (!dataSource) {
-				for (int i = 0; i < qMin(actualRows, lines); i++)
-					dataStrings << (QStringList() << QString::number(data[i]));
-				free(data);
-			}
+				columnOffset = dataSource->create(dataPointers, mode, RowSampler(q, actualRows).rows(), actualCols);
+			dataStrings = readRows(ncid, varid, type, ndims, actualRows, actualCols, lines, dataPointers);
 			break;
 		}
 	case 2: {
@@ -587,29 +703,8 @@ QList<QStringList> NetCDFFilterPrivate::readCurrentVar(const QString & fileName,
 			DEBUG("lines:" << lines);
 
 			if (dataSource != NULL)
-				columnOffset = dataSource->create(dataPointers, mode, actualRows, actualCols);
-
-			double** data = (double**) malloc(rows * sizeof(double*));
-			data[0] = (double*)malloc( cols * rows * sizeof(double) );
-			for (unsigned int i = 1; i < rows; i++) data[i] = data[0] + i*cols;
-
-			status = nc_get_var_double(ncid, varid, &data[0][0]);
-			handleError(status, "nc_get_var_double");
-			for (int i = 0; i < qMin((int)rows, lines); i++) {
-				QStringList line;
-				for (unsigned int j = 0; j < cols; j++) {
-					if (!dataPointers.isEmpty())
-						dataPointers[j-startColumn+1]->operator[](i-startRow+1) = data[i][j];
-					else {
-						line << QString::number(static_cast<double>(data[i][j]));
-					}
-				}
-				dataStrings << line;
-				emit q->completed(100*i/actualRows);
-			}
-			free(data[0]);
-			free(data);
-
+				columnOffset = dataSource->create(dataPointers, mode, RowSampler(q, actualRows).rows(), actualCols);
+			dataStrings = readRows(ncid, varid, type, ndims, actualRows, actualCols, lines, dataPointers);
 			break;
 		}
 	default:
@@ -618,6 +713,9 @@ QList<QStringList> NetCDFFilterPrivate::readCurrentVar(const QString & fileName,
 	}
 
 	free(dimids);
+	status = nc_close(ncid);
+	handleError(status, "nc_close");
+	locker.unlock();
 
 	if (!dataSource)
 		return dataStrings;
@@ -626,7 +724,7 @@ QList<QStringList> NetCDFFilterPrivate::readCurrentVar(const QString & fileName,
 	// set column comments in spreadsheet
 	Spreadsheet* spreadsheet = dynamic_cast<Spreadsheet*>(dataSource);
 	if (spreadsheet) {
-		QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", actualRows);
+		QString comment = i18np("numerical data, %1 element", "numerical data, %1 elements", RowSampler(q, actualRows).rows());
 		for (int n = 0; n < actualCols; n++) {
 			Column* column = spreadsheet->column(columnOffset+n);
 			column->setComment(comment);
@@ -659,6 +757,100 @@ QList<QStringList> NetCDFFilterPrivate::readCurrentVar(const QString & fileName,
 	return dataStrings;
 }
 
+#ifdef HAVE_NETCDF
+/*!
+  reads the rows \c startRow to \c endRow and the columns \c startColumn to \c endColumn of the one or two dimensional
+  variable \c varid to the vectors \c dataPointers, or the first \c lines rows to strings if \c dataPointers is empty (preview).
+
+  The values are read in the native type of the variable in blocks aligned to the chunks of the variable and converted directly
+  to the columns. If every k-th row is imported, only these rows are read from the file by using a strided read.
+  The number of rows available in the columns is published after every block.
+*/
+QList<QStringList> NetCDFFilterPrivate::readRows(int ncid, int varid, nc_type type, int ndims, int actualRows, int actualCols,
+		int lines, QVector<QVector<double>*>& dataPointers) {
+	QList<QStringList> dataStrings;
+	if (actualRows <= 0 || actualCols <= 0)
+		return dataStrings;
+
+	size_t start[2] = {(size_t)startRow-1, (size_t)startColumn-1};
+	size_t count[2] = {0, (size_t)actualCols};
+	ptrdiff_t stride[2] = {1, 1};
+	QVector<QVector<double> > blockColumns(actualCols);
+	QVector<double*> columns(actualCols);
+
+	if (dataPointers.isEmpty()) {
+		count[0] = qMin(actualRows, lines);
+		void* buffer = malloc(count[0]*actualCols*sizeof(double));
+		for (int j = 0; j < actualCols; j++) {
+			blockColumns[j].resize(count[0]);
+			columns[j] = blockColumns[j].data();
+		}
+		readBlock(ncid, varid, type, ndims, start, count, stride, buffer, columns.data());
+		free(buffer);
+
+		for (size_t i = 0; i < count[0]; i++) {
+			QStringList line;
+			for (int j = 0; j < actualCols; j++)
+				line << QString::number(blockColumns[j][i]);
+			dataStrings << line;
+		}
+		return dataStrings;
+	}
+
+	// every k-th row is read with a strided read directly to the columns,
+	// for the other sampling modes all rows are read to a block and passed to the sampler
+	RowSampler sampler(q, actualRows);
+	const bool strided = sampler.isActive() && q->samplingMode() == AbstractFileFilter::EveryKthRow;
+	const bool direct = !sampler.isActive() || strided;
+	if (strided)
+		stride[0] = q->samplingFactor();
+	const size_t rows = direct ? sampler.rows() : actualRows;
+
+	size_t chunkRows;
+	const size_t blockSize = qMin(blockRows(ncid, varid, ndims, actualCols*sizeof(double), chunkRows), rows);
+	if (strided)
+		chunkRows = 1;
+	void* buffer = malloc(blockSize*actualCols*sizeof(double));
+	if (!direct) {
+		for (int j = 0; j < actualCols; j++)
+			blockColumns[j].resize(blockSize);
+	}
+
+	size_t row = 0;
+	while (row < rows) {
+		if (q->isCanceled())
+			break;
+
+		// the first block ends at a chunk boundary, all further blocks start at one
+		start[0] = startRow-1 + row*stride[0];
+		const size_t offset = start[0] % chunkRows;
+		count[0] = qMin(blockSize > offset ? blockSize - offset : blockSize, rows - row);
+
+		for (int j = 0; j < actualCols; j++)
+			columns[j] = direct ? dataPointers[j]->data() + row : blockColumns[j].data();
+		readBlock(ncid, varid, type, ndims, start, count, stride, buffer, columns.data());
+
+		if (!direct) {
+			AbstractFileFilter::libraryMutex()->unlock();
+			for (size_t i = 0; i < count[0]; i++) {
+				if (!sampler.nextRow())
+					continue;
+				for (int j = 0; j < actualCols; j++)
+					sampler.setValue(dataPointers[j], blockColumns[j][i]);
+			}
+			AbstractFileFilter::libraryMutex()->lock();
+		}
+
+		row += count[0];
+		q->setProgress(row, rows);
+		q->setAvailableRows(direct ? row : sampler.completedRows());
+	}
+	free(buffer);
+
+	return dataStrings;
+}
+#endif
+
 /*!
     reads the content of the current selected variable from file \c fileName to the data source \c dataSource.
     Uses the settings defined in the data source.
@@ -677,9 +869,65 @@ void NetCDFFilterPrivate::read(const QString & fileName, AbstractDataSource* dat
     writes the content of \c dataSource to the file \c fileName.
 */
 void NetCDFFilterPrivate::write(const QString & fileName, AbstractDataSource* dataSource) {
+#ifdef HAVE_NETCDF
+	QVector<const QVector<double>*> columns;
+	QStringList names;
+	const int rows = AbstractFileFilter::numericColumns(dataSource, columns, names);
+	if (columns.isEmpty() || rows == 0)
+		return;
+
+	QMutexLocker locker(AbstractFileFilter::libraryMutex());
+	int ncid;
+	QByteArray bafileName = fileName.toLatin1();
+	status = nc_create(bafileName.data(), NC_CLOBBER|NC_64BIT_OFFSET, &ncid);
+	handleError(status, "nc_create");
+	if (status != NC_NOERR)
+		return;
+
+	// define the dimensions and the variables: one variable per numeric column of a spreadsheet
+	// or one two dimensional variable for a matrix
+	Matrix* matrix = dynamic_cast<Matrix*>(dataSource);
+	int dimids[2];
+	status = nc_def_dim(ncid, "rows", rows, &dimids[0]);
+	handleError(status, "nc_def_dim");
+	QVector<int> varids;
+	if (matrix) {
+		status = nc_def_dim(ncid, "columns", columns.size(), &dimids[1]);
+		handleError(status, "nc_def_dim");
+		int varid;
+		QByteArray baName = matrix->name().replace('/', '_').toLatin1();
+		status = nc_def_var(ncid, baName.data(), NC_DOUBLE, 2, dimids, &varid);
+		handleError(status, "nc_def_var");
+		varids << varid;
+	} else {
+		for (int j = 0; j < columns.size(); ++j) {
+			int varid;
+			QByteArray baName = QString(names.at(j)).replace('/', '_').toLatin1();
+			status = nc_def_var(ncid, baName.data(), NC_DOUBLE, 1, dimids, &varid);
+			handleError(status, "nc_def_var");
+			varids << varid;
+		}
+	}
+	status = nc_enddef(ncid);
+	handleError(status, "nc_enddef");
+
+	// write the values of every column with one call
+	for (int j = 0; j < columns.size(); ++j) {
+		const size_t start[2] = {0, (size_t)j};
+		const size_t count[2] = {(size_t)qMin(columns.at(j)->size(), rows), 1};
+		if (count[0] > 0) {
+			status = nc_put_vara_double(ncid, matrix ? varids.first() : varids.at(j), start, count, columns.at(j)->constData());
+			handleError(status, "nc_put_vara_double");
+		}
+		emit q->completed(100*(j+1)/columns.size());
+	}
+
+	status = nc_close(ncid);
+	handleError(status, "nc_close");
+#else
 	Q_UNUSED(fileName);
 	Q_UNUSED(dataSource);
-	//TODO: not implemented yet
+#endif
 }
 
 //##############################################################################
@@ -691,6 +939,7 @@ void NetCDFFilterPrivate::write(const QString & fileName, AbstractDataSource* da
  */
 void NetCDFFilter::save(QXmlStreamWriter* writer) const {
 	writer->writeStartElement("netcdfFilter");
+	saveSamplingAttributes(writer);
 	writer->writeEndElement();
 }
 
@@ -705,5 +954,6 @@ bool NetCDFFilter::load(XmlStreamReader* reader) {
 
 	QString attributeWarning = i18n("Attribute '%1' missing or empty, default value is used");
 	QXmlStreamAttributes attribs = reader->attributes();
+	loadSamplingAttributes(attribs);
 	return true;
 }
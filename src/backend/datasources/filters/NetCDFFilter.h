@@ -28,8 +28,8 @@ Copyright            : (C) 2015 Stefan Gerlach (stefan.gerlach@uni.kn)
 #define NETCDFFILTER_H
 
 #include <QStringList>
-#include <QTreeWidgetItem>
 #include "backend/datasources/filters/AbstractFileFilter.h"
+#include "backend/datasources/filters/FileContentItem.h"
 
 class NetCDFFilterPrivate;
 class NetCDFFilter : public AbstractFileFilter{
@@ -40,7 +40,8 @@ class NetCDFFilter : public AbstractFileFilter{
 	NetCDFFilter();
 	~NetCDFFilter();
 
-	void parse(const QString & fileName, QTreeWidgetItem* rootItem);
+	void parse(const QString & fileName, FileContent& content);
+	void parseVar(const QString & fileName, const QString& varName, FileContent& content);
 	void read(const QString & fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode importMode=AbstractFileFilter::Replace);
 	QString readAttribute(const QString & fileName, const QString & name, const QString & varName);
 	QList<QStringList> readCurrentVar(const QString & fileName, AbstractDataSource* dataSource, AbstractFileFilter::ImportMode importMode=AbstractFileFilter::Replace, int lines=-1);
@@ -27,6 +27,7 @@ Copyright            : (C) 2015 Stefan Gerlach (stefan.gerlach@uni.kn)
 #ifndef NETCDFFILTERPRIVATE_H
 #define NETCDFFILTERPRIVATE_H
 
+#include "backend/datasources/filters/FileContentItem.h"
 #ifdef HAVE_NETCDF
 #include <netcdf.h>
 #endif
@@ -38,7 +39,8 @@ class NetCDFFilterPrivate {
 	public:
 		explicit NetCDFFilterPrivate(NetCDFFilter*);
 
-		void parse(const QString & fileName, QTreeWidgetItem* rootItem);
+		void parse(const QString & fileName, FileContent& content);
+		void parseVar(const QString & fileName, const QString& varName, FileContent& content);
 		void read(const QString & fileName, AbstractDataSource* dataSource,
 					AbstractFileFilter::ImportMode importMode = AbstractFileFilter::Replace);
 		QString readAttribute(const QString & fileName, const QString & name, const QString & varName);
@@ -58,9 +60,15 @@ class NetCDFFilterPrivate {
 #ifdef HAVE_NETCDF
 		void handleError(int status, QString function);
 		QString translateDataType(nc_type type);
-		QString scanAttrs(int ncid, int varid, int attid, QTreeWidgetItem* parentItem=NULL);
-		void scanDims(int ncid, int ndims, QTreeWidgetItem* parentItem);
-		void scanVars(int ncid, int nvars, QTreeWidgetItem* parentItem);
+		QString scanAttrs(int ncid, int varid, int attid, FileContent* content=NULL, int parent=-1);
+		void scanDims(int ncid, int ndims, FileContent& content, int parent);
+		void scanVars(int ncid, int nvars, FileContent& content, int parent);
+		size_t blockRows(int ncid, int varid, int ndims, size_t rowSize, size_t& chunkRows);
+		QList<QStringList> readRows(int ncid, int varid, nc_type type, int ndims, int actualRows, int actualCols,
+				int lines, QVector<QVector<double>*>& dataPointers);
+		void readBlock(int ncid, int varid, nc_type type, int ndims, const size_t* start, const size_t* count,
+				const ptrdiff_t* stride, void* buffer, double** columns);
+		template <typename T> static void convertBlock(const T* src, size_t rows, size_t cols, double** columns);
 #endif
 };
 
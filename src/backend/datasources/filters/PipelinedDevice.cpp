@@ -0,0 +1,200 @@
+/***************************************************************************
+File                 : PipelinedDevice.cpp
+Project              : LabPlot
+Description          : Read-only device decompressing in a separate thread
+--------------------------------------------------------------------
+Copyright            : (C) 2017 by the LabPlot developers
+***************************************************************************/
+
+/***************************************************************************
+*                                                                         *
+*  This program is free software; you can redistribute it and/or modify   *
+*  it under the terms of the GNU General Public License as published by   *
+*  the Free Software Foundation; either version 2 of the License, or      *
+*  (at your option) any later version.                                    *
+*                                                                         *
+*  This program is distributed in the hope that it will be useful,        *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+*  GNU General Public License for more details.                           *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program; if not, write to the Free Software           *
+*   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+*   Boston, MA  02110-1301  USA                                           *
+*                                                                         *
+***************************************************************************/
+#include "PipelinedDevice.h"
+
+#include <QFile>
+#include <QThread>
+#include <QMutexLocker>
+
+#include <KFilterDev>
+
+/*!
+\class PipelinedDevice
+\brief Sequential read-only device for compressed files (gzip, bzip2, xz).
+
+The file is decompressed by KFilterDev in a separate thread that fills a bounded queue of large blocks,
+the parser reads from this queue. Decompression and parsing run concurrently and the parser doesn't
+have to wait for the decompression of every single line.
+
+\ingroup datasources
+*/
+
+class PipelinedDevice::DecompressionThread : public QThread {
+	public:
+		explicit DecompressionThread(PipelinedDevice* device) : m_device(device) {}
+		void run() {
+			m_device->decompress();
+		};
+
+	private:
+		PipelinedDevice* m_device;
+};
+
+/*!
+  returns a device to read the file \c fileName.
+  For compressed files a PipelinedDevice is returned, a plain QFile otherwise.
+  The caller takes the ownership of the device.
+*/
+QIODevice* PipelinedDevice::deviceForFile(const QString& fileName) {
+	QIODevice* device = KFilterDev::deviceForFile(fileName);
+	if (qobject_cast<QFile*>(device))
+		return device;
+
+	return new PipelinedDevice(device);
+}
+
+PipelinedDevice::PipelinedDevice(QIODevice* source) : QIODevice(),
+	m_source(source), m_thread(new DecompressionThread(this)),
+	m_finished(false), m_aborted(false), m_currentPos(0) {
+}
+
+PipelinedDevice::~PipelinedDevice() {
+	close();
+	delete m_thread;
+	delete m_source;
+}
+
+bool PipelinedDevice::open(OpenMode mode) {
+	if (mode & QIODevice::WriteOnly)
+		return false;
+
+	if (!m_source->open(QIODevice::ReadOnly))
+		return false;
+
+	m_finished = false;
+	m_aborted = false;
+	m_blocks.clear();
+	m_current.clear();
+	m_currentPos = 0;
+
+	QIODevice::open(mode);
+	m_thread->start();
+	return true;
+}
+
+void PipelinedDevice::close() {
+	if (!isOpen())
+		return;
+
+	//stop the decompression, the reader might close the device before the end of the file is reached
+	m_mutex.lock();
+	m_aborted = true;
+	m_spaceAvailable.wakeAll();
+	m_mutex.unlock();
+	m_thread->wait();
+
+	m_source->close();
+	m_blocks.clear();
+	m_current.clear();
+	QIODevice::close();
+}
+
+bool PipelinedDevice::isSequential() const {
+	return true;
+}
+
+bool PipelinedDevice::atEnd() const {
+	if (m_currentPos < m_current.size() || QIODevice::bytesAvailable() > 0)
+		return false;
+
+	return !waitForBlock();
+}
+
+qint64 PipelinedDevice::bytesAvailable() const {
+	QMutexLocker locker(&m_mutex);
+	qint64 bytes = m_current.size() - m_currentPos;
+	foreach (const QByteArray& block, m_blocks)
+		bytes += block.size();
+
+	return bytes + QIODevice::bytesAvailable();
+}
+
+qint64 PipelinedDevice::readData(char* data, qint64 maxSize) {
+	qint64 bytesRead = 0;
+	while (bytesRead < maxSize) {
+		if (m_currentPos == m_current.size()) {
+			//don't block if some data was already read
+			if (bytesRead > 0 && bytesAvailable() == 0)
+				break;
+			if (!waitForBlock())
+				break;
+
+			QMutexLocker locker(&m_mutex);
+			m_current = m_blocks.dequeue();
+			m_currentPos = 0;
+			m_spaceAvailable.wakeOne();
+		}
+
+		const int n = qMin(maxSize - bytesRead, (qint64)(m_current.size() - m_currentPos));
+		memcpy(data + bytesRead, m_current.constData() + m_currentPos, n);
+		m_currentPos += n;
+		bytesRead += n;
+	}
+
+	return bytesRead;
+}
+
+qint64 PipelinedDevice::writeData(const char* data, qint64 maxSize) {
+	Q_UNUSED(data);
+	Q_UNUSED(maxSize);
+	return -1;
+}
+
+/*!
+  blocks until the decompression thread provides the next block or finishes.
+  returns \c false if no further data is available.
+*/
+bool PipelinedDevice::waitForBlock() const {
+	QMutexLocker locker(&m_mutex);
+	while (m_blocks.isEmpty() && !m_finished)
+		m_blockAvailable.wait(&m_mutex);
+
+	return !m_blocks.isEmpty();
+}
+
+/*!
+  decompresses the source device block by block. Runs in the decompression thread.
+*/
+void PipelinedDevice::decompress() {
+	while (true) {
+		QByteArray block = m_source->read(blockSize);
+
+		QMutexLocker locker(&m_mutex);
+		while (m_blocks.size() >= maxBlocks && !m_aborted)
+			m_spaceAvailable.wait(&m_mutex);
+
+		if (m_aborted || block.isEmpty())
+			break;
+
+		m_blocks.enqueue(block);
+		m_blockAvailable.wakeOne();
+	}
+
+	QMutexLocker locker(&m_mutex);
+	m_finished = true;
+	m_blockAvailable.wakeAll();
+}
@@ -0,0 +1,82 @@
+/***************************************************************************
+    File                 : PipelinedDevice.h
+    Project              : LabPlot
+    Description          : Read-only device decompressing in a separate thread
+    --------------------------------------------------------------------
+    Copyright            : (C) 2017 by the LabPlot developers
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef PIPELINEDDEVICE_H
+#define PIPELINEDDEVICE_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QThread;
+
+class PipelinedDevice : public QIODevice {
+	Q_OBJECT
+
+	public:
+		static QIODevice* deviceForFile(const QString& fileName);
+		~PipelinedDevice();
+
+		virtual bool open(OpenMode);
+		virtual void close();
+		virtual bool isSequential() const;
+		virtual bool atEnd() const;
+		virtual qint64 bytesAvailable() const;
+
+		static const int blockSize = 1024*1024;
+		static const int maxBlocks = 8;
+
+	protected:
+		virtual qint64 readData(char* data, qint64 maxSize);
+		virtual qint64 writeData(const char* data, qint64 maxSize);
+
+	private:
+		explicit PipelinedDevice(QIODevice* source);
+		void decompress();
+		bool waitForBlock() const;
+
+		class DecompressionThread;
+		friend class DecompressionThread;
+
+		QIODevice* m_source;
+		QThread* m_thread;
+
+		mutable QMutex m_mutex;
+		mutable QWaitCondition m_blockAvailable;
+		QWaitCondition m_spaceAvailable;
+		mutable QQueue<QByteArray> m_blocks;
+		bool m_finished;
+		bool m_aborted;
+
+		//block currently consumed by the reader, accessed in the reading thread only
+		mutable QByteArray m_current;
+		mutable int m_currentPos;
+};
+
+#endif
@@ -0,0 +1,151 @@
+/***************************************************************************
+File                 : RowSampler.cpp
+Project              : LabPlot
+Description          : Reduction of the rows during the import
+--------------------------------------------------------------------
+Copyright            : (C) 2017 by the LabPlot developers
+***************************************************************************/
+
+/***************************************************************************
+*                                                                         *
+*  This program is free software; you can redistribute it and/or modify   *
+*  it under the terms of the GNU General Public License as published by   *
+*  the Free Software Foundation; either version 2 of the License, or      *
+*  (at your option) any later version.                                    *
+*                                                                         *
+*  This program is distributed in the hope that it will be useful,        *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+*  GNU General Public License for more details.                           *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program; if not, write to the Free Software           *
+*   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+*   Boston, MA  02110-1301  USA                                           *
+*                                                                         *
+***************************************************************************/
+#include "RowSampler.h"
+
+/*!
+\class RowSampler
+\brief Reduces the rows of a data set to a sample during the import.
+
+The readers feed the rows of the file one after another. nextRow() decides whether the row is
+used at all, the values of the used rows are written with setValue() to the data containers
+created for rows() rows.
+
+Supported are every k-th row, a random sample of rows/k rows that keeps the order of the rows
+(selection sampling), and the envelope consisting of the minimum and the maximum of each column
+in buckets of k rows. The random sample is reproducible, all columns of a data set get the same rows
+also when they are read separately.
+
+\ingroup datasources
+*/
+
+RowSampler::RowSampler(AbstractFileFilter::SamplingMode mode, int factor, int rows) {
+	init(mode, factor, rows);
+}
+
+RowSampler::RowSampler(const AbstractFileFilter* filter, int rows) {
+	init(filter->samplingMode(), filter->samplingFactor(), rows);
+}
+
+void RowSampler::init(AbstractFileFilter::SamplingMode mode, int factor, int rows) {
+	m_mode = mode;
+	m_factor = qMax(factor, 1);
+	m_inputRows = qMax(rows, 0);
+	m_inputRow = -1;
+	m_outputRow = -1;
+	m_selected = 0;
+	m_firstInBucket = true;
+	m_seed = 0x9E3779B97F4A7C15ULL;
+
+	if (m_factor == 1)
+		m_mode = AbstractFileFilter::NoSampling;
+
+	switch (m_mode) {
+	case AbstractFileFilter::NoSampling:
+		m_rows = m_inputRows;
+		break;
+	case AbstractFileFilter::EveryKthRow:
+		m_rows = (m_inputRows + m_factor - 1)/m_factor;
+		break;
+	case AbstractFileFilter::RandomSample:
+		m_rows = m_inputRows/m_factor;
+		if (m_rows == 0 && m_inputRows > 0)
+			m_rows = 1;
+		break;
+	case AbstractFileFilter::MinMaxEnvelope:
+		m_rows = 2*((m_inputRows + m_factor - 1)/m_factor);
+		break;
+	}
+}
+
+/*!
+  returns \c true if the rows are reduced.
+*/
+bool RowSampler::isActive() const {
+	return m_mode != AbstractFileFilter::NoSampling;
+}
+
+/*!
+  returns the number of rows after the reduction.
+*/
+int RowSampler::rows() const {
+	return m_rows;
+}
+
+/*!
+  advances to the next row of the file. Returns \c false if the row is not part
+  of the sample, the reader can skip the row without parsing it in this case.
+*/
+bool RowSampler::nextRow() {
+	++m_inputRow;
+	if (m_inputRow >= m_inputRows)
+		return false;
+
+	switch (m_mode) {
+	case AbstractFileFilter::NoSampling:
+		m_outputRow = m_inputRow;
+		return true;
+	case AbstractFileFilter::EveryKthRow:
+		if (m_inputRow % m_factor)
+			return false;
+		m_outputRow = m_inputRow/m_factor;
+		return true;
+	case AbstractFileFilter::RandomSample: {
+		//Knuth's algorithm S: select the row with probability (needed rows)/(remaining rows)
+		const int needed = m_rows - m_selected;
+		if (needed <= 0 || random()*(m_inputRows - m_inputRow) >= needed)
+			return false;
+		m_outputRow = m_selected++;
+		return true;
+	}
+	case AbstractFileFilter::MinMaxEnvelope:
+		m_outputRow = m_inputRow/m_factor;
+		m_firstInBucket = (m_inputRow % m_factor == 0);
+		return true;
+	}
+
+	return false;
+}
+
+/*!
+  returns the number of leading rows of the sample whose values are final after the current row was set.
+  The min/max values of the current bucket can still change with the following rows.
+*/
+int RowSampler::completedRows() const {
+	if (m_mode == AbstractFileFilter::MinMaxEnvelope)
+		return 2*qMax(m_outputRow, 0);
+	return m_outputRow + 1;
+}
+
+/*!
+  returns a pseudo-random number in [0,1) (xorshift64*), the sequence is the same for every sampler.
+*/
+double RowSampler::random() {
+	m_seed ^= m_seed >> 12;
+	m_seed ^= m_seed << 25;
+	m_seed ^= m_seed >> 27;
+	return (double)((m_seed * 2685821657736338717ULL) >> 11)/9007199254740992.0;
+}
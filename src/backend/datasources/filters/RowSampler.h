@@ -0,0 +1,79 @@
+/***************************************************************************
+    File                 : RowSampler.h
+    Project              : LabPlot
+    Description          : Reduction of the rows during the import
+    --------------------------------------------------------------------
+    Copyright            : (C) 2017 by the LabPlot developers
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef ROWSAMPLER_H
+#define ROWSAMPLER_H
+
+#include "backend/datasources/filters/AbstractFileFilter.h"
+#include <QVector>
+
+class RowSampler {
+	public:
+		RowSampler(AbstractFileFilter::SamplingMode, int factor, int rows);
+		explicit RowSampler(const AbstractFileFilter*, int rows);
+
+		bool isActive() const;
+		int rows() const;
+
+		bool nextRow();
+		int completedRows() const;
+
+		//! sets the value of the current row in the vector \c v
+		inline void setValue(QVector<double>* v, double value) const {
+			if (m_mode != AbstractFileFilter::MinMaxEnvelope) {
+				v->operator[](m_outputRow) = value;
+				return;
+			}
+
+			double& min = v->operator[](2*m_outputRow);
+			double& max = v->operator[](2*m_outputRow + 1);
+			if (m_firstInBucket || min != min) {
+				min = value;
+				max = value;
+			} else if (value < min)
+				min = value;
+			else if (value > max)
+				max = value;
+		}
+
+	private:
+		void init(AbstractFileFilter::SamplingMode, int factor, int rows);
+		double random();
+
+		AbstractFileFilter::SamplingMode m_mode;
+		int m_factor;
+		int m_inputRows;
+		int m_rows;
+
+		int m_inputRow;
+		int m_outputRow;
+		int m_selected;
+		bool m_firstInBucket;
+		quint64 m_seed;
+};
+
+#endif
@@ -0,0 +1,95 @@
+/***************************************************************************
+    File                 : RowSampler_test.cpp
+    Project              : LabPlot
+    Description          : Tests of the reduction of the rows during the import
+    --------------------------------------------------------------------
+    Copyright            : (C) 2017 by the LabPlot developers
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include "RowSampler.h"
+
+//the sampler only needs the settings of the filter, the rest of AbstractFileFilter is not linked
+AbstractFileFilter::SamplingMode AbstractFileFilter::samplingMode() const {
+	return m_samplingMode;
+}
+int AbstractFileFilter::samplingFactor() const {
+	return m_samplingFactor;
+}
+
+/* reads the values 0..rows-1 through the sampler and returns the sample */
+static QVector<double> sample(AbstractFileFilter::SamplingMode mode, int factor, int rows) {
+	RowSampler sampler(mode, factor, rows);
+	QVector<double> v(sampler.rows());
+	for (int i = 0; i < rows; ++i) {
+		if (sampler.nextRow())
+			sampler.setValue(&v, i);
+	}
+
+	return v;
+}
+
+static int check(const char* name, const QVector<double>& v, const double* expected, int n) {
+	printf("%s:", name);
+	for (int i = 0; i < v.size(); ++i)
+		printf(" %g", v.at(i));
+
+	int failed = (v.size() != n);
+	for (int i = 0; i < n && !failed; ++i)
+		failed = (v.at(i) != expected[i]);
+
+	printf(failed ? "\tFAILED\n" : "\tOK\n");
+	return failed;
+}
+
+int main() {
+	int failed = 0;
+
+	const double all[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+	failed += check("all rows", sample(AbstractFileFilter::NoSampling, 3, 10), all, 10);
+	//a factor of 1 doesn't reduce the rows in any mode
+	failed += check("factor 1", sample(AbstractFileFilter::MinMaxEnvelope, 1, 10), all, 10);
+
+	const double kth[] = {0, 3, 6, 9};
+	failed += check("every 3rd row", sample(AbstractFileFilter::EveryKthRow, 3, 10), kth, 4);
+
+	//min and max of the buckets {0,1,2}, {3,4,5}, {6,7,8} and {9}
+	const double envelope[] = {0, 2, 3, 5, 6, 8, 9, 9};
+	failed += check("min/max envelope", sample(AbstractFileFilter::MinMaxEnvelope, 3, 10), envelope, 8);
+
+	//random sample: 1/k of the rows, in ascending order, the same rows for every column
+	QVector<double> random = sample(AbstractFileFilter::RandomSample, 4, 1000);
+	QVector<double> random2 = sample(AbstractFileFilter::RandomSample, 4, 1000);
+	int randomFailed = (random.size() != 250);
+	for (int i = 1; i < random.size() && !randomFailed; ++i)
+		randomFailed = (random.at(i) <= random.at(i-1));
+	for (int i = 0; i < random.size() && !randomFailed; ++i)
+		randomFailed = (random.at(i) != random2.at(i));
+	printf("random sample: %d of 1000 rows, first %g, last %g\t%s\n", random.size(),
+		random.isEmpty() ? -1. : random.at(0), random.isEmpty() ? -1. : random.at(random.size()-1),
+		randomFailed ? "FAILED" : "OK");
+	failed += randomFailed;
+
+	printf("%d test(s) failed\n", failed);
+	return failed;
+}
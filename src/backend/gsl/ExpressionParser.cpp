@@ -30,7 +30,11 @@
 #include "backend/gsl/ExpressionParser.h"
 
 #include <klocale.h>
+#include <QBitArray>
 #include <QDebug>
+#include <QFutureSynchronizer>
+#include <QThread>
+#include <QtConcurrentRun>
 
 #include <cmath>
 extern "C" {
@@ -1096,15 +1100,54 @@ const QVector<int>& ExpressionParser::constantsGroupIndices() {
 	return m_constantsGroupIndex;
 }
 
-bool ExpressionParser::isValid(const QString& expr, const QStringList& vars) {
-	for (int i = 0; i < vars.size(); ++i)
-		assign_variable(vars.at(i).toLocal8Bit().data(), 0);
+/*!
+	compiles \c expr once, the variables \c vars are bound to the slots 0, 1, ... of the values passed to parse_eval().
+	Returns 0 if the expression is not valid, the returned expression is freed with parse_free().
+ */
+parser_expr* ExpressionParser::compile(const QString& expr, const QStringList& vars) {
+	//the global symbols are initialized once by the instance
+	getInstance();
+
+	QList<QByteArray> names;
+	foreach (const QString& var, vars)
+		names << var.toLocal8Bit();
+	QVector<const char*> namePointers;
+	foreach (const QByteArray& name, names)
+		namePointers << name.constData();
+
+	const QByteArray funcba = expr.toLocal8Bit();
+	return parse_compile(funcba.constData(), namePointers.data(), namePointers.size());
+}
 
-	QByteArray funcba = expr.toLocal8Bit();
-	const char* data = funcba.data();
+bool ExpressionParser::isValid(const QString& expr, const QStringList& vars) {
 	gsl_set_error_handler_off();
-	parse(data);
-	return !(parse_errors()>0);
+	parser_expr* e = compile(expr, vars);
+	parse_free(e);
+	return (e != 0);
+}
+
+/*!
+	evaluates the compiled expression \c e for the \c n values in \c x, the parameters \c paramValues follow x in the slots.
+	The expression is evaluated for blocks of values at once, non-finite results are replaced by NAN.
+	Native code is generated for large numbers of values if available.
+ */
+static void evaluateVector(parser_expr* e, const double* x, int n, const QVector<double>& paramValues, double* y) {
+	QVector<const double*> vars;
+	QVector<int> strides;
+	vars << x;
+	strides << 1;
+	for (int i = 0; i < paramValues.size(); ++i) {
+		vars << paramValues.constData() + i;
+		strides << 0;
+	}
+
+	if (n >= PARSER_JIT_MIN_POINTS)
+		parse_jit(e, strides.constData());
+	parse_eval_vector(e, vars.constData(), strides.constData(), n, y);
+	for (int i = 0; i < n; ++i) {
+		if (!std::isfinite(y[i]))
+			y[i] = NAN;
+	}
 }
 
 bool ExpressionParser::evaluateCartesian(const QString& expr, const QString& min, const QString& max,
@@ -1113,104 +1156,60 @@ bool ExpressionParser::evaluateCartesian(const QString& expr, const QString& min
 	double xMin = parse(min.toLocal8Bit().data());
 	double xMax = parse(max.toLocal8Bit().data());
 	double step = (xMax - xMin)/(double)(count - 1);
-	const char* func = expr.toLocal8Bit().data();
-	double x, y;
 	gsl_set_error_handler_off();
 
-	for (int i = 0; i < paramNames.size(); ++i)
-		assign_variable(paramNames.at(i).toLocal8Bit().data(), paramValues.at(i));
-
-	for (int i = 0; i < count; i++) {
-		x = xMin + step * i;
-		assign_variable("x", x);
-		y = parse(func);
+	parser_expr* e = compile(expr, QStringList("x") << paramNames);
+	if (!e)
+		return false;
 
-		if (parse_errors() > 0)
-			return false;
-
-		(*xVector)[i] = x;
-		if (std::isfinite(y))
-			(*yVector)[i] = y;
-		else
-			(*yVector)[i] = NAN;
-	}
+	for (int i = 0; i < count; i++)
+		(*xVector)[i] = xMin + step * i;
+	evaluateVector(e, xVector->constData(), count, paramValues, yVector->data());
+	parse_free(e);
 
 	return true;
 }
 
 bool ExpressionParser::evaluateCartesian(const QString& expr, const QString& min, const QString& max,
 										 int count, QVector<double>* xVector, QVector<double>* yVector) {
-	double xMin = parse(min.toLocal8Bit().data());
-	double xMax = parse(max.toLocal8Bit().data());
-	double step = (xMax - xMin)/(double)(count - 1);
-	const char* func = expr.toLocal8Bit().data();
-	double x, y;
-	gsl_set_error_handler_off();
-
-	for (int i = 0; i < count; i++) {
-		x = xMin + step*i;
-		assign_variable("x", x);
-		y = parse(func);
-
-		if (parse_errors() > 0)
-			return false;
-
-		(*xVector)[i] = x;
-		if (std::isfinite(y))
-			(*yVector)[i] = y;
-		else
-			(*yVector)[i] = NAN;
-	}
-
-	return true;
+	return evaluateCartesian(expr, min, max, count, xVector, yVector, QStringList(), QVector<double>());
 }
 
 bool ExpressionParser::evaluateCartesian(const QString& expr, QVector<double>* xVector, QVector<double>* yVector) {
-	const char* func = expr.toLocal8Bit().data();
-	double x, y;
-	gsl_set_error_handler_off();
-
-	for (int i = 0; i < xVector->count(); i++) {
-		x = xVector->at(i);
-		assign_variable("x", x);
-		y = parse(func);
-
-		if (parse_errors() > 0)
-			return false;
-
-		if (std::isfinite(y))
-			(*yVector)[i] = y;
-		else
-			(*yVector)[i] = NAN;
-	}
-
-	return true;
+	return evaluateCartesian(expr, xVector, yVector, QStringList(), QVector<double>());
 }
 
 bool ExpressionParser::evaluateCartesian(const QString& expr, QVector<double>* xVector, QVector<double>* yVector,
 		const QStringList& paramNames, const QVector<double>& paramValues) {
-	const char* func = expr.toLocal8Bit().data();
-	double x, y;
 	gsl_set_error_handler_off();
 
-	for (int i = 0; i < paramNames.size(); ++i)
-		assign_variable(paramNames.at(i).toLocal8Bit().data(), paramValues.at(i));
+	parser_expr* e = compile(expr, QStringList("x") << paramNames);
+	if (!e)
+		return false;
 
-	for (int i = 0; i < xVector->count(); i++) {
-		x = xVector->at(i);
-		assign_variable("x", x);
-		y = parse(func);
+	evaluateVector(e, xVector->constData(), xVector->count(), paramValues, yVector->data());
+	parse_free(e);
 
-		if (parse_errors() > 0)
-			return false;
+	return true;
+}
 
-		if (std::isfinite(y))
-			(*yVector)[i] = y;
-		else
-			(*yVector)[i] = NAN;
+/*!
+	evaluates the compiled expression \c e for the rows \c first to \c last-1, the variables are read from \c xVectors.
+	Called in parallel for blocks of rows, the compiled expression is evaluated without a shared state.
+ */
+static void evaluateRows(const parser_expr* e, const QVector<QVector<double>*>& xVectors, double* y, int first, int last) {
+	QVector<const double*> vars;
+	QVector<int> strides;
+	for (int n = 0; n < xVectors.size(); ++n) {
+		vars << xVectors.at(n)->constData() + first;
+		strides << 1;
 	}
 
-	return true;
+	parse_eval_vector(e, vars.constData(), strides.constData(), last - first, y + first);
+	for (int i = first; i < last; i++) {
+		if (!std::isfinite(y[i]))
+			y[i] = NAN;
+	}
 }
 
 /*!
@@ -1220,40 +1219,88 @@ bool ExpressionParser::evaluateCartesian(const QString& expr, QVector<double>* x
  */
 bool ExpressionParser::evaluateCartesian(const QString& expr, const QStringList& vars, const QVector<QVector<double>*>& xVectors, QVector<double>* yVector) {
 	Q_ASSERT(vars.size() == xVectors.size());
-	const char* func = expr.toLocal8Bit().data();
-	double y, varValue;
-	QString varName;
-
 	gsl_set_error_handler_off();
 
-	bool stop = false;
-	for (int i = 0; i < yVector->size(); i++) {
-		//stop iterating over i if one of the x-vectors has no elements anymore.
-		for (int n = 0; n < xVectors.size(); ++n) {
-			if (i == xVectors.at(n)->size()) {
-				stop = true;
-				break;
-			}
-		}
-		if (stop)
-			break;
+	parser_expr* e = compile(expr, vars);
+	if (!e)
+		return false;
+
+	//stop iterating if one of the x-vectors has no elements anymore.
+	int rows = yVector->size();
+	for (int n = 0; n < xVectors.size(); ++n)
+		rows = qMin(rows, xVectors.at(n)->size());
+
+	// large columns are evaluated in blocks of rows in the thread pool
+	double* y = yVector->data();
+	if (rows >= PARSER_JIT_MIN_POINTS)
+		parse_jit(e, QVector<int>(xVectors.size(), 1).constData());
+	const int threads = QThread::idealThreadCount();
+	if (rows < 10000 || threads < 2) {
+		evaluateRows(e, xVectors, y, 0, rows);
+	} else {
+		const int blockSize = (rows + threads - 1)/threads;
+		QFutureSynchronizer<void> synchronizer;
+		for (int first = 0; first < rows; first += blockSize)
+			synchronizer.addFuture(QtConcurrent::run(evaluateRows, e, xVectors, y, first, qMin(first + blockSize, rows)));
+		synchronizer.waitForFinished();
+	}
+	parse_free(e);
 
-		for (int n = 0; n < vars.size(); ++n) {
-			varName = vars.at(n);
-			varValue = xVectors.at(n)->at(i);
-			assign_variable(varName.toLocal8Bit().data(), varValue);
-		}
+	return true;
+}
 
-		y = parse(func);
+/*!
+	evaluates the condition \c e for the rows \c first to \c last-1 and sets the bits of the rows where it is true.
+	\c first is a multiple of 8, the blocks of rows evaluated in parallel don't share the bytes of \c rows.
+ */
+static void evaluateConditionRows(const parser_expr* e, const QVector<QVector<double>*>& xVectors, QBitArray* rows, int first, int last) {
+	QVector<const double*> vars;
+	QVector<int> strides;
+	for (int n = 0; n < xVectors.size(); ++n) {
+		vars << xVectors.at(n)->constData() + first;
+		strides << 1;
+	}
 
-		if (parse_errors() > 0)
-			return false;
+	QVector<double> values(last - first);
+	parse_eval_vector(e, vars.constData(), strides.constData(), last - first, values.data());
+	for (int i = 0; i < values.size(); i++) {
+		if (values.at(i) != 0 && !std::isnan(values.at(i)))
+			rows->setBit(first + i);
+	}
+}
 
-		if (std::isfinite(y))
-			(*yVector)[i] = y;
-		else
-			(*yVector)[i] = NAN;
+/*!
+	evaluates the condition \c expr, e.g. "x > 3 && fabs(y - z) < 0.1", for all rows of the vectors \c xVectors
+	bound to the variables \c vars. \c rows is resized to the number of rows and bit i is set if the condition is true
+	(different from 0) in row i. The expression is compiled once and evaluated in parallel for blocks of rows.
+ */
+bool ExpressionParser::evaluateCondition(const QString& expr, const QStringList& vars, const QVector<QVector<double>*>& xVectors, QBitArray* rows) {
+	Q_ASSERT(vars.size() == xVectors.size());
+	gsl_set_error_handler_off();
+
+	parser_expr* e = compile(expr, vars);
+	if (!e)
+		return false;
+
+	int count = xVectors.isEmpty() ? 0 : xVectors.first()->size();
+	for (int n = 1; n < xVectors.size(); ++n)
+		count = qMin(count, xVectors.at(n)->size());
+
+	//the workers set the bits of their rows only, the bit array must not be shared
+	*rows = QBitArray(count);
+	if (count >= PARSER_JIT_MIN_POINTS)
+		parse_jit(e, QVector<int>(xVectors.size(), 1).constData());
+	const int threads = QThread::idealThreadCount();
+	if (count < 10000 || threads < 2) {
+		evaluateConditionRows(e, xVectors, rows, 0, count);
+	} else {
+		const int blockSize = ((count + threads - 1)/threads + 7) & ~7;
+		QFutureSynchronizer<void> synchronizer;
+		for (int first = 0; first < count; first += blockSize)
+			synchronizer.addFuture(QtConcurrent::run(evaluateConditionRows, e, xVectors, rows, first, qMin(first + blockSize, count)));
+		synchronizer.waitForFinished();
 	}
+	parse_free(e);
 
 	return true;
 }
@@ -1263,18 +1310,21 @@ bool ExpressionParser::evaluatePolar(const QString& expr, const QString& min, co
 	double minValue = parse(min.toLocal8Bit().data());
 	double maxValue = parse(max.toLocal8Bit().data());
 	double step = (maxValue - minValue)/(double)(count - 1);
-	QByteArray funcba = expr.toLocal8Bit();
-	const char* func = funcba.data();
-	double r, phi;
 	gsl_set_error_handler_off();
 
-	for (int i = 0; i < count; i++) {
-		phi = minValue + step * i;
-		assign_variable("phi", phi);
-		r = parse(func);
-		if (parse_errors() > 0)
-			return false;
+	parser_expr* e = compile(expr, QStringList("phi"));
+	if (!e)
+		return false;
 
+	// r(phi) is evaluated into yVector first
+	for (int i = 0; i < count; i++)
+		(*xVector)[i] = minValue + step * i;
+	evaluateVector(e, xVector->constData(), count, QVector<double>(), yVector->data());
+	parse_free(e);
+
+	for (int i = 0; i < count; i++) {
+		const double phi = xVector->at(i);
+		const double r = yVector->at(i);
 		if (std::isfinite(r)) {
 			(*xVector)[i] = r*cos(phi);
 			(*yVector)[i] = r*sin(phi);
@@ -1292,34 +1342,23 @@ bool ExpressionParser::evaluateParametric(const QString& expr1, const QString& e
 	double minValue = parse(min.toLocal8Bit().data());
 	double maxValue = parse(max.toLocal8Bit().data());
 	double step = (maxValue - minValue)/(double)(count - 1);
-	QByteArray xfuncba = expr1.toLocal8Bit();
-	const char* xFunc = xfuncba.data();
-	QByteArray yfuncba = expr2.toLocal8Bit();
-	const char* yFunc = yfuncba.data();
-	double x, y, t;
 	gsl_set_error_handler_off();
 
-	for (int i = 0; i < count; i++) {
-		t = minValue + step*i;
-		assign_variable("t", t);
-		x = parse(xFunc);
-		if (parse_errors() > 0)
-			return false;
-
-		if (std::isfinite(x))
-			(*xVector)[i] = x;
-		else
-			(*xVector)[i] = NAN;
-
-		y = parse(yFunc);
-		if (parse_errors() > 0)
-			return false;
-
-		if (std::isfinite(y))
-			(*yVector)[i] = y;
-		else
-			(*yVector)[i] = NAN;
+	parser_expr* xFunc = compile(expr1, QStringList("t"));
+	parser_expr* yFunc = compile(expr2, QStringList("t"));
+	if (!xFunc || !yFunc) {
+		parse_free(xFunc);
+		parse_free(yFunc);
+		return false;
 	}
 
+	QVector<double> t(count);
+	for (int i = 0; i < count; i++)
+		t[i] = minValue + step*i;
+	evaluateVector(xFunc, t.constData(), count, QVector<double>(), xVector->data());
+	evaluateVector(yFunc, t.constData(), count, QVector<double>(), yVector->data());
+	parse_free(xFunc);
+	parse_free(yFunc);
+
 	return true;
 }
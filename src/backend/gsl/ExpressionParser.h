@@ -32,10 +32,15 @@
 #include <QVector>
 #include <QStringList>
 
+class QBitArray;
+
+struct parser_expr;
+
 class ExpressionParser {
 
 public:
 	static ExpressionParser* getInstance();
+	static parser_expr* compile(const QString& expr, const QStringList& vars);
 
 	bool isValid(const QString& expr, const QStringList& vars);
 	bool evaluateCartesian( const QString& expr, const QString& min, const QString& max,
@@ -47,6 +52,7 @@ public:
 	bool evaluateCartesian(const QString& expr, QVector<double>* xVector, QVector<double>* yVector,
 					const QStringList& paramNames, const QVector<double>& paramValues);
 	bool evaluateCartesian(const QString& expr, const QStringList& vars, const QVector<QVector<double>*>& xVectors, QVector<double>* yVector);
+	bool evaluateCondition(const QString& expr, const QStringList& vars, const QVector<QVector<double>*>& xVectors, QBitArray* rows);
 	bool evaluatePolar(const QString& expr, const QString& min, const QString& max,
 					int count, QVector<double>* xVector, QVector<double>* yVector);
 	bool evaluateParametric(const QString& expr1, const QString& expr2, const QString& min, const QString& max,
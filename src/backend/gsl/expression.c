@@ -0,0 +1,1135 @@
+/***************************************************************************
+    File                 : expression.c
+    Project              : LabPlot
+    Description          : Compiled mathematical expressions
+    --------------------------------------------------------------------
+    Copyright            : (C) 2017 by the LabPlot developers
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+/* The parser builds the syntax tree of an expression, expr_compile_tree() translates it once to a
+   program for a stack machine. Evaluating the program doesn't parse, allocate or look up symbols by name,
+   the variables are read from the slots of the value array. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <gsl/gsl_math.h>
+#include "expression.h"
+
+expr_node* expr_node_new(expr_node **pool, expr_type type) {
+	expr_node *node = (expr_node *) calloc(1, sizeof(expr_node));
+	node->type = type;
+	node->next = *pool;
+	*pool = node;
+	return node;
+}
+
+void expr_node_free_all(expr_node *pool) {
+	while (pool) {
+		expr_node *next = pool->next;
+		free(pool);
+		pool = next;
+	}
+}
+
+/* state of the code generation */
+typedef struct compile_state {
+	parser_expr *expr;
+	int capacity;
+	int depth;	/* current size of the stack */
+	int nnodes;	/* number of nodes of the tree */
+	expr_node **classes;	/* first node of every class of equal subexpressions */
+	int nclasses;
+	int *uses;	/* number of evaluations of a class */
+	int *temp;	/* temporary holding the value of a class or -1 */
+	char *generated;	/* value of the class is already in its temporary */
+} compile_state;
+
+static expr_instr* emit(compile_state *s, expr_op op, int push) {
+	parser_expr *e = s->expr;
+	if (e->size == s->capacity) {
+		s->capacity = s->capacity ? 2*s->capacity : 16;
+		e->code = (expr_instr *) realloc(e->code, s->capacity * sizeof(expr_instr));
+	}
+
+	expr_instr *instr = &e->code[e->size++];
+	instr->op = op;
+	instr->arg = 0;
+	instr->value = 0;
+	instr->ptr.sym = 0;
+
+	s->depth += push;
+	if (s->depth > e->stack_size)
+		e->stack_size = s->depth;
+
+	return instr;
+}
+
+/* the common functions get their own instructions, they are evaluated without a call through a function pointer.
+   sqrt() is vectorized like the arithmetic operations if EXPR_OPENMP_SIMD is defined, exp(), log(), sin(), cos()
+   and pow() remain calls of the C library for each point (its vector variants require -ffast-math) */
+static expr_op function_op(const expr_node *node) {
+	const char *name = node->sym->name;
+	if (node->nargs == 1) {
+		if (strcmp(name, "sqrt") == 0)
+			return OP_SQRT;
+		if (strcmp(name, "exp") == 0)
+			return OP_EXP;
+		if (strcmp(name, "log") == 0 || strcmp(name, "ln") == 0)
+			return OP_LOG;
+		if (strcmp(name, "sin") == 0)
+			return OP_SIN;
+		if (strcmp(name, "cos") == 0)
+			return OP_COS;
+	} else if (node->nargs == 2 && strcmp(name, "pow") == 0)
+		return OP_POW;
+
+	return (expr_op)(OP_CALL0 + node->nargs);
+}
+
+static void generate(compile_state *s, const expr_node *node) {
+	int i;
+	expr_instr *instr;
+	const int temp = s->temp[node->id];
+
+	/* common subexpression evaluated before */
+	if (temp >= 0 && s->generated[node->id]) {
+		emit(s, OP_LOAD, 1)->arg = temp;
+		return;
+	}
+
+	switch (node->type) {
+	case EXPR_NUM:
+		emit(s, OP_NUM, 1)->value = node->value;
+		break;
+	case EXPR_VAR:
+		emit(s, OP_VAR, 1)->arg = node->slot;
+		break;
+	case EXPR_SYM:
+		emit(s, OP_SYM, 1)->ptr.sym = node->sym;
+		break;
+	case EXPR_ASSIGN:
+		generate(s, node->args[0]);
+		/* assignments to bound variables only pass the value */
+		if (node->sym)
+			emit(s, OP_STORE, 0)->ptr.sym = node->sym;
+		break;
+	case EXPR_FNCT:
+		for (i = 0; i < node->nargs; i++)
+			generate(s, node->args[i]);
+		instr = emit(s, function_op(node), node->nargs == 0 ? 1 : 1 - node->nargs);
+		instr->ptr.fnct = node->sym->value.fnctptr;
+		break;
+	case EXPR_NEG:
+		generate(s, node->args[0]);
+		emit(s, OP_NEG, 0);
+		break;
+	case EXPR_NOT:
+		generate(s, node->args[0]);
+		emit(s, OP_NOT, 0);
+		break;
+	case EXPR_ADD:
+	case EXPR_SUB:
+	case EXPR_MUL:
+	case EXPR_DIV:
+	case EXPR_POW:
+		generate(s, node->args[0]);
+		generate(s, node->args[1]);
+		emit(s, (expr_op)(OP_ADD + (node->type - EXPR_ADD)), -1);
+		break;
+	case EXPR_LT:
+	case EXPR_LE:
+	case EXPR_GT:
+	case EXPR_GE:
+	case EXPR_EQ:
+	case EXPR_NE:
+	case EXPR_AND:
+	case EXPR_OR:
+		generate(s, node->args[0]);
+		generate(s, node->args[1]);
+		emit(s, (expr_op)(OP_LT + (node->type - EXPR_LT)), -1);
+		break;
+	}
+
+	if (temp >= 0) {
+		emit(s, OP_SAVE, 0)->arg = temp;
+		s->generated[node->id] = 1;
+	}
+}
+
+/************ optimization ************/
+
+/* value of an operation with constant operands */
+static double fold(const expr_node *node, const double *v) {
+	switch (node->type) {
+	case EXPR_NEG:
+		return -v[0];
+	case EXPR_ADD:
+		return v[0] + v[1];
+	case EXPR_SUB:
+		return v[0] - v[1];
+	case EXPR_MUL:
+		return v[0] * v[1];
+	case EXPR_DIV:
+		return v[0] / v[1];
+	case EXPR_POW:
+		return pow(v[0], v[1]);
+	case EXPR_LT:
+		return v[0] < v[1];
+	case EXPR_LE:
+		return v[0] <= v[1];
+	case EXPR_GT:
+		return v[0] > v[1];
+	case EXPR_GE:
+		return v[0] >= v[1];
+	case EXPR_EQ:
+		return v[0] == v[1];
+	case EXPR_NE:
+		return v[0] != v[1];
+	case EXPR_AND:
+		return v[0] != 0 && v[1] != 0;
+	case EXPR_OR:
+		return v[0] != 0 || v[1] != 0;
+	case EXPR_NOT:
+		return v[0] == 0;
+	case EXPR_FNCT:
+		switch (node->nargs) {
+		case 1:
+			return (*node->sym->value.fnctptr)(v[0]);
+		case 2:
+			return (*node->sym->value.fnctptr)(v[0], v[1]);
+		case 3:
+			return (*node->sym->value.fnctptr)(v[0], v[1], v[2]);
+		default:
+			return (*node->sym->value.fnctptr)(v[0], v[1], v[2], v[3]);
+		}
+	case EXPR_NUM:
+	case EXPR_VAR:
+	case EXPR_SYM:
+	case EXPR_ASSIGN:
+		break;
+	}
+
+	return node->value;
+}
+
+/* copies the tree. If \c optimize is set, operations on numbers are replaced by their value.
+   Functions without arguments (random numbers) and the variables of the context are not constant. */
+static expr_node* copy_tree(expr_node **pool, const expr_node *node, int optimize, int *nnodes) {
+	double values[EXPR_MAX_ARGS];
+	int i, constant = node->nargs > 0 && node->type != EXPR_ASSIGN;
+
+	expr_node *copy = expr_node_new(pool, node->type);
+	copy->value = node->value;
+	copy->slot = node->slot;
+	copy->sym = node->sym;
+	copy->nargs = node->nargs;
+	for (i = 0; i < node->nargs; i++) {
+		copy->args[i] = copy_tree(pool, node->args[i], optimize, nnodes);
+		values[i] = copy->args[i]->value;
+		if (copy->args[i]->type != EXPR_NUM)
+			constant = 0;
+	}
+
+	if (optimize && constant) {
+		copy->type = EXPR_NUM;
+		copy->value = fold(node, values);
+		copy->nargs = 0;
+	}
+
+	(*nnodes)++;
+	return copy;
+}
+
+static int has_side_effects(const expr_node *node) {
+	return node->type == EXPR_ASSIGN || (node->type == EXPR_FNCT && node->nargs == 0);
+}
+
+static int contains_assignment(const expr_node *node) {
+	int i;
+	if (node->type == EXPR_ASSIGN)
+		return 1;
+	for (i = 0; i < node->nargs; i++)
+		if (contains_assignment(node->args[i]))
+			return 1;
+	return 0;
+}
+
+/* equal subexpressions get the same id. The operands are numbered first,
+   two nodes are equal if they have the same operation and the same operand ids. */
+static void number_nodes(compile_state *s, expr_node *node, int cse) {
+	int i, j;
+	for (i = 0; i < node->nargs; i++)
+		number_nodes(s, node->args[i], cse);
+
+	if (cse && !has_side_effects(node)) {
+		for (j = 0; j < s->nclasses; j++) {
+			const expr_node *other = s->classes[j];
+			if (other->type != node->type || other->nargs != node->nargs || other->sym != node->sym)
+				continue;
+			if (node->type == EXPR_NUM && other->value != node->value)
+				continue;
+			if (node->type == EXPR_VAR && other->slot != node->slot)
+				continue;
+			for (i = 0; i < node->nargs; i++)
+				if (other->args[i]->id != node->args[i]->id)
+					break;
+			if (i == node->nargs) {
+				node->id = j;
+				return;
+			}
+		}
+	}
+
+	node->id = s->nclasses;
+	s->classes[s->nclasses++] = node;
+}
+
+/* counts how often a class is evaluated. The operands of a repeated subexpression are only evaluated the first time. */
+static void count_uses(compile_state *s, const expr_node *node) {
+	int i;
+	if (s->uses[node->id]++ > 0)
+		return;
+	for (i = 0; i < node->nargs; i++)
+		count_uses(s, node->args[i]);
+}
+
+/* translates the syntax tree with the root \c root to a program. \c nvars is the number of bound variables.
+   If \c optimize is set, constants are folded and common subexpressions are evaluated only once and kept in temporaries. */
+parser_expr* expr_compile_tree(const expr_node *root, int nvars, int optimize) {
+	if (!root)
+		return 0;
+
+	parser_expr *e = (parser_expr *) calloc(1, sizeof(parser_expr));
+	e->nvars = nvars;
+
+	compile_state s;
+	s.expr = e;
+	s.capacity = 0;
+	s.depth = 0;
+	s.nnodes = 0;
+	e->root = copy_tree(&e->nodes, root, optimize, &s.nnodes);
+
+	/* assignments change the values of the variables of the context, the parts of such expressions are not shared */
+	s.classes = (expr_node **) malloc(s.nnodes * sizeof(expr_node *));
+	s.nclasses = 0;
+	number_nodes(&s, e->root, optimize && !contains_assignment(e->root));
+
+	s.uses = (int *) calloc(s.nclasses, sizeof(int));
+	s.temp = (int *) malloc(s.nclasses * sizeof(int));
+	s.generated = (char *) calloc(s.nclasses, sizeof(char));
+	count_uses(&s, e->root);
+
+	/* reloading numbers and variables is as cheap as reloading a temporary */
+	int i;
+	for (i = 0; i < s.nclasses; i++) {
+		if (s.uses[i] > 1 && s.classes[i]->nargs > 0)
+			s.temp[i] = e->ntemps++;
+		else
+			s.temp[i] = -1;
+	}
+
+	generate(&s, e->root);
+
+	free(s.classes);
+	free(s.uses);
+	free(s.temp);
+	free(s.generated);
+
+	return e;
+}
+
+double parse_eval(const parser_expr *e, const double *values) {
+	double stack[e->stack_size];
+	double temps[e->ntemps > 0 ? e->ntemps : 1];
+	int top = -1;
+	const expr_instr *instr = e->code;
+	const expr_instr *end = e->code + e->size;
+
+	for (; instr != end; instr++) {
+		switch (instr->op) {
+		case OP_NUM:
+			stack[++top] = instr->value;
+			break;
+		case OP_VAR:
+			stack[++top] = values[instr->arg];
+			break;
+		case OP_SYM:
+			stack[++top] = instr->ptr.sym->value.var;
+			break;
+		case OP_STORE:
+			instr->ptr.sym->value.var = stack[top];
+			break;
+		case OP_SAVE:
+			temps[instr->arg] = stack[top];
+			break;
+		case OP_LOAD:
+			stack[++top] = temps[instr->arg];
+			break;
+		case OP_NEG:
+			stack[top] = -stack[top];
+			break;
+		case OP_ADD:
+			top--;
+			stack[top] += stack[top+1];
+			break;
+		case OP_SUB:
+			top--;
+			stack[top] -= stack[top+1];
+			break;
+		case OP_MUL:
+			top--;
+			stack[top] *= stack[top+1];
+			break;
+		case OP_DIV:
+			top--;
+			stack[top] /= stack[top+1];
+			break;
+		case OP_POW:
+			top--;
+			stack[top] = pow(stack[top], stack[top+1]);
+			break;
+		case OP_SQRT:
+			stack[top] = sqrt(stack[top]);
+			break;
+		case OP_EXP:
+			stack[top] = exp(stack[top]);
+			break;
+		case OP_LOG:
+			stack[top] = log(stack[top]);
+			break;
+		case OP_SIN:
+			stack[top] = sin(stack[top]);
+			break;
+		case OP_COS:
+			stack[top] = cos(stack[top]);
+			break;
+		case OP_CALL0:
+			stack[++top] = (*instr->ptr.fnct)();
+			break;
+		case OP_CALL1:
+			stack[top] = (*instr->ptr.fnct)(stack[top]);
+			break;
+		case OP_CALL2:
+			top--;
+			stack[top] = (*instr->ptr.fnct)(stack[top], stack[top+1]);
+			break;
+		case OP_CALL3:
+			top -= 2;
+			stack[top] = (*instr->ptr.fnct)(stack[top], stack[top+1], stack[top+2]);
+			break;
+		case OP_CALL4:
+			top -= 3;
+			stack[top] = (*instr->ptr.fnct)(stack[top], stack[top+1], stack[top+2], stack[top+3]);
+			break;
+		case OP_LT:
+			top--;
+			stack[top] = stack[top] < stack[top+1];
+			break;
+		case OP_LE:
+			top--;
+			stack[top] = stack[top] <= stack[top+1];
+			break;
+		case OP_GT:
+			top--;
+			stack[top] = stack[top] > stack[top+1];
+			break;
+		case OP_GE:
+			top--;
+			stack[top] = stack[top] >= stack[top+1];
+			break;
+		case OP_EQ:
+			top--;
+			stack[top] = stack[top] == stack[top+1];
+			break;
+		case OP_NE:
+			top--;
+			stack[top] = stack[top] != stack[top+1];
+			break;
+		case OP_AND:
+			top--;
+			stack[top] = stack[top] != 0 && stack[top+1] != 0;
+			break;
+		case OP_OR:
+			top--;
+			stack[top] = stack[top] != 0 || stack[top+1] != 0;
+			break;
+		case OP_NOT:
+			stack[top] = stack[top] == 0;
+			break;
+		}
+	}
+
+	return stack[0];
+}
+
+/* A uniform entry of the block stack has the same value for all points of the block and only its first value is set.
+   Operations on uniform operands (numbers, parameters and everything computed from them only) are evaluated once per block,
+   they are expanded to the whole block when combined with values that differ from point to point. */
+static void expand(double *a, char *uniform, int m) {
+	int k;
+	if (!*uniform)
+		return;
+	for (k = 1; k < m; k++)
+		a[k] = a[0];
+	*uniform = 0;
+}
+
+/* prepares the \c n operands of an operation at \c a and returns the number of values to compute */
+static int operands(double *a, char *uniform, int n, int m) {
+	int i;
+	for (i = 0; i < n; i++)
+		if (!uniform[i])
+			break;
+	if (i == n)
+		return 1;
+
+	for (i = 0; i < n; i++)
+		expand(a + i*EXPR_BLOCK_SIZE, uniform + i, m);
+	return m;
+}
+
+/* removes \c n operands from the block stack and leaves \c a pointing at the first one */
+/* the operands of an operation are separate blocks of the stack, the loops over them have no dependencies */
+#ifdef EXPR_OPENMP_SIMD
+#define EXPR_SIMD _Pragma("omp simd")
+#else
+#define EXPR_SIMD
+#endif
+
+#define POP_OPERANDS(n) { top -= (n) - 1; a = stack + top*EXPR_BLOCK_SIZE; b = a + EXPR_BLOCK_SIZE; count = operands(a, uniform + top, n, m); }
+
+static int native_strides_match(const parser_expr *e, const int strides[]) {
+	int i;
+	for (i = 0; i < e->nvars; i++)
+		if (strides[i] != e->native_strides[i])
+			return 0;
+	return 1;
+}
+
+/* evaluates the expression for \c n points and stores the values in \c result.
+   The values of the variable in slot i are vars[i][0], vars[i][strides[i]], ..., a stride of 0 is used for
+   variables that are the same for all points (parameters). The program is run on blocks of EXPR_BLOCK_SIZE points,
+   each instruction processes the whole block. The loops of the arithmetic operations, comparisons, ! and sqrt()
+   are vectorized if EXPR_OPENMP_SIMD is defined (CMake option ENABLE_EXPRESSION_SIMD, compiled with -fopenmp-simd
+   and -fno-math-errno), the other functions are called point by point. If native code was generated for the strides, it is used instead. */
+void parse_eval_vector(const parser_expr *e, const double *const vars[], const int strides[], int n, double *result) {
+	if (e->native && native_strides_match(e, strides)) {
+		e->native(vars, n, result);
+		return;
+	}
+
+	const int size = e->stack_size + e->ntemps;
+	double *stack = (double *) malloc(size * EXPR_BLOCK_SIZE * sizeof(double));
+	double *temps = stack + e->stack_size * EXPR_BLOCK_SIZE;
+	char *uniform = (char *) malloc(size * sizeof(char));
+	char *temp_uniform = uniform + e->stack_size;
+	int first, k;
+
+	for (first = 0; first < n; first += EXPR_BLOCK_SIZE) {
+		const int m = (n - first < EXPR_BLOCK_SIZE) ? n - first : EXPR_BLOCK_SIZE;
+		const expr_instr *instr = e->code;
+		const expr_instr *end = e->code + e->size;
+		int top = -1;	/* top of the stack */
+		int count = 0;	/* number of values computed by an operation */
+		double *a = 0, *b = 0;
+
+		for (; instr != end; instr++) {
+			switch (instr->op) {
+			case OP_NUM:
+				a = stack + (++top)*EXPR_BLOCK_SIZE;
+				a[0] = instr->value;
+				uniform[top] = 1;
+				break;
+			case OP_VAR: {
+				const int stride = strides[instr->arg];
+				const double *v = vars[instr->arg] + (size_t)first*stride;
+				a = stack + (++top)*EXPR_BLOCK_SIZE;
+				uniform[top] = (stride == 0);
+				if (stride == 0)
+					a[0] = v[0];
+				else if (stride == 1)
+					memcpy(a, v, m*sizeof(double));
+				else
+					for (k = 0; k < m; k++)
+						a[k] = v[(size_t)k*stride];
+				break;
+			}
+			case OP_SYM:
+				a = stack + (++top)*EXPR_BLOCK_SIZE;
+				a[0] = instr->ptr.sym->value.var;
+				uniform[top] = 1;
+				break;
+			case OP_STORE:
+				instr->ptr.sym->value.var = a[uniform[top] ? 0 : m-1];
+				break;
+			case OP_SAVE:
+				temp_uniform[instr->arg] = uniform[top];
+				memcpy(temps + instr->arg*EXPR_BLOCK_SIZE, a, (uniform[top] ? 1 : m)*sizeof(double));
+				break;
+			case OP_LOAD:
+				a = stack + (++top)*EXPR_BLOCK_SIZE;
+				uniform[top] = temp_uniform[instr->arg];
+				memcpy(a, temps + instr->arg*EXPR_BLOCK_SIZE, (uniform[top] ? 1 : m)*sizeof(double));
+				break;
+			case OP_NEG:
+				POP_OPERANDS(1)
+				EXPR_SIMD
+				for (k = 0; k < count; k++)
+					a[k] = -a[k];
+				break;
+			case OP_ADD:
+				POP_OPERANDS(2)
+				EXPR_SIMD
+				for (k = 0; k < count; k++)
+					a[k] += b[k];
+				break;
+			case OP_SUB:
+				POP_OPERANDS(2)
+				EXPR_SIMD
+				for (k = 0; k < count; k++)
+					a[k] -= b[k];
+				break;
+			case OP_MUL:
+				POP_OPERANDS(2)
+				EXPR_SIMD
+				for (k = 0; k < count; k++)
+					a[k] *= b[k];
+				break;
+			case OP_DIV:
+				POP_OPERANDS(2)
+				EXPR_SIMD
+				for (k = 0; k < count; k++)
+					a[k] /= b[k];
+				break;
+			case OP_POW:
+				POP_OPERANDS(2)
+				for (k = 0; k < count; k++)
+					a[k] = pow(a[k], b[k]);
+				break;
+			case OP_SQRT:
+				POP_OPERANDS(1)
+				EXPR_SIMD
+				for (k = 0; k < count; k++)
+					a[k] = sqrt(a[k]);
+				break;
+			case OP_EXP:
+				POP_OPERANDS(1)
+				for (k = 0; k < count; k++)
+					a[k] = exp(a[k]);
+				break;
+			case OP_LOG:
+				POP_OPERANDS(1)
+				for (k = 0; k < count; k++)
+					a[k] = log(a[k]);
+				break;
+			case OP_SIN:
+				POP_OPERANDS(1)
+				for (k = 0; k < count; k++)
+					a[k] = sin(a[k]);
+				break;
+			case OP_COS:
+				POP_OPERANDS(1)
+				for (k = 0; k < count; k++)
+					a[k] = cos(a[k]);
+				break;
+			case OP_CALL0:
+				a = stack + (++top)*EXPR_BLOCK_SIZE;
+				uniform[top] = 0;
+				for (k = 0; k < m; k++)
+					a[k] = (*instr->ptr.fnct)();
+				break;
+			case OP_CALL1:
+				POP_OPERANDS(1)
+				for (k = 0; k < count; k++)
+					a[k] = (*instr->ptr.fnct)(a[k]);
+				break;
+			case OP_CALL2:
+				POP_OPERANDS(2)
+				for (k = 0; k < count; k++)
+					a[k] = (*instr->ptr.fnct)(a[k], b[k]);
+				break;
+			case OP_CALL3:
+				POP_OPERANDS(3)
+				for (k = 0; k < count; k++)
+					a[k] = (*instr->ptr.fnct)(a[k], b[k], b[k + EXPR_BLOCK_SIZE]);
+				break;
+			case OP_CALL4:
+				POP_OPERANDS(4)
+				for (k = 0; k < count; k++)
+					a[k] = (*instr->ptr.fnct)(a[k], b[k], b[k + EXPR_BLOCK_SIZE], b[k + 2*EXPR_BLOCK_SIZE]);
+				break;
+			case OP_LT:
+				POP_OPERANDS(2)
+				EXPR_SIMD
+				for (k = 0; k < count; k++)
+					a[k] = a[k] < b[k];
+				break;
+			case OP_LE:
+				POP_OPERANDS(2)
+				EXPR_SIMD
+				for (k = 0; k < count; k++)
+					a[k] = a[k] <= b[k];
+				break;
+			case OP_GT:
+				POP_OPERANDS(2)
+				EXPR_SIMD
+				for (k = 0; k < count; k++)
+					a[k] = a[k] > b[k];
+				break;
+			case OP_GE:
+				POP_OPERANDS(2)
+				EXPR_SIMD
+				for (k = 0; k < count; k++)
+					a[k] = a[k] >= b[k];
+				break;
+			case OP_EQ:
+				POP_OPERANDS(2)
+				EXPR_SIMD
+				for (k = 0; k < count; k++)
+					a[k] = a[k] == b[k];
+				break;
+			case OP_NE:
+				POP_OPERANDS(2)
+				EXPR_SIMD
+				for (k = 0; k < count; k++)
+					a[k] = a[k] != b[k];
+				break;
+			case OP_AND:
+				POP_OPERANDS(2)
+				for (k = 0; k < count; k++)
+					a[k] = a[k] != 0 && b[k] != 0;
+				break;
+			case OP_OR:
+				POP_OPERANDS(2)
+				for (k = 0; k < count; k++)
+					a[k] = a[k] != 0 || b[k] != 0;
+				break;
+			case OP_NOT:
+				POP_OPERANDS(1)
+				EXPR_SIMD
+				for (k = 0; k < count; k++)
+					a[k] = a[k] == 0;
+				break;
+			}
+		}
+
+		expand(stack, uniform, m);
+		memcpy(result + first, stack, m*sizeof(double));
+	}
+
+	free(uniform);
+	free(stack);
+}
+
+void parse_free(parser_expr *e) {
+	if (!e)
+		return;
+	expr_jit_free(e);
+	expr_node_free_all(e->nodes);
+	free(e->code);
+	free(e);
+}
+
+/************ invariant subexpressions ************/
+
+/* bit 1: uses the variable in \c slot, bit 2: uses other bound variables, bit 4: random numbers */
+static int dependencies(const expr_node *node, int slot) {
+	int i, deps = 0;
+	if (node->type == EXPR_VAR)
+		return node->slot == slot ? 1 : 2;
+	if (node->type == EXPR_FNCT && node->nargs == 0)
+		return 4;
+	for (i = 0; i < node->nargs; i++)
+		deps |= dependencies(node->args[i], slot);
+	return deps;
+}
+
+typedef struct factor_state {
+	expr_node *pool;
+	int slot;
+	int nvars;
+	parser_expr **parts;
+	int maxparts;
+	int nparts;
+} factor_state;
+
+/* replaces the largest subtrees depending only on other variables than \c slot by new variables */
+static expr_node* factor(factor_state *s, expr_node *node) {
+	int i;
+	if (node->nargs > 0 && dependencies(node, s->slot) == 2 && s->nparts < s->maxparts) {
+		s->parts[s->nparts] = expr_compile_tree(node, s->nvars, 1);
+		expr_node *var = expr_node_new(&s->pool, EXPR_VAR);
+		var->slot = s->nvars + s->nparts++;
+		return var;
+	}
+
+	expr_node *copy = expr_node_new(&s->pool, node->type);
+	copy->value = node->value;
+	copy->slot = node->slot;
+	copy->sym = node->sym;
+	copy->nargs = node->nargs;
+	for (i = 0; i < node->nargs; i++)
+		copy->args[i] = factor(s, node->args[i]);
+
+	return copy;
+}
+
+/* The invariant parts of an expression are evaluated once for all values of the variable in \c slot,
+   e.g. the parts depending only on the row of a matrix are shared by all columns. Expressions with
+   assignments are not split. */
+parser_expr* parse_factor(const parser_expr *e, int slot, parser_expr *parts[], int maxparts, int *nparts) {
+	factor_state s;
+	s.pool = 0;
+	s.slot = slot;
+	s.nvars = e->nvars;
+	s.parts = parts;
+	s.maxparts = contains_assignment(e->root) ? 0 : maxparts;
+	s.nparts = 0;
+
+	expr_node *root = factor(&s, e->root);
+	parser_expr *result = expr_compile_tree(root, e->nvars + s.nparts, 1);
+	expr_node_free_all(s.pool);
+
+	*nparts = s.nparts;
+	return result;
+}
+
+/************ symbolic differentiation ************/
+
+static double expr_sgn(double x) {
+	if (x > 0)
+		return 1.;
+	else if (x < 0)
+		return -1.;
+	return 0.;
+}
+
+/* functions appearing in derivatives */
+enum {DF_SIN, DF_COS, DF_EXP, DF_LOG, DF_SQRT, DF_SINH, DF_COSH, DF_SGN};
+static symrec derivative_functions[] = {
+	{(char *)"sin", 0, {.fnctptr = sin}, 0},
+	{(char *)"cos", 0, {.fnctptr = cos}, 0},
+	{(char *)"exp", 0, {.fnctptr = exp}, 0},
+	{(char *)"log", 0, {.fnctptr = log}, 0},
+	{(char *)"sqrt", 0, {.fnctptr = sqrt}, 0},
+	{(char *)"sinh", 0, {.fnctptr = sinh}, 0},
+	{(char *)"cosh", 0, {.fnctptr = cosh}, 0},
+	{(char *)"sgn", 0, {.fnctptr = expr_sgn}, 0}
+};
+
+/* the constructors fold constants and drop the neutral elements, most terms of a derivative vanish */
+static int is_num(const expr_node *node, double value) {
+	return node->type == EXPR_NUM && node->value == value;
+}
+
+static expr_node* num(expr_node **pool, double value) {
+	expr_node *node = expr_node_new(pool, EXPR_NUM);
+	node->value = value;
+	return node;
+}
+
+static expr_node* neg(expr_node **pool, expr_node *a) {
+	if (a->type == EXPR_NUM)
+		return num(pool, -a->value);
+	if (a->type == EXPR_NEG)
+		return a->args[0];
+
+	expr_node *node = expr_node_new(pool, EXPR_NEG);
+	node->nargs = 1;
+	node->args[0] = a;
+	return node;
+}
+
+static expr_node* binary(expr_node **pool, expr_type type, expr_node *a, expr_node *b) {
+	if (a->type == EXPR_NUM && b->type == EXPR_NUM) {
+		switch (type) {
+		case EXPR_ADD:
+			return num(pool, a->value + b->value);
+		case EXPR_SUB:
+			return num(pool, a->value - b->value);
+		case EXPR_MUL:
+			return num(pool, a->value * b->value);
+		case EXPR_DIV:
+			return num(pool, a->value / b->value);
+		case EXPR_POW:
+			return num(pool, pow(a->value, b->value));
+		case EXPR_NUM:
+		case EXPR_VAR:
+		case EXPR_SYM:
+		case EXPR_ASSIGN:
+		case EXPR_FNCT:
+		case EXPR_NEG:
+		case EXPR_LT:
+		case EXPR_LE:
+		case EXPR_GT:
+		case EXPR_GE:
+		case EXPR_EQ:
+		case EXPR_NE:
+		case EXPR_AND:
+		case EXPR_OR:
+		case EXPR_NOT:
+			break;
+		}
+	}
+
+	switch (type) {
+	case EXPR_ADD:
+		if (is_num(a, 0))
+			return b;
+		if (is_num(b, 0))
+			return a;
+		break;
+	case EXPR_SUB:
+		if (is_num(b, 0))
+			return a;
+		if (is_num(a, 0))
+			return neg(pool, b);
+		break;
+	case EXPR_MUL:
+		if (is_num(a, 0) || is_num(b, 0))
+			return num(pool, 0);
+		if (is_num(a, 1))
+			return b;
+		if (is_num(b, 1))
+			return a;
+		if (is_num(a, -1))
+			return neg(pool, b);
+		if (is_num(b, -1))
+			return neg(pool, a);
+		break;
+	case EXPR_DIV:
+		if (is_num(a, 0))
+			return num(pool, 0);
+		if (is_num(b, 1))
+			return a;
+		break;
+	case EXPR_POW:
+		if (is_num(b, 0))
+			return num(pool, 1);
+		if (is_num(b, 1))
+			return a;
+		break;
+	case EXPR_NUM:
+	case EXPR_VAR:
+	case EXPR_SYM:
+	case EXPR_ASSIGN:
+	case EXPR_FNCT:
+	case EXPR_NEG:
+	case EXPR_LT:
+	case EXPR_LE:
+	case EXPR_GT:
+	case EXPR_GE:
+	case EXPR_EQ:
+	case EXPR_NE:
+	case EXPR_AND:
+	case EXPR_OR:
+	case EXPR_NOT:
+		break;
+	}
+
+	expr_node *node = expr_node_new(pool, type);
+	node->nargs = 2;
+	node->args[0] = a;
+	node->args[1] = b;
+	return node;
+}
+
+static expr_node* fnct(expr_node **pool, int f, expr_node *a) {
+	expr_node *node = expr_node_new(pool, EXPR_FNCT);
+	node->sym = &derivative_functions[f];
+	node->nargs = 1;
+	node->args[0] = a;
+	return node;
+}
+
+/* derivative of a^b (the node \c node) */
+static expr_node* derive_pow(expr_node **pool, expr_node *node, expr_node *a, expr_node *b, expr_node *da, expr_node *db) {
+	/* b*a^(b-1)*da */
+	if (is_num(db, 0))
+		return binary(pool, EXPR_MUL, binary(pool, EXPR_MUL, b,
+			binary(pool, EXPR_POW, a, binary(pool, EXPR_SUB, b, num(pool, 1)))), da);
+
+	/* a^b*(log(a)*db + b*da/a) */
+	expr_node *d = binary(pool, EXPR_MUL, fnct(pool, DF_LOG, a), db);
+	d = binary(pool, EXPR_ADD, d, binary(pool, EXPR_DIV, binary(pool, EXPR_MUL, b, da), a));
+	return binary(pool, EXPR_MUL, node, d);
+}
+
+static expr_node* derive(expr_node **pool, expr_node *node, int slot);
+
+/* derivative of the function f(a) (the node \c node) with respect to a, 0 if not known */
+static expr_node* derive_fnct1(expr_node **pool, expr_node *node, expr_node *a) {
+	const char *name = node->sym->name;
+
+	if (strcmp(name, "exp") == 0)
+		return node;
+	if (strcmp(name, "log") == 0 || strcmp(name, "ln") == 0)
+		return binary(pool, EXPR_DIV, num(pool, 1), a);
+	if (strcmp(name, "log10") == 0)
+		return binary(pool, EXPR_DIV, num(pool, M_LOG10E), a);
+	if (strcmp(name, "sqrt") == 0)
+		return binary(pool, EXPR_DIV, num(pool, 0.5), node);
+	if (strcmp(name, "cbrt") == 0)
+		return binary(pool, EXPR_DIV, num(pool, 1./3.), binary(pool, EXPR_MUL, node, node));
+	if (strcmp(name, "sin") == 0)
+		return fnct(pool, DF_COS, a);
+	if (strcmp(name, "cos") == 0)
+		return neg(pool, fnct(pool, DF_SIN, a));
+	if (strcmp(name, "tan") == 0)
+		return binary(pool, EXPR_ADD, num(pool, 1), binary(pool, EXPR_MUL, node, node));
+	if (strcmp(name, "asin") == 0)
+		return binary(pool, EXPR_DIV, num(pool, 1),
+			fnct(pool, DF_SQRT, binary(pool, EXPR_SUB, num(pool, 1), binary(pool, EXPR_MUL, a, a))));
+	if (strcmp(name, "acos") == 0)
+		return binary(pool, EXPR_DIV, num(pool, -1),
+			fnct(pool, DF_SQRT, binary(pool, EXPR_SUB, num(pool, 1), binary(pool, EXPR_MUL, a, a))));
+	if (strcmp(name, "atan") == 0)
+		return binary(pool, EXPR_DIV, num(pool, 1), binary(pool, EXPR_ADD, num(pool, 1), binary(pool, EXPR_MUL, a, a)));
+	if (strcmp(name, "sinh") == 0)
+		return fnct(pool, DF_COSH, a);
+	if (strcmp(name, "cosh") == 0)
+		return fnct(pool, DF_SINH, a);
+	if (strcmp(name, "tanh") == 0)
+		return binary(pool, EXPR_SUB, num(pool, 1), binary(pool, EXPR_MUL, node, node));
+	if (strcmp(name, "fabs") == 0)
+		return fnct(pool, DF_SGN, a);
+	if (strcmp(name, "erf") == 0)
+		return binary(pool, EXPR_MUL, num(pool, M_2_SQRTPI), fnct(pool, DF_EXP, neg(pool, binary(pool, EXPR_MUL, a, a))));
+	if (strcmp(name, "erfc") == 0)
+		return binary(pool, EXPR_MUL, num(pool, -M_2_SQRTPI), fnct(pool, DF_EXP, neg(pool, binary(pool, EXPR_MUL, a, a))));
+
+	return 0;
+}
+
+static expr_node* derive_fnct(expr_node **pool, expr_node *node, int slot) {
+	expr_node *da[EXPR_MAX_ARGS];
+	int i, constant = 1;
+
+	for (i = 0; i < node->nargs; i++) {
+		da[i] = derive(pool, node->args[i], slot);
+		if (!da[i])
+			return 0;
+		if (!is_num(da[i], 0))
+			constant = 0;
+	}
+
+	/* functions of constant arguments (and the functions without arguments) are constant */
+	if (constant)
+		return num(pool, 0);
+
+	if (node->nargs == 1) {
+		expr_node *df = derive_fnct1(pool, node, node->args[0]);
+		return df ? binary(pool, EXPR_MUL, df, da[0]) : 0;
+	}
+	if (node->nargs == 2 && strcmp(node->sym->name, "pow") == 0)
+		return derive_pow(pool, node, node->args[0], node->args[1], da[0], da[1]);
+
+	return 0;
+}
+
+/* derivative of the tree \c node with respect to the variable in slot \c slot. The nodes of the tree are shared. */
+static expr_node* derive(expr_node **pool, expr_node *node, int slot) {
+	expr_node *a = node->args[0], *b = node->args[1];
+	expr_node *da = 0, *db = 0;
+
+	switch (node->type) {
+	case EXPR_NUM:
+	case EXPR_SYM:
+		return num(pool, 0);
+	case EXPR_VAR:
+		return num(pool, node->slot == slot ? 1 : 0);
+	case EXPR_ASSIGN:
+		return derive(pool, a, slot);
+	case EXPR_FNCT:
+		return derive_fnct(pool, node, slot);
+	case EXPR_NEG:
+		da = derive(pool, a, slot);
+		return da ? neg(pool, da) : 0;
+	case EXPR_LT:
+	case EXPR_LE:
+	case EXPR_GT:
+	case EXPR_GE:
+	case EXPR_EQ:
+	case EXPR_NE:
+	case EXPR_AND:
+	case EXPR_OR:
+	case EXPR_NOT:
+		/* comparisons and logical operations are piecewise constant */
+		return num(pool, 0);
+	case EXPR_ADD:
+	case EXPR_SUB:
+	case EXPR_MUL:
+	case EXPR_DIV:
+	case EXPR_POW:
+		da = derive(pool, a, slot);
+		db = derive(pool, b, slot);
+		if (!da || !db)
+			return 0;
+		break;
+	}
+
+	switch (node->type) {
+	case EXPR_ADD:
+	case EXPR_SUB:
+		return binary(pool, node->type, da, db);
+	case EXPR_MUL:
+		/* da*b + a*db */
+		return binary(pool, EXPR_ADD, binary(pool, EXPR_MUL, da, b), binary(pool, EXPR_MUL, a, db));
+	case EXPR_DIV:
+		/* da/b - a*db/b^2 */
+		return binary(pool, EXPR_SUB, binary(pool, EXPR_DIV, da, b),
+			binary(pool, EXPR_DIV, binary(pool, EXPR_MUL, a, db), binary(pool, EXPR_MUL, b, b)));
+	case EXPR_POW:
+		return derive_pow(pool, node, a, b, da, db);
+	case EXPR_NUM:
+	case EXPR_VAR:
+	case EXPR_SYM:
+	case EXPR_ASSIGN:
+	case EXPR_FNCT:
+	case EXPR_NEG:
+	case EXPR_LT:
+	case EXPR_LE:
+	case EXPR_GT:
+	case EXPR_GE:
+	case EXPR_EQ:
+	case EXPR_NE:
+	case EXPR_AND:
+	case EXPR_OR:
+	case EXPR_NOT:
+		break;
+	}
+
+	return 0;
+}
+
+/* the derivative is built from the syntax tree of the expression, the constant terms are folded while building it */
+parser_expr* parse_derivative(const parser_expr *e, int slot) {
+	expr_node *pool = 0;
+	expr_node *root = derive(&pool, e->root, slot);
+
+	parser_expr *d = root ? expr_compile_tree(root, e->nvars, 1) : 0;
+	expr_node_free_all(pool);
+
+	return d;
+}
@@ -0,0 +1,101 @@
+/***************************************************************************
+    File                 : expression.h
+    Project              : LabPlot
+    Description          : Compiled mathematical expressions
+    --------------------------------------------------------------------
+    Copyright            : (C) 2017 by the LabPlot developers
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include "parser.h"
+
+/* maximal number of arguments of a function */
+#define EXPR_MAX_ARGS 4
+
+/* types of the nodes of the syntax tree */
+typedef enum {EXPR_NUM, EXPR_VAR, EXPR_SYM, EXPR_ASSIGN, EXPR_FNCT, EXPR_NEG,
+	EXPR_ADD, EXPR_SUB, EXPR_MUL, EXPR_DIV, EXPR_POW,
+	EXPR_LT, EXPR_LE, EXPR_GT, EXPR_GE, EXPR_EQ, EXPR_NE, EXPR_AND, EXPR_OR, EXPR_NOT} expr_type;
+
+/* node of the syntax tree */
+typedef struct expr_node {
+	expr_type type;
+	double value;	/* value of EXPR_NUM */
+	int slot;	/* slot of the variable (EXPR_VAR) */
+	symrec *sym;	/* symbol of EXPR_SYM, EXPR_ASSIGN and EXPR_FNCT */
+	int nargs;	/* number of operands */
+	struct expr_node *args[EXPR_MAX_ARGS];
+	struct expr_node *next;	/* next node of the pool */
+	int id;	/* class of equal subexpressions, used by the compiler */
+} expr_node;
+
+/* operations of the stack program. Comparisons and logical operations give 1 (true) or 0 (false),
+   operands different from 0 are true */
+typedef enum {OP_NUM, OP_VAR, OP_SYM, OP_STORE, OP_SAVE, OP_LOAD, OP_NEG, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_POW,
+	OP_SQRT, OP_EXP, OP_LOG, OP_SIN, OP_COS,
+	OP_CALL0, OP_CALL1, OP_CALL2, OP_CALL3, OP_CALL4,
+	OP_LT, OP_LE, OP_GT, OP_GE, OP_EQ, OP_NE, OP_AND, OP_OR, OP_NOT} expr_op;
+
+/* number of points evaluated at once by parse_eval_vector() */
+#define EXPR_BLOCK_SIZE 1024
+
+/* instruction of the stack program */
+typedef struct expr_instr {
+	expr_op op;
+	int arg;	/* slot of a variable or index of a temporary */
+	double value;	/* constant */
+	union {
+		func_t fnct;
+		symrec *sym;
+	} ptr;
+} expr_instr;
+
+/* native code evaluating the expression for n points, see parse_jit() */
+typedef void (*expr_native)(const double *const vars[], int n, double *result);
+
+/* compiled expression: the instructions in postfix order and a copy of the syntax tree */
+struct parser_expr {
+	expr_instr *code;
+	int size;
+	int stack_size;
+	int nvars;
+	int ntemps;	/* number of temporaries for common subexpressions */
+	expr_node *nodes;	/* pool of the nodes of the syntax tree */
+	expr_node *root;
+	expr_native native;	/* native code or 0 */
+	void *native_result;	/* owner of the native code */
+	int *native_strides;	/* strides the native code was generated for */
+};
+
+/* nodes are allocated in the pool and freed together */
+expr_node* expr_node_new(expr_node **pool, expr_type type);
+void expr_node_free_all(expr_node *pool);
+
+/* translates the syntax tree to a program, the tree is copied and may be freed afterwards */
+parser_expr* expr_compile_tree(const expr_node *root, int nvars, int optimize);
+/* releases the native code of the expression */
+void expr_jit_free(parser_expr *e);
+
+#endif /* EXPRESSION_H */
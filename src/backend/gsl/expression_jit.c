@@ -0,0 +1,342 @@
+/***************************************************************************
+    File                 : expression.c
+    File                 : expression_jit.c
+    Project              : LabPlot
+    Description          : Native code for compiled expressions
+    Copyright            : (C) 2017 by the LabPlot developers
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+/* The native code is generated with libgccjit from the program of a compiled expression. It evaluates the expression
+   in a loop over the points like parse_eval_vector(), the operations on numbers and parameters are done once before the loop.
+   The functions of the parser are called through their pointers. Without libgccjit, or if the generation fails,
+   the expressions are interpreted. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "expression.h"
+
+#ifdef HAVE_LIBGCCJIT
+#include <libgccjit.h>
+
+/* value of an instruction during the code generation */
+typedef struct jit_value {
+	gcc_jit_rvalue *rvalue;
+	int uniform;	/* same value for all points, computed before the loop */
+} jit_value;
+
+typedef struct jit_state {
+	gcc_jit_context *ctxt;
+	gcc_jit_function *fn;
+	gcc_jit_type *double_type;
+	gcc_jit_block *init;	/* code before the loop */
+	gcc_jit_block *body;	/* code for every point */
+	int nlocals;
+} jit_state;
+
+/* assigns \c value to a new local variable in the block of uniform or of point values */
+static jit_value assign(jit_state *s, gcc_jit_rvalue *value, int uniform) {
+	char name[16];
+	snprintf(name, sizeof(name), "t%d", s->nlocals++);
+	gcc_jit_lvalue *local = gcc_jit_function_new_local(s->fn, NULL, s->double_type, name);
+	gcc_jit_block_add_assignment(uniform ? s->init : s->body, NULL, local, value);
+
+	jit_value result;
+	result.rvalue = gcc_jit_lvalue_as_rvalue(local);
+	result.uniform = uniform;
+	return result;
+}
+
+/* function of the math library with \c nargs arguments */
+static gcc_jit_function* math_function(jit_state *s, const char *name, int nargs) {
+	const char *names[] = {"x", "y"};
+	gcc_jit_param *params[2];
+	int i;
+	for (i = 0; i < nargs; i++)
+		params[i] = gcc_jit_context_new_param(s->ctxt, NULL, s->double_type, names[i]);
+	return gcc_jit_context_new_function(s->ctxt, NULL, GCC_JIT_FUNCTION_IMPORTED, s->double_type, name, nargs, params, 0);
+}
+
+/* 1 or 0 for the result of a comparison */
+static gcc_jit_rvalue* boolean_value(jit_state *s, gcc_jit_rvalue *value) {
+	gcc_jit_type *int_type = gcc_jit_context_get_type(s->ctxt, GCC_JIT_TYPE_INT);
+	return gcc_jit_context_new_cast(s->ctxt, NULL, gcc_jit_context_new_cast(s->ctxt, NULL, value, int_type), s->double_type);
+}
+
+/* operand of a logical operation, values different from 0 are true */
+static gcc_jit_rvalue* truth_value(jit_state *s, gcc_jit_rvalue *value) {
+	return gcc_jit_context_new_comparison(s->ctxt, NULL, GCC_JIT_COMPARISON_NE, value, gcc_jit_context_zero(s->ctxt, s->double_type));
+}
+
+/* pointer to the value of a variable of the context */
+static gcc_jit_lvalue* symbol(jit_state *s, symrec *sym) {
+	gcc_jit_rvalue *ptr = gcc_jit_context_new_rvalue_from_ptr(s->ctxt, gcc_jit_type_get_pointer(s->double_type), &sym->value.var);
+	return gcc_jit_rvalue_dereference(ptr, NULL);
+}
+
+/* generates the function "void expr(const double *const vars[], int n, double *result)".
+   Variables with a stride of 0 are read before the loop, the others are contiguous. */
+static gcc_jit_result* generate(const parser_expr *e, const int strides[]) {
+	jit_state s;
+	gcc_jit_context *ctxt = gcc_jit_context_acquire();
+	s.ctxt = ctxt;
+	s.nlocals = 0;
+	gcc_jit_context_set_int_option(ctxt, GCC_JIT_INT_OPTION_OPTIMIZATION_LEVEL, 3);
+
+	gcc_jit_type *int_type = gcc_jit_context_get_type(ctxt, GCC_JIT_TYPE_INT);
+	gcc_jit_type *void_type = gcc_jit_context_get_type(ctxt, GCC_JIT_TYPE_VOID);
+	s.double_type = gcc_jit_context_get_type(ctxt, GCC_JIT_TYPE_DOUBLE);
+	gcc_jit_type *data_type = gcc_jit_type_get_pointer(gcc_jit_type_get_const(s.double_type));
+
+	gcc_jit_param *params[3];
+	params[0] = gcc_jit_context_new_param(ctxt, NULL, gcc_jit_type_get_pointer(gcc_jit_type_get_const(data_type)), "vars");
+	params[1] = gcc_jit_context_new_param(ctxt, NULL, int_type, "n");
+	params[2] = gcc_jit_context_new_param(ctxt, NULL, gcc_jit_type_get_pointer(s.double_type), "result");
+	s.fn = gcc_jit_context_new_function(ctxt, NULL, GCC_JIT_FUNCTION_EXPORTED, void_type, "expr", 3, params, 0);
+
+	s.init = gcc_jit_function_new_block(s.fn, "init");
+	gcc_jit_block *cond = gcc_jit_function_new_block(s.fn, "cond");
+	s.body = gcc_jit_function_new_block(s.fn, "body");
+	gcc_jit_block *done = gcc_jit_function_new_block(s.fn, "done");
+
+	gcc_jit_lvalue *i = gcc_jit_function_new_local(s.fn, NULL, int_type, "i");
+	gcc_jit_rvalue *index = gcc_jit_lvalue_as_rvalue(i);
+	gcc_jit_rvalue *vars = gcc_jit_param_as_rvalue(params[0]);
+
+	/* the context variables are constant during the evaluation if the expression doesn't assign them */
+	int k, stores = 0;
+	for (k = 0; k < e->size; k++)
+		if (e->code[k].op == OP_STORE)
+			stores = 1;
+
+	gcc_jit_function *functions[OP_CALL0] = {0};
+	jit_value *stack = (jit_value *) malloc((e->stack_size + 1) * sizeof(jit_value));
+	jit_value *temps = (jit_value *) malloc((e->ntemps + 1) * sizeof(jit_value));
+	int top = -1;
+
+	for (k = 0; k < e->size; k++) {
+		const expr_instr *instr = &e->code[k];
+		gcc_jit_rvalue *args[EXPR_MAX_ARGS];
+		gcc_jit_rvalue *value = 0;
+		int nargs = 0, uniform = 1, j;
+		const char *name = 0;
+
+		switch (instr->op) {
+		case OP_NUM:
+			stack[++top].rvalue = gcc_jit_context_new_rvalue_from_double(ctxt, s.double_type, instr->value);
+			stack[top].uniform = 1;
+			continue;
+		case OP_VAR: {
+			gcc_jit_rvalue *slot = gcc_jit_context_new_rvalue_from_int(ctxt, int_type, instr->arg);
+			gcc_jit_rvalue *data = gcc_jit_lvalue_as_rvalue(gcc_jit_context_new_array_access(ctxt, NULL, vars, slot));
+			uniform = (strides[instr->arg] == 0);
+			value = gcc_jit_lvalue_as_rvalue(gcc_jit_context_new_array_access(ctxt, NULL, data,
+					uniform ? gcc_jit_context_zero(ctxt, int_type) : index));
+			stack[++top] = assign(&s, value, uniform);
+			continue;
+		}
+		case OP_SYM:
+			stack[++top] = assign(&s, gcc_jit_lvalue_as_rvalue(symbol(&s, instr->ptr.sym)), !stores);
+			continue;
+		case OP_STORE:
+			gcc_jit_block_add_assignment(stack[top].uniform ? s.init : s.body, NULL, symbol(&s, instr->ptr.sym), stack[top].rvalue);
+			continue;
+		case OP_SAVE:
+			temps[instr->arg] = stack[top];
+			continue;
+		case OP_LOAD:
+			stack[++top] = temps[instr->arg];
+			continue;
+		case OP_NEG:
+			value = gcc_jit_context_new_unary_op(ctxt, NULL, GCC_JIT_UNARY_OP_MINUS, s.double_type, stack[top].rvalue);
+			uniform = stack[top].uniform;
+			top--;
+			break;
+		case OP_ADD:
+		case OP_SUB:
+		case OP_MUL:
+		case OP_DIV: {
+			const enum gcc_jit_binary_op ops[] = {GCC_JIT_BINARY_OP_PLUS, GCC_JIT_BINARY_OP_MINUS, GCC_JIT_BINARY_OP_MULT, GCC_JIT_BINARY_OP_DIVIDE};
+			value = gcc_jit_context_new_binary_op(ctxt, NULL, ops[instr->op - OP_ADD], s.double_type, stack[top-1].rvalue, stack[top].rvalue);
+			uniform = stack[top-1].uniform && stack[top].uniform;
+			top -= 2;
+			break;
+		}
+		case OP_POW:
+			name = "pow";
+			nargs = 2;
+			break;
+		case OP_SQRT:
+			name = "sqrt";
+			nargs = 1;
+			break;
+		case OP_EXP:
+			name = "exp";
+			nargs = 1;
+			break;
+		case OP_LOG:
+			name = "log";
+			nargs = 1;
+			break;
+		case OP_SIN:
+			name = "sin";
+			nargs = 1;
+			break;
+		case OP_COS:
+			name = "cos";
+			nargs = 1;
+			break;
+		case OP_CALL0:
+		case OP_CALL1:
+		case OP_CALL2:
+		case OP_CALL3:
+		case OP_CALL4: {
+			gcc_jit_type *param_types[EXPR_MAX_ARGS];
+			nargs = instr->op - OP_CALL0;
+			for (j = 0; j < nargs; j++) {
+				param_types[j] = s.double_type;
+				args[j] = stack[top - nargs + 1 + j].rvalue;
+				uniform = uniform && stack[top - nargs + 1 + j].uniform;
+			}
+			/* random numbers are different for every point */
+			if (nargs == 0)
+				uniform = 0;
+			gcc_jit_type *fn_type = gcc_jit_context_new_function_ptr_type(ctxt, NULL, s.double_type, nargs, param_types, 0);
+			gcc_jit_rvalue *fn = gcc_jit_context_new_rvalue_from_ptr(ctxt, fn_type, (void *) instr->ptr.fnct);
+			value = gcc_jit_context_new_call_through_ptr(ctxt, NULL, fn, nargs, args);
+			top -= nargs;
+			break;
+		}
+		case OP_LT:
+		case OP_LE:
+		case OP_GT:
+		case OP_GE:
+		case OP_EQ:
+		case OP_NE: {
+			const enum gcc_jit_comparison ops[] = {GCC_JIT_COMPARISON_LT, GCC_JIT_COMPARISON_LE, GCC_JIT_COMPARISON_GT,
+				GCC_JIT_COMPARISON_GE, GCC_JIT_COMPARISON_EQ, GCC_JIT_COMPARISON_NE};
+			value = boolean_value(&s, gcc_jit_context_new_comparison(ctxt, NULL, ops[instr->op - OP_LT], stack[top-1].rvalue, stack[top].rvalue));
+			uniform = stack[top-1].uniform && stack[top].uniform;
+			top -= 2;
+			break;
+		}
+		case OP_AND:
+		case OP_OR: {
+			gcc_jit_type *bool_type = gcc_jit_context_get_type(ctxt, GCC_JIT_TYPE_BOOL);
+			value = gcc_jit_context_new_binary_op(ctxt, NULL, instr->op == OP_AND ? GCC_JIT_BINARY_OP_LOGICAL_AND : GCC_JIT_BINARY_OP_LOGICAL_OR,
+					bool_type, truth_value(&s, stack[top-1].rvalue), truth_value(&s, stack[top].rvalue));
+			value = boolean_value(&s, value);
+			uniform = stack[top-1].uniform && stack[top].uniform;
+			top -= 2;
+			break;
+		}
+		case OP_NOT:
+			value = boolean_value(&s, gcc_jit_context_new_comparison(ctxt, NULL, GCC_JIT_COMPARISON_EQ, stack[top].rvalue,
+					gcc_jit_context_zero(ctxt, s.double_type)));
+			uniform = stack[top].uniform;
+			top--;
+			break;
+		}
+
+		/* functions of the math library, gcc knows them as builtins */
+		if (name) {
+			if (!functions[instr->op])
+				functions[instr->op] = math_function(&s, name, nargs);
+			for (j = 0; j < nargs; j++) {
+				args[j] = stack[top - nargs + 1 + j].rvalue;
+				uniform = uniform && stack[top - nargs + 1 + j].uniform;
+			}
+			value = gcc_jit_context_new_call(ctxt, NULL, functions[instr->op], nargs, args);
+			top -= nargs;
+		}
+
+		stack[++top] = assign(&s, value, uniform);
+	}
+
+	/* for (i = 0; i < n; i++) result[i] = value; */
+	gcc_jit_block_add_assignment(s.init, NULL, i, gcc_jit_context_zero(ctxt, int_type));
+	gcc_jit_block_end_with_jump(s.init, NULL, cond);
+	gcc_jit_block_end_with_conditional(cond, NULL,
+		gcc_jit_context_new_comparison(ctxt, NULL, GCC_JIT_COMPARISON_LT, index, gcc_jit_param_as_rvalue(params[1])), s.body, done);
+	gcc_jit_block_add_assignment(s.body, NULL,
+		gcc_jit_context_new_array_access(ctxt, NULL, gcc_jit_param_as_rvalue(params[2]), index), stack[0].rvalue);
+	gcc_jit_block_add_assignment_op(s.body, NULL, i, GCC_JIT_BINARY_OP_PLUS, gcc_jit_context_one(ctxt, int_type));
+	gcc_jit_block_end_with_jump(s.body, NULL, cond);
+	gcc_jit_block_end_with_void_return(done, NULL);
+
+	gcc_jit_result *result = gcc_jit_context_compile(ctxt);
+	gcc_jit_context_release(ctxt);
+	free(stack);
+	free(temps);
+
+	return result;
+}
+
+int parse_jit(parser_expr *e, const int strides[]) {
+	int i;
+	if (!e)
+		return 0;
+	/* only parameters and contiguous data are supported */
+	for (i = 0; i < e->nvars; i++)
+		if (strides[i] != 0 && strides[i] != 1)
+			return 0;
+
+	expr_jit_free(e);
+	gcc_jit_result *result = generate(e, strides);
+	if (!result)
+		return 0;
+
+	e->native = (expr_native) gcc_jit_result_get_code(result, "expr");
+	if (!e->native) {
+		gcc_jit_result_release(result);
+		return 0;
+	}
+	e->native_result = result;
+	e->native_strides = (int *) malloc((e->nvars + 1) * sizeof(int));
+	memcpy(e->native_strides, strides, e->nvars * sizeof(int));
+
+	return 1;
+}
+
+void expr_jit_free(parser_expr *e) {
+	if (e->native_result)
+		gcc_jit_result_release((gcc_jit_result *) e->native_result);
+	free(e->native_strides);
+	e->native = 0;
+	e->native_result = 0;
+	e->native_strides = 0;
+}
+
+#else
+
+int parse_jit(parser_expr *e, const int strides[]) {
+	(void) e;
+	(void) strides;
+	return 0;
+}
+
+void expr_jit_free(parser_expr *e) {
+	(void) e;
+}
+
+#endif
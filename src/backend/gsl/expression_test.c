@@ -0,0 +1,237 @@
+/***************************************************************************
+    File                 : expression_test.c
+    Project              : LabPlot
+    Description          : benchmark of the compiled expressions
+    Copyright            : (C) 2017 by the LabPlot developers
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include "expression.h"
+
+#define N 1000000
+
+/* typical models using the functions of the parser. x varies from point to point, a, b and c are parameters */
+static const char *models[] = {
+	"a*exp(-(x-b)^2/(2*c^2))",
+	"sqrt(x^2+a^2) + b/sqrt(x^2+a^2) - c*sqrt(x^2+a^2)^3",
+	"a*sin(b*x+c) + b*cos(b*x+c) + sin(b*x+c)^2",
+	"a/2*(1 + erf((x-b)/(sqrt(2)*c)))",
+	"a*gamma(b)*x^(b-1)*exp(-x/c)/c^b",
+	"atan2(x, a) + hypot(x, b) + log(2*pi*c^2)",
+	"a*(x > b && x <= 2*b) + !(x < c || x >= 3*b)*exp(-x/c)"
+};
+
+static double elapsed(clock_t start) {
+	return 1000.*(clock() - start)/CLOCKS_PER_SEC;
+}
+
+/* maximal relative difference of the values in y and y0, values that are NAN in both are equal */
+static double max_difference(const double *y, const double *y0, int n) {
+	double maxdiff = 0;
+	int i;
+	for (i = 0; i < n; i++) {
+		if (isnan(y[i]) && isnan(y0[i]))
+			continue;
+		const double diff = fabs(y[i] - y0[i])/fmax(1., fabs(y0[i]));
+		if (!(diff <= maxdiff))
+			maxdiff = diff;
+	}
+	return maxdiff;
+}
+
+/* expressions and the slot of the variable of the derivatives compared with finite differences */
+static const struct {
+	const char *expr;
+	int slot;
+} derivatives[] = {
+	{"x^x", 0},
+	{"pow(x, a*x)", 0},
+	{"a^(b*x)", 0},
+	{"(x^2 + a)/(b*x + c)", 0},
+	{"x/(a - sin(x))", 0},
+	{"erf(a*x - b)", 0},
+	{"erfc(x/c)", 0},
+	{"fabs(x - b)*x", 0},
+	{"sin(exp(cos(a*x)))", 0},
+	{"log(sqrt(x^2 + c))^2", 0},
+	{"a*exp(-(x-b)^2/(2*c^2))", 2},
+	{"x^a/(1 + tanh(a*x))", 1}
+};
+
+/* compares the derivatives with central finite differences at several points, returns the number of failures */
+static int check_derivatives(const char *vars[]) {
+	const double points[] = {0.3, 1.7, 2.9};
+	int failures = 0;
+	unsigned int i, j;
+
+	printf("\n%-56s %s\n", "derivative", "max. rel. diff to finite differences");
+	for (j = 0; j < sizeof(derivatives)/sizeof(derivatives[0]); j++) {
+		parser_expr *expr = parse_compile(derivatives[j].expr, vars, 4);
+		parser_expr *d = expr ? parse_derivative(expr, derivatives[j].slot) : 0;
+		if (!d) {
+			printf("%-56s FAILED: no derivative\n", derivatives[j].expr);
+			failures++;
+			parse_free(expr);
+			continue;
+		}
+
+		double maxdiff = 0;
+		for (i = 0; i < sizeof(points)/sizeof(points[0]); i++) {
+			double v[4] = {points[i], 1.5, 2.5, 0.7};
+			const double value = v[derivatives[j].slot];
+			const double h = 1.e-5*fmax(1., fabs(value));
+			v[derivatives[j].slot] = value + h;
+			const double right = parse_eval(expr, v);
+			v[derivatives[j].slot] = value - h;
+			const double left = parse_eval(expr, v);
+			v[derivatives[j].slot] = value;
+
+			const double fd = (right - left)/(2.*h);
+			const double diff = fabs(parse_eval(d, v) - fd)/fmax(1., fabs(fd));
+			if (!(diff <= maxdiff))
+				maxdiff = diff;
+		}
+
+		printf("%-56s %g%s\n", derivatives[j].expr, maxdiff, maxdiff > 1.e-6 ? " FAILED" : "");
+		if (maxdiff > 1.e-6)
+			failures++;
+
+		parse_free(d);
+		parse_free(expr);
+	}
+
+	return failures;
+}
+
+#ifdef HAVE_LIBGCCJIT
+/* compares the native code of every model with the interpreted program, returns the number of failures */
+static int check_jit(const char *vars[], const double *values[], const int strides[], double *y, double *y0) {
+	int failures = 0;
+	unsigned int j;
+
+	printf("\n%-56s %8s %8s %8s\n", "model (native code)", "compile", "native", "speedup");
+	for (j = 0; j < sizeof(models)/sizeof(models[0]); j++) {
+		parser_expr *expr = parse_compile(models[j], vars, 4);
+		if (!expr)
+			continue;
+
+		clock_t start = clock();
+		parse_eval_vector(expr, values, strides, N, y0);
+		const double interpreted = elapsed(start);
+
+		start = clock();
+		const int jit = parse_jit(expr, strides);
+		const double compile = elapsed(start);
+		if (!jit) {
+			printf("%-56s FAILED: no native code\n", models[j]);
+			failures++;
+			parse_free(expr);
+			continue;
+		}
+
+		start = clock();
+		parse_eval_vector(expr, values, strides, N, y);
+		const double native = elapsed(start);
+
+		const double maxdiff = max_difference(y, y0, N);
+		printf("%-56s %8.1f %8.1f %8.1f (max. rel. diff %g)%s\n", models[j], compile, native, interpreted/native,
+			maxdiff, maxdiff > 1.e-12 ? " FAILED" : "");
+		if (maxdiff > 1.e-12)
+			failures++;
+
+		parse_free(expr);
+	}
+
+	return failures;
+}
+#endif
+
+int main() {
+	static double x[N], y[N], y0[N];
+	const char *vars[] = {"x", "a", "b", "c"};
+	double a = 1.5, b = 2.5, c = 0.7;
+	const double *values[] = {x, &a, &b, &c};
+	const int strides[] = {1, 0, 0, 0};
+	unsigned int i, j;
+	int failures = 0;
+
+	init_table();
+	for (i = 0; i < N; i++)
+		x[i] = 0.1 + 10.*i/N;
+
+	printf("%d points, times in ms\n", N);
+	printf("%-56s %8s %8s %8s %8s\n", "model", "scalar", "block", "optimized", "speedup");
+	for (j = 0; j < sizeof(models)/sizeof(models[0]); j++) {
+		parser_expr *expr = parse_compile(models[j], vars, 4);
+		if (!expr) {
+			printf("%s: parse error\n", models[j]);
+			continue;
+		}
+		/* the same expression without folding and common subexpressions */
+		parser_expr *plain = expr_compile_tree(expr->root, 4, 0);
+
+		/* point by point */
+		clock_t start = clock();
+		for (i = 0; i < N; i++) {
+			double v[4] = {x[i], a, b, c};
+			y0[i] = parse_eval(plain, v);
+		}
+		const double scalar = elapsed(start);
+
+		start = clock();
+		parse_eval_vector(plain, values, strides, N, y);
+		const double block = elapsed(start);
+
+		start = clock();
+		parse_eval_vector(expr, values, strides, N, y);
+		const double optimized = elapsed(start);
+
+		const double maxdiff = max_difference(y, y0, N);
+
+		printf("%-56s %8.1f %8.1f %8.1f %8.1f (instructions %d/%d, max. rel. diff %g)\n", models[j], scalar, block, optimized,
+			scalar/optimized, plain->size, expr->size, maxdiff);
+
+		parse_free(plain);
+		parse_free(expr);
+	}
+
+#ifdef HAVE_LIBGCCJIT
+	failures += check_jit(vars, values, strides, y, y0);
+#endif
+
+	failures += check_derivatives(vars);
+
+	/* the global constants are shared by all threads and can't be assigned */
+	parser_expr *assignment = parse_compile("pi = 3", vars, 4);
+	printf("assignment to a constant: %s\n", assignment ? "FAILED" : "rejected");
+	failures += (assignment != 0);
+	parse_free(assignment);
+	assignment = parse_compile("a = pi", vars, 4);
+	printf("assignment to a variable: %s\n", assignment ? "OK" : "FAILED");
+	failures += (assignment == 0);
+	parse_free(assignment);
+
+	return failures ? 1 : 0;
+}
@@ -63,7 +63,7 @@ typedef struct symrec {
 	struct symrec *next;	/* next field */
 } symrec;
 
-void init_table();	/* initialize symbol table */
+void init_table();	/* initialize the symbol table, once before parsing */
 void delete_table();	/* delete symbol table */
 int parse_errors();
 symrec* assign_variable(const char* symb_name, double value);
@@ -71,6 +71,36 @@ symrec* assign_variable(const char* symb_name, double value);
 double parse(const char *str);
 double parse_with_vars(const char[], const parser_var[], int nvars);
 
+/* parser context holding the variables, the error state and the result of the last parse.
+   Each thread uses its own context, the compiled expressions refer to the variables of the context. */
+typedef struct parser_context parser_context;
+typedef struct parser_expr parser_expr;
+parser_context* parser_context_new(void);
+void parser_context_free(parser_context *context);
+symrec* parser_context_assign(parser_context *context, const char *symb_name, double value);
+parser_expr* parser_context_compile(parser_context *context, const char *str, const char *vars[], int nvars);
+double parser_context_parse(parser_context *context, const char *str);
+int parser_context_errors(const parser_context *context);
+
+/* compiled expressions: parsed once, evaluated many times.
+   The variables vars[0..nvars-1] are bound to the slots of the values passed to parse_eval(),
+   the evaluation is thread-safe. */
+parser_expr* parse_compile(const char *str, const char *vars[], int nvars);
+double parse_eval(const parser_expr *expr, const double *values);
+void parse_eval_vector(const parser_expr *expr, const double *const vars[], const int strides[], int n, double *result);
+/* generates native code for the evaluations with parse_eval_vector() using the same pattern of strides (0 or 1).
+   Returns 0 if native code is not available, the expression is interpreted then. Not thread-safe, call before evaluating. */
+int parse_jit(parser_expr *expr, const int strides[]);
+/* number of points of an evaluation for which generating native code pays off */
+#define PARSER_JIT_MIN_POINTS 1000000
+void parse_free(parser_expr *expr);
+/* moves the subexpressions that depend on bound variables other than the one in \c slot out of \c expr.
+   The value of parts[k] is read from the slot nvars+k of the returned expression, at most \c maxparts are moved. */
+parser_expr* parse_factor(const parser_expr *expr, int slot, parser_expr *parts[], int maxparts, int *nparts);
+/* derivative of the compiled expression with respect to the variable in slot \c slot,
+   0 if the expression contains a function without a known derivative */
+parser_expr* parse_derivative(const parser_expr *expr, int slot);
+
 extern struct con _constants[];
 extern struct func _functions[];
 
@@ -1,21 +1,22 @@
-/* A Bison parser, made by GNU Bison 2.7.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison implementation for Yacc-like parsers in C
-   
-      Copyright (C) 1984, 1989-1990, 2000-2012 Free Software Foundation, Inc.
-   
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
    This program is free software: you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published by
    the Free Software Foundation, either version 3 of the License, or
    (at your option) any later version.
-   
+
    This program is distributed in the hope that it will be useful,
    but WITHOUT ANY WARRANTY; without even the implied warranty of
    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
    GNU General Public License for more details.
-   
+
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -26,13 +27,17 @@
    special exception, which will cause the skeleton and the resulting
    Bison output files to be licensed under the GNU General Public
    License without this special exception.
-   
+
    This special exception was added by the Free Software Foundation in
    version 2.2 of Bison.  */
 
 /* C LALR(1) parser skeleton written by Richard Stallman, by
    simplifying the original so-called "semantic" parser.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 /* All symbols defined below should begin with yy or YY, to avoid
    infringing on user name space.  This should be done even for local
    variables, as they might otherwise be expanded by user macros.
@@ -40,17 +45,17 @@
    define necessary library symbols; they are noted "INFRINGES ON
    USER NAME SPACE" below.  */
 
-/* Identify Bison output.  */
-#define YYBISON 1
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
 
-/* Bison version.  */
-#define YYBISON_VERSION "2.7"
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
 
 /* Skeleton name.  */
 #define YYSKELETON_NAME "yacc.c"
 
 /* Pure parsers.  */
-#define YYPURE 0
+#define YYPURE 2
 
 /* Push parsers.  */
 #define YYPUSH 0
@@ -61,14 +66,15 @@
 
 
 
-/* Copy the first part of user declarations.  */
-/* Line 371 of yacc.c  */
+/* First part of user prologue.  */
 #line 30 "parser.y"
 
 #include <string.h>
 #include <ctype.h>
 #include <locale.h>
+#include <math.h>
 #include "parser.h"
+#include "expression.h"
 #include "constants.h"
 #include "functions.h"
 
@@ -80,39 +86,73 @@
 
 #define YYERROR_VERBOSE 1
 
+/* parser context: the variables, the error state and the result of the last parse */
+struct parser_context {
+	symrec *sym_table;	/* variables of the context, searched before the global symbols */
+	int errors;		/* errors of the last parse */
+	double result;		/* result of the last parse */
+};
+
 /* params passed to yylex (and yyerror) */
 typedef struct param {
 	unsigned int pos;	/* current position in string */
 	char *string;		/* the string to parse */
-/*	symrec *sym_table;	the symbol table (not used) */
+	parser_context *context;	/* variables and error state */
+	const char **vars;	/* names of the variables bound to slots */
+	int nvars;
+	char *symbuf;		/* buffer for identifiers */
+	int length;		/* size of symbuf */
+	expr_node *nodes;	/* all nodes of the syntax tree */
+	expr_node *root;	/* root of the syntax tree of the last line */
 } param;
 
 int yyerror(param *p, const char *err);
-int yylex(param *p);
+static int is_global_symbol(const symrec *s);
+
+static expr_node* new_node(param *p, expr_type type, expr_node *arg1, expr_node *arg2) {
+	expr_node *node = expr_node_new(&p->nodes, type);
+	node->args[0] = arg1;
+	node->args[1] = arg2;
+	node->nargs = (arg1 != 0) + (arg2 != 0);
+	return node;
+}
 
-double res;
+static expr_node* new_fnct(param *p, symrec *sym, int nargs, expr_node *arg1, expr_node *arg2, expr_node *arg3, expr_node *arg4) {
+	expr_node *node = expr_node_new(&p->nodes, EXPR_FNCT);
+	node->sym = sym;
+	node->nargs = nargs;
+	node->args[0] = arg1;
+	node->args[1] = arg2;
+	node->args[2] = arg3;
+	node->args[3] = arg4;
+	return node;
+}
 
-/* Line 371 of yacc.c  */
-#line 97 "parser.tab.c"
+#line 132 "parser.tab.c"
 
-# ifndef YY_NULL
-#  if defined __cplusplus && 201103L <= __cplusplus
-#   define YY_NULL nullptr
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
 #  else
-#   define YY_NULL 0
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
+# ifndef YY_NULLPTR
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
+#  else
+#   define YY_NULLPTR ((void*)0)
 #  endif
 # endif
-
-/* Enabling verbose error messages.  */
-#ifdef YYERROR_VERBOSE
-# undef YYERROR_VERBOSE
-# define YYERROR_VERBOSE 1
-#else
-# define YYERROR_VERBOSE 0
-#endif
 
 
-/* Enabling traces.  */
+/* Debug traces.  */
 #ifndef YYDEBUG
 # define YYDEBUG 0
 #endif
@@ -120,90 +160,188 @@ double res;
 extern int yydebug;
 #endif
 
-/* Tokens.  */
+/* Token kinds.  */
 #ifndef YYTOKENTYPE
 # define YYTOKENTYPE
-   /* Put the tokens into the symbol table, so that GDB and other debuggers
-      know about them.  */
-   enum yytokentype {
-     NUM = 258,
-     VAR = 259,
-     FNCT = 260,
-     NEG = 261
-   };
+  enum yytokentype
+  {
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    NUM = 258,                     /* NUM  */
+    VAR = 259,                     /* VAR  */
+    FNCT = 260,                    /* FNCT  */
+    SLOT = 261,                    /* SLOT  */
+    LE = 262,                      /* LE  */
+    GE = 263,                      /* GE  */
+    EQ = 264,                      /* EQ  */
+    NE = 265,                      /* NE  */
+    AND = 266,                     /* AND  */
+    OR = 267,                      /* OR  */
+    NEG = 268                      /* NEG  */
+  };
+  typedef enum yytokentype yytoken_kind_t;
 #endif
 
-
+/* Value type.  */
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-typedef union YYSTYPE
+union YYSTYPE
 {
-/* Line 387 of yacc.c  */
-#line 62 "parser.y"
+#line 95 "parser.y"
 
 double dval;	/* For returning numbers */
 symrec *tptr;   /* For returning symbol-table pointers */
+int ival;	/* For returning slots of bound variables */
+expr_node *nptr;	/* For returning nodes of the syntax tree */
 
+#line 199 "parser.tab.c"
 
-/* Line 387 of yacc.c  */
-#line 149 "parser.tab.c"
-} YYSTYPE;
+};
+typedef union YYSTYPE YYSTYPE;
 # define YYSTYPE_IS_TRIVIAL 1
-# define yystype YYSTYPE /* obsolescent; will be withdrawn */
 # define YYSTYPE_IS_DECLARED 1
 #endif
 
-extern YYSTYPE yylval;
 
-#ifdef YYPARSE_PARAM
-#if defined __STDC__ || defined __cplusplus
-int yyparse (void *YYPARSE_PARAM);
-#else
-int yyparse ();
-#endif
-#else /* ! YYPARSE_PARAM */
-#if defined __STDC__ || defined __cplusplus
+
+
 int yyparse (param *p);
-#else
-int yyparse ();
-#endif
-#endif /* ! YYPARSE_PARAM */
 
 
 
-/* Copy the second part of user declarations.  */
+/* Symbol kind.  */
+enum yysymbol_kind_t
+{
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_NUM = 3,                        /* NUM  */
+  YYSYMBOL_VAR = 4,                        /* VAR  */
+  YYSYMBOL_FNCT = 5,                       /* FNCT  */
+  YYSYMBOL_SLOT = 6,                       /* SLOT  */
+  YYSYMBOL_LE = 7,                         /* LE  */
+  YYSYMBOL_GE = 8,                         /* GE  */
+  YYSYMBOL_EQ = 9,                         /* EQ  */
+  YYSYMBOL_NE = 10,                        /* NE  */
+  YYSYMBOL_AND = 11,                       /* AND  */
+  YYSYMBOL_OR = 12,                        /* OR  */
+  YYSYMBOL_13_ = 13,                       /* '='  */
+  YYSYMBOL_14_ = 14,                       /* '<'  */
+  YYSYMBOL_15_ = 15,                       /* '>'  */
+  YYSYMBOL_16_ = 16,                       /* '-'  */
+  YYSYMBOL_17_ = 17,                       /* '+'  */
+  YYSYMBOL_18_ = 18,                       /* '*'  */
+  YYSYMBOL_19_ = 19,                       /* '/'  */
+  YYSYMBOL_NEG = 20,                       /* NEG  */
+  YYSYMBOL_21_ = 21,                       /* '!'  */
+  YYSYMBOL_22_ = 22,                       /* '^'  */
+  YYSYMBOL_23_n_ = 23,                     /* '\n'  */
+  YYSYMBOL_24_ = 24,                       /* '('  */
+  YYSYMBOL_25_ = 25,                       /* ')'  */
+  YYSYMBOL_26_ = 26,                       /* ','  */
+  YYSYMBOL_YYACCEPT = 27,                  /* $accept  */
+  YYSYMBOL_input = 28,                     /* input  */
+  YYSYMBOL_line = 29,                      /* line  */
+  YYSYMBOL_expr = 30                       /* expr  */
+};
+typedef enum yysymbol_kind_t yysymbol_kind_t;
+
+
+
+/* Unqualified %code blocks.  */
+#line 108 "parser.y"
+
+int yylex(YYSTYPE *lvalp, param *p);
 
-/* Line 390 of yacc.c  */
-#line 177 "parser.tab.c"
+#line 259 "parser.tab.c"
 
 #ifdef short
 # undef short
 #endif
 
-#ifdef YYTYPE_UINT8
-typedef YYTYPE_UINT8 yytype_uint8;
-#else
-typedef unsigned char yytype_uint8;
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
+
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
+# endif
 #endif
 
-#ifdef YYTYPE_INT8
-typedef YYTYPE_INT8 yytype_int8;
-#elif (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
+
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
+#else
 typedef signed char yytype_int8;
+#endif
+
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
 #else
-typedef short int yytype_int8;
+typedef short yytype_int16;
 #endif
 
-#ifdef YYTYPE_UINT16
-typedef YYTYPE_UINT16 yytype_uint16;
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
+typedef unsigned char yytype_uint8;
 #else
-typedef unsigned short int yytype_uint16;
+typedef short yytype_uint8;
 #endif
 
-#ifdef YYTYPE_INT16
-typedef YYTYPE_INT16 yytype_int16;
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
+typedef unsigned short yytype_uint16;
 #else
-typedef short int yytype_int16;
+typedef int yytype_uint16;
+#endif
+
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
 #endif
 
 #ifndef YYSIZE_T
@@ -211,16 +349,28 @@ typedef short int yytype_int16;
 #  define YYSIZE_T __SIZE_TYPE__
 # elif defined size_t
 #  define YYSIZE_T size_t
-# elif ! defined YYSIZE_T && (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
 #  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
 #  define YYSIZE_T size_t
 # else
-#  define YYSIZE_T unsigned int
+#  define YYSIZE_T unsigned
 # endif
 #endif
 
-#define YYSIZE_MAXIMUM ((YYSIZE_T) -1)
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_int8 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
 
 #ifndef YY_
 # if defined YYENABLE_NLS && YYENABLE_NLS
@@ -234,32 +384,71 @@ typedef short int yytype_int16;
 # endif
 #endif
 
+
+#ifndef YY_ATTRIBUTE_PURE
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
+#endif
+
+#ifndef YY_ATTRIBUTE_UNUSED
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
+# else
+#  define YY_ATTRIBUTE_UNUSED
+# endif
+#endif
+
 /* Suppress unused-variable warnings by "using" E.  */
 #if ! defined lint || defined __GNUC__
-# define YYUSE(E) ((void) (E))
+# define YY_USE(E) ((void) (E))
 #else
-# define YYUSE(E) /* empty */
+# define YY_USE(E) /* empty */
 #endif
 
-/* Identity function, used to suppress warnings about constant conditions.  */
-#ifndef lint
-# define YYID(N) (N)
-#else
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-static int
-YYID (int yyi)
+/* Suppress an incorrect diagnostic about yylval being uninitialized.  */
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
+    _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
+    _Pragma ("GCC diagnostic pop")
 #else
-static int
-YYID (yyi)
-    int yyi;
+# define YY_INITIAL_VALUE(Value) Value
 #endif
-{
-  return yyi;
-}
+#ifndef YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END
+#endif
+#ifndef YY_INITIAL_VALUE
+# define YY_INITIAL_VALUE(Value) /* Nothing. */
 #endif
 
-#if ! defined yyoverflow || YYERROR_VERBOSE
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
+
+#define YY_ASSERT(E) ((void) (0 && (E)))
+
+#if !defined yyoverflow
 
 /* The parser invokes alloca or malloc; define the necessary symbols.  */
 
@@ -276,8 +465,7 @@ YYID (yyi)
 #    define alloca _alloca
 #   else
 #    define YYSTACK_ALLOC alloca
-#    if ! defined _ALLOCA_H && ! defined EXIT_SUCCESS && (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
+#    if ! defined _ALLOCA_H && ! defined EXIT_SUCCESS
 #     include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
       /* Use EXIT_SUCCESS as a witness for stdlib.h.  */
 #     ifndef EXIT_SUCCESS
@@ -289,8 +477,8 @@ YYID (yyi)
 # endif
 
 # ifdef YYSTACK_ALLOC
-   /* Pacify GCC's `empty if-body' warning.  */
-#  define YYSTACK_FREE(Ptr) do { /* empty */; } while (YYID (0))
+   /* Pacify GCC's 'empty if-body' warning.  */
+#  define YYSTACK_FREE(Ptr) do { /* empty */; } while (0)
 #  ifndef YYSTACK_ALLOC_MAXIMUM
     /* The OS might guarantee only one guard page at the bottom of the stack,
        and a page size can be as small as 4096 bytes.  So we cannot safely
@@ -306,7 +494,7 @@ YYID (yyi)
 #  endif
 #  if (defined __cplusplus && ! defined EXIT_SUCCESS \
        && ! ((defined YYMALLOC || defined malloc) \
-	     && (defined YYFREE || defined free)))
+             && (defined YYFREE || defined free)))
 #   include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
 #   ifndef EXIT_SUCCESS
 #    define EXIT_SUCCESS 0
@@ -314,40 +502,37 @@ YYID (yyi)
 #  endif
 #  ifndef YYMALLOC
 #   define YYMALLOC malloc
-#   if ! defined malloc && ! defined EXIT_SUCCESS && (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
+#   if ! defined malloc && ! defined EXIT_SUCCESS
 void *malloc (YYSIZE_T); /* INFRINGES ON USER NAME SPACE */
 #   endif
 #  endif
 #  ifndef YYFREE
 #   define YYFREE free
-#   if ! defined free && ! defined EXIT_SUCCESS && (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
+#   if ! defined free && ! defined EXIT_SUCCESS
 void free (void *); /* INFRINGES ON USER NAME SPACE */
 #   endif
 #  endif
 # endif
-#endif /* ! defined yyoverflow || YYERROR_VERBOSE */
-
+#endif /* !defined yyoverflow */
 
 #if (! defined yyoverflow \
      && (! defined __cplusplus \
-	 || (defined YYSTYPE_IS_TRIVIAL && YYSTYPE_IS_TRIVIAL)))
+         || (defined YYSTYPE_IS_TRIVIAL && YYSTYPE_IS_TRIVIAL)))
 
 /* A type that is properly aligned for any stack member.  */
 union yyalloc
 {
-  yytype_int16 yyss_alloc;
+  yy_state_t yyss_alloc;
   YYSTYPE yyvs_alloc;
 };
 
 /* The size of the maximum gap between one aligned stack and the next.  */
-# define YYSTACK_GAP_MAXIMUM (sizeof (union yyalloc) - 1)
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
 
 /* The size of an array large to enough to hold all stacks, each with
    N elements.  */
 # define YYSTACK_BYTES(N) \
-     ((N) * (sizeof (yytype_int16) + sizeof (YYSTYPE)) \
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE)) \
       + YYSTACK_GAP_MAXIMUM)
 
 # define YYCOPY_NEEDED 1
@@ -357,16 +542,16 @@ union yyalloc
    elements in the stack, and YYPTR gives the new location of the
    stack.  Advance YYPTR to a properly aligned location for the next
    stack.  */
-# define YYSTACK_RELOCATE(Stack_alloc, Stack)				\
-    do									\
-      {									\
-	YYSIZE_T yynewbytes;						\
-	YYCOPY (&yyptr->Stack_alloc, Stack, yysize);			\
-	Stack = &yyptr->Stack_alloc;					\
-	yynewbytes = yystacksize * sizeof (*Stack) + YYSTACK_GAP_MAXIMUM; \
-	yyptr += yynewbytes / sizeof (*yyptr);				\
-      }									\
-    while (YYID (0))
+# define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
+    do                                                                  \
+      {                                                                 \
+        YYPTRDIFF_T yynewbytes;                                         \
+        YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
+        Stack = &yyptr->Stack_alloc;                                    \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
+      }                                                                 \
+    while (0)
 
 #endif
 
@@ -376,16 +561,16 @@ union yyalloc
 # ifndef YYCOPY
 #  if defined __GNUC__ && 1 < __GNUC__
 #   define YYCOPY(Dst, Src, Count) \
-      __builtin_memcpy (Dst, Src, (Count) * sizeof (*(Src)))
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
 #  else
 #   define YYCOPY(Dst, Src, Count)              \
       do                                        \
         {                                       \
-          YYSIZE_T yyi;                         \
+          YYPTRDIFF_T yyi;                      \
           for (yyi = 0; yyi < (Count); yyi++)   \
             (Dst)[yyi] = (Src)[yyi];            \
         }                                       \
-      while (YYID (0))
+      while (0)
 #  endif
 # endif
 #endif /* !YYCOPY_NEEDED */
@@ -393,37 +578,42 @@ union yyalloc
 /* YYFINAL -- State number of the termination state.  */
 #define YYFINAL  2
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   114
+#define YYLAST   266
 
 /* YYNTOKENS -- Number of terminals.  */
-#define YYNTOKENS  17
+#define YYNTOKENS  27
 /* YYNNTS -- Number of nonterminals.  */
 #define YYNNTS  4
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  22
-/* YYNRULES -- Number of states.  */
-#define YYNSTATES  44
+#define YYNRULES  33
+/* YYNSTATES -- Number of states.  */
+#define YYNSTATES  65
+
+/* YYMAXUTOK -- Last valid token kind.  */
+#define YYMAXUTOK   268
 
-/* YYTRANSLATE(YYLEX) -- Bison symbol number corresponding to YYLEX.  */
-#define YYUNDEFTOK  2
-#define YYMAXUTOK   261
 
-#define YYTRANSLATE(YYX)						\
-  ((unsigned int) (YYX) <= YYMAXUTOK ? yytranslate[YYX] : YYUNDEFTOK)
+/* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex, with out-of-bounds checking.  */
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
 
-/* YYTRANSLATE[YYLEX] -- Bison symbol number corresponding to YYLEX.  */
-static const yytype_uint8 yytranslate[] =
+/* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex.  */
+static const yytype_int8 yytranslate[] =
 {
        0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-      13,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+      23,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-      14,    15,     9,     8,    16,     7,     2,    10,     2,     2,
+       2,     2,     2,    21,     2,     2,     2,     2,     2,     2,
+      24,    25,    18,    17,    26,    16,     2,    19,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-       2,     6,     2,     2,     2,     2,     2,     2,     2,     2,
+      14,    13,    15,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-       2,     2,     2,     2,    12,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,    22,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
@@ -440,230 +630,225 @@ static const yytype_uint8 yytranslate[] =
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
-       5,    11
+       5,     6,     7,     8,     9,    10,    11,    12,    20
 };
 
 #if YYDEBUG
-/* YYPRHS[YYN] -- Index of the first RHS symbol of rule number YYN in
-   YYRHS.  */
-static const yytype_uint8 yyprhs[] =
-{
-       0,     0,     3,     4,     7,     9,    12,    15,    17,    19,
-      23,    27,    32,    39,    48,    59,    63,    67,    71,    75,
-      78,    82,    87
-};
-
-/* YYRHS -- A `-1'-separated list of the rules' RHS.  */
-static const yytype_int8 yyrhs[] =
-{
-      18,     0,    -1,    -1,    18,    19,    -1,    13,    -1,    20,
-      13,    -1,     1,    13,    -1,     3,    -1,     4,    -1,     4,
-       6,    20,    -1,     5,    14,    15,    -1,     5,    14,    20,
-      15,    -1,     5,    14,    20,    16,    20,    15,    -1,     5,
-      14,    20,    16,    20,    16,    20,    15,    -1,     5,    14,
-      20,    16,    20,    16,    20,    16,    20,    15,    -1,    20,
-       8,    20,    -1,    20,     7,    20,    -1,    20,     9,    20,
-      -1,    20,    10,    20,    -1,     7,    20,    -1,    20,    12,
-      20,    -1,    20,     9,     9,    20,    -1,    14,    20,    15,
-      -1
-};
-
-/* YYRLINE[YYN] -- source line where rule number YYN was defined.  */
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_uint8 yyrline[] =
 {
-       0,    78,    78,    79,    82,    83,    84,    87,    88,    89,
-      90,    91,    92,    93,    94,    95,    96,    97,    98,    99,
-     100,   101,   102
+       0,   123,   123,   124,   127,   128,   129,   132,   133,   134,
+     135,   138,   139,   140,   141,   142,   143,   144,   145,   146,
+     147,   148,   149,   150,   151,   152,   153,   154,   155,   156,
+     157,   158,   159,   160
 };
 #endif
 
-#if YYDEBUG || YYERROR_VERBOSE || 0
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
 /* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
    First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
 static const char *const yytname[] =
 {
-  "$end", "error", "$undefined", "NUM", "VAR", "FNCT", "'='", "'-'",
-  "'+'", "'*'", "'/'", "NEG", "'^'", "'\\n'", "'('", "')'", "','",
-  "$accept", "input", "line", "expr", YY_NULL
+  "\"end of file\"", "error", "\"invalid token\"", "NUM", "VAR", "FNCT",
+  "SLOT", "LE", "GE", "EQ", "NE", "AND", "OR", "'='", "'<'", "'>'", "'-'",
+  "'+'", "'*'", "'/'", "NEG", "'!'", "'^'", "'\\n'", "'('", "')'", "','",
+  "$accept", "input", "line", "expr", YY_NULLPTR
 };
-#endif
 
-# ifdef YYPRINT
-/* YYTOKNUM[YYLEX-NUM] -- Internal token number corresponding to
-   token YYLEX-NUM.  */
-static const yytype_uint16 yytoknum[] =
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
 {
-       0,   256,   257,   258,   259,   260,    61,    45,    43,    42,
-      47,   261,    94,    10,    40,    41,    44
-};
-# endif
+  return yytname[yysymbol];
+}
+#endif
+
+#define YYPACT_NINF (-22)
 
-/* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
-static const yytype_uint8 yyr1[] =
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
+
+#define YYTABLE_NINF (-1)
+
+#define yytable_value_is_error(Yyn) \
+  0
+
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
+static const yytype_int16 yypact[] =
 {
-       0,    17,    18,    18,    19,    19,    19,    20,    20,    20,
-      20,    20,    20,    20,    20,    20,    20,    20,    20,    20,
-      20,    20,    20
+     -22,    29,   -22,   -21,   -22,    -9,   -19,    -7,    59,    59,
+     -22,    59,   -22,   182,   -22,    59,    52,    59,   -12,   -12,
+     144,    59,    59,    59,    59,    59,    59,    59,    59,    59,
+      59,    66,    59,    59,   -22,   199,   -22,    84,   199,   -22,
+      21,    21,   244,   244,   231,   215,    21,    21,     9,     9,
+      59,   -12,   -12,   -12,   -22,    59,   -12,   104,   -22,    59,
+     124,   -22,    59,   163,   -22
 };
 
-/* YYR2[YYN] -- Number of symbols composing right hand side of rule YYN.  */
-static const yytype_uint8 yyr2[] =
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
+static const yytype_int8 yydefact[] =
 {
-       0,     2,     0,     2,     1,     2,     2,     1,     1,     3,
-       3,     4,     6,     8,    10,     3,     3,     3,     3,     2,
-       3,     4,     3
+       2,     0,     1,     0,     7,     8,     0,     9,     0,     0,
+       4,     0,     3,     0,     6,     0,     0,     0,    21,    22,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     5,    10,    12,     0,    11,    33,
+      24,    26,    27,    28,    29,    30,    23,    25,    18,    17,
+       0,    19,    20,    31,    13,     0,    32,     0,    14,     0,
+       0,    15,     0,     0,    16
 };
 
-/* YYDEFACT[STATE-NAME] -- Default reduction number in state STATE-NUM.
-   Performed when YYTABLE doesn't specify something else to do.  Zero
-   means the default is an error.  */
-static const yytype_uint8 yydefact[] =
+/* YYPGOTO[NTERM-NUM].  */
+static const yytype_int8 yypgoto[] =
 {
-       2,     0,     1,     0,     7,     8,     0,     0,     4,     0,
-       3,     0,     6,     0,     0,    19,     0,     0,     0,     0,
-       0,     0,     5,     9,    10,     0,    22,    16,    15,     0,
-      17,    18,    20,    11,     0,    21,     0,    12,     0,     0,
-      13,     0,     0,    14
+     -22,   -22,   -22,    -8
 };
 
 /* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int8 yydefgoto[] =
 {
-      -1,     1,    10,    11
+       0,     1,    12,    13
 };
 
-/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
-   STATE-NUM.  */
-#define YYPACT_NINF -13
-static const yytype_int8 yypact[] =
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
+static const yytype_int8 yytable[] =
 {
-     -13,    16,   -13,   -12,   -13,    -3,   -10,    42,   -13,    42,
-     -13,    91,   -13,    42,    21,    -4,    73,    42,    42,    34,
-      42,    42,   -13,    98,   -13,    43,   -13,   102,   102,    42,
-      -4,    -4,    -4,   -13,    42,    -4,    53,   -13,    42,    63,
-     -13,    42,    82,   -13
+      18,    19,    14,    20,    15,    16,    17,    35,    37,    38,
+      33,     0,     0,    40,    41,    42,    43,    44,    45,    46,
+      47,    48,    49,    51,    52,    53,     0,    31,    32,     2,
+       3,    33,     4,     5,     6,     7,     0,    29,    30,    31,
+      32,     0,    56,    33,     0,     8,     0,    57,     0,     0,
+       9,    60,    10,    11,    63,     4,     5,     6,     7,     0,
+       0,     0,     4,     5,     6,     7,     0,     0,     8,     4,
+       5,     6,     7,     9,     0,     8,    11,    36,     0,     0,
+       9,     0,     8,    11,    50,     0,     0,     9,     0,     0,
+      11,    21,    22,    23,    24,    25,    26,     0,    27,    28,
+      29,    30,    31,    32,     0,     0,    33,     0,     0,    54,
+      55,    21,    22,    23,    24,    25,    26,     0,    27,    28,
+      29,    30,    31,    32,     0,     0,    33,     0,     0,    58,
+      59,    21,    22,    23,    24,    25,    26,     0,    27,    28,
+      29,    30,    31,    32,     0,     0,    33,     0,     0,    61,
+      62,    21,    22,    23,    24,    25,    26,     0,    27,    28,
+      29,    30,    31,    32,     0,     0,    33,     0,     0,    39,
+      21,    22,    23,    24,    25,    26,     0,    27,    28,    29,
+      30,    31,    32,     0,     0,    33,     0,     0,    64,    21,
+      22,    23,    24,    25,    26,     0,    27,    28,    29,    30,
+      31,    32,     0,     0,    33,    34,    21,    22,    23,    24,
+      25,    26,     0,    27,    28,    29,    30,    31,    32,     0,
+       0,    33,    21,    22,    23,    24,    25,     0,     0,    27,
+      28,    29,    30,    31,    32,     0,     0,    33,    21,    22,
+      23,    24,     0,     0,     0,    27,    28,    29,    30,    31,
+      32,    21,    22,    33,     0,     0,     0,     0,    27,    28,
+      29,    30,    31,    32,     0,     0,    33
 };
 
-/* YYPGOTO[NTERM-NUM].  */
-static const yytype_int8 yypgoto[] =
+static const yytype_int8 yycheck[] =
 {
-     -13,   -13,   -13,    -7
+       8,     9,    23,    11,    13,    24,    13,    15,    16,    17,
+      22,    -1,    -1,    21,    22,    23,    24,    25,    26,    27,
+      28,    29,    30,    31,    32,    33,    -1,    18,    19,     0,
+       1,    22,     3,     4,     5,     6,    -1,    16,    17,    18,
+      19,    -1,    50,    22,    -1,    16,    -1,    55,    -1,    -1,
+      21,    59,    23,    24,    62,     3,     4,     5,     6,    -1,
+      -1,    -1,     3,     4,     5,     6,    -1,    -1,    16,     3,
+       4,     5,     6,    21,    -1,    16,    24,    25,    -1,    -1,
+      21,    -1,    16,    24,    18,    -1,    -1,    21,    -1,    -1,
+      24,     7,     8,     9,    10,    11,    12,    -1,    14,    15,
+      16,    17,    18,    19,    -1,    -1,    22,    -1,    -1,    25,
+      26,     7,     8,     9,    10,    11,    12,    -1,    14,    15,
+      16,    17,    18,    19,    -1,    -1,    22,    -1,    -1,    25,
+      26,     7,     8,     9,    10,    11,    12,    -1,    14,    15,
+      16,    17,    18,    19,    -1,    -1,    22,    -1,    -1,    25,
+      26,     7,     8,     9,    10,    11,    12,    -1,    14,    15,
+      16,    17,    18,    19,    -1,    -1,    22,    -1,    -1,    25,
+       7,     8,     9,    10,    11,    12,    -1,    14,    15,    16,
+      17,    18,    19,    -1,    -1,    22,    -1,    -1,    25,     7,
+       8,     9,    10,    11,    12,    -1,    14,    15,    16,    17,
+      18,    19,    -1,    -1,    22,    23,     7,     8,     9,    10,
+      11,    12,    -1,    14,    15,    16,    17,    18,    19,    -1,
+      -1,    22,     7,     8,     9,    10,    11,    -1,    -1,    14,
+      15,    16,    17,    18,    19,    -1,    -1,    22,     7,     8,
+       9,    10,    -1,    -1,    -1,    14,    15,    16,    17,    18,
+      19,     7,     8,    22,    -1,    -1,    -1,    -1,    14,    15,
+      16,    17,    18,    19,    -1,    -1,    22
 };
 
-/* YYTABLE[YYPACT[STATE-NUM]].  What to do in state STATE-NUM.  If
-   positive, shift that token.  If negative, reduce the rule which
-   number is the opposite.  If YYTABLE_NINF, syntax error.  */
-#define YYTABLE_NINF -1
-static const yytype_uint8 yytable[] =
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_int8 yystos[] =
 {
-      15,    12,    16,    13,    14,     0,    23,    25,    21,     0,
-      27,    28,    30,    31,    32,     0,     2,     3,     0,     4,
-       5,     6,    35,     7,     4,     5,     6,    36,     7,     8,
-       9,    39,     0,     0,    42,     9,    24,     4,     5,     6,
-       0,     7,     0,    29,     0,     4,     5,     6,     9,     7,
-      17,    18,    19,    20,     0,    21,     9,     0,    33,    34,
-      17,    18,    19,    20,     0,    21,     0,     0,    37,    38,
-      17,    18,    19,    20,     0,    21,     0,     0,    40,    41,
-      17,    18,    19,    20,     0,    21,     0,     0,    26,    17,
-      18,    19,    20,     0,    21,     0,     0,    43,    17,    18,
-      19,    20,     0,    21,    22,    17,    18,    19,    20,     0,
-      21,    19,    20,     0,    21
+       0,    28,     0,     1,     3,     4,     5,     6,    16,    21,
+      23,    24,    29,    30,    23,    13,    24,    13,    30,    30,
+      30,     7,     8,     9,    10,    11,    12,    14,    15,    16,
+      17,    18,    19,    22,    23,    30,    25,    30,    30,    25,
+      30,    30,    30,    30,    30,    30,    30,    30,    30,    30,
+      18,    30,    30,    30,    25,    26,    30,    30,    25,    26,
+      30,    25,    26,    30,    25
 };
 
-#define yypact_value_is_default(Yystate) \
-  (!!((Yystate) == (-13)))
-
-#define yytable_value_is_error(Yytable_value) \
-  YYID (0)
-
-static const yytype_int8 yycheck[] =
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr1[] =
 {
-       7,    13,     9,     6,    14,    -1,    13,    14,    12,    -1,
-      17,    18,    19,    20,    21,    -1,     0,     1,    -1,     3,
-       4,     5,    29,     7,     3,     4,     5,    34,     7,    13,
-      14,    38,    -1,    -1,    41,    14,    15,     3,     4,     5,
-      -1,     7,    -1,     9,    -1,     3,     4,     5,    14,     7,
-       7,     8,     9,    10,    -1,    12,    14,    -1,    15,    16,
-       7,     8,     9,    10,    -1,    12,    -1,    -1,    15,    16,
-       7,     8,     9,    10,    -1,    12,    -1,    -1,    15,    16,
-       7,     8,     9,    10,    -1,    12,    -1,    -1,    15,     7,
-       8,     9,    10,    -1,    12,    -1,    -1,    15,     7,     8,
-       9,    10,    -1,    12,    13,     7,     8,     9,    10,    -1,
-      12,     9,    10,    -1,    12
+       0,    27,    28,    28,    29,    29,    29,    30,    30,    30,
+      30,    30,    30,    30,    30,    30,    30,    30,    30,    30,
+      30,    30,    30,    30,    30,    30,    30,    30,    30,    30,
+      30,    30,    30,    30
 };
 
-/* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
-   symbol of state STATE-NUM.  */
-static const yytype_uint8 yystos[] =
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
 {
-       0,    18,     0,     1,     3,     4,     5,     7,    13,    14,
-      19,    20,    13,     6,    14,    20,    20,     7,     8,     9,
-      10,    12,    13,    20,    15,    20,    15,    20,    20,     9,
-      20,    20,    20,    15,    16,    20,    20,    15,    16,    20,
-      15,    16,    20,    15
+       0,     2,     0,     2,     1,     2,     2,     1,     1,     1,
+       3,     3,     3,     4,     6,     8,    10,     3,     3,     3,
+       3,     2,     2,     3,     3,     3,     3,     3,     3,     3,
+       3,     3,     4,     3
 };
 
-#define yyerrok		(yyerrstatus = 0)
-#define yyclearin	(yychar = YYEMPTY)
-#define YYEMPTY		(-2)
-#define YYEOF		0
-
-#define YYACCEPT	goto yyacceptlab
-#define YYABORT		goto yyabortlab
-#define YYERROR		goto yyerrorlab
-
-
-/* Like YYERROR except do call yyerror.  This remains here temporarily
-   to ease the transition to the new meaning of YYERROR, for GCC.
-   Once GCC version 2 has supplanted version 1, this can go.  However,
-   YYFAIL appears to be in use.  Nevertheless, it is formally deprecated
-   in Bison 2.4.2's NEWS entry, where a plan to phase it out is
-   discussed.  */
-
-#define YYFAIL		goto yyerrlab
-#if defined YYFAIL
-  /* This is here to suppress warnings from the GCC cpp's
-     -Wunused-macros.  Normally we don't worry about that warning, but
-     some users do, and we want to make it easy for users to remove
-     YYFAIL uses, which will produce warnings from Bison 2.5.  */
-#endif
 
-#define YYRECOVERING()  (!!yyerrstatus)
+enum { YYENOMEM = -2 };
 
-#define YYBACKUP(Token, Value)                                  \
-do                                                              \
-  if (yychar == YYEMPTY)                                        \
-    {                                                           \
-      yychar = (Token);                                         \
-      yylval = (Value);                                         \
-      YYPOPSTACK (yylen);                                       \
-      yystate = *yyssp;                                         \
-      goto yybackup;                                            \
-    }                                                           \
-  else                                                          \
-    {                                                           \
-      yyerror (p, YY_("syntax error: cannot back up")); \
-      YYERROR;							\
-    }								\
-while (YYID (0))
-
-/* Error token number */
-#define YYTERROR	1
-#define YYERRCODE	256
-
-
-/* This macro is provided for backward compatibility. */
-#ifndef YY_LOCATION_PRINT
-# define YY_LOCATION_PRINT(File, Loc) ((void) 0)
-#endif
+#define yyerrok         (yyerrstatus = 0)
+#define yyclearin       (yychar = YYEMPTY)
 
+#define YYACCEPT        goto yyacceptlab
+#define YYABORT         goto yyabortlab
+#define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
+
+
+#define YYRECOVERING()  (!!yyerrstatus)
+
+#define YYBACKUP(Token, Value)                                    \
+  do                                                              \
+    if (yychar == YYEMPTY)                                        \
+      {                                                           \
+        yychar = (Token);                                         \
+        yylval = (Value);                                         \
+        YYPOPSTACK (yylen);                                       \
+        yystate = *yyssp;                                         \
+        goto yybackup;                                            \
+      }                                                           \
+    else                                                          \
+      {                                                           \
+        yyerror (p, YY_("syntax error: cannot back up")); \
+        YYERROR;                                                  \
+      }                                                           \
+  while (0)
+
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
 
-/* YYLEX -- calling `yylex' with the right arguments.  */
-#ifdef YYLEX_PARAM
-# define YYLEX yylex (YYLEX_PARAM)
-#else
-# define YYLEX yylex (p)
-#endif
 
 /* Enable debugging if requested.  */
 #if YYDEBUG
@@ -673,85 +858,59 @@ while (YYID (0))
 #  define YYFPRINTF fprintf
 # endif
 
-# define YYDPRINTF(Args)			\
-do {						\
-  if (yydebug)					\
-    YYFPRINTF Args;				\
-} while (YYID (0))
-
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)			  \
-do {									  \
-  if (yydebug)								  \
-    {									  \
-      YYFPRINTF (stderr, "%s ", Title);					  \
-      yy_symbol_print (stderr,						  \
-		  Type, Value, p); \
-      YYFPRINTF (stderr, "\n");						  \
-    }									  \
-} while (YYID (0))
-
-
-/*--------------------------------.
-| Print this symbol on YYOUTPUT.  |
-`--------------------------------*/
-
-/*ARGSUSED*/
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-static void
-yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, param *p)
-#else
+# define YYDPRINTF(Args)                        \
+do {                                            \
+  if (yydebug)                                  \
+    YYFPRINTF Args;                             \
+} while (0)
+
+
+
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
+do {                                                                      \
+  if (yydebug)                                                            \
+    {                                                                     \
+      YYFPRINTF (stderr, "%s ", Title);                                   \
+      yy_symbol_print (stderr,                                            \
+                  Kind, Value, p); \
+      YYFPRINTF (stderr, "\n");                                           \
+    }                                                                     \
+} while (0)
+
+
+/*-----------------------------------.
+| Print this symbol's value on YYO.  |
+`-----------------------------------*/
+
 static void
-yy_symbol_value_print (yyoutput, yytype, yyvaluep, p)
-    FILE *yyoutput;
-    int yytype;
-    YYSTYPE const * const yyvaluep;
-    param *p;
-#endif
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, param *p)
 {
-  FILE *yyo = yyoutput;
-  YYUSE (yyo);
+  FILE *yyoutput = yyo;
+  YY_USE (yyoutput);
+  YY_USE (p);
   if (!yyvaluep)
     return;
-  YYUSE (p);
-# ifdef YYPRINT
-  if (yytype < YYNTOKENS)
-    YYPRINT (yyoutput, yytoknum[yytype], *yyvaluep);
-# else
-  YYUSE (yyoutput);
-# endif
-  switch (yytype)
-    {
-      default:
-        break;
-    }
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
-/*--------------------------------.
-| Print this symbol on YYOUTPUT.  |
-`--------------------------------*/
+/*---------------------------.
+| Print this symbol on YYO.  |
+`---------------------------*/
 
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-static void
-yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, param *p)
-#else
 static void
-yy_symbol_print (yyoutput, yytype, yyvaluep, p)
-    FILE *yyoutput;
-    int yytype;
-    YYSTYPE const * const yyvaluep;
-    param *p;
-#endif
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, param *p)
 {
-  if (yytype < YYNTOKENS)
-    YYFPRINTF (yyoutput, "token %s (", yytname[yytype]);
-  else
-    YYFPRINTF (yyoutput, "nterm %s (", yytname[yytype]);
+  YYFPRINTF (yyo, "%s %s (",
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  yy_symbol_value_print (yyoutput, yytype, yyvaluep, p);
-  YYFPRINTF (yyoutput, ")");
+  yy_symbol_value_print (yyo, yykind, yyvaluep, p);
+  YYFPRINTF (yyo, ")");
 }
 
 /*------------------------------------------------------------------.
@@ -759,16 +918,8 @@ yy_symbol_print (yyoutput, yytype, yyvaluep, p)
 | TOP (included).                                                   |
 `------------------------------------------------------------------*/
 
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
 static void
-yy_stack_print (yytype_int16 *yybottom, yytype_int16 *yytop)
-#else
-static void
-yy_stack_print (yybottom, yytop)
-    yytype_int16 *yybottom;
-    yytype_int16 *yytop;
-#endif
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
 {
   YYFPRINTF (stderr, "Stack now");
   for (; yybottom <= yytop; yybottom++)
@@ -779,64 +930,56 @@ yy_stack_print (yybottom, yytop)
   YYFPRINTF (stderr, "\n");
 }
 
-# define YY_STACK_PRINT(Bottom, Top)				\
-do {								\
-  if (yydebug)							\
-    yy_stack_print ((Bottom), (Top));				\
-} while (YYID (0))
+# define YY_STACK_PRINT(Bottom, Top)                            \
+do {                                                            \
+  if (yydebug)                                                  \
+    yy_stack_print ((Bottom), (Top));                           \
+} while (0)
 
 
 /*------------------------------------------------.
 | Report that the YYRULE is going to be reduced.  |
 `------------------------------------------------*/
 
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
 static void
-yy_reduce_print (YYSTYPE *yyvsp, int yyrule, param *p)
-#else
-static void
-yy_reduce_print (yyvsp, yyrule, p)
-    YYSTYPE *yyvsp;
-    int yyrule;
-    param *p;
-#endif
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule, param *p)
 {
+  int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
   int yyi;
-  unsigned long int yylno = yyrline[yyrule];
-  YYFPRINTF (stderr, "Reducing stack by rule %d (line %lu):\n",
-	     yyrule - 1, yylno);
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
+             yyrule - 1, yylno);
   /* The symbols being reduced.  */
   for (yyi = 0; yyi < yynrhs; yyi++)
     {
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
-      yy_symbol_print (stderr, yyrhs[yyprhs[yyrule] + yyi],
-		       &(yyvsp[(yyi + 1) - (yynrhs)])
-		       		       , p);
+      yy_symbol_print (stderr,
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)], p);
       YYFPRINTF (stderr, "\n");
     }
 }
 
-# define YY_REDUCE_PRINT(Rule)		\
-do {					\
-  if (yydebug)				\
-    yy_reduce_print (yyvsp, Rule, p); \
-} while (YYID (0))
+# define YY_REDUCE_PRINT(Rule)          \
+do {                                    \
+  if (yydebug)                          \
+    yy_reduce_print (yyssp, yyvsp, Rule, p); \
+} while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
    multiple parsers can coexist.  */
 int yydebug;
 #else /* !YYDEBUG */
-# define YYDPRINTF(Args)
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
 # define YY_STACK_PRINT(Bottom, Top)
 # define YY_REDUCE_PRINT(Rule)
 #endif /* !YYDEBUG */
 
 
 /* YYINITDEPTH -- initial size of the parser's stacks.  */
-#ifndef	YYINITDEPTH
+#ifndef YYINITDEPTH
 # define YYINITDEPTH 200
 #endif
 
@@ -852,365 +995,84 @@ int yydebug;
 #endif
 
 
-#if YYERROR_VERBOSE
-
-# ifndef yystrlen
-#  if defined __GLIBC__ && defined _STRING_H
-#   define yystrlen strlen
-#  else
-/* Return the length of YYSTR.  */
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-static YYSIZE_T
-yystrlen (const char *yystr)
-#else
-static YYSIZE_T
-yystrlen (yystr)
-    const char *yystr;
-#endif
-{
-  YYSIZE_T yylen;
-  for (yylen = 0; yystr[yylen]; yylen++)
-    continue;
-  return yylen;
-}
-#  endif
-# endif
-
-# ifndef yystpcpy
-#  if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
-#   define yystpcpy stpcpy
-#  else
-/* Copy YYSRC to YYDEST, returning the address of the terminating '\0' in
-   YYDEST.  */
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-static char *
-yystpcpy (char *yydest, const char *yysrc)
-#else
-static char *
-yystpcpy (yydest, yysrc)
-    char *yydest;
-    const char *yysrc;
-#endif
-{
-  char *yyd = yydest;
-  const char *yys = yysrc;
-
-  while ((*yyd++ = *yys++) != '\0')
-    continue;
-
-  return yyd - 1;
-}
-#  endif
-# endif
-
-# ifndef yytnamerr
-/* Copy to YYRES the contents of YYSTR after stripping away unnecessary
-   quotes and backslashes, so that it's suitable for yyerror.  The
-   heuristic is that double-quoting is unnecessary unless the string
-   contains an apostrophe, a comma, or backslash (other than
-   backslash-backslash).  YYSTR is taken from yytname.  If YYRES is
-   null, do not copy; instead, return the length of what the result
-   would have been.  */
-static YYSIZE_T
-yytnamerr (char *yyres, const char *yystr)
-{
-  if (*yystr == '"')
-    {
-      YYSIZE_T yyn = 0;
-      char const *yyp = yystr;
-
-      for (;;)
-	switch (*++yyp)
-	  {
-	  case '\'':
-	  case ',':
-	    goto do_not_strip_quotes;
-
-	  case '\\':
-	    if (*++yyp != '\\')
-	      goto do_not_strip_quotes;
-	    /* Fall through.  */
-	  default:
-	    if (yyres)
-	      yyres[yyn] = *yyp;
-	    yyn++;
-	    break;
-
-	  case '"':
-	    if (yyres)
-	      yyres[yyn] = '\0';
-	    return yyn;
-	  }
-    do_not_strip_quotes: ;
-    }
-
-  if (! yyres)
-    return yystrlen (yystr);
-
-  return yystpcpy (yyres, yystr) - yyres;
-}
-# endif
-
-/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
-   about the unexpected token YYTOKEN for the state stack whose top is
-   YYSSP.
-
-   Return 0 if *YYMSG was successfully written.  Return 1 if *YYMSG is
-   not large enough to hold the message.  In that case, also set
-   *YYMSG_ALLOC to the required number of bytes.  Return 2 if the
-   required number of bytes is too large to store.  */
-static int
-yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
-                yytype_int16 *yyssp, int yytoken)
-{
-  YYSIZE_T yysize0 = yytnamerr (YY_NULL, yytname[yytoken]);
-  YYSIZE_T yysize = yysize0;
-  enum { YYERROR_VERBOSE_ARGS_MAXIMUM = 5 };
-  /* Internationalized format string. */
-  const char *yyformat = YY_NULL;
-  /* Arguments of yyformat. */
-  char const *yyarg[YYERROR_VERBOSE_ARGS_MAXIMUM];
-  /* Number of reported tokens (one for the "unexpected", one per
-     "expected"). */
-  int yycount = 0;
-
-  /* There are many possibilities here to consider:
-     - Assume YYFAIL is not used.  It's too flawed to consider.  See
-       <http://lists.gnu.org/archive/html/bison-patches/2009-12/msg00024.html>
-       for details.  YYERROR is fine as it does not invoke this
-       function.
-     - If this state is a consistent state with a default action, then
-       the only way this function was invoked is if the default action
-       is an error action.  In that case, don't check for expected
-       tokens because there are none.
-     - The only way there can be no lookahead present (in yychar) is if
-       this state is a consistent state with a default action.  Thus,
-       detecting the absence of a lookahead is sufficient to determine
-       that there is no unexpected or expected token to report.  In that
-       case, just report a simple "syntax error".
-     - Don't assume there isn't a lookahead just because this state is a
-       consistent state with a default action.  There might have been a
-       previous inconsistent state, consistent state with a non-default
-       action, or user semantic action that manipulated yychar.
-     - Of course, the expected token list depends on states to have
-       correct lookahead information, and it depends on the parser not
-       to perform extra reductions after fetching a lookahead from the
-       scanner and before detecting a syntax error.  Thus, state merging
-       (from LALR or IELR) and default reductions corrupt the expected
-       token list.  However, the list is correct for canonical LR with
-       one exception: it will still contain any token that will not be
-       accepted due to an error action in a later state.
-  */
-  if (yytoken != YYEMPTY)
-    {
-      int yyn = yypact[*yyssp];
-      yyarg[yycount++] = yytname[yytoken];
-      if (!yypact_value_is_default (yyn))
-        {
-          /* Start YYX at -YYN if negative to avoid negative indexes in
-             YYCHECK.  In other words, skip the first -YYN actions for
-             this state because they are default actions.  */
-          int yyxbegin = yyn < 0 ? -yyn : 0;
-          /* Stay within bounds of both yycheck and yytname.  */
-          int yychecklim = YYLAST - yyn + 1;
-          int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
-          int yyx;
-
-          for (yyx = yyxbegin; yyx < yyxend; ++yyx)
-            if (yycheck[yyx + yyn] == yyx && yyx != YYTERROR
-                && !yytable_value_is_error (yytable[yyx + yyn]))
-              {
-                if (yycount == YYERROR_VERBOSE_ARGS_MAXIMUM)
-                  {
-                    yycount = 1;
-                    yysize = yysize0;
-                    break;
-                  }
-                yyarg[yycount++] = yytname[yyx];
-                {
-                  YYSIZE_T yysize1 = yysize + yytnamerr (YY_NULL, yytname[yyx]);
-                  if (! (yysize <= yysize1
-                         && yysize1 <= YYSTACK_ALLOC_MAXIMUM))
-                    return 2;
-                  yysize = yysize1;
-                }
-              }
-        }
-    }
-
-  switch (yycount)
-    {
-# define YYCASE_(N, S)                      \
-      case N:                               \
-        yyformat = S;                       \
-      break
-      YYCASE_(0, YY_("syntax error"));
-      YYCASE_(1, YY_("syntax error, unexpected %s"));
-      YYCASE_(2, YY_("syntax error, unexpected %s, expecting %s"));
-      YYCASE_(3, YY_("syntax error, unexpected %s, expecting %s or %s"));
-      YYCASE_(4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
-      YYCASE_(5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
-# undef YYCASE_
-    }
 
-  {
-    YYSIZE_T yysize1 = yysize + yystrlen (yyformat);
-    if (! (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM))
-      return 2;
-    yysize = yysize1;
-  }
 
-  if (*yymsg_alloc < yysize)
-    {
-      *yymsg_alloc = 2 * yysize;
-      if (! (yysize <= *yymsg_alloc
-             && *yymsg_alloc <= YYSTACK_ALLOC_MAXIMUM))
-        *yymsg_alloc = YYSTACK_ALLOC_MAXIMUM;
-      return 1;
-    }
 
-  /* Avoid sprintf, as that infringes on the user's name space.
-     Don't have undefined behavior even if the translation
-     produced a string with the wrong number of "%s"s.  */
-  {
-    char *yyp = *yymsg;
-    int yyi = 0;
-    while ((*yyp = *yyformat) != '\0')
-      if (*yyp == '%' && yyformat[1] == 's' && yyi < yycount)
-        {
-          yyp += yytnamerr (yyp, yyarg[yyi++]);
-          yyformat += 2;
-        }
-      else
-        {
-          yyp++;
-          yyformat++;
-        }
-  }
-  return 0;
-}
-#endif /* YYERROR_VERBOSE */
 
 /*-----------------------------------------------.
 | Release the memory associated to this symbol.  |
 `-----------------------------------------------*/
 
-/*ARGSUSED*/
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, param *p)
-#else
 static void
-yydestruct (yymsg, yytype, yyvaluep, p)
-    const char *yymsg;
-    int yytype;
-    YYSTYPE *yyvaluep;
-    param *p;
-#endif
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, param *p)
 {
-  YYUSE (yyvaluep);
-  YYUSE (p);
-
+  YY_USE (yyvaluep);
+  YY_USE (p);
   if (!yymsg)
     yymsg = "Deleting";
-  YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
-
-  switch (yytype)
-    {
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
 
-      default:
-        break;
-    }
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
 
 
-/* The lookahead symbol.  */
-int yychar;
-
-
-#ifndef YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-# define YY_IGNORE_MAYBE_UNINITIALIZED_END
-#endif
-#ifndef YY_INITIAL_VALUE
-# define YY_INITIAL_VALUE(Value) /* Nothing. */
-#endif
-
-/* The semantic value of the lookahead symbol.  */
-YYSTYPE yylval YY_INITIAL_VALUE(yyval_default);
-
-/* Number of syntax errors so far.  */
-int yynerrs;
 
 
 /*----------.
 | yyparse.  |
 `----------*/
 
-#ifdef YYPARSE_PARAM
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
-int
-yyparse (void *YYPARSE_PARAM)
-#else
-int
-yyparse (YYPARSE_PARAM)
-    void *YYPARSE_PARAM;
-#endif
-#else /* ! YYPARSE_PARAM */
-#if (defined __STDC__ || defined __C99__FUNC__ \
-     || defined __cplusplus || defined _MSC_VER)
 int
 yyparse (param *p)
-#else
-int
-yyparse (p)
-    param *p;
-#endif
-#endif
 {
-    int yystate;
-    /* Number of tokens to shift before error messages enabled.  */
-    int yyerrstatus;
+/* Lookahead token kind.  */
+int yychar;
+
 
-    /* The stacks and their tools:
-       `yyss': related to states.
-       `yyvs': related to semantic values.
+/* The semantic value of the lookahead symbol.  */
+/* Default value used for initialization, for pacifying older GCCs
+   or non-GCC compilers.  */
+YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
+YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
+
+    /* Number of syntax errors so far.  */
+    int yynerrs = 0;
 
-       Refer to the stacks through separate pointers, to allow yyoverflow
+    yy_state_fast_t yystate = 0;
+    /* Number of tokens to shift before error messages enabled.  */
+    int yyerrstatus = 0;
+
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
        to reallocate them elsewhere.  */
 
-    /* The state stack.  */
-    yytype_int16 yyssa[YYINITDEPTH];
-    yytype_int16 *yyss;
-    yytype_int16 *yyssp;
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
 
-    /* The semantic value stack.  */
-    YYSTYPE yyvsa[YYINITDEPTH];
-    YYSTYPE *yyvs;
-    YYSTYPE *yyvsp;
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH];
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
 
-    YYSIZE_T yystacksize;
+    /* The semantic value stack: array, bottom, top.  */
+    YYSTYPE yyvsa[YYINITDEPTH];
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
 
   int yyn;
+  /* The return value of yyparse.  */
   int yyresult;
-  /* Lookahead token as an internal (translated) token number.  */
-  int yytoken = 0;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
   /* The variables used to return semantic value and location from the
      action routines.  */
   YYSTYPE yyval;
 
-#if YYERROR_VERBOSE
-  /* Buffer for error messages, and its allocated size.  */
-  char yymsgbuf[128];
-  char *yymsg = yymsgbuf;
-  YYSIZE_T yymsg_alloc = sizeof yymsgbuf;
-#endif
+
 
 #define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
 
@@ -1218,102 +1080,107 @@ yyparse (p)
      Keep to zero when no symbol should be popped.  */
   int yylen = 0;
 
-  yyssp = yyss = yyssa;
-  yyvsp = yyvs = yyvsa;
-  yystacksize = YYINITDEPTH;
-
   YYDPRINTF ((stderr, "Starting parse\n"));
 
-  yystate = 0;
-  yyerrstatus = 0;
-  yynerrs = 0;
   yychar = YYEMPTY; /* Cause a token to be read.  */
+
   goto yysetstate;
 
+
 /*------------------------------------------------------------.
-| yynewstate -- Push a new state, which is found in yystate.  |
+| yynewstate -- push a new state, which is found in yystate.  |
 `------------------------------------------------------------*/
- yynewstate:
+yynewstate:
   /* In all cases, when you get here, the value and location stacks
      have just been pushed.  So pushing a state here evens the stacks.  */
   yyssp++;
 
- yysetstate:
-  *yyssp = yystate;
+
+/*--------------------------------------------------------------------.
+| yysetstate -- set current state (the top of the stack) to yystate.  |
+`--------------------------------------------------------------------*/
+yysetstate:
+  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+  YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
 
   if (yyss + yystacksize - 1 <= yyssp)
+#if !defined yyoverflow && !defined YYSTACK_RELOCATE
+    YYNOMEM;
+#else
     {
       /* Get the current used size of the three stacks, in elements.  */
-      YYSIZE_T yysize = yyssp - yyss + 1;
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
 
-#ifdef yyoverflow
+# if defined yyoverflow
       {
-	/* Give user a chance to reallocate the stack.  Use copies of
-	   these so that the &'s don't force the real ones into
-	   memory.  */
-	YYSTYPE *yyvs1 = yyvs;
-	yytype_int16 *yyss1 = yyss;
-
-	/* Each stack pointer address is followed by the size of the
-	   data in use in that stack, in bytes.  This used to be a
-	   conditional around just the two extra args, but that might
-	   be undefined if yyoverflow is a macro.  */
-	yyoverflow (YY_("memory exhausted"),
-		    &yyss1, yysize * sizeof (*yyssp),
-		    &yyvs1, yysize * sizeof (*yyvsp),
-		    &yystacksize);
-
-	yyss = yyss1;
-	yyvs = yyvs1;
+        /* Give user a chance to reallocate the stack.  Use copies of
+           these so that the &'s don't force the real ones into
+           memory.  */
+        yy_state_t *yyss1 = yyss;
+        YYSTYPE *yyvs1 = yyvs;
+
+        /* Each stack pointer address is followed by the size of the
+           data in use in that stack, in bytes.  This used to be a
+           conditional around just the two extra args, but that might
+           be undefined if yyoverflow is a macro.  */
+        yyoverflow (YY_("memory exhausted"),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
+                    &yystacksize);
+        yyss = yyss1;
+        yyvs = yyvs1;
       }
-#else /* no yyoverflow */
-# ifndef YYSTACK_RELOCATE
-      goto yyexhaustedlab;
-# else
+# else /* defined YYSTACK_RELOCATE */
       /* Extend the stack our own way.  */
       if (YYMAXDEPTH <= yystacksize)
-	goto yyexhaustedlab;
+        YYNOMEM;
       yystacksize *= 2;
       if (YYMAXDEPTH < yystacksize)
-	yystacksize = YYMAXDEPTH;
+        yystacksize = YYMAXDEPTH;
 
       {
-	yytype_int16 *yyss1 = yyss;
-	union yyalloc *yyptr =
-	  (union yyalloc *) YYSTACK_ALLOC (YYSTACK_BYTES (yystacksize));
-	if (! yyptr)
-	  goto yyexhaustedlab;
-	YYSTACK_RELOCATE (yyss_alloc, yyss);
-	YYSTACK_RELOCATE (yyvs_alloc, yyvs);
+        yy_state_t *yyss1 = yyss;
+        union yyalloc *yyptr =
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
+        if (! yyptr)
+          YYNOMEM;
+        YYSTACK_RELOCATE (yyss_alloc, yyss);
+        YYSTACK_RELOCATE (yyvs_alloc, yyvs);
 #  undef YYSTACK_RELOCATE
-	if (yyss1 != yyssa)
-	  YYSTACK_FREE (yyss1);
+        if (yyss1 != yyssa)
+          YYSTACK_FREE (yyss1);
       }
 # endif
-#endif /* no yyoverflow */
 
       yyssp = yyss + yysize - 1;
       yyvsp = yyvs + yysize - 1;
 
-      YYDPRINTF ((stderr, "Stack size increased to %lu\n",
-		  (unsigned long int) yystacksize));
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
 
       if (yyss + yystacksize - 1 <= yyssp)
-	YYABORT;
+        YYABORT;
     }
+#endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
 
-  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
 
   if (yystate == YYFINAL)
     YYACCEPT;
 
   goto yybackup;
 
+
 /*-----------.
 | yybackup.  |
 `-----------*/
 yybackup:
-
   /* Do appropriate processing given the current state.  Read a
      lookahead token if we need one and don't already have one.  */
 
@@ -1324,18 +1191,29 @@ yybackup:
 
   /* Not known => get a lookahead token if don't already have one.  */
 
-  /* YYCHAR is either YYEMPTY or YYEOF or a valid lookahead symbol.  */
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
   if (yychar == YYEMPTY)
     {
-      YYDPRINTF ((stderr, "Reading a token: "));
-      yychar = YYLEX;
+      YYDPRINTF ((stderr, "Reading a token\n"));
+      yychar = yylex (&yylval, p);
     }
 
   if (yychar <= YYEOF)
     {
-      yychar = yytoken = YYEOF;
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
       YYDPRINTF ((stderr, "Now at end of input.\n"));
     }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
   else
     {
       yytoken = YYTRANSLATE (yychar);
@@ -1363,15 +1241,13 @@ yybackup:
 
   /* Shift the lookahead token.  */
   YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
-
-  /* Discard the shifted token.  */
-  yychar = YYEMPTY;
-
   yystate = yyn;
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
   *++yyvsp = yylval;
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 
+  /* Discard the shifted token.  */
+  yychar = YYEMPTY;
   goto yynewstate;
 
 
@@ -1386,14 +1262,14 @@ yydefault:
 
 
 /*-----------------------------.
-| yyreduce -- Do a reduction.  |
+| yyreduce -- do a reduction.  |
 `-----------------------------*/
 yyreduce:
   /* yyn is the number of a rule to reduce with.  */
   yylen = yyr2[yyn];
 
   /* If YYLEN is nonzero, implement the default value of the action:
-     `$$ = $1'.
+     '$$ = $1'.
 
      Otherwise, the following line sets YYVAL to garbage.
      This behavior is undocumented and Bison
@@ -1406,117 +1282,185 @@ yyreduce:
   YY_REDUCE_PRINT (yyn);
   switch (yyn)
     {
-        case 5:
-/* Line 1792 of yacc.c  */
-#line 83 "parser.y"
-    { res=(yyvsp[(1) - (2)].dval); }
+  case 5: /* line: expr '\n'  */
+#line 128 "parser.y"
+                      { p->root = (yyvsp[-1].nptr); }
+#line 1289 "parser.tab.c"
     break;
 
-  case 6:
-/* Line 1792 of yacc.c  */
-#line 84 "parser.y"
-    { yyerrok; }
+  case 6: /* line: error '\n'  */
+#line 129 "parser.y"
+                     { yyerrok; }
+#line 1295 "parser.tab.c"
     break;
 
-  case 7:
-/* Line 1792 of yacc.c  */
-#line 87 "parser.y"
-    { (yyval.dval) = (yyvsp[(1) - (1)].dval);                         }
+  case 7: /* expr: NUM  */
+#line 132 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_NUM, 0, 0); (yyval.nptr)->value = (yyvsp[0].dval); }
+#line 1301 "parser.tab.c"
     break;
 
-  case 8:
-/* Line 1792 of yacc.c  */
-#line 88 "parser.y"
-    { (yyval.dval) = (yyvsp[(1) - (1)].tptr)->value.var;              }
+  case 8: /* expr: VAR  */
+#line 133 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_SYM, 0, 0); (yyval.nptr)->sym = (yyvsp[0].tptr);   }
+#line 1307 "parser.tab.c"
     break;
 
-  case 9:
-/* Line 1792 of yacc.c  */
-#line 89 "parser.y"
-    { (yyval.dval) = (yyvsp[(3) - (3)].dval); (yyvsp[(1) - (3)].tptr)->value.var = (yyvsp[(3) - (3)].dval);     }
+  case 9: /* expr: SLOT  */
+#line 134 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_VAR, 0, 0); (yyval.nptr)->slot = (yyvsp[0].ival);  }
+#line 1313 "parser.tab.c"
     break;
 
-  case 10:
-/* Line 1792 of yacc.c  */
-#line 90 "parser.y"
-    { (yyval.dval) = (*((yyvsp[(1) - (3)].tptr)->value.fnctptr))();   }
+  case 10: /* expr: VAR '=' expr  */
+#line 135 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_ASSIGN, (yyvsp[0].nptr), 0); (yyval.nptr)->sym = (yyvsp[-2].tptr);
+                       /* the global symbols are shared by all threads */
+                       if (is_global_symbol((yyvsp[-2].tptr))) yyerror(p, "assignment to a constant"); }
+#line 1321 "parser.tab.c"
     break;
 
-  case 11:
-/* Line 1792 of yacc.c  */
-#line 91 "parser.y"
-    { (yyval.dval) = (*((yyvsp[(1) - (4)].tptr)->value.fnctptr))((yyvsp[(3) - (4)].dval)); }
+  case 11: /* expr: SLOT '=' expr  */
+#line 138 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_ASSIGN, (yyvsp[0].nptr), 0);             }
+#line 1327 "parser.tab.c"
     break;
 
-  case 12:
-/* Line 1792 of yacc.c  */
-#line 92 "parser.y"
-    { (yyval.dval) = (*((yyvsp[(1) - (6)].tptr)->value.fnctptr))((yyvsp[(3) - (6)].dval),(yyvsp[(5) - (6)].dval)); }
+  case 12: /* expr: FNCT '(' ')'  */
+#line 139 "parser.y"
+                     { (yyval.nptr) = new_fnct(p, (yyvsp[-2].tptr), 0, 0, 0, 0, 0);              }
+#line 1333 "parser.tab.c"
     break;
 
-  case 13:
-/* Line 1792 of yacc.c  */
-#line 93 "parser.y"
-    { (yyval.dval) = (*((yyvsp[(1) - (8)].tptr)->value.fnctptr))((yyvsp[(3) - (8)].dval),(yyvsp[(5) - (8)].dval),(yyvsp[(7) - (8)].dval)); }
+  case 13: /* expr: FNCT '(' expr ')'  */
+#line 140 "parser.y"
+                     { (yyval.nptr) = new_fnct(p, (yyvsp[-3].tptr), 1, (yyvsp[-1].nptr), 0, 0, 0);             }
+#line 1339 "parser.tab.c"
     break;
 
-  case 14:
-/* Line 1792 of yacc.c  */
-#line 94 "parser.y"
-    { (yyval.dval) = (*((yyvsp[(1) - (10)].tptr)->value.fnctptr))((yyvsp[(3) - (10)].dval),(yyvsp[(5) - (10)].dval),(yyvsp[(7) - (10)].dval),(yyvsp[(9) - (10)].dval)); }
+  case 14: /* expr: FNCT '(' expr ',' expr ')'  */
+#line 141 "parser.y"
+                              { (yyval.nptr) = new_fnct(p, (yyvsp[-5].tptr), 2, (yyvsp[-3].nptr), (yyvsp[-1].nptr), 0, 0);   }
+#line 1345 "parser.tab.c"
     break;
 
-  case 15:
-/* Line 1792 of yacc.c  */
-#line 95 "parser.y"
-    { (yyval.dval) = (yyvsp[(1) - (3)].dval) + (yyvsp[(3) - (3)].dval);                    }
+  case 15: /* expr: FNCT '(' expr ',' expr ',' expr ')'  */
+#line 142 "parser.y"
+                                      { (yyval.nptr) = new_fnct(p, (yyvsp[-7].tptr), 3, (yyvsp[-5].nptr), (yyvsp[-3].nptr), (yyvsp[-1].nptr), 0); }
+#line 1351 "parser.tab.c"
     break;
 
-  case 16:
-/* Line 1792 of yacc.c  */
-#line 96 "parser.y"
-    { (yyval.dval) = (yyvsp[(1) - (3)].dval) - (yyvsp[(3) - (3)].dval);                    }
+  case 16: /* expr: FNCT '(' expr ',' expr ',' expr ',' expr ')'  */
+#line 143 "parser.y"
+                                               { (yyval.nptr) = new_fnct(p, (yyvsp[-9].tptr), 4, (yyvsp[-7].nptr), (yyvsp[-5].nptr), (yyvsp[-3].nptr), (yyvsp[-1].nptr)); }
+#line 1357 "parser.tab.c"
     break;
 
-  case 17:
-/* Line 1792 of yacc.c  */
-#line 97 "parser.y"
-    { (yyval.dval) = (yyvsp[(1) - (3)].dval) * (yyvsp[(3) - (3)].dval);                    }
+  case 17: /* expr: expr '+' expr  */
+#line 144 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_ADD, (yyvsp[-2].nptr), (yyvsp[0].nptr));               }
+#line 1363 "parser.tab.c"
     break;
 
-  case 18:
-/* Line 1792 of yacc.c  */
-#line 98 "parser.y"
-    { (yyval.dval) = (yyvsp[(1) - (3)].dval) / (yyvsp[(3) - (3)].dval);                    }
+  case 18: /* expr: expr '-' expr  */
+#line 145 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_SUB, (yyvsp[-2].nptr), (yyvsp[0].nptr));               }
+#line 1369 "parser.tab.c"
     break;
 
-  case 19:
-/* Line 1792 of yacc.c  */
-#line 99 "parser.y"
-    { (yyval.dval) = -(yyvsp[(2) - (2)].dval);                        }
+  case 19: /* expr: expr '*' expr  */
+#line 146 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_MUL, (yyvsp[-2].nptr), (yyvsp[0].nptr));               }
+#line 1375 "parser.tab.c"
     break;
 
-  case 20:
-/* Line 1792 of yacc.c  */
-#line 100 "parser.y"
-    { (yyval.dval) = pow ((yyvsp[(1) - (3)].dval), (yyvsp[(3) - (3)].dval));               }
+  case 20: /* expr: expr '/' expr  */
+#line 147 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_DIV, (yyvsp[-2].nptr), (yyvsp[0].nptr));               }
+#line 1381 "parser.tab.c"
     break;
 
-  case 21:
-/* Line 1792 of yacc.c  */
-#line 101 "parser.y"
-    { (yyval.dval) = pow ((yyvsp[(1) - (4)].dval), (yyvsp[(4) - (4)].dval));               }
+  case 21: /* expr: '-' expr  */
+#line 148 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_NEG, (yyvsp[0].nptr), 0);                }
+#line 1387 "parser.tab.c"
     break;
 
-  case 22:
-/* Line 1792 of yacc.c  */
-#line 102 "parser.y"
-    { (yyval.dval) = (yyvsp[(2) - (3)].dval);                         }
+  case 22: /* expr: '!' expr  */
+#line 149 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_NOT, (yyvsp[0].nptr), 0);                }
+#line 1393 "parser.tab.c"
     break;
 
+  case 23: /* expr: expr '<' expr  */
+#line 150 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_LT, (yyvsp[-2].nptr), (yyvsp[0].nptr));                }
+#line 1399 "parser.tab.c"
+    break;
+
+  case 24: /* expr: expr LE expr  */
+#line 151 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_LE, (yyvsp[-2].nptr), (yyvsp[0].nptr));                }
+#line 1405 "parser.tab.c"
+    break;
+
+  case 25: /* expr: expr '>' expr  */
+#line 152 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_GT, (yyvsp[-2].nptr), (yyvsp[0].nptr));                }
+#line 1411 "parser.tab.c"
+    break;
+
+  case 26: /* expr: expr GE expr  */
+#line 153 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_GE, (yyvsp[-2].nptr), (yyvsp[0].nptr));                }
+#line 1417 "parser.tab.c"
+    break;
+
+  case 27: /* expr: expr EQ expr  */
+#line 154 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_EQ, (yyvsp[-2].nptr), (yyvsp[0].nptr));                }
+#line 1423 "parser.tab.c"
+    break;
+
+  case 28: /* expr: expr NE expr  */
+#line 155 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_NE, (yyvsp[-2].nptr), (yyvsp[0].nptr));                }
+#line 1429 "parser.tab.c"
+    break;
+
+  case 29: /* expr: expr AND expr  */
+#line 156 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_AND, (yyvsp[-2].nptr), (yyvsp[0].nptr));               }
+#line 1435 "parser.tab.c"
+    break;
+
+  case 30: /* expr: expr OR expr  */
+#line 157 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_OR, (yyvsp[-2].nptr), (yyvsp[0].nptr));                }
+#line 1441 "parser.tab.c"
+    break;
+
+  case 31: /* expr: expr '^' expr  */
+#line 158 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_POW, (yyvsp[-2].nptr), (yyvsp[0].nptr));               }
+#line 1447 "parser.tab.c"
+    break;
+
+  case 32: /* expr: expr '*' '*' expr  */
+#line 159 "parser.y"
+                     { (yyval.nptr) = new_node(p, EXPR_POW, (yyvsp[-3].nptr), (yyvsp[0].nptr));               }
+#line 1453 "parser.tab.c"
+    break;
+
+  case 33: /* expr: '(' expr ')'  */
+#line 160 "parser.y"
+                     { (yyval.nptr) = (yyvsp[-1].nptr);                                          }
+#line 1459 "parser.tab.c"
+    break;
+
+
+#line 1463 "parser.tab.c"
 
-/* Line 1792 of yacc.c  */
-#line 1520 "parser.tab.c"
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
@@ -1530,96 +1474,58 @@ yyreduce:
      case of YYERROR or YYBACKUP, subsequent parser actions might lead
      to an incorrect destructor call or verbose syntax error message
      before the lookahead is translated.  */
-  YY_SYMBOL_PRINT ("-> $$ =", yyr1[yyn], &yyval, &yyloc);
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
 
   YYPOPSTACK (yylen);
   yylen = 0;
-  YY_STACK_PRINT (yyss, yyssp);
 
   *++yyvsp = yyval;
 
-  /* Now `shift' the result of the reduction.  Determine what state
+  /* Now 'shift' the result of the reduction.  Determine what state
      that goes to, based on the state we popped back to and the rule
      number reduced by.  */
-
-  yyn = yyr1[yyn];
-
-  yystate = yypgoto[yyn - YYNTOKENS] + *yyssp;
-  if (0 <= yystate && yystate <= YYLAST && yycheck[yystate] == *yyssp)
-    yystate = yytable[yystate];
-  else
-    yystate = yydefgoto[yyn - YYNTOKENS];
+  {
+    const int yylhs = yyr1[yyn] - YYNTOKENS;
+    const int yyi = yypgoto[yylhs] + *yyssp;
+    yystate = (0 <= yyi && yyi <= YYLAST && yycheck[yyi] == *yyssp
+               ? yytable[yyi]
+               : yydefgoto[yylhs]);
+  }
 
   goto yynewstate;
 
 
-/*------------------------------------.
-| yyerrlab -- here on detecting error |
-`------------------------------------*/
+/*--------------------------------------.
+| yyerrlab -- here on detecting error.  |
+`--------------------------------------*/
 yyerrlab:
   /* Make sure we have latest lookahead translation.  See comments at
      user semantic actions for why this is necessary.  */
-  yytoken = yychar == YYEMPTY ? YYEMPTY : YYTRANSLATE (yychar);
-
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
   /* If not already recovering from an error, report this error.  */
   if (!yyerrstatus)
     {
       ++yynerrs;
-#if ! YYERROR_VERBOSE
       yyerror (p, YY_("syntax error"));
-#else
-# define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
-                                        yyssp, yytoken)
-      {
-        char const *yymsgp = YY_("syntax error");
-        int yysyntax_error_status;
-        yysyntax_error_status = YYSYNTAX_ERROR;
-        if (yysyntax_error_status == 0)
-          yymsgp = yymsg;
-        else if (yysyntax_error_status == 1)
-          {
-            if (yymsg != yymsgbuf)
-              YYSTACK_FREE (yymsg);
-            yymsg = (char *) YYSTACK_ALLOC (yymsg_alloc);
-            if (!yymsg)
-              {
-                yymsg = yymsgbuf;
-                yymsg_alloc = sizeof yymsgbuf;
-                yysyntax_error_status = 2;
-              }
-            else
-              {
-                yysyntax_error_status = YYSYNTAX_ERROR;
-                yymsgp = yymsg;
-              }
-          }
-        yyerror (p, yymsgp);
-        if (yysyntax_error_status == 2)
-          goto yyexhaustedlab;
-      }
-# undef YYSYNTAX_ERROR
-#endif
     }
 
-
-
   if (yyerrstatus == 3)
     {
       /* If just tried and failed to reuse lookahead token after an
-	 error, discard it.  */
+         error, discard it.  */
 
       if (yychar <= YYEOF)
-	{
-	  /* Return failure if at end of input.  */
-	  if (yychar == YYEOF)
-	    YYABORT;
-	}
+        {
+          /* Return failure if at end of input.  */
+          if (yychar == YYEOF)
+            YYABORT;
+        }
       else
-	{
-	  yydestruct ("Error: discarding",
-		      yytoken, &yylval, p);
-	  yychar = YYEMPTY;
-	}
+        {
+          yydestruct ("Error: discarding",
+                      yytoken, &yylval, p);
+          yychar = YYEMPTY;
+        }
     }
 
   /* Else will try to reuse lookahead token after shifting the error
@@ -1631,14 +1537,13 @@ yyerrlab:
 | yyerrorlab -- error raised explicitly by YYERROR.  |
 `---------------------------------------------------*/
 yyerrorlab:
+  /* Pacify compilers when the user code never invokes YYERROR and the
+     label yyerrorlab therefore never appears in user code.  */
+  if (0)
+    YYERROR;
+  ++yynerrs;
 
-  /* Pacify compilers like GCC when the user code never invokes
-     YYERROR and the label yyerrorlab therefore never appears in user
-     code.  */
-  if (/*CONSTCOND*/ 0)
-     goto yyerrorlab;
-
-  /* Do not reclaim the symbols of the rule which action triggered
+  /* Do not reclaim the symbols of the rule whose action triggered
      this YYERROR.  */
   YYPOPSTACK (yylen);
   yylen = 0;
@@ -1651,29 +1556,30 @@ yyerrorlab:
 | yyerrlab1 -- common code for both syntax error and YYERROR.  |
 `-------------------------------------------------------------*/
 yyerrlab1:
-  yyerrstatus = 3;	/* Each real token shifted decrements this.  */
+  yyerrstatus = 3;      /* Each real token shifted decrements this.  */
 
+  /* Pop stack until we find a state that shifts the error token.  */
   for (;;)
     {
       yyn = yypact[yystate];
       if (!yypact_value_is_default (yyn))
-	{
-	  yyn += YYTERROR;
-	  if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYTERROR)
-	    {
-	      yyn = yytable[yyn];
-	      if (0 < yyn)
-		break;
-	    }
-	}
+        {
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
+            {
+              yyn = yytable[yyn];
+              if (0 < yyn)
+                break;
+            }
+        }
 
       /* Pop the current state because it cannot handle the error token.  */
       if (yyssp == yyss)
-	YYABORT;
+        YYABORT;
 
 
       yydestruct ("Error: popping",
-		  yystos[yystate], yyvsp, p);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, p);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1685,7 +1591,7 @@ yyerrlab1:
 
 
   /* Shift the error token.  */
-  YY_SYMBOL_PRINT ("Shifting", yystos[yyn], yyvsp, yylsp);
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
 
   yystate = yyn;
   goto yynewstate;
@@ -1696,26 +1602,30 @@ yyerrlab1:
 `-------------------------------------*/
 yyacceptlab:
   yyresult = 0;
-  goto yyreturn;
+  goto yyreturnlab;
+
 
 /*-----------------------------------.
 | yyabortlab -- YYABORT comes here.  |
 `-----------------------------------*/
 yyabortlab:
   yyresult = 1;
-  goto yyreturn;
+  goto yyreturnlab;
+
 
-#if !defined yyoverflow || YYERROR_VERBOSE
-/*-------------------------------------------------.
-| yyexhaustedlab -- memory exhaustion comes here.  |
-`-------------------------------------------------*/
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
 yyexhaustedlab:
   yyerror (p, YY_("memory exhausted"));
   yyresult = 2;
-  /* Fall through.  */
-#endif
+  goto yyreturnlab;
 
-yyreturn:
+
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
   if (yychar != YYEMPTY)
     {
       /* Make sure we have latest lookahead translation.  See comments at
@@ -1724,49 +1634,47 @@ yyreturn:
       yydestruct ("Cleanup: discarding lookahead",
                   yytoken, &yylval, p);
     }
-  /* Do not reclaim the symbols of the rule which action triggered
+  /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
   YYPOPSTACK (yylen);
   YY_STACK_PRINT (yyss, yyssp);
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-		  yystos[*yyssp], yyvsp, p);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, p);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
   if (yyss != yyssa)
     YYSTACK_FREE (yyss);
 #endif
-#if YYERROR_VERBOSE
-  if (yymsg != yymsgbuf)
-    YYSTACK_FREE (yymsg);
-#endif
-  /* Make sure YYID is used.  */
-  return YYID (yyresult);
-}
 
+  return yyresult;
+}
 
-/* Line 2055 of yacc.c  */
-#line 105 "parser.y"
+#line 163 "parser.y"
 
 
-/* global symbol table */
+/* global symbol table of the functions and constants, read-only after init_table() */
 symrec *sym_table = 0;
 
+/* context of the functions without an explicit context, not thread-safe */
+static parser_context default_context = {0, 0, 0};
+
 int parse_errors() {
-	return yynerrs;
+	return default_context.errors;
 }
 
 int yyerror(param *p, const char *s) {
+	p->context->errors++;
 	/* remove trailing newline */
 	p->string[strcspn(p->string, "\n")] = 0;
 	printf("PARSER ERROR: %s @ position %d of string \'%s\'\n", s, p->pos, p->string);
 	return 0;
 }
 
-/* save symbol in symbol table */
-symrec* putsym(const char *sym_name, int sym_type) {
+/* save symbol in symbol table \c table */
+static symrec* putsym(symrec **table, const char *sym_name, int sym_type) {
 	pdebug("PARSER: putsym(): sym_name = %s\n", sym_name);
 
 	symrec *ptr = (symrec *) malloc(sizeof (symrec));
@@ -1774,19 +1682,19 @@ symrec* putsym(const char *sym_name, int sym_type) {
 	strcpy(ptr->name, sym_name);
 	ptr->type = sym_type;
 	ptr->value.var = 0;	/* set value to 0 even if fctn */
-	ptr->next = (struct symrec *)sym_table;
-	sym_table = ptr;
+	ptr->next = *table;
+	*table = ptr;
 	
 	pdebug("PARSER: putsym() DONE\n");
 	return ptr;
 }
 
-/* get symbol from symbol table */
-symrec* getsym(const char *sym_name) {
+/* get symbol from symbol table \c table */
+static symrec* getsym(symrec *table, const char *sym_name) {
 	pdebug("PARSER: getsym(): sym_name = %s\n", sym_name);
 	
 	symrec *ptr;
-	for (ptr = sym_table; ptr != 0; ptr = (symrec *)ptr->next) {
+	for (ptr = table; ptr != 0; ptr = (symrec *)ptr->next) {
 		/* pdebug("%s ", ptr->name); */
 		if (strcmp(ptr->name, sym_name) == 0) {
 			pdebug("PARSER: symbol \'%s\' found\n", sym_name);
@@ -1798,19 +1706,43 @@ symrec* getsym(const char *sym_name) {
 	return 0;
 }
 
+/* returns 1 if \c s is a function or constant of the global table */
+static int is_global_symbol(const symrec *s) {
+	const symrec *ptr;
+	for (ptr = sym_table; ptr != 0; ptr = (symrec *)ptr->next) {
+		if (ptr == s)
+			return 1;
+	}
+
+	return 0;
+}
+
+static void free_symbols(symrec **table) {
+	while(*table) {
+		symrec *tmp = *table;
+		*table = (*table)->next;
+		free(tmp->name);
+		free(tmp);
+	}
+}
+
+/* initializes the global table of functions and constants, calls after the first one do nothing.
+   Has to be called once before parsing, before contexts are used in several threads (done by ExpressionParser). */
 void init_table(void) {
 	pdebug("PARSER: init_table()\n");
+	if (sym_table)
+		return;
 
 	symrec *ptr = 0;
 	int i;
 	/* add functions */
 	for (i = 0; _functions[i].name != 0; i++) {
-		ptr = putsym (_functions[i].name, FNCT);
+		ptr = putsym(&sym_table, _functions[i].name, FNCT);
 		ptr->value.fnctptr = _functions[i].fnct;
 	}
 	/* add constants */
 	for (i = 0; _constants[i].name != 0; i++) {
-		ptr = putsym (_constants[i].name, VAR);
+		ptr = putsym(&sym_table, _constants[i].name, VAR);
 		ptr->value.var = _constants[i].value;
 	}
 
@@ -1818,30 +1750,40 @@ void init_table(void) {
 }
 
 void delete_table(void) {
-	while(sym_table) {
-		symrec *tmp = sym_table;
-		sym_table = sym_table->next;
-		free(tmp->name);
-		free(tmp);
-	}
+	free_symbols(&sym_table);
+	free_symbols(&default_context.sym_table);
 }
 
-symrec* assign_variable(const char* symb_name, double value) {
-	/* new style: pdebug("PARSER: assign_variable(): symb_name = %s value = %g sym_table = %p\n", var.name, var.value, sym_table);*/
-	pdebug("PARSER: assign_variable() : symb_name = %s value=%g\n", symb_name, value);
+parser_context* parser_context_new(void) {
+	return (parser_context *) calloc(1, sizeof(parser_context));
+}
+
+void parser_context_free(parser_context *context) {
+	if (!context)
+		return;
+	free_symbols(&context->sym_table);
+	free(context);
+}
 
-	/* be sure that the symbol table has been initialized */
-	if (!sym_table)
-		init_table();
+int parser_context_errors(const parser_context *context) {
+	return context->errors;
+}
+
+symrec* parser_context_assign(parser_context *context, const char* symb_name, double value) {
+	pdebug("PARSER: parser_context_assign() : symb_name = %s value=%g\n", symb_name, value);
 
-	symrec* ptr = getsym(symb_name);
+	symrec* ptr = getsym(context->sym_table, symb_name);
 	if (!ptr) {
 		pdebug("PARSER: calling putsym(): symb_name = %s\n", symb_name);
-		ptr = putsym(symb_name, VAR);
+		ptr = putsym(&context->sym_table, symb_name, VAR);
 	}
 	ptr->value.var = value;
 
 	return ptr;
+}
+
+symrec* assign_variable(const char* symb_name, double value) {
+	return parser_context_assign(&default_context, symb_name, value);
 };
 
 static int getcharstr(param *p) {
@@ -1858,15 +1800,20 @@ static void ungetcstr(unsigned int *pos) {
         (*pos)--;
 }
 
-double parse(const char *str) {
-	pdebug("\nPARSER: parse(\"%s\") len=%zu\n", str, strlen(str));
-
-	/* be sure that the symbol table has been initialized */
-	if (!sym_table)
-		init_table();
+/* compiles the expression \c str once in the context \c context, the variables \c vars are bound to the slots 0..nvars-1.
+   The other variables refer to the variables of the context. Returns 0 if the expression contains errors. */
+parser_expr* parser_context_compile(parser_context *context, const char *str, const char *vars[], int nvars) {
+	pdebug("\nPARSER: parse_compile(\"%s\") len=%zu\n", str, strlen(str));
 
 	param p;
 	p.pos = 0;
+	p.context = context;
+	p.vars = vars;
+	p.nvars = nvars;
+	p.symbuf = 0;
+	p.length = 0;
+	p.nodes = 0;
+	p.root = 0;
 	/* leave space to terminate string by "\n\0" */
 	size_t slen = strlen(str) + 2;
 	p.string = (char *) malloc(slen * sizeof(char));
@@ -1876,13 +1823,39 @@ double parse(const char *str) {
 	pdebug("\nPARSER: yyparse(\"%s\") len=%zu\n", p.string, strlen(p.string));
 
 	/* parameter for yylex */
+	context->errors = 0;
 	yyparse(&p);
 
-	pdebug("PARSER: parse() DONE (res = %g, parse errors = %d)\n", res, parse_errors());
+	parser_expr *expr = 0;
+	if (context->errors == 0)
+		expr = expr_compile_tree(p.root, nvars, 1);
+
+	pdebug("PARSER: parse_compile() DONE (parse errors = %d)\n", context->errors);
+	expr_node_free_all(p.nodes);
+	free(p.symbuf);
 	free(p.string);
 	p.string = 0;
 
-	return res;
+	return expr;
+}
+
+double parser_context_parse(parser_context *context, const char *str) {
+	parser_expr *expr = parser_context_compile(context, str, 0, 0);
+	if (!expr)
+		return NAN;
+
+	context->result = parse_eval(expr, 0);
+	parse_free(expr);
+
+	return context->result;
+}
+
+parser_expr* parse_compile(const char *str, const char *vars[], int nvars) {
+	return parser_context_compile(&default_context, str, vars, nvars);
+}
+
+double parse(const char *str) {
+	return parser_context_parse(&default_context, str);
 }
 
 double parse_with_vars(const char *str, const parser_var *vars, int nvars) {
@@ -1896,7 +1869,7 @@ double parse_with_vars(const char *str, const parser_var *vars, int nvars) {
 	return parse(str);
 }
 
-int yylex(param *p) {
+int yylex(YYSTYPE *lvalp, param *p) {
 	pdebug("PARSER: yylex()\n");
 	int c;
 
@@ -1911,7 +1884,7 @@ int yylex(param *p) {
 	/* check for non-ASCII chars */
 	if (!isascii(c)) {
 		pdebug("non-ASCII character found. Giving up\n");
-		yynerrs++;
+		p->context->errors++;
 		return 0;
 	}
 
@@ -1943,7 +1916,7 @@ int yylex(param *p) {
 
 		pdebug("PARSER: result = %g\n", result);
 
-		yylval.dval = result;
+		lvalp->dval = result;
 
                 p->pos += strlen(s) - strlen(remain);
 
@@ -1952,22 +1925,20 @@ int yylex(param *p) {
 
 	if (isalpha (c) || c == '.') {
 		pdebug("PARSER: reading identifier (starts with alpha: %c)\n", c);
-		static char *symbuf = 0;
-		static int length = 0;
-		int i = 0;
+		int i = 0, slot;
 
 		/* Initially make the buffer long enough for a 10-character symbol name */
-		if (length == 0)
-			length = 10, symbuf = (char *) malloc(length + 1);
+		if (p->length == 0)
+			p->length = 10, p->symbuf = (char *) malloc(p->length + 1);
 
 		do {
 			pdebug("reading symbol .. ");
 			/* If buffer is full, make it bigger */
-			if (i == length) {
-				length *= 2;
-				symbuf = (char *) realloc(symbuf, length + 1);
+			if (i == p->length) {
+				p->length *= 2;
+				p->symbuf = (char *) realloc(p->symbuf, p->length + 1);
 			}
-			symbuf[i++] = c;
+			p->symbuf[i++] = c;
 			c = getcharstr(p);
 			pdebug("got %c\n", c);
 		}
@@ -1976,22 +1947,52 @@ int yylex(param *p) {
 
 		if (c != EOF)
 			ungetcstr(&(p->pos));
-		symbuf[i] = '\0';
+		p->symbuf[i] = '\0';
 
-		symrec *s = getsym(symbuf);
+		/* variables bound to slots hide the symbols with the same name */
+		for (slot = 0; slot < p->nvars; slot++) {
+			if (strcmp(p->vars[slot], p->symbuf) == 0) {
+				lvalp->ival = slot;
+				return SLOT;
+			}
+		}
+
+		/* variables of the context hide the global symbols */
+		symrec *s = getsym(p->context->sym_table, p->symbuf);
+		if (s == 0)
+			s = getsym(sym_table, p->symbuf);
 		if(s == 0) {	/* symbol unknown */
-			pdebug("PARSER: ERROR: symbol \"%s\" UNKNOWN\n", symbuf);
-			yynerrs++;
+			pdebug("PARSER: ERROR: symbol \"%s\" UNKNOWN\n", p->symbuf);
+			p->context->errors++;
 			return 0;
 		}
 		/* old behavior */
 		/* if (s == 0)
 			 s = putsym (symbuf, VAR);
 		*/
-		yylval.tptr = s;
+		lvalp->tptr = s;
 		return s->type;
 	}
 
+	/* operators with two characters: <= >= == != && || */
+	const int next = getcharstr(p);
+	if (next == '=') {
+		if (c == '<')
+			return LE;
+		if (c == '>')
+			return GE;
+		if (c == '=')
+			return EQ;
+		if (c == '!')
+			return NE;
+	}
+	if (c == '&' && next == '&')
+		return AND;
+	if (c == '|' && next == '|')
+		return OR;
+	if (next != EOF)
+		ungetcstr(&(p->pos));
+
 	/* else: single operator */
 	pdebug("PARSER: single operator\n");
 	return c;
@@ -31,7 +31,9 @@
 #include <string.h>
 #include <ctype.h>
 #include <locale.h>
+#include <math.h>
 #include "parser.h"
+#include "expression.h"
 #include "constants.h"
 #include "functions.h"
 
@@ -43,35 +45,78 @@
 
 #define YYERROR_VERBOSE 1
 
+/* parser context: the variables, the error state and the result of the last parse */
+struct parser_context {
+	symrec *sym_table;	/* variables of the context, searched before the global symbols */
+	int errors;		/* errors of the last parse */
+	double result;		/* result of the last parse */
+};
+
 /* params passed to yylex (and yyerror) */
 typedef struct param {
 	unsigned int pos;	/* current position in string */
 	char *string;		/* the string to parse */
-/*	symrec *sym_table;	the symbol table (not used) */
+	parser_context *context;	/* variables and error state */
+	const char **vars;	/* names of the variables bound to slots */
+	int nvars;
+	char *symbuf;		/* buffer for identifiers */
+	int length;		/* size of symbuf */
+	expr_node *nodes;	/* all nodes of the syntax tree */
+	expr_node *root;	/* root of the syntax tree of the last line */
 } param;
 
 int yyerror(param *p, const char *err);
-int yylex(param *p);
+static int is_global_symbol(const symrec *s);
+
+static expr_node* new_node(param *p, expr_type type, expr_node *arg1, expr_node *arg2) {
+	expr_node *node = expr_node_new(&p->nodes, type);
+	node->args[0] = arg1;
+	node->args[1] = arg2;
+	node->nargs = (arg1 != 0) + (arg2 != 0);
+	return node;
+}
 
-double res;
+static expr_node* new_fnct(param *p, symrec *sym, int nargs, expr_node *arg1, expr_node *arg2, expr_node *arg3, expr_node *arg4) {
+	expr_node *node = expr_node_new(&p->nodes, EXPR_FNCT);
+	node->sym = sym;
+	node->nargs = nargs;
+	node->args[0] = arg1;
+	node->args[1] = arg2;
+	node->args[2] = arg3;
+	node->args[3] = arg4;
+	return node;
+}
 %}
 
+%define api.pure full
 %lex-param {param *p}
 %parse-param {param *p}
 
 %union {
 double dval;	/* For returning numbers */
 symrec *tptr;   /* For returning symbol-table pointers */
+int ival;	/* For returning slots of bound variables */
+expr_node *nptr;	/* For returning nodes of the syntax tree */
 }
 
 %token <dval>  NUM 	/* Simple double precision number */
 %token <tptr> VAR FNCT	/* VARiable and FuNCTion */
-%type  <dval>  expr
+%token <ival> SLOT	/* variable bound to a slot */
+%token LE GE EQ NE AND OR	/* comparisons and logical operators with two characters */
+%type  <nptr>  expr
+
+%code {
+int yylex(YYSTYPE *lvalp, param *p);
+}
 
 %right '='
+%left OR
+%left AND
+%left EQ NE
+%left '<' '>' LE GE
 %left '-' '+'
 %left '*' '/'
-%left NEG     /* Negation--unary minus */
+%left NEG '!' /* Negation--unary minus and logical not */
 %right '^'    /* Exponential */
 
 %%
@@ -80,46 +125,63 @@ input:   /* empty */
 ;
 
 line:	'\n'
-	| expr '\n'   { res=$1; }
+	| expr '\n'   { p->root = $1; }
 	| error '\n' { yyerrok; }
 ;
 
-expr:      NUM       { $$ = $1;                         }
-| VAR                { $$ = $1->value.var;              }
-| VAR '=' expr       { $$ = $3; $1->value.var = $3;     }
-| FNCT '(' ')'       { $$ = (*($1->value.fnctptr))();   }
-| FNCT '(' expr ')'  { $$ = (*($1->value.fnctptr))($3); }
-| FNCT '(' expr ',' expr ')'  { $$ = (*($1->value.fnctptr))($3,$5); }
-| FNCT '(' expr ',' expr ','expr ')'  { $$ = (*($1->value.fnctptr))($3,$5,$7); }
-| FNCT '(' expr ',' expr ',' expr ','expr ')'  { $$ = (*($1->value.fnctptr))($3,$5,$7,$9); }
-| expr '+' expr      { $$ = $1 + $3;                    }
-| expr '-' expr      { $$ = $1 - $3;                    }
-| expr '*' expr      { $$ = $1 * $3;                    }
-| expr '/' expr      { $$ = $1 / $3;                    }
-| '-' expr  %prec NEG{ $$ = -$2;                        }
-| expr '^' expr      { $$ = pow ($1, $3);               }
-| expr '*' '*' expr  { $$ = pow ($1, $4);               }
-| '(' expr ')'       { $$ = $2;                         }
+expr:      NUM       { $$ = new_node(p, EXPR_NUM, 0, 0); $$->value = $1; }
+| VAR                { $$ = new_node(p, EXPR_SYM, 0, 0); $$->sym = $1;   }
+| SLOT               { $$ = new_node(p, EXPR_VAR, 0, 0); $$->slot = $1;  }
+| VAR '=' expr       { $$ = new_node(p, EXPR_ASSIGN, $3, 0); $$->sym = $1;
+                       /* the global symbols are shared by all threads */
+                       if (is_global_symbol($1)) yyerror(p, "assignment to a constant"); }
+| SLOT '=' expr      { $$ = new_node(p, EXPR_ASSIGN, $3, 0);             }
+| FNCT '(' ')'       { $$ = new_fnct(p, $1, 0, 0, 0, 0, 0);              }
+| FNCT '(' expr ')'  { $$ = new_fnct(p, $1, 1, $3, 0, 0, 0);             }
+| FNCT '(' expr ',' expr ')'  { $$ = new_fnct(p, $1, 2, $3, $5, 0, 0);   }
+| FNCT '(' expr ',' expr ','expr ')'  { $$ = new_fnct(p, $1, 3, $3, $5, $7, 0); }
+| FNCT '(' expr ',' expr ',' expr ','expr ')'  { $$ = new_fnct(p, $1, 4, $3, $5, $7, $9); }
+| expr '+' expr      { $$ = new_node(p, EXPR_ADD, $1, $3);               }
+| expr '-' expr      { $$ = new_node(p, EXPR_SUB, $1, $3);               }
+| expr '*' expr      { $$ = new_node(p, EXPR_MUL, $1, $3);               }
+| expr '/' expr      { $$ = new_node(p, EXPR_DIV, $1, $3);               }
+| '-' expr  %prec NEG{ $$ = new_node(p, EXPR_NEG, $2, 0);                }
+| '!' expr           { $$ = new_node(p, EXPR_NOT, $2, 0);                }
+| expr '<' expr      { $$ = new_node(p, EXPR_LT, $1, $3);                }
+| expr LE expr       { $$ = new_node(p, EXPR_LE, $1, $3);                }
+| expr '>' expr      { $$ = new_node(p, EXPR_GT, $1, $3);                }
+| expr GE expr       { $$ = new_node(p, EXPR_GE, $1, $3);                }
+| expr EQ expr       { $$ = new_node(p, EXPR_EQ, $1, $3);                }
+| expr NE expr       { $$ = new_node(p, EXPR_NE, $1, $3);                }
+| expr AND expr      { $$ = new_node(p, EXPR_AND, $1, $3);               }
+| expr OR expr       { $$ = new_node(p, EXPR_OR, $1, $3);                }
+| expr '^' expr      { $$ = new_node(p, EXPR_POW, $1, $3);               }
+| expr '*' '*' expr  { $$ = new_node(p, EXPR_POW, $1, $4);               }
+| '(' expr ')'       { $$ = $2;                                          }
 ;
 
 %%
 
-/* global symbol table */
+/* global symbol table of the functions and constants, read-only after init_table() */
 symrec *sym_table = 0;
 
+/* context of the functions without an explicit context, not thread-safe */
+static parser_context default_context = {0, 0, 0};
+
 int parse_errors() {
-	return yynerrs;
+	return default_context.errors;
 }
 
 int yyerror(param *p, const char *s) {
+	p->context->errors++;
 	/* remove trailing newline */
 	p->string[strcspn(p->string, "\n")] = 0;
 	printf("PARSER ERROR: %s @ position %d of string \'%s\'\n", s, p->pos, p->string);
 	return 0;
 }
 
-/* save symbol in symbol table */
-symrec* putsym(const char *sym_name, int sym_type) {
+/* save symbol in symbol table \c table */
+static symrec* putsym(symrec **table, const char *sym_name, int sym_type) {
 	pdebug("PARSER: putsym(): sym_name = %s\n", sym_name);
 
 	symrec *ptr = (symrec *) malloc(sizeof (symrec));
@@ -127,19 +189,19 @@ symrec* putsym(const char *sym_name, int sym_type) {
 	strcpy(ptr->name, sym_name);
 	ptr->type = sym_type;
 	ptr->value.var = 0;	/* set value to 0 even if fctn */
-	ptr->next = (struct symrec *)sym_table;
-	sym_table = ptr;
+	ptr->next = *table;
+	*table = ptr;
 	
 	pdebug("PARSER: putsym() DONE\n");
 	return ptr;
 }
 
-/* get symbol from symbol table */
-symrec* getsym(const char *sym_name) {
+/* get symbol from symbol table \c table */
+static symrec* getsym(symrec *table, const char *sym_name) {
 	pdebug("PARSER: getsym(): sym_name = %s\n", sym_name);
 	
 	symrec *ptr;
-	for (ptr = sym_table; ptr != 0; ptr = (symrec *)ptr->next) {
+	for (ptr = table; ptr != 0; ptr = (symrec *)ptr->next) {
 		/* pdebug("%s ", ptr->name); */
 		if (strcmp(ptr->name, sym_name) == 0) {
 			pdebug("PARSER: symbol \'%s\' found\n", sym_name);
@@ -151,19 +213,43 @@ symrec* getsym(const char *sym_name) {
 	return 0;
 }
 
+/* returns 1 if \c s is a function or constant of the global table */
+static int is_global_symbol(const symrec *s) {
+	const symrec *ptr;
+	for (ptr = sym_table; ptr != 0; ptr = (symrec *)ptr->next) {
+		if (ptr == s)
+			return 1;
+	}
+
+	return 0;
+}
+
+static void free_symbols(symrec **table) {
+	while(*table) {
+		symrec *tmp = *table;
+		*table = (*table)->next;
+		free(tmp->name);
+		free(tmp);
+	}
+}
+
+/* initializes the global table of functions and constants, calls after the first one do nothing.
+   Has to be called once before parsing, before contexts are used in several threads (done by ExpressionParser). */
 void init_table(void) {
 	pdebug("PARSER: init_table()\n");
+	if (sym_table)
+		return;
 
 	symrec *ptr = 0;
 	int i;
 	/* add functions */
 	for (i = 0; _functions[i].name != 0; i++) {
-		ptr = putsym (_functions[i].name, FNCT);
+		ptr = putsym(&sym_table, _functions[i].name, FNCT);
 		ptr->value.fnctptr = _functions[i].fnct;
 	}
 	/* add constants */
 	for (i = 0; _constants[i].name != 0; i++) {
-		ptr = putsym (_constants[i].name, VAR);
+		ptr = putsym(&sym_table, _constants[i].name, VAR);
 		ptr->value.var = _constants[i].value;
 	}
 
@@ -171,30 +257,40 @@ void init_table(void) {
 }
 
 void delete_table(void) {
-	while(sym_table) {
-		symrec *tmp = sym_table;
-		sym_table = sym_table->next;
-		free(tmp->name);
-		free(tmp);
-	}
+	free_symbols(&sym_table);
+	free_symbols(&default_context.sym_table);
 }
 
-symrec* assign_variable(const char* symb_name, double value) {
-	/* new style: pdebug("PARSER: assign_variable(): symb_name = %s value = %g sym_table = %p\n", var.name, var.value, sym_table);*/
-	pdebug("PARSER: assign_variable() : symb_name = %s value=%g\n", symb_name, value);
+parser_context* parser_context_new(void) {
+	return (parser_context *) calloc(1, sizeof(parser_context));
+}
 
-	/* be sure that the symbol table has been initialized */
-	if (!sym_table)
-		init_table();
+void parser_context_free(parser_context *context) {
+	if (!context)
+		return;
+	free_symbols(&context->sym_table);
+	free(context);
+}
+
+int parser_context_errors(const parser_context *context) {
+	return context->errors;
+}
 
-	symrec* ptr = getsym(symb_name);
+symrec* parser_context_assign(parser_context *context, const char* symb_name, double value) {
+	pdebug("PARSER: parser_context_assign() : symb_name = %s value=%g\n", symb_name, value);
+
+	symrec* ptr = getsym(context->sym_table, symb_name);
 	if (!ptr) {
 		pdebug("PARSER: calling putsym(): symb_name = %s\n", symb_name);
-		ptr = putsym(symb_name, VAR);
+		ptr = putsym(&context->sym_table, symb_name, VAR);
 	}
 	ptr->value.var = value;
 
 	return ptr;
+}
+
+symrec* assign_variable(const char* symb_name, double value) {
+	return parser_context_assign(&default_context, symb_name, value);
 };
 
 static int getcharstr(param *p) {
@@ -211,15 +307,20 @@ static void ungetcstr(unsigned int *pos) {
         (*pos)--;
 }
 
-double parse(const char *str) {
-	pdebug("\nPARSER: parse(\"%s\") len=%zu\n", str, strlen(str));
-
-	/* be sure that the symbol table has been initialized */
-	if (!sym_table)
-		init_table();
+/* compiles the expression \c str once in the context \c context, the variables \c vars are bound to the slots 0..nvars-1.
+   The other variables refer to the variables of the context. Returns 0 if the expression contains errors. */
+parser_expr* parser_context_compile(parser_context *context, const char *str, const char *vars[], int nvars) {
+	pdebug("\nPARSER: parse_compile(\"%s\") len=%zu\n", str, strlen(str));
 
 	param p;
 	p.pos = 0;
+	p.context = context;
+	p.vars = vars;
+	p.nvars = nvars;
+	p.symbuf = 0;
+	p.length = 0;
+	p.nodes = 0;
+	p.root = 0;
 	/* leave space to terminate string by "\n\0" */
 	size_t slen = strlen(str) + 2;
 	p.string = (char *) malloc(slen * sizeof(char));
@@ -229,13 +330,39 @@ double parse(const char *str) {
 	pdebug("\nPARSER: yyparse(\"%s\") len=%zu\n", p.string, strlen(p.string));
 
 	/* parameter for yylex */
+	context->errors = 0;
 	yyparse(&p);
 
-	pdebug("PARSER: parse() DONE (res = %g, parse errors = %d)\n", res, parse_errors());
+	parser_expr *expr = 0;
+	if (context->errors == 0)
+		expr = expr_compile_tree(p.root, nvars, 1);
+
+	pdebug("PARSER: parse_compile() DONE (parse errors = %d)\n", context->errors);
+	expr_node_free_all(p.nodes);
+	free(p.symbuf);
 	free(p.string);
 	p.string = 0;
 
-	return res;
+	return expr;
+}
+
+double parser_context_parse(parser_context *context, const char *str) {
+	parser_expr *expr = parser_context_compile(context, str, 0, 0);
+	if (!expr)
+		return NAN;
+
+	context->result = parse_eval(expr, 0);
+	parse_free(expr);
+
+	return context->result;
+}
+
+parser_expr* parse_compile(const char *str, const char *vars[], int nvars) {
+	return parser_context_compile(&default_context, str, vars, nvars);
+}
+
+double parse(const char *str) {
+	return parser_context_parse(&default_context, str);
 }
 
 double parse_with_vars(const char *str, const parser_var *vars, int nvars) {
@@ -249,7 +376,7 @@ double parse_with_vars(const char *str, const parser_var *vars, int nvars) {
 	return parse(str);
 }
 
-int yylex(param *p) {
+int yylex(YYSTYPE *lvalp, param *p) {
 	pdebug("PARSER: yylex()\n");
 	int c;
 
@@ -264,7 +391,7 @@ int yylex(param *p) {
 	/* check for non-ASCII chars */
 	if (!isascii(c)) {
 		pdebug("non-ASCII character found. Giving up\n");
-		yynerrs++;
+		p->context->errors++;
 		return 0;
 	}
 
@@ -296,7 +423,7 @@ int yylex(param *p) {
 
 		pdebug("PARSER: result = %g\n", result);
 
-		yylval.dval = result;
+		lvalp->dval = result;
 
                 p->pos += strlen(s) - strlen(remain);
 
@@ -305,22 +432,20 @@ int yylex(param *p) {
 
 	if (isalpha (c) || c == '.') {
 		pdebug("PARSER: reading identifier (starts with alpha: %c)\n", c);
-		static char *symbuf = 0;
-		static int length = 0;
-		int i = 0;
+		int i = 0, slot;
 
 		/* Initially make the buffer long enough for a 10-character symbol name */
-		if (length == 0)
-			length = 10, symbuf = (char *) malloc(length + 1);
+		if (p->length == 0)
+			p->length = 10, p->symbuf = (char *) malloc(p->length + 1);
 
 		do {
 			pdebug("reading symbol .. ");
 			/* If buffer is full, make it bigger */
-			if (i == length) {
-				length *= 2;
-				symbuf = (char *) realloc(symbuf, length + 1);
+			if (i == p->length) {
+				p->length *= 2;
+				p->symbuf = (char *) realloc(p->symbuf, p->length + 1);
 			}
-			symbuf[i++] = c;
+			p->symbuf[i++] = c;
 			c = getcharstr(p);
 			pdebug("got %c\n", c);
 		}
@@ -329,22 +454,52 @@ int yylex(param *p) {
 
 		if (c != EOF)
 			ungetcstr(&(p->pos));
-		symbuf[i] = '\0';
+		p->symbuf[i] = '\0';
+
+		/* variables bound to slots hide the symbols with the same name */
+		for (slot = 0; slot < p->nvars; slot++) {
+			if (strcmp(p->vars[slot], p->symbuf) == 0) {
+				lvalp->ival = slot;
+				return SLOT;
+			}
+		}
 
-		symrec *s = getsym(symbuf);
+		/* variables of the context hide the global symbols */
+		symrec *s = getsym(p->context->sym_table, p->symbuf);
+		if (s == 0)
+			s = getsym(sym_table, p->symbuf);
 		if(s == 0) {	/* symbol unknown */
-			pdebug("PARSER: ERROR: symbol \"%s\" UNKNOWN\n", symbuf);
-			yynerrs++;
+			pdebug("PARSER: ERROR: symbol \"%s\" UNKNOWN\n", p->symbuf);
+			p->context->errors++;
 			return 0;
 		}
 		/* old behavior */
 		/* if (s == 0)
 			 s = putsym (symbuf, VAR);
 		*/
-		yylval.tptr = s;
+		lvalp->tptr = s;
 		return s->type;
 	}
 
+	/* operators with two characters: <= >= == != && || */
+	const int next = getcharstr(p);
+	if (next == '=') {
+		if (c == '<')
+			return LE;
+		if (c == '>')
+			return GE;
+		if (c == '=')
+			return EQ;
+		if (c == '!')
+			return NE;
+	}
+	if (c == '&' && next == '&')
+		return AND;
+	if (c == '|' && next == '|')
+		return OR;
+	if (next != EOF)
+		ungetcstr(&(p->pos));
+
 	/* else: single operator */
 	pdebug("PARSER: single operator\n");
 	return c;
@@ -0,0 +1,90 @@
+/***************************************************************************
+    File                 : ResultKey.cpp
+    Project              : LabPlot
+    Description          : Hash of the inputs of a calculation
+    --------------------------------------------------------------------
+    Copyright            : (C) 2017 by the LabPlot developers
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "backend/lib/ResultKey.h"
+#include "backend/core/column/Column.h"
+#include "backend/lib/Interval.h"
+
+/*!
+	\class ResultKey
+	\brief Hash of the inputs of a calculation, e.g. the expression, the values of the parameters and the data of the input columns.
+
+	Curves calculating their data keep the results for the keys of their inputs and reuse them if
+	the inputs are the same again, e.g. after an undo or when the project is opened. The key is saved
+	in the project together with the result.
+
+	\ingroup backend
+*/
+
+ResultKey::ResultKey() : m_hash(QCryptographicHash::Sha1) {
+}
+
+void ResultKey::addData(const QString& str) {
+	const QByteArray bytes = str.toUtf8();
+	addData(bytes.size());
+	m_hash.addData(bytes);
+}
+
+void ResultKey::addData(double value) {
+	m_hash.addData(reinterpret_cast<const char*>(&value), sizeof(double));
+}
+
+void ResultKey::addData(const QVector<double>& values) {
+	addData(values.size());
+	m_hash.addData(reinterpret_cast<const char*>(values.constData()), values.size()*sizeof(double));
+}
+
+/*!
+	adds the values and the masked rows of the column \c column, a null pointer is a missing column.
+	The values of numeric columns are hashed as they are stored, other columns value by value.
+*/
+void ResultKey::addData(const AbstractColumn* column) {
+	if (!column) {
+		m_hash.addData("", 1);
+		return;
+	}
+
+	const Column* col = dynamic_cast<const Column*>(column);
+	if (col && col->columnMode() == AbstractColumn::Numeric) {
+		addData(*static_cast<QVector<double>* >(col->data()));
+	} else {
+		addData(column->rowCount());
+		for (int row = 0; row < column->rowCount(); ++row)
+			addData(column->valueAt(row));
+	}
+
+	foreach (const Interval<int>& interval, column->maskedIntervals()) {
+		addData(interval.start());
+		addData(interval.end());
+	}
+}
+
+//! returns the key as hexadecimal string, the key can't be extended afterwards
+QByteArray ResultKey::result() {
+	return m_hash.result().toHex();
+}
@@ -0,0 +1,50 @@
+/***************************************************************************
+    File                 : ResultKey.h
+    Project              : LabPlot
+    Description          : Hash of the inputs of a calculation
+    --------------------------------------------------------------------
+    Copyright            : (C) 2017 by the LabPlot developers
+
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 2 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor,                    *
+ *   Boston, MA  02110-1301  USA                                           *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef RESULTKEY_H
+#define RESULTKEY_H
+
+#include <QCryptographicHash>
+#include <QVector>
+
+class AbstractColumn;
+
+class ResultKey {
+	public:
+		ResultKey();
+
+		void addData(const QString&);
+		void addData(double);
+		void addData(const QVector<double>&);
+		void addData(const AbstractColumn*);
+		QByteArray result();
+
+	private:
+		QCryptographicHash m_hash;
+};
+
+#endif
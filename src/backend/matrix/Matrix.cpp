@@ -36,12 +36,23 @@
 #include "backend/lib/XmlStreamReader.h"
 #include "commonfrontend/matrix/MatrixView.h"
 #include "kdefrontend/spreadsheet/ExportSpreadsheetDialog.h"
+#include "backend/datasources/filters/BinaryFilter.h"
+#include "backend/datasources/filters/HDFFilter.h"
+#include "backend/datasources/filters/NetCDFFilter.h"
+#include "backend/gsl/ExpressionParser.h"
 
+extern "C" {
+#include "backend/gsl/parser.h"
+}
+
+#include <QCoreApplication>
 #include <QHeaderView>
 #include <QLocale>
 #include <QPrinter>
 #include <QPrintDialog>
 #include <QPrintPreviewDialog>
+#include <QRunnable>
+#include <QThreadPool>
 
 #include <KIcon>
 #include <KLocale>
@@ -155,6 +166,17 @@ bool Matrix::exportView() const {
 		} else if (dlg->format() == ExportSpreadsheetDialog::FITS) {
 			const int exportTo = dlg->exportToFits();
 			view->exportToFits(path, exportTo );
+		} else if (dlg->format() == ExportSpreadsheetDialog::Binary) {
+			BinaryFilter filter;
+			filter.setDataType(BinaryFilter::REAL64);
+			filter.write(path, const_cast<Matrix*>(this));
+		} else if (dlg->format() == ExportSpreadsheetDialog::HDF) {
+			HDFFilter filter;
+			filter.setCompressionLevel(dlg->compressionLevel());
+			filter.write(path, const_cast<Matrix*>(this));
+		} else if (dlg->format() == ExportSpreadsheetDialog::NETCDF) {
+			NetCDFFilter filter;
+			filter.write(path, const_cast<Matrix*>(this));
 		} else {
 			const QString separator = dlg->separator();
 			view->exportToFile(path, separator);
@@ -412,6 +434,126 @@ void Matrix::copy(Matrix* other) {
 	RESET_CURSOR;
 }
 
+/* task filling the columns startCol to endCol-1 with the values of the compiled function */
+class FillTask : public QRunnable {
+public:
+	FillTask(int startCol, int endCol, QVector<double>* columns, double xStart, double xStep,
+		const parser_expr* expr, const QVector<const double*>& vars, const QAtomicInt* canceled, QAtomicInt* filledColumns)
+		: m_startCol(startCol), m_endCol(endCol), m_columns(columns), m_xStart(xStart), m_xStep(xStep),
+		m_expr(expr), m_vars(vars), m_canceled(canceled), m_filledColumns(filledColumns) {
+	};
+
+	void run() {
+		// x is the same for all rows of a column, y and the invariants of the rows are contiguous
+		QVector<int> strides(m_vars.size(), 1);
+		strides[0] = 0;
+		QVector<const double*> vars = m_vars;
+		for (int col = m_startCol; col < m_endCol; ++col) {
+			if (*m_canceled)
+				return;
+			const double x = m_xStart + m_xStep*col;
+			vars[0] = &x;
+			QVector<double>& column = m_columns[col];
+			parse_eval_vector(m_expr, vars.constData(), strides.constData(), column.size(), column.data());
+			m_filledColumns->ref();
+		}
+	}
+
+private:
+	int m_startCol;
+	int m_endCol;
+	QVector<double>* m_columns;
+	double m_xStart;
+	double m_xStep;
+	const parser_expr* m_expr;
+	QVector<const double*> m_vars;
+	const QAtomicInt* m_canceled;
+	QAtomicInt* m_filledColumns;
+};
+
+/*!
+	fills the matrix with the values of the function \c formula of x (columns) and y (rows).
+
+	The function is compiled once. The parts of the function depending only on y are evaluated once
+	for all rows and shared by the columns, the parts depending only on x are evaluated once per column.
+	Tiles of columns are filled in parallel, the new values replace the old ones in one undo step.
+	If fillProgress() is connected, the progress is reported while the events are processed.
+	Returns \c false if the function is not valid or if the fill was canceled with cancelFill().
+ */
+bool Matrix::fillWithFunction(const QString& formula) {
+	parser_expr* expr = ExpressionParser::compile(formula, QStringList() << "x" << "y");
+	if (!expr)
+		return false;
+
+	const int rows = rowCount();
+	const int cols = columnCount();
+	const double xStep = (cols > 1) ? (xEnd() - xStart())/double(cols - 1) : 0.0;
+	const double yStep = (rows > 1) ? (yEnd() - yStart())/double(rows - 1) : 0.0;
+
+	// invariants of the rows: the parts not depending on x, bound to the slots following x and y
+	const int maxParts = 16;
+	parser_expr* parts[maxParts];
+	int nparts = 0;
+	parser_expr* function = parse_factor(expr, 0, parts, maxParts, &nparts);
+	parse_free(expr);
+
+	QVector<double> yValues(rows);
+	for (int row = 0; row < rows; ++row)
+		yValues[row] = yStart() + yStep*row;
+
+	const double x = xStart();
+	const double* partVars[2] = {&x, yValues.constData()};
+	const int partStrides[2] = {0, 1};
+	QVector<QVector<double> > invariants(nparts);
+	QVector<const double*> vars;
+	vars << 0 << yValues.constData();
+	for (int i = 0; i < nparts; ++i) {
+		invariants[i].resize(rows);
+		parse_eval_vector(parts[i], partVars, partStrides, rows, invariants[i].data());
+		parse_free(parts[i]);
+		vars << invariants.at(i).constData();
+	}
+
+	if ((qint64)rows*cols >= PARSER_JIT_MIN_POINTS) {
+		QVector<int> strides(vars.size(), 1);
+		strides[0] = 0;
+		parse_jit(function, strides.constData());
+	}
+
+	// the new values are written to new columns, the old ones are kept for undo
+	QVector<QVector<double> > newData(cols);
+	for (int col = 0; col < cols; ++col)
+		newData[col].resize(rows);
+
+	d->fillCanceled = 0;
+	QAtomicInt filledColumns(0);
+	QThreadPool pool;	// own pool, waitForDone() only waits for the fill tasks
+	const int tileSize = qMax(1, cols/(4*pool.maxThreadCount()));
+	for (int start = 0; start < cols; start += tileSize)
+		pool.start(new FillTask(start, qMin(start + tileSize, cols), newData.data(), xStart(), xStep,
+			function, vars, &d->fillCanceled, &filledColumns));
+
+	// long fills with a connected progress dialog report the progress and can be canceled,
+	// the events are only processed in this case
+	if (receivers(SIGNAL(fillProgress(int))) > 0) {
+		while (!pool.waitForDone(100)) {
+			emit fillProgress(100*filledColumns/cols);
+			QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
+		}
+	} else
+		pool.waitForDone();
+	parse_free(function);
+
+	if (d->fillCanceled)
+		return false;
+
+	beginMacro(i18n("%1: fill matrix with function values", name()));
+	setFormula(formula);
+	exec(new MatrixReplaceValuesCmd(d, newData));
+	endMacro();
+
+	return true;
+}
 
 //! Duplicate the matrix inside its folder
 void Matrix::duplicate() {
@@ -514,6 +656,11 @@ void Matrix::clear() {
 	RESET_CURSOR;
 }
 
+//! Cancels a running fillWithFunction()
+void Matrix::cancelFill() {
+	d->fillCanceled = 1;
+}
+
 void Matrix::transpose() {
 	WAIT_CURSOR;
 	exec(new MatrixTransposeCmd(d));
@@ -537,7 +684,7 @@ void Matrix::mirrorVertically() {
 //######################  Private implementation ###############################
 //##############################################################################
 
-MatrixPrivate::MatrixPrivate(Matrix* owner) : q(owner), columnCount(0), rowCount(0), suppressDataChange(false) {
+MatrixPrivate::MatrixPrivate(Matrix* owner) : q(owner), columnCount(0), rowCount(0), suppressDataChange(false), fillCanceled(0) {
 	QFont font;
 	font.setFamily(font.defaultFamily());
 	QFontMetrics fm(font);
@@ -101,6 +101,7 @@ class Matrix : public AbstractDataSource {
 		void setRowCells(int row, int first_column, int last_column, const QVector<double>& values);
 
 		void copy(Matrix* other);
+		bool fillWithFunction(const QString& formula);
 
 		virtual void save(QXmlStreamWriter*) const;
 		virtual bool load(XmlStreamReader*);
@@ -116,6 +117,7 @@ class Matrix : public AbstractDataSource {
 		void addColumns();
 		void addRows();
 		void duplicate();
+		void cancelFill();
 
 	signals:
 		void requestProjectContextMenu(QMenu*);
@@ -129,6 +131,7 @@ class Matrix : public AbstractDataSource {
 		void rowsRemoved(int first, int count);
 		void dataChanged(int top, int left, int bottom, int right);
 		void coordinatesChanged();
+		void fillProgress(int);
 
 		friend class MatrixInsertRowsCmd;
 		friend class MatrixRemoveRowsCmd;
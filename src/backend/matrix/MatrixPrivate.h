@@ -30,6 +30,7 @@
 #ifndef MATRIXPRIVATE_H
 #define MATRIXPRIVATE_H
 
+#include <QAtomicInt>
 #include <QVector>
 
 class MatrixPrivate {
@@ -75,6 +76,7 @@ class MatrixPrivate {
 		double yStart;
 		double yEnd;
 		bool suppressDataChange;
+		QAtomicInt fillCanceled;
 };
 
 #endif
@@ -359,14 +359,17 @@ MatrixReplaceValuesCmd::MatrixReplaceValuesCmd(MatrixPrivate* private_obj, const
 	setText(i18n("%1: replace values", m_private_obj->name()));
 }
 
+//only the values not shown in the matrix are kept in the command, the matrix data is not shared and not copied on the next change
 void MatrixReplaceValuesCmd::redo() {
 	m_old_values = m_private_obj->matrixData;
 	m_private_obj->matrixData = m_new_values;
+	m_new_values.clear();
 	m_private_obj->emitDataChanged(0, 0, m_private_obj->rowCount -1, m_private_obj->columnCount-1);
 }
 
 void MatrixReplaceValuesCmd::undo() {
 	m_new_values = m_private_obj->matrixData;
 	m_private_obj->matrixData = m_old_values;
+	m_old_values.clear();
 	m_private_obj->emitDataChanged(0, 0, m_private_obj->rowCount -1, m_private_obj->columnCount-1);
 }
@@ -32,6 +32,9 @@
 #include "backend/core/AbstractAspect.h"
 #include "commonfrontend/spreadsheet/SpreadsheetView.h"
 #include "kdefrontend/spreadsheet/ExportSpreadsheetDialog.h"
+#include "backend/datasources/filters/BinaryFilter.h"
+#include "backend/datasources/filters/HDFFilter.h"
+#include "backend/datasources/filters/NetCDFFilter.h"
 
 #include <QPrinter>
 #include <QPrintDialog>
@@ -63,7 +66,7 @@
 */
 
 Spreadsheet::Spreadsheet(AbstractScriptingEngine* engine, const QString& name, bool loading)
-  : AbstractDataSource(engine, name){
+  : AbstractDataSource(engine, name), m_readOnly(false) {
 
 	if (!loading)
 		init();
@@ -97,21 +100,39 @@ QWidget *Spreadsheet::view() const {
 		KConfig config;
 		KConfigGroup group = config.group( "Spreadsheet" );
 		reinterpret_cast<SpreadsheetView*>(m_view)->showComments(group.readEntry("ShowComments", false));
+		m_view->setEnabled(!m_readOnly);
 	}
 
 	return m_view;
 }
 
+/*!
+  makes the spreadsheet read-only, the data can't be modified in the view.
+  Used while the spreadsheet is filled in the background without undo commands, see ImportJob.
+*/
+void Spreadsheet::setReadOnly(bool readOnly) {
+	m_readOnly = readOnly;
+	if (m_view)
+		m_view->setEnabled(!readOnly);
+}
+
+bool Spreadsheet::isReadOnly() const {
+	return m_readOnly;
+}
+
 bool Spreadsheet::exportView() const {
 	ExportSpreadsheetDialog* dlg = new ExportSpreadsheetDialog(view());
 	dlg->setFileName(name());
 
 	dlg->setExportTo(QStringList() << i18n("FITS image") << i18n("FITS table"));
+	QStringList nonNumericColumns;
 	for (int i = 0; i < columnCount();++i) {
-		if (column(i)->columnMode() != AbstractColumn::Numeric) {
-			dlg->setExportToImage(false);
-			break;
-        	}
+		if (column(i)->columnMode() != AbstractColumn::Numeric)
+			nonNumericColumns << column(i)->name();
+	}
+	if (!nonNumericColumns.isEmpty()) {
+		dlg->setExportToImage(false);
+		dlg->setNonNumericColumns(nonNumericColumns);
 	}
 	if (const_cast<SpreadsheetView*>(reinterpret_cast<const SpreadsheetView*>(m_view))->selectedColumnCount() == 0) {
 		dlg->setExportSelection(false);
@@ -134,6 +155,17 @@ bool Spreadsheet::exportView() const {
 			const int exportTo = dlg->exportToFits();
 			const bool commentsAsUnits = dlg->commentsAsUnitsFits();
 			view->exportToFits(path, exportTo, commentsAsUnits);
+		} else if (dlg->format() == ExportSpreadsheetDialog::Binary) {
+			BinaryFilter filter;
+			filter.setDataType(BinaryFilter::REAL64);
+			filter.write(path, const_cast<Spreadsheet*>(this));
+		} else if (dlg->format() == ExportSpreadsheetDialog::HDF) {
+			HDFFilter filter;
+			filter.setCompressionLevel(dlg->compressionLevel());
+			filter.write(path, const_cast<Spreadsheet*>(this));
+		} else if (dlg->format() == ExportSpreadsheetDialog::NETCDF) {
+			NetCDFFilter filter;
+			filter.write(path, const_cast<Spreadsheet*>(this));
 		} else {
 			const QString separator = dlg->separator();
 			view->exportToFile(path, exportHeader, separator);
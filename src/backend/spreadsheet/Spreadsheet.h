@@ -69,6 +69,9 @@ class Spreadsheet : public AbstractDataSource {
 
 		void setColumnSelectedInView(int index, bool selected);
 
+		void setReadOnly(bool);
+		bool isReadOnly() const;
+
 		// used from model to inform dock
 		void emitRowCountChanged() { emit rowCountChanged(rowCount()); }
 		void emitColumnCountChanged() { emit columnCountChanged(columnCount()); }
@@ -91,6 +94,7 @@ class Spreadsheet : public AbstractDataSource {
 
 	private:
 		void init();
+		bool m_readOnly;
 
 	private slots:
 		virtual void childSelected(const AbstractAspect*);
@@ -80,7 +80,9 @@ SpreadsheetModel::SpreadsheetModel(Spreadsheet* spreadsheet)
 }
 
 Qt::ItemFlags SpreadsheetModel::flags(const QModelIndex& index) const {
-	if (index.isValid())
+	if (index.isValid() && m_spreadsheet->isReadOnly())
+		return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+	else if (index.isValid())
 		return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsEditable;
 	else
 		return Qt::ItemIsEnabled;
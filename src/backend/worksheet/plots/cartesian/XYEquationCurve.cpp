@@ -38,11 +38,26 @@
 #include "backend/core/AbstractColumn.h"
 #include "backend/core/column/Column.h"
 #include "backend/lib/commandtemplates.h"
+#include "backend/lib/ResultKey.h"
+#include "backend/worksheet/plots/cartesian/CartesianPlot.h"
+#include "backend/worksheet/Worksheet.h"
 #include "backend/gsl/ExpressionParser.h"
 
+#include <QApplication>
+#include <QDesktopWidget>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 #include <KIcon>
 #include <KLocale>
 
+#include <cmath>
+#include <limits>
+
+extern "C" {
+#include <gsl/gsl_errno.h>
+#include "backend/gsl/parser.h"
+}
+
 XYEquationCurve::XYEquationCurve(const QString& name)
 		: XYCurve(name, new XYEquationCurvePrivate(this)) {
 	init();
@@ -76,6 +91,8 @@ void XYEquationCurve::init() {
 	setXColumn(d->xColumn);
 	setYColumn(d->yColumn);
 	setUndoAware(true);
+
+	connect(&d->samplingWatcher, SIGNAL(finished()), this, SLOT(samplingFinished()));
 }
 
 void XYEquationCurve::recalculate() {
@@ -83,6 +100,21 @@ void XYEquationCurve::recalculate() {
 	d->recalculate();
 }
 
+/*!
+	retransforms the curve and samples the equation again if the visible range
+	or the size of the plot has changed.
+*/
+void XYEquationCurve::retransform() {
+	Q_D(XYEquationCurve);
+	XYCurve::retransform();
+	d->updateSampling();
+}
+
+void XYEquationCurve::samplingFinished() {
+	Q_D(XYEquationCurve);
+	d->samplingFinished();
+}
+
 /*!
 	Returns an icon to be used in the project explorer.
 */
@@ -105,7 +137,8 @@ void XYEquationCurve::setEquationData(const XYEquationCurve::EquationData& equat
 		|| (equationData.expression2 != d->equationData.expression2)
 		|| (equationData.min != d->equationData.min)
 		|| (equationData.max != d->equationData.max)
-		|| (equationData.count != d->equationData.count) )
+		|| (equationData.count != d->equationData.count)
+		|| (equationData.adaptive != d->equationData.adaptive) )
 		exec(new XYEquationCurveSetEquationDataCmd(d, equationData, i18n("%1: set equation")));
 }
 
@@ -117,6 +150,11 @@ XYEquationCurvePrivate::XYEquationCurvePrivate(XYEquationCurve* owner) : XYCurve
 	yColumn(new Column("y", AbstractColumn::Numeric)),
 	xVector(static_cast<QVector<double>* >(xColumn->data())),
 	yVector(static_cast<QVector<double>* >(yColumn->data())),
+	samplingRunning(false),
+	samplingPending(false),
+	generation(0),
+	samplingGeneration(0),
+	results(1 << 21),
 	q(owner)  {
 
 }
@@ -127,6 +165,33 @@ XYEquationCurvePrivate::~XYEquationCurvePrivate() {
 }
 
 void XYEquationCurvePrivate::recalculate() {
+	//the cached samples belong to the previous equation, running samplings are discarded
+	cache.clear();
+	++generation;
+
+	//the equation was calculated before, e.g. before an undo or when the project was saved
+	key = resultKey();
+	const Result* result = results.object(key);
+	if (result) {
+		*xVector = result->x;
+		*yVector = result->y;
+		emit (q->dataChanged());
+
+		//sample again if the view of the plot has changed in the meantime
+		if (equationData.adaptive) {
+			view = result->view;
+			updateSampling();
+		}
+		return;
+	}
+
+	//adaptively sampled curves are evaluated in the worker thread for the current view of the plot
+	if (equationData.adaptive && !currentView().isEmpty()) {
+		view = View();
+		startSampling();
+		return;
+	}
+
 	//resize the vector if a new number of point to calculate was provided
 	if (equationData.count != xVector->size()) {
 		if (equationData.count >= 1) {
@@ -161,10 +226,365 @@ void XYEquationCurvePrivate::recalculate() {
 	if (!rc) {
 		xVector->clear();
 		yVector->clear();
+	} else {
+		cacheResult();
 	}
 	emit (q->dataChanged());
 }
 
+/*!
+	returns the key of the current equation, the hash of the expressions, the range and the number of points.
+*/
+QByteArray XYEquationCurvePrivate::resultKey() const {
+	ResultKey resultKey;
+	resultKey.addData(equationData.type);
+	resultKey.addData(equationData.expression1);
+	resultKey.addData(equationData.expression2);
+	resultKey.addData(equationData.min);
+	resultKey.addData(equationData.max);
+	resultKey.addData(equationData.count);
+	resultKey.addData(equationData.adaptive);
+	return resultKey.result();
+}
+
+/*!
+	keeps the calculated points for the current equation
+*/
+void XYEquationCurvePrivate::cacheResult() {
+	Result* result = new Result;
+	result->x = *xVector;
+	result->y = *yVector;
+	result->view = view;
+	results.insert(key, result, qMax(1, xVector->size()));
+}
+
+/*!
+	returns the visible range of the parent plot and the size of its data area in pixels.
+	The view is empty if the curve is not part of a cartesian plot.
+*/
+XYEquationCurvePrivate::View XYEquationCurvePrivate::currentView() const {
+	View current;
+	CartesianPlot* plot = dynamic_cast<CartesianPlot*>(q->parentAspect());
+	if (!plot)
+		return current;
+
+	const QRectF rect = plot->plotRect();
+	const double inch = Worksheet::convertToSceneUnits(1, Worksheet::Inch);
+	current.xMin = plot->xMin();
+	current.xMax = plot->xMax();
+	current.yMin = plot->yMin();
+	current.yMax = plot->yMax();
+	current.width = qMax(0, qRound(rect.width()*QApplication::desktop()->physicalDpiX()/inch));
+	current.height = qMax(0, qRound(rect.height()*QApplication::desktop()->physicalDpiY()/inch));
+	//with auto-scaling the x-range follows the curve, the whole range of the equation is sampled then
+	current.clip = !plot->autoScaleX();
+	return current;
+}
+
+/*!
+	starts a new sampling if the view of the plot has changed by more than a pixel in x or by more than
+	a tenth of the y-range. Smaller changes, e.g. caused by the auto-scaling to the new samples, are ignored.
+*/
+void XYEquationCurvePrivate::updateSampling() {
+	if (!equationData.adaptive || m_suppressRetransform)
+		return;
+
+	const View current = currentView();
+	if (current.isEmpty())
+		return;
+
+	const double pixel = fabs(current.xMax - current.xMin)/current.width;
+	const double yRange = fabs(view.yMax - view.yMin);
+	if (current.width == view.width && current.height == view.height && current.clip == view.clip
+		&& fabs(current.xMin - view.xMin) <= pixel && fabs(current.xMax - view.xMax) <= pixel
+		&& fabs(current.yMin - view.yMin) <= 0.1*yRange && fabs(current.yMax - view.yMax) <= 0.1*yRange)
+		return;
+
+	startSampling();
+}
+
+/*!
+	compiles the equation and samples it in a worker thread for the current view.
+	Requests during a running sampling are collected and handled once it has finished.
+*/
+void XYEquationCurvePrivate::startSampling() {
+	if (samplingRunning) {
+		samplingPending = true;
+		return;
+	}
+
+	view = currentView();
+	if (view.isEmpty())
+		return;
+
+	Task task;
+	task.type = equationData.type;
+	task.count = equationData.count;
+	gsl_set_error_handler_off();
+
+	//the expressions are compiled here, evaluating them in the worker thread doesn't touch the parser's state
+	QString var("x");
+	if (equationData.type == XYEquationCurve::Polar)
+		var = "phi";
+	else if (equationData.type == XYEquationCurve::Parametric)
+		var = "t";
+	task.expression1 = ExpressionParser::compile(equationData.expression1, QStringList(var));
+	task.expression2 = 0;
+	if (equationData.type == XYEquationCurve::Parametric)
+		task.expression2 = ExpressionParser::compile(equationData.expression2, QStringList(var));
+	task.min = parse(equationData.min.toLocal8Bit().data());
+	task.max = parse(equationData.max.toLocal8Bit().data());
+
+	samplingRunning = true;
+	samplingPending = false;
+	samplingGeneration = generation;
+	samplingWatcher.setFuture(QtConcurrent::run(XYEquationCurvePrivate::sample, task, view, cache));
+}
+
+/*!
+	publishes the samples calculated in the worker thread, results for a previous equation are discarded.
+*/
+void XYEquationCurvePrivate::samplingFinished() {
+	const Sampling sampling = samplingWatcher.result();
+	samplingRunning = false;
+
+	if (samplingGeneration == generation) {
+		cache = sampling.cache;
+		if (sampling.valid) {
+			*xVector = sampling.x;
+			*yVector = sampling.y;
+			cacheResult();
+		} else {
+			xVector->clear();
+			yVector->clear();
+		}
+		emit (q->dataChanged());
+	}
+
+	if (samplingPending && equationData.adaptive)
+		startSampling();
+}
+
+static bool isValidSample(const QPointF& p) {
+	return !std::isnan(p.x()) && !std::isnan(p.y());
+}
+
+//! position of the point \c p in pixels relative to the lower left corner of the view
+static QPointF toPixels(const QPointF& p, const XYEquationCurvePrivate::View& view) {
+	return QPointF((p.x() - view.xMin)*view.width/(view.xMax - view.xMin), (p.y() - view.yMin)*view.height/(view.yMax - view.yMin));
+}
+
+//! checks whether the line between the points \c pa and \c pb in pixels crosses the whole height of the view
+static bool isJump(const QPointF& pa, const QPointF& pb, const XYEquationCurvePrivate::View& view) {
+	const double ay = pa.y();
+	const double by = pb.y();
+	return fabs(by - ay) > view.height && !(ay < 0 && by < 0) && !(ay > view.height && by > view.height);
+}
+
+/*!
+	returns the points of the curve for the parameter values \c t. Values not contained in \c cache
+	are evaluated in one block and added to the cache.
+*/
+static QVector<QPointF> evaluateSamples(const XYEquationCurvePrivate::Task& task, const QVector<double>& t, XYEquationCurvePrivate::Samples& cache) {
+	QVector<double> missing;
+	foreach (double value, t) {
+		if (!cache.contains(value))
+			missing << value;
+	}
+
+	if (!missing.isEmpty()) {
+		const int n = missing.size();
+		QVector<double> values1(n), values2(n);
+		const double* vars[] = {missing.constData()};
+		const int strides[] = {1};
+		parse_eval_vector(task.expression1, vars, strides, n, values1.data());
+		if (task.expression2)
+			parse_eval_vector(task.expression2, vars, strides, n, values2.data());
+
+		for (int i = 0; i < n; ++i) {
+			const double value = missing.at(i);
+			const double v1 = values1.at(i);
+			const double v2 = values2.at(i);
+			QPointF point(NAN, NAN);
+			if (task.type == XYEquationCurve::Cartesian) {
+				point = QPointF(value, std::isfinite(v1) ? v1 : NAN);
+			} else if (task.type == XYEquationCurve::Polar) {
+				if (std::isfinite(v1))
+					point = QPointF(v1*cos(value), v1*sin(value));
+			} else if (std::isfinite(v1) && std::isfinite(v2)) {
+				point = QPointF(v1, v2);
+			}
+			cache.insert(value, point);
+		}
+	}
+
+	QVector<QPointF> points;
+	points.reserve(t.size());
+	foreach (double value, t)
+		points << cache.value(value);
+	return points;
+}
+
+/*!
+	samples the curve of the compiled expressions in \c task for the view \c view. Called in the worker thread.
+
+	The curve parameter is sampled on a grid of multiples of a power of two with roughly one point per pixel column
+	(cartesian curves) or \c count points (polar and parametric curves). Intervals are bisected where the curve
+	deviates from the chord by more than half a pixel and at the boundaries of the domain of the equation.
+	The bisections lie on finer grids of the same kind, so the samples of overlapping ranges and of previous
+	zoom levels coincide exactly and are taken from \c cache.
+	Jumps larger than the plot that remain at the finest level are treated as discontinuities and the line is interrupted.
+*/
+XYEquationCurvePrivate::Sampling XYEquationCurvePrivate::sample(const Task& task, const View& view, Samples cache) {
+	Sampling sampling;
+	static const int maxLevels = 8;
+	static const int maxCacheSize = 1 << 20;
+
+	const bool supported = (task.type == XYEquationCurve::Cartesian || task.type == XYEquationCurve::Polar
+							|| task.type == XYEquationCurve::Parametric);
+	double min = qMin(task.min, task.max);
+	double max = qMax(task.min, task.max);
+	if (!supported || !task.expression1 || (task.type == XYEquationCurve::Parametric && !task.expression2)
+		|| !std::isfinite(min) || !std::isfinite(max)) {
+		parse_free(task.expression1);
+		parse_free(task.expression2);
+		return sampling;
+	}
+
+	//cartesian curves are sampled in the visible range only, one pixel more on both sides to reach the borders
+	if (task.type == XYEquationCurve::Cartesian && view.clip) {
+		const double pixel = fabs(view.xMax - view.xMin)/view.width;
+		min = qMax(min, qMin(view.xMin, view.xMax) - pixel);
+		max = qMin(max, qMax(view.xMin, view.xMax) + pixel);
+	}
+
+	sampling.valid = true;
+	if (min >= max) {
+		parse_free(task.expression1);
+		parse_free(task.expression2);
+		sampling.cache = cache;
+		return sampling;
+	}
+
+	const int base = (task.type == XYEquationCurve::Cartesian) ? view.width : qMax(task.count, 2);
+	const int maxPoints = 64*base;
+
+	//in deeply zoomed views the step is limited to a few ulps of the range, the grid wouldn't advance otherwise
+	const double ulp = std::numeric_limits<double>::epsilon()*qMax(fabs(min), fabs(max));
+	const double step = qMax(exp2(floor(log2((max - min)/base))), qMax((max - min)/maxPoints, 4*ulp));
+	const double minStep = qMax(step/(1 << maxLevels), 4*ulp);
+
+	QVector<double> t;
+	t << min;
+	const double first = floor(min/step) + 1;
+	for (qint64 k = 0; (first + k)*step < max && t.size() < maxPoints; ++k)
+		t << (first + k)*step;
+	t << max;
+	QVector<QPointF> points = evaluateSamples(task, t, cache);
+
+	for (int level = 0; level < maxLevels && t.size() < maxPoints; ++level) {
+		QVector<bool> refine(t.size() - 1, false);
+		for (int i = 0; i < t.size() - 1; ++i) {
+			const QPointF& a = points.at(i);
+			const QPointF& b = points.at(i + 1);
+			const bool aValid = isValidSample(a);
+			const bool bValid = isValidSample(b);
+
+			//boundary of the domain
+			if (aValid != bValid)
+				refine[i] = true;
+
+			if (!aValid || !bValid)
+				continue;
+
+			//a jump over the whole plot is a possible discontinuity
+			const QPointF pa = toPixels(a, view);
+			const QPointF pb = toPixels(b, view);
+			const double ax = pa.x(), bx = pb.x();
+			const double ay = pa.y(), by = pb.y();
+			if (isJump(pa, pb, view))
+				refine[i] = true;
+
+			if (i == 0 || !isValidSample(points.at(i - 1)))
+				continue;
+
+			//no refinement for curve pieces completely outside the plot on one side
+			const QPointF pp = toPixels(points.at(i - 1), view);
+			const double px = pp.x(), py = pp.y();
+			if ((px < 0 && ax < 0 && bx < 0) || (px > view.width && ax > view.width && bx > view.width)
+				|| (py < 0 && ay < 0 && by < 0) || (py > view.height && ay > view.height && by > view.height))
+				continue;
+
+			//deviation of a from the chord between its neighbours
+			const double dx = bx - px;
+			const double dy = by - py;
+			const double length = sqrt(dx*dx + dy*dy);
+			double deviation;
+			if (length > 0)
+				deviation = fabs(dx*(ay - py) - dy*(ax - px))/length;
+			else
+				deviation = sqrt((ax - px)*(ax - px) + (ay - py)*(ay - py));
+
+			if (!(deviation <= 0.5)) {
+				refine[i - 1] = true;
+				refine[i] = true;
+			}
+		}
+
+		QVector<double> midpoints;
+		for (int i = 0; i < refine.size(); ++i) {
+			if (refine.at(i) && t.at(i + 1) - t.at(i) > minStep)
+				midpoints << (t.at(i) + t.at(i + 1))/2;
+		}
+		if (midpoints.isEmpty())
+			break;
+
+		const QVector<QPointF> midpointValues = evaluateSamples(task, midpoints, cache);
+		QVector<double> refinedT;
+		QVector<QPointF> refinedPoints;
+		refinedT.reserve(t.size() + midpoints.size());
+		refinedPoints.reserve(t.size() + midpoints.size());
+		int m = 0;
+		for (int i = 0; i < t.size(); ++i) {
+			refinedT << t.at(i);
+			refinedPoints << points.at(i);
+			if (m < midpoints.size() && i + 1 < t.size() && midpoints.at(m) < t.at(i + 1)) {
+				refinedT << midpoints.at(m);
+				refinedPoints << midpointValues.at(m);
+				++m;
+			}
+		}
+		t = refinedT;
+		points = refinedPoints;
+	}
+
+	parse_free(task.expression1);
+	parse_free(task.expression2);
+
+	sampling.x.reserve(points.size());
+	sampling.y.reserve(points.size());
+	for (int i = 0; i < points.size(); ++i) {
+		const QPointF& point = points.at(i);
+		if (i > 0 && t.at(i) - t.at(i - 1) <= minStep && isValidSample(point) && isValidSample(points.at(i - 1))
+			&& isJump(toPixels(points.at(i - 1), view), toPixels(point, view), view)) {
+			sampling.x << NAN;
+			sampling.y << NAN;
+		}
+		sampling.x << point.x();
+		sampling.y << point.y();
+	}
+
+	//keep the cache bounded, only the current samples are kept if it grows too large
+	if (cache.size() > maxCacheSize) {
+		cache.clear();
+		for (int i = 0; i < t.size(); ++i)
+			cache.insert(t.at(i), points.at(i));
+	}
+	sampling.cache = cache;
+
+	return sampling;
+}
+
 //##############################################################################
 //##################  Serialization/Deserialization  ###########################
 //##############################################################################
@@ -185,8 +605,25 @@ void XYEquationCurve::save(QXmlStreamWriter* writer) const{
 	writer->writeAttribute( "min", d->equationData.min);
 	writer->writeAttribute( "max", d->equationData.max );
 	writer->writeAttribute( "count", QString::number(d->equationData.count) );
+	writer->writeAttribute( "adaptive", QString::number(d->equationData.adaptive) );
 	writer->writeEndElement();
 
+	//save the calculated points with the key of the equation, they are used on load if the equation is the same
+	if (!d->xVector->isEmpty() && d->results.contains(d->key)) {
+		writer->writeStartElement( "result" );
+		writer->writeAttribute( "key", QString(d->key) );
+		writer->writeAttribute( "xMin", QString::number(d->view.xMin, 'g', 16) );
+		writer->writeAttribute( "xMax", QString::number(d->view.xMax, 'g', 16) );
+		writer->writeAttribute( "yMin", QString::number(d->view.yMin, 'g', 16) );
+		writer->writeAttribute( "yMax", QString::number(d->view.yMax, 'g', 16) );
+		writer->writeAttribute( "width", QString::number(d->view.width) );
+		writer->writeAttribute( "height", QString::number(d->view.height) );
+		writer->writeAttribute( "clip", QString::number(d->view.clip) );
+		d->xColumn->save(writer);
+		d->yColumn->save(writer);
+		writer->writeEndElement();
+	}
+
 	writer->writeEndElement();
 }
 
@@ -202,6 +639,9 @@ bool XYEquationCurve::load(XmlStreamReader* reader) {
 	QString attributeWarning = i18n( "Attribute '%1' missing or empty, default value is used" );
 	QXmlStreamAttributes attribs;
 	QString str;
+	QByteArray key;
+	XYEquationCurvePrivate::View view;
+	QList<Column*> columns;
 
 	while (!reader->atEnd()) {
 		reader->readNext();
@@ -223,8 +663,41 @@ bool XYEquationCurve::load(XmlStreamReader* reader) {
 			READ_STRING_VALUE("min", equationData.min);
 			READ_STRING_VALUE("max", equationData.max);
 			READ_INT_VALUE("count", equationData.count, int);
+
+			//projects created before the adaptive sampling was available keep the fixed number of points
+			str = attribs.value("adaptive").toString();
+			d->equationData.adaptive = (str.toInt() == 1);
+		} else if (reader->name() == "result") {
+			attribs = reader->attributes();
+			key = attribs.value("key").toString().toLatin1();
+			view.xMin = attribs.value("xMin").toString().toDouble();
+			view.xMax = attribs.value("xMax").toString().toDouble();
+			view.yMin = attribs.value("yMin").toString().toDouble();
+			view.yMax = attribs.value("yMax").toString().toDouble();
+			view.width = attribs.value("width").toString().toInt();
+			view.height = attribs.value("height").toString().toInt();
+			view.clip = (attribs.value("clip").toString().toInt() == 1);
+		} else if (reader->name() == "column") {
+			Column* column = new Column("", AbstractColumn::Numeric);
+			if (!column->load(reader)) {
+				delete column;
+				qDeleteAll(columns);
+				return false;
+			}
+			columns << column;
 		}
 	}
 
+	//the saved points are used by recalculate() if the equation is the same, the columns are decoded in the thread pool
+	if (!key.isEmpty() && columns.size() == 2) {
+		QThreadPool::globalInstance()->waitForDone();
+		XYEquationCurvePrivate::Result* result = new XYEquationCurvePrivate::Result;
+		result->x = *static_cast<QVector<double>* >(columns.at(0)->data());
+		result->y = *static_cast<QVector<double>* >(columns.at(1)->data());
+		result->view = view;
+		d->results.insert(key, result, qMax(1, result->x.size()));
+	}
+	qDeleteAll(columns);
+
 	return true;
 }
@@ -39,7 +39,7 @@ class XYEquationCurve: public XYCurve {
 		enum EquationType {Cartesian, Polar, Parametric, Implicit, Neutral};
 
 		struct EquationData {
-			EquationData() : type(Cartesian), min("0"), max("1"), count(1000) {};
+			EquationData() : type(Cartesian), min("0"), max("1"), count(1000), adaptive(true) {};
 
 			EquationType type;
 			QString expression1;
@@ -47,6 +47,7 @@ class XYEquationCurve: public XYCurve {
 			QString min;
 			QString max;
 			int count;
+			bool adaptive;	//sample the visible range per pixel and refine where necessary
 		};
 
 		explicit XYEquationCurve(const QString& name);
@@ -65,10 +66,16 @@ class XYEquationCurve: public XYCurve {
 	protected:
 		XYEquationCurve(const QString& name, XYEquationCurvePrivate* dd);
 
+	public slots:
+		virtual void retransform();
+
 	private:
 		Q_DECLARE_PRIVATE(XYEquationCurve)
 		void init();
 
+	private slots:
+		void samplingFinished();
+
 	signals:
 		friend class XYEquationCurveSetEquationDataCmd;
 		void equationDataChanged(const XYEquationCurve::EquationData&);
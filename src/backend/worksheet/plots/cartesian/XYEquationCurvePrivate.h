@@ -31,16 +31,71 @@
 
 #include "backend/worksheet/plots/cartesian/XYCurvePrivate.h"
 #include "backend/worksheet/plots/cartesian/XYEquationCurve.h"
+#include <QCache>
+#include <QFutureWatcher>
+#include <QMap>
 
 class XYEquationCurve;
 class Column;
+struct parser_expr;
 
 class XYEquationCurvePrivate: public XYCurvePrivate {
 	public:
 		explicit XYEquationCurvePrivate(XYEquationCurve*);
 		~XYEquationCurvePrivate();
 
+		//visible range of the plot and its size in pixels the curve is sampled for
+		struct View {
+			View() : xMin(0), xMax(0), yMin(0), yMax(0), width(0), height(0), clip(false) {};
+			bool isEmpty() const { return width <= 0 || height <= 0 || xMin == xMax || yMin == yMax; }
+
+			double xMin;
+			double xMax;
+			double yMin;
+			double yMax;
+			int width;
+			int height;
+			bool clip;	//restrict cartesian curves to the visible x-range
+		};
+
+		//sampled points, the keys are the values of the curve parameter (x, phi or t)
+		typedef QMap<double, QPointF> Samples;
+
+		//compiled expressions and the range of the curve parameter, the expressions are freed by sample()
+		struct Task {
+			parser_expr* expression1;
+			parser_expr* expression2;
+			XYEquationCurve::EquationType type;
+			double min;
+			double max;
+			int count;
+		};
+
+		//result of the adaptive sampling in the worker thread
+		struct Sampling {
+			Sampling() : valid(false) {};
+
+			QVector<double> x;
+			QVector<double> y;
+			Samples cache;
+			bool valid;
+		};
+
+		//calculated points of an equation and the view they were sampled for, cached for the key of the equation
+		struct Result {
+			QVector<double> x;
+			QVector<double> y;
+			View view;
+		};
+
 		void recalculate();
+		QByteArray resultKey() const;
+		void cacheResult();
+		void updateSampling();
+		void startSampling();
+		void samplingFinished();
+		View currentView() const;
+		static Sampling sample(const Task&, const View&, Samples cache);
 
 		XYEquationCurve::EquationData equationData;
 		Column* xColumn;
@@ -48,6 +103,16 @@ class XYEquationCurvePrivate: public XYCurvePrivate {
 		QVector<double>* xVector;
 		QVector<double>* yVector;
 
+		View view;	//view of the last sampling
+		Samples cache;
+		QFutureWatcher<Sampling> samplingWatcher;
+		bool samplingRunning;
+		bool samplingPending;
+		int generation;	//incremented on changes of the equation, results of older samplings are discarded
+		int samplingGeneration;
+		QByteArray key;	//key of the current equation
+		QCache<QByteArray, Result> results;	//results of the recent equations, the cost is the number of points
+
 		XYEquationCurve* const q;
 };
 
@@ -41,10 +41,12 @@
 #include "backend/core/column/Column.h"
 #include "backend/lib/commandtemplates.h"
 #include "backend/lib/macros.h"
+#include "backend/lib/ResultKey.h"
 #include "backend/gsl/ExpressionParser.h"
 
 extern "C" {
 #include <gsl/gsl_blas.h>
+#include <gsl/gsl_math.h>
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_version.h>
@@ -181,6 +183,7 @@ XYFitCurvePrivate::XYFitCurvePrivate(XYFitCurve* owner) : XYCurvePrivate(owner),
 	xColumn(0), yColumn(0), residualsColumn(0),
 	xVector(0), yVector(0), residualsVector(0),
 	sourceDataChangedSinceLastFit(false),
+	results(1 << 21),
 	q(owner)  {
 
 }
@@ -204,6 +207,8 @@ struct data {
 	double* paramMin;	// lower parameter limits
 	double* paramMax;	// upper parameter limits
 	bool* paramFixed;	// parameter fixed?
+	parser_expr* expr;	// model compiled with the variables x and the parameters
+	parser_expr** derivatives;	// derivatives of the custom model with respect to the parameters, 0 if not known
 };
 
 /*!
@@ -218,40 +223,45 @@ int func_f(const gsl_vector* paramValues, void* params, gsl_vector* f) {
 	double* sigma = ((struct data*)params)->sigma;
 	nsl_fit_model_category modelCategory = ((struct data*)params)->modelCategory;
 	unsigned int modelType = ((struct data*)params)->modelType;
-	QByteArray funcba = ((struct data*)params)->func->toLocal8Bit();	// a local byte array is needed!
 	QStringList* paramNames = ((struct data*)params)->paramNames;
 	double *min = ((struct data*)params)->paramMin;
 	double *max = ((struct data*)params)->paramMax;
-
-	// set current values of the parameters
-	for (int i = 0; i < paramNames->size(); i++) {
+	const parser_expr* expr = ((struct data*)params)->expr;	// function to evaluate
+
+	// set current values of the parameters, they follow x in the slots of the compiled model
+	const int np = paramNames->size();
+	QVector<double> values(np);
+	QVector<const double*> vars(1 + np);
+	QVector<int> strides(1 + np, 0);
+	for (int i = 0; i < np; i++) {
 		double x = gsl_vector_get(paramValues, i);
 		// bound values if limits are set
-		assign_variable(paramNames->at(i).toLocal8Bit().data(), nsl_fit_map_bound(x, min[i], max[i]));
+		values[i] = nsl_fit_map_bound(x, min[i], max[i]);
+		vars[1 + i] = values.constData() + i;
 		QDEBUG("Parameter"<<i<<" (\" "<<paramNames->at(i).toLocal8Bit().data()<<"\")"<<'['<<min[i]<<','<<max[i]
 			<<"] free/bound:"<<QString::number(x, 'g', 15)<<' '<<QString::number(nsl_fit_map_bound(x, min[i], max[i]), 'g', 15));
 	}
 
-	const char *func = funcba.data();	// function to evaluate
-	for (size_t i = 0; i < n; i++) {
-		if (std::isnan(x[i]) || std::isnan(y[i]))
-			continue;
-
-		// checks for allowed values of x for different models
-		// TODO: more to check
-		if (modelCategory == nsl_fit_model_distribution && modelType == nsl_sf_stats_lognormal) {
+	// checks for allowed values of x for different models
+	// TODO: more to check
+	if (modelCategory == nsl_fit_model_distribution && modelType == nsl_sf_stats_lognormal) {
+		for (size_t i = 0; i < n; i++) {
 			if (x[i] < 0)
 				x[i] = 0;
 		}
+	}
 
-		assign_variable("x", x[i]);
-		double Yi = parse(func);
-
-//		DEBUG("evaluate function"<<QString(func)<<": f(x["<<i<<"]) ="<<Yi);
+	// the model is evaluated for all x-values at once
+	QVector<double> Y((int)n);
+	vars[0] = x;
+	strides[0] = 1;
+	parse_eval_vector(expr, vars.constData(), strides.constData(), (int)n, Y.data());
 
-		if (parse_errors() > 0)
-			return GSL_EINVAL;
+	for (size_t i = 0; i < n; i++) {
+		if (std::isnan(x[i]) || std::isnan(y[i]))
+			continue;
 
+		const double Yi = Y.at(i);
 		if (sigma)
 			gsl_vector_set (f, i, (Yi - y[i])/sigma[i]);
 		else
@@ -740,44 +750,51 @@ int func_df(const gsl_vector* paramValues, void* params, gsl_matrix* J) {
 		}
 		break;
 	case nsl_fit_model_custom:
-		QByteArray funcba = ((struct data*)params)->func->toLocal8Bit();
-		char* func = funcba.data();
-		QByteArray nameba;
-		double value;
-		const unsigned int np = paramNames->size();
-		for (size_t i = 0; i < n; i++) {
-			x = xVector[i];
-			assign_variable("x", x);
-			if (sigmaVector) sigma = sigmaVector[i];
-
-			for (unsigned int j = 0; j < np; j++) {
-				for (unsigned int k = 0; k < np; k++) {
-					if (k != j) {
-						nameba = paramNames->at(k).toLocal8Bit();
-						value = nsl_fit_map_bound(gsl_vector_get(paramValues, k), min[k], max[k]);
-						assign_variable(nameba.data(), value);
-					}
-				}
-
-				nameba = paramNames->at(j).toLocal8Bit();
-				char *name = nameba.data();
-				value = nsl_fit_map_bound(gsl_vector_get(paramValues, j), min[j], max[j]);
-				assign_variable(name, value);
-				double f_p = parse(func);
+		const parser_expr* expr = ((struct data*)params)->expr;
+		parser_expr** derivatives = ((struct data*)params)->derivatives;
+		const int np = paramNames->size();
+		// the parameters follow x in the slots of the compiled model and of its derivatives
+		QVector<double> values(np);
+		QVector<const double*> vars(1 + np);
+		QVector<int> strides(1 + np, 0);
+		for (int k = 0; k < np; k++) {
+			values[k] = nsl_fit_map_bound(gsl_vector_get(paramValues, k), min[k], max[k]);
+			vars[1 + k] = values.constData() + k;
+		}
+		vars[0] = xVector;
+		strides[0] = 1;
+
+		// the columns of the Jacobian are evaluated for all points at once
+		QVector<double> df((int)n), f_p, f_pdp;
+		for (int j = 0; j < np; j++) {
+			if (fixed[j]) {
+				for (size_t i = 0; i < n; i++)
+					gsl_matrix_set(J, i, j, 0.);
+				continue;
+			}
 
-				double eps = 1.e-9*fabs(f_p);	// adapt step size to value
-				value += eps;
-				assign_variable(name, value);
-				double f_pdp = parse(func);
+			if (derivatives[j]) {
+				parse_eval_vector(derivatives[j], vars.constData(), strides.constData(), (int)n, df.data());
+			} else {
+				// no analytic derivative available (special functions): finite differences
+				if (f_p.isEmpty()) {
+					f_p.resize((int)n);
+					f_pdp.resize((int)n);
+					parse_eval_vector(expr, vars.constData(), strides.constData(), (int)n, f_p.data());
+				}
 
-//		qDebug()<<"evaluate deriv"<<QString(func)<<": f(x["<<i<<"]) ="<<QString::number(f_p, 'g', 15);
-//		qDebug()<<"evaluate deriv"<<QString(func)<<": f(x["<<i<<"]+dx) ="<<QString::number(f_pdp, 'g', 15);
-//		qDebug()<<"	deriv = "<<QString::number((f_pdp-f_p)/eps/sigma, 'g', 15);
+				const double value = values[j];
+				const double eps = GSL_SQRT_DBL_EPSILON*qMax(fabs(value), 1.);
+				values[j] = value + eps;
+				parse_eval_vector(expr, vars.constData(), strides.constData(), (int)n, f_pdp.data());
+				values[j] = value;
+				for (size_t i = 0; i < n; i++)
+					df[i] = (f_pdp[i] - f_p[i])/eps;
+			}
 
-				if (fixed[j])
-					gsl_matrix_set(J, i, j, 0.);
-				else	// calculate finite difference
-					gsl_matrix_set(J, i, j, (f_pdp - f_p)/eps/sigma);
+			for (size_t i = 0; i < n; i++) {
+				if (sigmaVector) sigma = sigmaVector[i];
+				gsl_matrix_set(J, i, j, df[i]/sigma);
 			}
 		}
 	}
@@ -826,6 +843,21 @@ void XYFitCurvePrivate::recalculate() {
 	// clear the previous result
 	fitResult = XYFitCurve::FitResult();
 
+	//the same fit was done before, e.g. before an undo
+	key = resultKey();
+	const Result* result = results.object(key);
+	if (result) {
+		fitData = result->fitData;
+		fitResult = result->fitResult;
+		*xVector = result->x;
+		*yVector = result->y;
+		*residualsVector = result->residuals;
+		residualsColumn->setChanged();
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastFit = false;
+		return;
+	}
+
 	if (!xDataColumn || !yDataColumn) {
 		emit (q->dataChanged());
 		sourceDataChangedSinceLastFit = false;
@@ -930,10 +962,36 @@ void XYFitCurvePrivate::recalculate() {
 	for (unsigned int i = 0; i < np; i++)
 		DEBUG("fixed parameter"<<i<<fitData.paramFixed.data()[i]);
 
-	//function to fit
+	//function to fit, compiled once for all iterations
+	parser_expr* expr = ExpressionParser::compile(fitData.model, QStringList("x") << fitData.paramNames);
+	if (!expr) {
+		fitResult.available = true;
+		fitResult.valid = false;
+		fitResult.status = i18n("The fit model is not valid.");
+		emit (q->dataChanged());
+		sourceDataChangedSinceLastFit = false;
+		return;
+	}
+
+	//analytic Jacobian of custom models, the slot of parameter i is i+1
+	QVector<parser_expr*> derivatives(np, 0);
+	if (fitData.modelCategory == nsl_fit_model_custom) {
+		for (unsigned int i = 0; i < np; i++)
+			derivatives[i] = parse_derivative(expr, i + 1);
+
+		//native code for long fits: x is contiguous, the parameters are the same for all points
+		if (n*(size_t)maxIters >= PARSER_JIT_MIN_POINTS) {
+			QVector<int> strides(1 + np, 0);
+			strides[0] = 1;
+			parse_jit(expr, strides.constData());
+			foreach (parser_expr* derivative, derivatives)
+				parse_jit(derivative, strides.constData());
+		}
+	}
+
 	gsl_multifit_function_fdf f;
-	struct data params = {n, xdata, ydata, sigma, fitData.modelCategory, fitData.modelType, fitData.degree, &fitData.model, &fitData.paramNames, 
-				fitData.paramLowerLimits.data(), fitData.paramUpperLimits.data(), fitData.paramFixed.data()};
+	struct data params = {n, xdata, ydata, sigma, fitData.modelCategory, fitData.modelType, fitData.degree, &fitData.model, &fitData.paramNames,
+				fitData.paramLowerLimits.data(), fitData.paramUpperLimits.data(), fitData.paramFixed.data(), expr, derivatives.data()};
 	f.f = &func_f;
 	f.df = &func_df;
 	f.fdf = &func_fdf;
@@ -1069,6 +1127,9 @@ void XYFitCurvePrivate::recalculate() {
 	//free resources
 	gsl_multifit_fdfsolver_free(s);
 	gsl_matrix_free(covar);
+	parse_free(expr);
+	foreach (parser_expr* derivative, derivatives)
+		parse_free(derivative);
 
 	//calculate the fit function (vectors)
 	ExpressionParser* parser = ExpressionParser::getInstance();
@@ -1086,12 +1147,56 @@ void XYFitCurvePrivate::recalculate() {
 	}
 
 	fitResult.elapsedTime = timer.elapsed();
+	cacheResult();
 
 	//redraw the curve
 	emit (q->dataChanged());
 	sourceDataChangedSinceLastFit = false;
 }
 
+/*!
+	returns the key of the current fit, the hash of the fit settings and of the data in the source columns.
+*/
+QByteArray XYFitCurvePrivate::resultKey() const {
+	ResultKey resultKey;
+	resultKey.addData(fitData.modelCategory);
+	resultKey.addData(fitData.modelType);
+	resultKey.addData(fitData.weightsType);
+	resultKey.addData(fitData.degree);
+	resultKey.addData(fitData.model);
+	foreach (const QString& name, fitData.paramNames)
+		resultKey.addData(name);
+	resultKey.addData(fitData.paramStartValues);
+	resultKey.addData(fitData.paramLowerLimits);
+	resultKey.addData(fitData.paramUpperLimits);
+	foreach (bool fixed, fitData.paramFixed)
+		resultKey.addData(fixed);
+	resultKey.addData(fitData.maxIterations);
+	resultKey.addData(fitData.eps);
+	resultKey.addData(fitData.evaluatedPoints);
+	resultKey.addData(fitData.useResults);
+	resultKey.addData(fitData.evaluateFullRange);
+	resultKey.addData(fitData.autoRange);
+	resultKey.addData(fitData.xRange);
+	resultKey.addData(xDataColumn);
+	resultKey.addData(yDataColumn);
+	resultKey.addData(weightsColumn);
+	return resultKey.result();
+}
+
+/*!
+	keeps the settings and the result of the last fit for its key
+*/
+void XYFitCurvePrivate::cacheResult() {
+	Result* result = new Result;
+	result->fitData = fitData;
+	result->fitResult = fitResult;
+	result->x = *xVector;
+	result->y = *yVector;
+	result->residuals = *residualsVector;
+	results.insert(key, result, qMax(1, xVector->size() + residualsVector->size()));
+}
+
 /*!
  * writes out the current state of the solver \c s
  */
@@ -1219,6 +1324,8 @@ void XYFitCurve::save(QXmlStreamWriter* writer) const {
 
 	//save calculated columns if available
 	if (d->xColumn && d->yColumn && d->residualsColumn) {
+		if (d->results.contains(d->key))
+			writer->writeTextElement("key", QString(d->key));
 		d->xColumn->save(writer);
 		d->yColumn->save(writer);
 		d->residualsColumn->save(writer);
@@ -1299,6 +1406,8 @@ bool XYFitCurve::load(XmlStreamReader* reader) {
 			d->fitResult.paramValues<<reader->readElementText().toDouble();
 		} else if (reader->name() == "error") {
 			d->fitResult.errorValues<<reader->readElementText().toDouble();
+		} else if (reader->name() == "key") {
+			d->key = reader->readElementText().toLatin1();
 		} else if (reader->name() == "fitResult") {
 			attribs = reader->attributes();
 
@@ -1374,6 +1483,10 @@ bool XYFitCurve::load(XmlStreamReader* reader) {
 		XYCurve::d_ptr->xColumn = d->xColumn;
 		XYCurve::d_ptr->yColumn = d->yColumn;
 		setUndoAware(true);
+
+		//the saved result is used again if the same fit is done on the same data
+		if (!d->key.isEmpty())
+			d->cacheResult();
 	}
 
 	return true;
@@ -31,6 +31,7 @@
 
 #include "backend/worksheet/plots/cartesian/XYCurvePrivate.h"
 #include "backend/worksheet/plots/cartesian/XYFitCurve.h"
+#include <QCache>
 
 class XYFitCurve;
 class Column;
@@ -44,7 +45,18 @@ class XYFitCurvePrivate: public XYCurvePrivate {
 		explicit XYFitCurvePrivate(XYFitCurve*);
 		~XYFitCurvePrivate();
 
+		//fit settings after the fit and its result, cached for the key of the settings and the data before the fit
+		struct Result {
+			XYFitCurve::FitData fitData;
+			XYFitCurve::FitResult fitResult;
+			QVector<double> x;
+			QVector<double> y;
+			QVector<double> residuals;
+		};
+
 		void recalculate();
+		QByteArray resultKey() const;
+		void cacheResult();
 
 		const AbstractColumn* xDataColumn; //<! column storing the values for the x-data to be fitted
 		const AbstractColumn* yDataColumn; //<! column storing the values for the y-data to be fitted
@@ -65,6 +77,8 @@ class XYFitCurvePrivate: public XYCurvePrivate {
 		QVector<double>* residualsVector;
 
 		bool sourceDataChangedSinceLastFit; //<! \c true if the data in the source columns (x, y, or weights) was changed, \c false otherwise
+		QByteArray key; //<! key of the settings and the data of the last fit
+		QCache<QByteArray, Result> results; //<! results of the recent fits, the cost is the number of points
 
 		XYFitCurve* const q;
 
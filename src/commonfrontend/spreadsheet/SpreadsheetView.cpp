@@ -39,6 +39,7 @@
 #include "backend/core/datatypes/String2DoubleFilter.h"
 #include "backend/core/datatypes/DateTime2StringFilter.h"
 #include "backend/core/datatypes/String2DateTimeFilter.h"
+#include "backend/datasources/filters/AsciiFilter.h"
 
 #include <QTableView>
 #include <QHBoxLayout>
@@ -1803,36 +1804,10 @@ void SpreadsheetView::print(QPrinter* printer) const {
 }
 
 void SpreadsheetView::exportToFile(const QString& path, const bool exportHeader, const QString& separator) const {
-	QFile file(path);
-	if (!file.open(QFile::WriteOnly | QFile::Truncate))
-		return;
-
-	QTextStream out(&file);
-	const int cols = m_spreadsheet->columnCount();
-
-	QString sep = separator;
-	sep = sep.replace(QLatin1String("TAB"), QLatin1String("\t"), Qt::CaseInsensitive);
-	sep = sep.replace(QLatin1String("SPACE"), QLatin1String(" "), Qt::CaseInsensitive);
-
-	//export header (column names)
-	if (exportHeader) {
-		for (int j=0; j<cols; ++j) {
-			out << m_spreadsheet->column(j)->name();
-			if (j!=cols-1)
-				out<<sep;
-		}
-		out << '\n';
-	}
-
-	//export values
-	for (int i=0; i<m_spreadsheet->rowCount(); ++i) {
-		for (int j=0; j<cols; ++j) {
-			out << m_spreadsheet->column(j)->asStringColumn()->textAt(i);
-			if (j!=cols-1)
-				out<<sep;
-		}
-		out << '\n';
-	}
+	AsciiFilter filter;
+	filter.setSeparatingCharacter(separator);
+	filter.setHeaderEnabled(exportHeader);
+	filter.write(path, m_spreadsheet);
 }
 
 void SpreadsheetView::exportToLaTeX(const QString & path, const bool exportHeaders,
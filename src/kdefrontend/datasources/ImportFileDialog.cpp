@@ -31,6 +31,8 @@
 #include "ImportFileWidget.h"
 #include "backend/core/AspectTreeModel.h"
 #include "backend/datasources/FileDataSource.h"
+#include "backend/datasources/ImportCache.h"
+#include "backend/datasources/ImportJob.h"
 #include "backend/datasources/filters/AbstractFileFilter.h"
 #include "backend/datasources/filters/HDFFilter.h"
 #include "backend/datasources/filters/NetCDFFilter.h"
@@ -44,6 +46,7 @@
 #include <KInputDialog>
 #include <QProgressBar>
 #include <QStatusBar>
+#include <QToolButton>
 #include <QDir>
 #include <QInputDialog>
 #include <KMenu>
@@ -190,6 +193,38 @@ void ImportFileDialog::importToFileDataSource(FileDataSource* source, QStatusBar
 	RESET_CURSOR;
 	statusBar->removeWidget(progressBar);
 }
+/*!
+  starts the import of the file \c fileName into \c spreadsheet in the background.
+  A progress bar and a button to cancel the import are shown in the status bar until the job has finished.
+  If \c previous is set, the import is started after the job \c previous has finished.
+*/
+static ImportJob* startImportJob(AbstractFileFilter* filter, const QString& fileName, Spreadsheet* spreadsheet, QStatusBar* statusBar,
+		ImportJob* previous = 0, AbstractFileFilter::ImportMode mode = AbstractFileFilter::Replace) {
+	ImportJob* job = new ImportJob(filter, fileName, spreadsheet, mode);
+
+	QProgressBar* progressBar = new QProgressBar();
+	progressBar->setRange(0, 100);
+	progressBar->setToolTip(fileName);
+	QToolButton* cancelButton = new QToolButton();
+	cancelButton->setIcon(KIcon("process-stop"));
+	cancelButton->setToolTip(i18n("Cancel the import of %1", fileName));
+
+	QObject::connect(job, SIGNAL(completed(int)), progressBar, SLOT(setValue(int)));
+	QObject::connect(cancelButton, SIGNAL(clicked()), job, SLOT(cancel()));
+	QObject::connect(job, SIGNAL(finished()), progressBar, SLOT(deleteLater()));
+	QObject::connect(job, SIGNAL(finished()), cancelButton, SLOT(deleteLater()));
+
+	statusBar->clearMessage();
+	statusBar->addWidget(progressBar, 1);
+	statusBar->addWidget(cancelButton);
+	if (previous)
+		QObject::connect(previous, SIGNAL(finished()), job, SLOT(start()));
+	else
+		job->start();
+
+	return job;
+}
+
 /*!
   triggers data import to the currently selected data container
 */
@@ -206,6 +241,20 @@ void ImportFileDialog::importTo(QStatusBar* statusBar) const {
 	AbstractFileFilter* filter = importFileWidget->currentFileFilter();
 	AbstractFileFilter::ImportMode mode = AbstractFileFilter::ImportMode(cbPosition->currentIndex());
 
+	//ASCII, binary and image files are imported into a spreadsheet in the background, the rows are shown while the file is read.
+	//the import into matrices and of FITS files still blocks the GUI, it is shown with a progress bar only
+	const FileDataSource::FileType fileType = importFileWidget->currentFileType();
+	if (aspect->inherits("Spreadsheet")
+		&& (fileType == FileDataSource::Ascii || fileType == FileDataSource::Binary || fileType == FileDataSource::Image)) {
+		Spreadsheet* spreadsheet = qobject_cast<Spreadsheet*>(aspect);
+		if (mode == AbstractFileFilter::Replace && ImportCache::read(fileName, filter, spreadsheet, mode)) {
+			statusBar->showMessage(i18n("File %1 imported from the cache.", fileName));
+			delete filter;
+		} else
+			startImportJob(filter, fileName, spreadsheet, statusBar, 0, mode);
+		return;
+	}
+
 	//show a progress bar in the status bar
 	QProgressBar* progressBar = new QProgressBar();
 	progressBar->setMinimum(0);
@@ -225,13 +274,17 @@ void ImportFileDialog::importTo(QStatusBar* statusBar) const {
 		filter->read(fileName, matrix, mode);
 	} else if (aspect->inherits("Spreadsheet")) {
 		Spreadsheet* spreadsheet = qobject_cast<Spreadsheet*>(aspect);
-		filter->read(fileName, spreadsheet, mode);
+		if (mode != AbstractFileFilter::Replace)
+			filter->read(fileName, spreadsheet, mode);
+		else if (!ImportCache::read(fileName, filter, spreadsheet, mode)) {
+			filter->read(fileName, spreadsheet, mode);
+			ImportCache::write(fileName, filter, spreadsheet);
+		}
 	} else if (aspect->inherits("Workbook")) {
 		Workbook* workbook = qobject_cast<Workbook*>(aspect);
 		QList<AbstractAspect*> sheets = workbook->children<AbstractAspect>();
 
 		QStringList names;
-		FileDataSource::FileType fileType = importFileWidget->currentFileType();
 		if (fileType == FileDataSource::HDF)
 			names = importFileWidget->selectedHDFNames();
 		else if (fileType == FileDataSource::NETCDF)
@@ -261,16 +314,35 @@ void ImportFileDialog::importTo(QStatusBar* statusBar) const {
 
 			// import to sheets
 			sheets = workbook->children<AbstractAspect>();
+
+			// matrices are filled directly
 			for (int i = 0; i < nrNames; i++) {
+				if (!sheets[i+offset]->inherits("Matrix"))
+					continue;
+
 				if (fileType == FileDataSource::HDF)
 					((HDFFilter*) filter)->setCurrentDataSetName(names[i]);
 				else
 					((NetCDFFilter*) filter)->setCurrentVarName(names[i]);
+				filter->read(fileName, qobject_cast<Matrix*>(sheets[i+offset]), AbstractFileFilter::Replace);
+			}
+
+			// the data sets/variables to be imported into spreadsheets are read in the background afterwards.
+			// The filters serialize the calls of the libraries, the values read by one job are converted while
+			// the next job reads. A job per core runs at the same time, the remaining jobs are queued behind them.
+			QVector<ImportJob*> previous(qMax(QThread::idealThreadCount(), 2), 0);
+			int jobs = 0;
+			for (int i = 0; i < nrNames; i++) {
+				if (!sheets[i+offset]->inherits("Spreadsheet"))
+					continue;
 
-				if (sheets[i+offset]->inherits("Matrix"))
-					filter->read(fileName, qobject_cast<Matrix*>(sheets[i+offset]), AbstractFileFilter::Replace);
-				else if (sheets[i+offset]->inherits("Spreadsheet"))
-					filter->read(fileName, qobject_cast<Spreadsheet*>(sheets[i+offset]), AbstractFileFilter::Replace);
+				AbstractFileFilter* sheetFilter = importFileWidget->currentFileFilter();
+				if (fileType == FileDataSource::HDF)
+					((HDFFilter*) sheetFilter)->setCurrentDataSetName(names[i]);
+				else
+					((NetCDFFilter*) sheetFilter)->setCurrentVarName(names[i]);
+				ImportJob*& queue = previous[jobs++ % previous.size()];
+				queue = startImportJob(sheetFilter, fileName, qobject_cast<Spreadsheet*>(sheets[i+offset]), statusBar, queue);
 			}
 		} else { // single import file types
 			// use active spreadsheet/matrix if present, else new spreadsheet
@@ -399,5 +471,6 @@ void ImportFileDialog::checkOkButton() {
 			fileName = fileName.mid(0, extensionBraceletPos);
 	}
 
-	enableButtonOk( QFile::exists(fileName) ) ;
+	//the data sets/variables can only be selected after the content of the file was scanned
+	enableButtonOk( QFile::exists(fileName) && !importFileWidget->isScanning() ) ;
 }
@@ -31,12 +31,15 @@ Copyright            : (C) 2009-2017 Alexander Semke (alexander.semke@web.de)
 #include "FileInfoDialog.h"
 #include "backend/datasources/filters/AsciiFilter.h"
 #include "backend/datasources/filters/BinaryFilter.h"
+#include "backend/datasources/filters/BinaryRecord.h"
 #include "backend/datasources/filters/HDFFilter.h"
 #include "backend/datasources/filters/NetCDFFilter.h"
 #include "backend/datasources/filters/ImageFilter.h"
 #include "backend/datasources/filters/FITSFilter.h"
 
 #include <QTableWidget>
+#include <QHeaderView>
+#include <QSpinBox>
 #include <QInputDialog>
 #include <QDir>
 #include <QFileDialog>
@@ -44,16 +47,21 @@ Copyright            : (C) 2009-2017 Alexander Semke (alexander.semke@web.de)
 #include <QTimer>
 #include <QStandardItemModel>
 #include <QImageReader>
+#include <QtConcurrentRun>
+#include <QTreeWidgetItem>
 
 #include <KUrlCompletion>
 
+#include <limits>
+
 /*!
    \class ImportFileWidget
    \brief Widget for importing data from a file.
 
    \ingroup kdefrontend
 */
-ImportFileWidget::ImportFileWidget(QWidget* parent, const QString& fileName) : QWidget(parent), m_fileName(fileName) {
+ImportFileWidget::ImportFileWidget(QWidget* parent, const QString& fileName) : QWidget(parent), m_fileName(fileName),
+	m_scannedTree(0), m_scannedItem(0), m_rescan(false) {
 	ui.setupUi(this);
 
 	KUrlCompletion *comp = new KUrlCompletion();
@@ -63,6 +71,7 @@ ImportFileWidget::ImportFileWidget(QWidget* parent, const QString& fileName) : Q
 	QStringList filterItems;
 	filterItems << i18n("Automatic") << i18n("Custom");
 	ui.cbFilter->addItems( filterItems );
+	ui.cbSamplingMode->addItems(AbstractFileFilter::samplingModes());
 
 	// file type specific option widgets
 	QWidget* asciiw = new QWidget(0);
@@ -76,6 +85,10 @@ ImportFileWidget::ImportFileWidget(QWidget* parent, const QString& fileName) : Q
 	binaryOptionsWidget.setupUi(binaryw);
 	binaryOptionsWidget.cbDataType->addItems(BinaryFilter::dataTypes());
 	binaryOptionsWidget.cbByteOrder->addItems(BinaryFilter::byteOrders());
+	binaryOptionsWidget.twRecordFields->horizontalHeader()->setStretchLastSection(true);
+	binaryOptionsWidget.twRecordFields->verticalHeader()->hide();
+	binaryOptionsWidget.bAddRecordField->setIcon( KIcon("list-add") );
+	binaryOptionsWidget.bRemoveRecordField->setIcon( KIcon("list-remove") );
 	ui.swOptions->insertWidget(FileDataSource::Binary, binaryw);
 
 	QWidget* imagew = new QWidget(0);
@@ -165,14 +178,20 @@ ImportFileWidget::ImportFileWidget(QWidget* parent, const QString& fileName) : Q
 	connect( ui.cbFileType, SIGNAL(currentIndexChanged(int)), SLOT(fileTypeChanged(int)) );
 	connect( ui.cbFilter, SIGNAL(activated(int)), SLOT(filterChanged(int)) );
 	connect( ui.bRefreshPreview, SIGNAL(clicked()), SLOT(refreshPreview()) );
+	connect( ui.cbSamplingMode, SIGNAL(currentIndexChanged(int)), SLOT(samplingModeChanged(int)) );
 
 	connect( asciiOptionsWidget.chbHeader, SIGNAL(stateChanged(int)), SLOT(headerChanged(int)) );
 	connect( hdfOptionsWidget.twContent, SIGNAL(itemSelectionChanged()), SLOT(hdfTreeWidgetSelectionChanged()) );
+	connect( hdfOptionsWidget.twContent, SIGNAL(itemExpanded(QTreeWidgetItem*)), SLOT(hdfTreeWidgetItemExpanded(QTreeWidgetItem*)) );
 	connect( hdfOptionsWidget.bRefreshPreview, SIGNAL(clicked()), SLOT(refreshPreview()) );
 	connect( netcdfOptionsWidget.twContent, SIGNAL(itemSelectionChanged()), SLOT(netcdfTreeWidgetSelectionChanged()) );
+	connect( netcdfOptionsWidget.twContent, SIGNAL(itemExpanded(QTreeWidgetItem*)), SLOT(netcdfTreeWidgetItemExpanded(QTreeWidgetItem*)) );
 	connect( netcdfOptionsWidget.bRefreshPreview, SIGNAL(clicked()), SLOT(refreshPreview()) );
 	connect( fitsOptionsWidget.twExtensions, SIGNAL(itemSelectionChanged()), SLOT(fitsTreeWidgetSelectionChanged()));
 	connect( fitsOptionsWidget.bRefreshPreview, SIGNAL(clicked()), SLOT(refreshPreview()) );
+	connect( &m_scanWatcher, SIGNAL(finished()), SLOT(scanFinished()) );
+	connect( binaryOptionsWidget.bAddRecordField, SIGNAL(clicked()), SLOT(addRecordField()) );
+	connect( binaryOptionsWidget.bRemoveRecordField, SIGNAL(clicked()), SLOT(removeRecordField()) );
 
 	//TODO: implement save/load of user-defined settings later and activate these buttons again
 	ui.bSaveFilter->hide();
@@ -202,6 +221,10 @@ void ImportFileWidget::loadSettings() {
 	binaryOptionsWidget.cbByteOrder->setCurrentIndex(conf.readEntry("ByteOrder", 0));
 	binaryOptionsWidget.sbSkipStartBytes->setValue(conf.readEntry("SkipStartBytes", 0));
 	binaryOptionsWidget.sbSkipBytes->setValue(conf.readEntry("SkipBytes", 0));
+	binaryOptionsWidget.twRecordFields->setRowCount(0);
+	foreach (const BinaryFilter::RecordField& field, BinaryRecord::fieldsFromString(conf.readEntry("RecordFields", "")))
+		insertRecordField(field);
+	binaryOptionsWidget.sbRecordSize->setValue(conf.readEntry("RecordSize", 0));
 
 	// image data
 	imageOptionsWidget.cbImportFormat->setCurrentIndex(conf.readEntry("ImportFormat", 0));
@@ -210,6 +233,9 @@ void ImportFileWidget::loadSettings() {
 	ui.cbFileType->setCurrentIndex(conf.readEntry("Type", 0));
 	ui.cbFilter->setCurrentIndex(conf.readEntry("Filter", 0));
 	filterChanged(ui.cbFilter->currentIndex());	// needed if filter is not changed
+	ui.cbSamplingMode->setCurrentIndex(conf.readEntry("SamplingMode", 0));
+	ui.sbSamplingFactor->setValue(conf.readEntry("SamplingFactor", 1));
+	samplingModeChanged(ui.cbSamplingMode->currentIndex());
 	if (m_fileName.isEmpty())
 		ui.kleFileName->setText(conf.readEntry("LastImportedFile", ""));
 	else
@@ -217,6 +243,10 @@ void ImportFileWidget::loadSettings() {
 }
 
 ImportFileWidget::~ImportFileWidget() {
+	//don't leave the scan of a closed dialog running in the background
+	if (m_scannedTree)
+		m_scanWatcher.waitForFinished();
+
 	// save current settings
 	KConfigGroup conf(KSharedConfig::openConfig(), "Import");
 
@@ -224,6 +254,8 @@ ImportFileWidget::~ImportFileWidget() {
 	conf.writeEntry("LastImportedFile", ui.kleFileName->text());
 	conf.writeEntry("Type", ui.cbFileType->currentIndex());
 	conf.writeEntry("Filter", ui.cbFilter->currentIndex());
+	conf.writeEntry("SamplingMode", ui.cbSamplingMode->currentIndex());
+	conf.writeEntry("SamplingFactor", ui.sbSamplingFactor->value());
 
 	// data type specific settings
 	// ascii data
@@ -240,6 +272,8 @@ ImportFileWidget::~ImportFileWidget() {
 	conf.writeEntry("DataType", binaryOptionsWidget.cbDataType->currentIndex());
 	conf.writeEntry("SkipStartBytes", binaryOptionsWidget.sbSkipStartBytes->value());
 	conf.writeEntry("SkipBytes", binaryOptionsWidget.sbSkipBytes->value());
+	conf.writeEntry("RecordFields", BinaryRecord::fieldsToString(recordFields()));
+	conf.writeEntry("RecordSize", binaryOptionsWidget.sbRecordSize->value());
 
 	// image data
 	conf.writeEntry("ImportFormat", imageOptionsWidget.cbImportFormat->currentIndex());
@@ -333,6 +367,8 @@ AbstractFileFilter* ImportFileWidget::currentFileFilter() const {
 			filter->setEndRow( ui.sbEndRow->value() );
 			filter->setStartColumn( ui.sbStartColumn->value());
 			filter->setEndColumn( ui.sbEndColumn->value());
+			filter->setSamplingMode( (AbstractFileFilter::SamplingMode)ui.cbSamplingMode->currentIndex() );
+			filter->setSamplingFactor( ui.sbSamplingFactor->value() );
 
 			return filter;
 		}
@@ -344,6 +380,10 @@ AbstractFileFilter* ImportFileWidget::currentFileFilter() const {
 				filter->setAutoModeEnabled(false);
 				filter->setVectors( binaryOptionsWidget.niVectors->value() );
 				filter->setDataType( (BinaryFilter::DataType) binaryOptionsWidget.cbDataType->currentIndex() );
+				filter->setByteOrder( (BinaryFilter::ByteOrder) binaryOptionsWidget.cbByteOrder->currentIndex() );
+				filter->setSkipStartBytes( binaryOptionsWidget.sbSkipStartBytes->value() );
+				filter->setRecordFields( recordFields() );
+				filter->setRecordSize( binaryOptionsWidget.sbRecordSize->value() );
 			} else {
 				//TODO: load filter settings
 // 			filter->setFilterName( ui.cbFilter->currentText() );
@@ -351,6 +391,8 @@ AbstractFileFilter* ImportFileWidget::currentFileFilter() const {
 
 			filter->setStartRow( ui.sbStartRow->value() );
 			filter->setEndRow( ui.sbEndRow->value() );
+			filter->setSamplingMode( (AbstractFileFilter::SamplingMode)ui.cbSamplingMode->currentIndex() );
+			filter->setSamplingFactor( ui.sbSamplingFactor->value() );
 
 			return filter;
 		}
@@ -374,6 +416,8 @@ AbstractFileFilter* ImportFileWidget::currentFileFilter() const {
 			filter->setEndRow( ui.sbEndRow->value() );
 			filter->setStartColumn( ui.sbStartColumn->value() );
 			filter->setEndColumn( ui.sbEndColumn->value() );
+			filter->setSamplingMode( (AbstractFileFilter::SamplingMode)ui.cbSamplingMode->currentIndex() );
+			filter->setSamplingFactor( ui.sbSamplingFactor->value() );
 
 			return filter;
 		}
@@ -386,6 +430,8 @@ AbstractFileFilter* ImportFileWidget::currentFileFilter() const {
 			filter->setEndRow( ui.sbEndRow->value() );
 			filter->setStartColumn( ui.sbStartColumn->value() );
 			filter->setEndColumn( ui.sbEndColumn->value() );
+			filter->setSamplingMode( (AbstractFileFilter::SamplingMode)ui.cbSamplingMode->currentIndex() );
+			filter->setSamplingFactor( ui.sbSamplingFactor->value() );
 
 			return filter;
 		}
@@ -395,6 +441,8 @@ AbstractFileFilter* ImportFileWidget::currentFileFilter() const {
 			filter->setEndRow( ui.sbEndRow->value() );
 			filter->setStartColumn( ui.sbStartColumn->value());
 			filter->setEndColumn( ui.sbEndColumn->value());
+			filter->setSamplingMode( (AbstractFileFilter::SamplingMode)ui.cbSamplingMode->currentIndex() );
+			filter->setSamplingFactor( ui.sbSamplingFactor->value() );
 			return filter;
 		}
 	}
@@ -442,6 +490,12 @@ void ImportFileWidget::selectFile() {
 	and activates the corresponding options.
 */
 void ImportFileWidget::fileNameChanged(const QString& name) {
+	//the content of the previous file is still scanned, the new file is handled when the scan has finished
+	if (m_scannedTree) {
+		m_rescan = true;
+		return;
+	}
+
 	QString fileName = name;
 #ifndef _WIN32
 	// make relative path
@@ -504,28 +558,16 @@ void ImportFileWidget::fileNameChanged(const QString& name) {
 
 		// update HDF tree widget using current selected file
 		hdfOptionsWidget.twContent->clear();
-
-		QTreeWidgetItem *rootItem = hdfOptionsWidget.twContent->invisibleRootItem();
-		HDFFilter *filter = (HDFFilter *)this->currentFileFilter();
-		filter->parse(fileName, rootItem);
-		hdfOptionsWidget.twContent->insertTopLevelItem(0, rootItem);
-		hdfOptionsWidget.twContent->expandAll();
-		hdfOptionsWidget.twContent->resizeColumnToContents(0);
-		hdfOptionsWidget.twContent->resizeColumnToContents(3);
+		m_scannedFileName = fileName;
+		scanContent(hdfOptionsWidget.twContent, 0);
 	} else if (fileInfo.contains("NetCDF Data Format") || fileName.endsWith("nc", Qt::CaseInsensitive) ||
 	           fileName.endsWith("netcdf", Qt::CaseInsensitive) || fileName.endsWith("cdf", Qt::CaseInsensitive)) {
 		ui.cbFileType->setCurrentIndex(FileDataSource::NETCDF);
 
 		// update NetCDF tree widget using current selected file
 		netcdfOptionsWidget.twContent->clear();
-
-		QTreeWidgetItem *rootItem = netcdfOptionsWidget.twContent->invisibleRootItem();
-		NetCDFFilter *filter = (NetCDFFilter *)this->currentFileFilter();
-		filter->parse(fileName, rootItem);
-		netcdfOptionsWidget.twContent->insertTopLevelItem(0, rootItem);
-		netcdfOptionsWidget.twContent->expandAll();
-		netcdfOptionsWidget.twContent->resizeColumnToContents(0);
-		netcdfOptionsWidget.twContent->resizeColumnToContents(2);
+		m_scannedFileName = fileName;
+		scanContent(netcdfOptionsWidget.twContent, 0);
 	} else if (fileInfo.contains("FITS image data") || fileName.endsWith("fits", Qt::CaseInsensitive) ||
 	           fileName.endsWith("fit", Qt::CaseInsensitive) || fileName.endsWith("fts", Qt::CaseInsensitive)) {
 #ifdef HAVE_FITS
@@ -586,6 +628,10 @@ void ImportFileWidget::fileTypeChanged(int fileType) {
 	ui.sbStartColumn->show();
 	ui.lEndColumn->show();
 	ui.sbEndColumn->show();
+	ui.lSamplingMode->show();
+	ui.cbSamplingMode->show();
+	ui.lSamplingFactor->show();
+	ui.sbSamplingFactor->show();
 
 	switch (fileType) {
 	case FileDataSource::Ascii:
@@ -608,6 +654,11 @@ void ImportFileWidget::fileTypeChanged(int fileType) {
 	case FileDataSource::Image:
 		ui.lPreviewLines->hide();
 		ui.sbPreviewLines->hide();
+		//the rows of an image are not sampled
+		ui.lSamplingMode->hide();
+		ui.cbSamplingMode->hide();
+		ui.lSamplingFactor->hide();
+		ui.sbSamplingFactor->hide();
 		ui.lFilter->hide();
 		ui.cbFilter->hide();
 		break;
@@ -654,6 +705,146 @@ void ImportFileWidget::hdfTreeWidgetSelectionChanged() {
 		DEBUG("non data set selected in HDF tree widget");
 }
 
+/*!
+	scans the content of the HDF group \c item when it is expanded for the first time
+*/
+void ImportFileWidget::hdfTreeWidgetItemExpanded(QTreeWidgetItem* item) {
+	if (item->data(0, Qt::UserRole).toBool())
+		scanContent(hdfOptionsWidget.twContent, item);
+}
+
+/*!
+	scans the attributes of the NetCDF variable \c item when it is expanded for the first time
+*/
+void ImportFileWidget::netcdfTreeWidgetItemExpanded(QTreeWidgetItem* item) {
+	if (item->data(0, Qt::UserRole).toBool())
+		scanContent(netcdfOptionsWidget.twContent, item);
+}
+
+/*!
+  scans the content of the HDF/NetCDF file \c fileName. For an empty \c name the content of the whole file is scanned,
+  otherwise the members of the HDF group or the attributes of the NetCDF variable \c name.
+  Called in the worker thread, only the description of the content is created here.
+*/
+static FileContent scanFileContent(FileDataSource::FileType fileType, const QString& fileName, const QString& name) {
+	FileContent content;
+	if (fileType == FileDataSource::HDF) {
+		HDFFilter filter;
+		if (!name.isEmpty())
+			filter.parseGroup(fileName, name, content);
+		else
+			filter.parse(fileName, content);
+	} else {
+		NetCDFFilter filter;
+		if (!name.isEmpty())
+			filter.parseVar(fileName, name, content);
+		else
+			filter.parse(fileName, content);
+	}
+
+	return content;
+}
+
+/*!
+	scans the content of the current HDF/NetCDF file in a worker thread. For \c item = 0 the content
+	of the whole file is added to \c tree, otherwise the content of the expanded group or variable \c item.
+	The tree is disabled until the content is added in scanFinished().
+*/
+void ImportFileWidget::scanContent(QTreeWidget* tree, QTreeWidgetItem* item) {
+	const FileDataSource::FileType fileType = (tree == hdfOptionsWidget.twContent) ? FileDataSource::HDF : FileDataSource::NETCDF;
+	QString name;
+	if (item) {
+		//groups are identified by their path, variables by their name
+		name = item->text(fileType == FileDataSource::HDF ? 1 : 0);
+		item->setData(0, Qt::UserRole, false);
+		item->setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicatorWhenChildless);
+	}
+
+	m_scannedTree = tree;
+	m_scannedItem = item;
+	tree->setEnabled(false);
+
+	m_scanWatcher.setFuture(QtConcurrent::run(scanFileContent, fileType, m_scannedFileName, name));
+
+	//no import while the library is used in the worker thread
+	if (item)
+		emit fileNameChanged();
+}
+
+/*!
+	creates the tree widget items of the scanned \c content and returns the top level items.
+*/
+static QList<QTreeWidgetItem*> contentItems(const FileContent& content) {
+	QList<QTreeWidgetItem*> topLevelItems;
+	QVector<QTreeWidgetItem*> items(content.size());
+	for (int i = 0; i < content.size(); ++i) {
+		const FileContentItem& contentItem = content.at(i);
+		QTreeWidgetItem* item = new QTreeWidgetItem(contentItem.texts);
+		if (!contentItem.icon.isEmpty())
+			item->setIcon(0, KIcon(contentItem.icon));
+		item->setFlags(contentItem.flags);
+		if (contentItem.highlighted) {
+			for (int c = 0; c < item->columnCount(); ++c) {
+				item->setBackground(c, QColor(192, 255, 192));
+				item->setForeground(c, Qt::black);
+			}
+		}
+		if (contentItem.expandable) {
+			item->setData(0, Qt::UserRole, true);
+			item->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+		}
+
+		items[i] = item;
+		if (contentItem.parent == -1)
+			topLevelItems << item;
+		else
+			items.at(contentItem.parent)->addChild(item);
+	}
+
+	return topLevelItems;
+}
+
+/*!
+	adds the content scanned in the worker thread to the tree, the items and their icons are created here in the GUI thread.
+	If the file was changed in the meantime, the content is discarded and the new file is handled.
+*/
+void ImportFileWidget::scanFinished() {
+	QTreeWidget* tree = m_scannedTree;
+	m_scannedTree = 0;
+	tree->setEnabled(true);
+
+	if (m_rescan) {
+		m_rescan = false;
+		fileNameChanged(ui.kleFileName->text());
+		return;
+	}
+
+	const QList<QTreeWidgetItem*> items = contentItems(m_scanWatcher.result());
+	if (m_scannedItem) {
+		m_scannedItem->addChildren(items);
+		tree->resizeColumnToContents(0);
+	} else {
+		tree->addTopLevelItems(items);
+		//sub groups and the attributes of variables are scanned when they are expanded
+		tree->expandToDepth(0);
+		tree->resizeColumnToContents(0);
+		if (tree == hdfOptionsWidget.twContent)
+			tree->resizeColumnToContents(3);
+		else
+			tree->resizeColumnToContents(2);
+	}
+
+	//the import is possible again
+	emit fileNameChanged();
+}
+
+/*!
+	returns \c true if the content of a HDF/NetCDF file is still being scanned.
+*/
+bool ImportFileWidget::isScanning() const {
+	return (m_scannedTree != 0);
+}
+
 /*!
 	return list of selected HDF item names
 */
@@ -851,8 +1042,75 @@ void ImportFileWidget::headerChanged(int state) {
 	}
 }
 
+void ImportFileWidget::samplingModeChanged(int mode) {
+	const bool sampling = (mode != AbstractFileFilter::NoSampling);
+	ui.lSamplingFactor->setEnabled(sampling);
+	ui.sbSamplingFactor->setEnabled(sampling);
+}
+
+/*!
+  appends a row for the field \c field to the table of the record fields of binary files.
+*/
+void ImportFileWidget::insertRecordField(const BinaryFilter::RecordField& field) {
+	QTableWidget* table = binaryOptionsWidget.twRecordFields;
+	const int row = table->rowCount();
+	table->insertRow(row);
+
+	KComboBox* cb = new KComboBox(table);
+	cb->addItems(BinaryFilter::dataTypes());
+	cb->setCurrentIndex(field.type);
+	table->setCellWidget(row, 0, cb);
+
+	QSpinBox* sb = new QSpinBox(table);
+	sb->setMaximum(std::numeric_limits<int>::max());
+	sb->setValue(field.offset);
+	table->setCellWidget(row, 1, sb);
+
+	table->setItem(row, 2, new QTableWidgetItem(field.name));
+}
+
+/*!
+  returns the record fields of binary files defined in the table.
+  Fields without a name get the default name of their column during the import.
+*/
+QList<BinaryFilter::RecordField> ImportFileWidget::recordFields() const {
+	QList<BinaryFilter::RecordField> fields;
+	const QTableWidget* table = binaryOptionsWidget.twRecordFields;
+	for (int row = 0; row < table->rowCount(); ++row) {
+		const KComboBox* cb = static_cast<KComboBox*>(table->cellWidget(row, 0));
+		const QSpinBox* sb = static_cast<QSpinBox*>(table->cellWidget(row, 1));
+		const QTableWidgetItem* item = table->item(row, 2);
+		fields << BinaryFilter::RecordField((BinaryFilter::DataType)cb->currentIndex(), sb->value(),
+						item ? item->text().trimmed() : QString());
+	}
+
+	return fields;
+}
+
+/*!
+  adds a record field of the type \c real64 directly behind the last field.
+*/
+void ImportFileWidget::addRecordField() {
+	const QList<BinaryFilter::RecordField> fields = recordFields();
+	int offset = 0;
+	if (!fields.isEmpty())
+		offset = fields.last().offset + BinaryFilter::dataSize(fields.last().type);
+
+	insertRecordField(BinaryFilter::RecordField(BinaryFilter::REAL64, offset));
+}
+
+void ImportFileWidget::removeRecordField() {
+	const int row = binaryOptionsWidget.twRecordFields->currentRow();
+	if (row != -1)
+		binaryOptionsWidget.twRecordFields->removeRow(row);
+}
+
 void ImportFileWidget::refreshPreview() {
 	DEBUG("refreshPreview()");
+	//the libraries are locked by the scan, the preview would block the GUI until the scan has finished
+	if (isScanning() && (currentFileType() == FileDataSource::HDF || currentFileType() == FileDataSource::NETCDF))
+		return;
+
 	WAIT_CURSOR;
 
 	QString fileName = ui.kleFileName->text();
@@ -37,11 +37,16 @@
 #include "NetCDFOptionsWidget.h"
 #include "FITSOptionsWidget.h"
 #include "backend/datasources/FileDataSource.h"
+#include "backend/datasources/filters/BinaryFilter.h"
+#include "backend/datasources/filters/FileContentItem.h"
 
+#include <QFutureWatcher>
 
 class FileDataSource;
 class AbstractFileFilter;
 class QTableWidget;
+class QTreeWidget;
+class QTreeWidgetItem;
 
 class ImportFileWidget : public QWidget {
 	Q_OBJECT
@@ -60,6 +65,7 @@ public:
 	const QStringList selectedFITSExtensions() const;
 	void hideDataSource() const;
 	void showAsciiHeaderOptions(bool);
+	bool isScanning() const;
 
 private:
 	Ui::ImportFileWidget ui;
@@ -72,17 +78,32 @@ private:
 	QTableWidget* twPreview;
 	const QString& m_fileName;
 
+	void insertRecordField(const BinaryFilter::RecordField&);
+	QList<BinaryFilter::RecordField> recordFields() const;
+	void scanContent(QTreeWidget*, QTreeWidgetItem*);
+	QFutureWatcher<FileContent> m_scanWatcher;
+	QTreeWidget* m_scannedTree;
+	QTreeWidgetItem* m_scannedItem;
+	QString m_scannedFileName;
+	bool m_rescan;
+
 private slots:
 	void fileNameChanged(const QString&);
 	void fileTypeChanged(int);
 	void hdfTreeWidgetSelectionChanged();
+	void hdfTreeWidgetItemExpanded(QTreeWidgetItem*);
 	void netcdfTreeWidgetSelectionChanged();
+	void netcdfTreeWidgetItemExpanded(QTreeWidgetItem*);
+	void scanFinished();
+	void addRecordField();
+	void removeRecordField();
 	void fitsTreeWidgetSelectionChanged();
 
 	void saveFilter();
 	void manageFilters();
 	void filterChanged(int);
 	void headerChanged(int);
+	void samplingModeChanged(int);
 	void selectFile();
 	void fileInfoDialog();
 	void refreshPreview();
@@ -32,14 +32,10 @@
 #include "kdefrontend/widgets/ConstantsWidget.h"
 #include "kdefrontend/widgets/FunctionsWidget.h"
 
-extern "C" {
-#include "backend/gsl/parser.h"
-}
-#include <cmath>
-
 #include <QMenu>
+#include <QProgressDialog>
 #include <QWidgetAction>
-#include <QThreadPool>
+#include <KMessageBox>
 #ifndef NDEBUG
 #include <QDebug>
 #include <QElapsedTimer>
@@ -135,116 +131,33 @@ void MatrixFunctionDialog::insertConstant(const QString& str) {
 	ui.teEquation->insertPlainText(str);
 }
 
-/* task class for parallel fill (not used) */
-class GenerateValueTask : public QRunnable {
-public:
-	GenerateValueTask(int startCol, int endCol, QVector<QVector<double>>& matrixData, double xStart, double yStart,
-		double xStep, double yStep, char* func): m_startCol(startCol), m_endCol(endCol), m_matrixData(matrixData),
-		m_xStart(xStart), m_yStart(yStart), m_xStep(xStep), m_yStep(yStep), m_func(func) {
-	};
-
-	void run() {
-		const int rows = m_matrixData[m_startCol].size();
-		double x = m_xStart;
-		double y = m_yStart;
-#ifndef NDEBUG
-		qDebug()<<"FILL col"<<m_startCol<<"-"<<m_endCol<<" x/y ="<<x<<'/'<<y<<" steps ="<<m_xStep<<'/'<<m_yStep<<" rows ="<<rows;
-#endif
-		parser_var vars[] = { {"x", x}, {"y", y}};
-		for (int col = m_startCol; col < m_endCol; ++col) {
-			vars[0].value = x;
-			for (int row = 0; row < rows; row++) {
-				vars[1].value = y;
-				double z = parse_with_vars(m_func, vars, 2);
-				//qDebug()<<" z ="<<z;
-				m_matrixData[col][row] = z;
-				y += m_yStep;
-			}
-
-			y = m_yStart;
-			x += m_xStep;
-		}
+void MatrixFunctionDialog::generate() {
+	//large matrices are filled with a progress dialog allowing to cancel the fill
+	QProgressDialog* progressDialog = 0;
+	if (m_matrix->rowCount()*m_matrix->columnCount() >= 1000000) {
+		progressDialog = new QProgressDialog(i18n("Generating function values..."), i18n("Cancel"), 0, 100, parentWidget());
+		progressDialog->setWindowModality(Qt::ApplicationModal);
+		progressDialog->setMinimumDuration(0);
+		connect(m_matrix, SIGNAL(fillProgress(int)), progressDialog, SLOT(setValue(int)));
+		connect(progressDialog, SIGNAL(canceled()), m_matrix, SLOT(cancelFill()));
 	}
 
-private:
-	int m_startCol;
-	int m_endCol;
-	QVector<QVector<double>>& m_matrixData;
-	double m_xStart;
-	double m_yStart;
-	double m_xStep;
-	double m_yStep;
-	char* m_func;
-};
-
-void MatrixFunctionDialog::generate() {
 	WAIT_CURSOR;
-
-	m_matrix->beginMacro(i18n("%1: fill matrix with function values", m_matrix->name()));
-
-	QVector<QVector<double> > new_data = m_matrix->data();
-
-	QByteArray funcba = ui.teEquation->toPlainText().toLocal8Bit();
-	char* func = funcba.data();
-
-	// check if rows or cols == 1
-	double diff = m_matrix->xEnd() - m_matrix->xStart();
-	double xStep = 0.0;
-	if (m_matrix->columnCount() > 1)
-		xStep = diff/double(m_matrix->columnCount() - 1);
-
-	diff = m_matrix->yEnd() - m_matrix->yStart();
-	double yStep = 0.0;
-	if (m_matrix->rowCount() > 1)
-		yStep = diff/double(m_matrix->rowCount() - 1);
-
 #ifndef NDEBUG
 	QElapsedTimer timer;
 	timer.start();
 #endif
 
-	//TODO: too slow because every parser thread needs an own symbol_table
-	// idea: use pool->maxThreadCount() symbol tables and reuse them?
-/*	double yStart = m_matrix->yStart();
-	const int cols = m_matrix->columnCount();
-	QThreadPool* pool = QThreadPool::globalInstance();
-	int range = ceil(double(cols)/pool->maxThreadCount());
-#ifndef NDEBUG
-	qDebug() << "Starting" << pool->maxThreadCount() << "threads. cols =" << cols << ": range =" << range;
-#endif
-	for (int i = 0; i < pool->maxThreadCount(); ++i) {
-		const int start = i*range;
-		int end = (i+1)*range;
-		if (end > cols) end = cols;
-		qDebug() << "start/end: " << start << end;
-		const double xStart = m_matrix->xStart() + xStep*start;
-		GenerateValueTask* task = new GenerateValueTask(start, end, new_data, xStart, yStart, xStep, yStep, func);
-		task->setAutoDelete(false);
-		pool->start(task);
-	}
-	pool->waitForDone();
-*/
-	double x = 0, y = 0;
-	parser_var vars[] = {{"x", x}, {"y", y}};
-	for (int col = 0; col < m_matrix->columnCount(); col++) {
-		vars[0].value = x;
-		for (int row = 0; row < m_matrix->rowCount(); row++) {
-			vars[1].value = y;
-			new_data[col][row] = parse_with_vars(func, vars, 2);
-			y += yStep;
-		}
-		y = m_matrix->yStart();
-		x += xStep;
-	}
+	const bool filled = m_matrix->fillWithFunction(ui.teEquation->toPlainText());
 
-	// Timing
 #ifndef NDEBUG
 	qDebug() << "elapsed time =" << timer.elapsed() << "ms";
 #endif
-
-	m_matrix->setFormula(ui.teEquation->toPlainText());
-	m_matrix->setData(new_data);
-
-	m_matrix->endMacro();
 	RESET_CURSOR;
+
+	//a canceled fill keeps the previous values, no error in this case
+	if (!filled && !(progressDialog && progressDialog->wasCanceled()))
+		KMessageBox::error(this, i18n("The function could not be evaluated. Please check the expression."),
+			i18n("Invalid function"));
+	delete progressDialog;
 }
@@ -27,9 +27,12 @@
  ***************************************************************************/
 #include "DropValuesDialog.h"
 #include "backend/core/column/Column.h"
+#include "backend/lib/Interval.h"
 #include "backend/lib/macros.h"
 #include "backend/spreadsheet/Spreadsheet.h"
+#include "backend/gsl/ExpressionParser.h"
 
+#include <QBitArray>
 #include <QThreadPool>
 
 #include <cmath>
@@ -57,10 +60,50 @@ DropValuesDialog::DropValuesDialog(Spreadsheet* s, bool mask, QWidget* parent, Q
 	ui.cbOperator->addItem(i18n("greater then or equal to"));
 	ui.cbOperator->addItem(i18n("lesser then"));
 	ui.cbOperator->addItem(i18n("lesser then or equal to"));
+	ui.cbOperator->addItem(i18n("satisfying the expression"));
 
 	ui.leValue1->setValidator( new QDoubleValidator(ui.leValue1) );
 	ui.leValue2->setValidator( new QDoubleValidator(ui.leValue2) );
 
+	//the numeric columns of the spreadsheet can be used as variables in the expression.
+	//columns whose names are no identifiers are available by their position, e.g. c3 for the third column
+	const QRegExp identifier("^[a-zA-Z_][a-zA-Z0-9_]*$");
+	QStringList identifierNames;
+	for (int i=0; i<m_spreadsheet->columnCount(); ++i) {
+		const Column* col = m_spreadsheet->column(i);
+		if (col->columnMode() == AbstractColumn::Numeric && identifier.exactMatch(col->name()))
+			identifierNames << col->name();
+	}
+
+	QStringList positionalNames;
+	QStringList excludedNames;
+	for (int i=0; i<m_spreadsheet->columnCount(); ++i) {
+		Column* col = m_spreadsheet->column(i);
+		if (col->columnMode() != AbstractColumn::Numeric)
+			continue;
+
+		QString name = col->name();
+		if (!identifier.exactMatch(name)) {
+			name = QString("c%1").arg(i+1);
+			if (identifierNames.contains(name)) {
+				excludedNames << col->name();
+				continue;
+			}
+			positionalNames << i18n("%1 for \"%2\"", name, col->name());
+		}
+		m_variableNames << name;
+		m_variableColumns << col;
+	}
+	ui.teExpression->setMaximumHeight(QLineEdit().sizeHint().height()*2);
+	ui.teExpression->setVariables(m_variableNames);
+	QString toolTip = i18n("Condition on the columns %1, e.g. \"%2 > 0 && %2 < 1\"",
+	                       m_variableNames.join(", "), m_variableNames.isEmpty() ? QString("x") : m_variableNames.first());
+	if (!positionalNames.isEmpty())
+		toolTip += '\n' + i18n("Columns named by their position: %1", positionalNames.join(", "));
+	if (!excludedNames.isEmpty())
+		toolTip += '\n' + i18n("Not available: %1", excludedNames.join(", "));
+	ui.teExpression->setToolTip(toolTip);
+
 	setButtons( KDialog::Ok | KDialog::Cancel );
 	if (m_mask) {
 		setButtonText(KDialog::Ok, i18n("&Mask"));
@@ -73,6 +116,7 @@ DropValuesDialog::DropValuesDialog(Spreadsheet* s, bool mask, QWidget* parent, Q
 	}
 
 	connect( ui.cbOperator, SIGNAL(currentIndexChanged(int)), this, SLOT(operatorChanged(int)) );
+	connect( ui.teExpression, SIGNAL(expressionChanged()), this, SLOT(checkValues()) );
 	connect(this, SIGNAL(okClicked()), this, SLOT(okClicked()));
 
 	resize( QSize(400,0).expandedTo(minimumSize()) );
@@ -83,12 +127,35 @@ void DropValuesDialog::setColumns(QList<Column*> list) {
 	m_columns = list;
 }
 
-void DropValuesDialog::operatorChanged(int index) const {
+void DropValuesDialog::operatorChanged(int index) {
 	bool value2 = (index==1) || (index==2);
+	bool expression = (index==7);
 	ui.lMin->setVisible(value2);
 	ui.lMax->setVisible(value2);
 	ui.lAnd->setVisible(value2);
+	ui.leValue1->setVisible(!expression);
 	ui.leValue2->setVisible(value2);
+	ui.teExpression->setVisible(expression);
+	checkValues();
+}
+
+void DropValuesDialog::checkValues() {
+	if (ui.cbOperator->currentIndex() == 7)
+		enableButtonOk(!ui.teExpression->toPlainText().simplified().isEmpty() && ui.teExpression->isValid());
+	else
+		enableButtonOk(true);
+}
+
+/*!
+	evaluates the expression for all rows of the spreadsheet, the bit of a row is set if the condition is true.
+	The expression is compiled once and evaluated for all rows at once instead of row by row.
+ */
+bool DropValuesDialog::selectRows(QBitArray* rows) const {
+	QVector<QVector<double>*> xVectors;
+	foreach(Column* col, m_variableColumns)
+		xVectors << static_cast<QVector<double>* >(col->data());
+
+	return ExpressionParser::getInstance()->evaluateCondition(ui.teExpression->toPlainText(), m_variableNames, xVectors, rows);
 }
 
 void DropValuesDialog::okClicked() const {
@@ -98,7 +165,26 @@ void DropValuesDialog::okClicked() const {
 		dropValues();
 }
 
-//TODO: m_column->setMasked() is slow, we need direct access to the masked-container -> redesign
+/*!
+	returns the intervals of consecutive rows set in \c rows, up to the row \c count.
+ */
+static QList< Interval<int> > rowIntervals(const QBitArray& rows, int count) {
+	QList< Interval<int> > intervals;
+	int start = -1;
+	for (int i=0; i<=count; ++i) {
+		if (i<count && rows.testBit(i)) {
+			if (start == -1)
+				start = i;
+		} else if (start != -1) {
+			intervals << Interval<int>(start, i-1);
+			start = -1;
+		}
+	}
+
+	return intervals;
+}
+
+//the rows to mask are collected first and masked with one undo command per column
 class MaskValuesTask : public QRunnable {
 	public:
 		MaskValuesTask(Column* col, int op, double value1, double value2){
@@ -112,12 +198,13 @@ class MaskValuesTask : public QRunnable {
 			m_column->setSuppressDataChangedSignal(true);
 			bool changed = false;
 			QVector<double>* data = static_cast<QVector<double>* >(m_column->data());
+			QBitArray rows(data->size());
 
 			//equal to
 			if (m_operator == 0) {
 				for (int i=0; i<data->size(); ++i) {
 					if (data->at(i) == m_value1) {
-						m_column->setMasked(i, true);
+						rows.setBit(i);
 						changed = true;
 					}
 				}
@@ -127,7 +214,7 @@ class MaskValuesTask : public QRunnable {
 			else if (m_operator == 1) {
 				for (int i=0; i<data->size(); ++i) {
 					if (data->at(i) >= m_value1 && data->at(i) <= m_value2) {
-						m_column->setMasked(i, true);
+						rows.setBit(i);
 						changed = true;
 					}
 				}
@@ -137,7 +224,7 @@ class MaskValuesTask : public QRunnable {
 			else if (m_operator == 2) {
 				for (int i=0; i<data->size(); ++i) {
 					if (data->at(i) > m_value1 && data->at(i) < m_value2) {
-						m_column->setMasked(i, true);
+						rows.setBit(i);
 						changed = true;
 					}
 				}
@@ -147,7 +234,7 @@ class MaskValuesTask : public QRunnable {
 			else if (m_operator == 3) {
 				for (int i=0; i<data->size(); ++i) {
 					if (data->at(i) > m_value1) {
-						m_column->setMasked(i, true);
+						rows.setBit(i);
 						changed = true;
 					}
 				}
@@ -157,7 +244,7 @@ class MaskValuesTask : public QRunnable {
 			else if (m_operator == 4) {
 				for (int i=0; i<data->size(); ++i) {
 					if (data->at(i) >= m_value1) {
-						m_column->setMasked(i, true);
+						rows.setBit(i);
 						changed = true;
 					}
 				}
@@ -167,7 +254,7 @@ class MaskValuesTask : public QRunnable {
 			else if (m_operator == 5) {
 				for (int i=0; i<data->size(); ++i) {
 					if (data->at(i) < m_value1) {
-						m_column->setMasked(i, true);
+						rows.setBit(i);
 						changed = true;
 					}
 				}
@@ -177,12 +264,14 @@ class MaskValuesTask : public QRunnable {
 			else if (m_operator == 6) {
 				for (int i=0; i<data->size(); ++i) {
 					if (data->at(i) <= m_value1) {
-						m_column->setMasked(i, true);
+						rows.setBit(i);
 						changed = true;
 					}
 				}
 			}
 
+			if (changed)
+				m_column->setMasked(rowIntervals(rows, rows.size()), true);
 			m_column->setSuppressDataChangedSignal(false);
 			if (changed)
 				m_column->setChanged();
@@ -300,6 +389,28 @@ void DropValuesDialog::maskValues() const {
 	const double value1 = ui.leValue1->text().toDouble();
 	const double value2 = ui.leValue2->text().toDouble();
 
+	//satisfying the expression: the rows are selected once for all columns,
+	//all selected rows of a column are masked with one undo command
+	if (op == 7) {
+		QBitArray rows;
+		if (selectRows(&rows)) {
+			foreach(Column* col, m_columns) {
+				const QList< Interval<int> > intervals = rowIntervals(rows, qMin(rows.size(), col->rowCount()));
+				if (intervals.isEmpty())
+					continue;
+
+				col->setSuppressDataChangedSignal(true);
+				col->setMasked(intervals, true);
+				col->setSuppressDataChangedSignal(false);
+				col->setChanged();
+			}
+		}
+
+		m_spreadsheet->endMacro();
+		RESET_CURSOR;
+		return;
+	}
+
 	foreach(Column* col, m_columns) {
 		MaskValuesTask* task = new MaskValuesTask(col, op, value1, value2);
 		task->run();
@@ -324,6 +435,30 @@ void DropValuesDialog::dropValues() const {
 	const double value1 = ui.leValue1->text().toDouble();
 	const double value2 = ui.leValue2->text().toDouble();
 
+	//satisfying the expression: the rows are selected once for all columns
+	if (op == 7) {
+		QBitArray rows;
+		if (selectRows(&rows)) {
+			foreach(Column* col, m_columns) {
+				QVector<double> new_data(*static_cast<QVector<double>* >(col->data()));
+				bool changed = false;
+				const int count = qMin(rows.size(), new_data.size());
+				for (int i=0; i<count; ++i) {
+					if (rows.testBit(i)) {
+						new_data[i] = NAN;
+						changed = true;
+					}
+				}
+				if (changed)
+					col->replaceValues(0, new_data);
+			}
+		}
+
+		m_spreadsheet->endMacro();
+		RESET_CURSOR;
+		return;
+	}
+
 	foreach(Column* col, m_columns) {
 		DropValuesTask* task = new DropValuesTask(col, op, value1, value2);
 		QThreadPool::globalInstance()->start(task);
@@ -33,6 +33,7 @@
 
 
 class Column;
+class QBitArray;
 class Spreadsheet;
 
 class DropValuesDialog : public KDialog {
@@ -47,12 +48,16 @@ class DropValuesDialog : public KDialog {
 		QList<Column*> m_columns;
 		Spreadsheet* m_spreadsheet;
 		bool m_mask;
+		QStringList m_variableNames;
+		QVector<Column*> m_variableColumns;
 
 		void dropValues() const;
 		void maskValues() const;
+		bool selectRows(QBitArray*) const;
 
 	private slots:
-		void operatorChanged(int) const;
+		void operatorChanged(int);
+		void checkValues();
 		void okClicked() const;
 };
 
@@ -48,10 +48,17 @@ ExportSpreadsheetDialog::ExportSpreadsheetDialog(QWidget* parent) : KDialog(pare
 
 	ui.kleFileName->setCompletionObject(urlCompletion);
 
-	ui.cbFormat->addItem("ASCII");
-	ui.cbFormat->addItem("Binary");
-	ui.cbFormat->addItem("LaTeX");
-	ui.cbFormat->addItem("FITS");
+	//the format is stored in the item data, HDF5 and NetCDF are only available if their libraries were found
+	ui.cbFormat->addItem("ASCII", ASCII);
+	ui.cbFormat->addItem("Binary", Binary);
+	ui.cbFormat->addItem("LaTeX", LaTeX);
+	ui.cbFormat->addItem("FITS", FITS);
+#ifdef HAVE_HDF5
+	ui.cbFormat->addItem("HDF5", HDF);
+#endif
+#ifdef HAVE_NETCDF
+	ui.cbFormat->addItem("NetCDF", NETCDF);
+#endif
 
 	ui.cbSeparator->addItem("TAB");
 	ui.cbSeparator->addItem("SPACE");
@@ -98,6 +105,7 @@ ExportSpreadsheetDialog::ExportSpreadsheetDialog(QWidget* parent) : KDialog(pare
 	ui.chkMatrixVHeader->setChecked(conf.readEntry("MatrixVerticalHeader", true));
 	ui.chkMatrixVHeader->setChecked(conf.readEntry("FITSSpreadsheetColumnsUnits", true));
 	ui.cbExportToFITS->setCurrentIndex(conf.readEntry("FITSTo", 0));
+	ui.sbCompression->setValue(conf.readEntry("HDFCompression", 0));
 	m_showOptions = conf.readEntry("ShowOptions", false);
 	ui.gbOptions->setVisible(m_showOptions);
 	m_showOptions ? setButtonText(KDialog::User1,i18n("Hide Options")) : setButtonText(KDialog::User1,i18n("Show Options"));
@@ -120,6 +128,7 @@ ExportSpreadsheetDialog::~ExportSpreadsheetDialog() {
 	conf.writeEntry("MatrixHorizontalHeader", ui.chkMatrixHHeader->isChecked());
 	conf.writeEntry("FITSTo", ui.cbExportToFITS->currentIndex());
 	conf.writeEntry("FITSSpreadsheetColumnsUnits", ui.chkColumnsAsUnits->isChecked());
+	conf.writeEntry("HDFCompression", ui.sbCompression->value());
 
 	saveDialogSize(conf);
 	delete urlCompletion;
@@ -152,7 +161,7 @@ void ExportSpreadsheetDialog::setMatrixMode(bool b) {
 		ui.chkExportHeader->hide();
 		ui.lEmptyRows->hide();
 		ui.chkEmptyRows->hide();
-		if (ui.cbFormat->currentIndex() != 3) {
+		if (format() != FITS) {
 			ui.chkMatrixHHeader->show();
 			ui.chkMatrixVHeader->show();
 			ui.lMatrixHHeader->show();
@@ -219,6 +228,11 @@ bool ExportSpreadsheetDialog::commentsAsUnitsFits() const {
 	return ui.chkColumnsAsUnits->isChecked();
 }
 
+//! deflate compression level (0-9) of the data sets written to HDF5 files
+int ExportSpreadsheetDialog::compressionLevel() const {
+	return ui.sbCompression->value();
+}
+
 QString ExportSpreadsheetDialog::separator() const {
 	return ui.cbSeparator->currentText();
 }
@@ -237,6 +251,14 @@ void ExportSpreadsheetDialog::setExportToImage(bool possible) {
 	}
 }
 
+/*!
+	sets the names of the text and date-time columns of the spreadsheet.
+	Binary, HDF5 and NetCDF files contain the numeric columns only, the user is warned before these columns are left out.
+*/
+void ExportSpreadsheetDialog::setNonNumericColumns(const QStringList& names) {
+	m_nonNumericColumns = names;
+}
+
 //SLOTS
 void ExportSpreadsheetDialog::okClicked() {
 	if (format() != FITS)
@@ -245,6 +267,14 @@ void ExportSpreadsheetDialog::okClicked() {
 			if (r==KMessageBox::No)
 				return;
 		}
+
+	if (!m_nonNumericColumns.isEmpty() && (format() == Binary || format() == HDF || format() == NETCDF)) {
+		const int r = KMessageBox::warningContinueCancelList(this,
+			i18n("Only numeric columns can be exported to this format, the following columns are not exported:"),
+			m_nonNumericColumns, i18n("Export"));
+		if (r == KMessageBox::Cancel)
+			return;
+	}
 	KConfigGroup conf(KSharedConfig::openConfig(), "ExportSpreadsheetDialog");
 	conf.writeEntry("Format", ui.cbFormat->currentIndex());
 	conf.writeEntry("Header", ui.chkExportHeader->isChecked());
@@ -301,17 +331,18 @@ void ExportSpreadsheetDialog::selectFile() {
 	called when the output format was changed. Adjusts the extension for the specified file.
  */
 void ExportSpreadsheetDialog::formatChanged(int index) {
+	const Format format = static_cast<Format>(ui.cbFormat->itemData(index).toInt());
 	QStringList extensions;
-	extensions << ".txt" << ".bin" << ".tex" << ".fits";
+	extensions << ".txt" << ".bin" << ".tex" << ".fits" << ".h5" << ".nc";
 	QString path = ui.kleFileName->text();
 	int i = path.indexOf(".");
-	if (index != 1) {
+	if (format != Binary) {
 		if (i==-1)
-			path = path + extensions.at(index);
+			path = path + extensions.at(format);
 		else
-			path=path.left(i) + extensions.at(index);
+			path=path.left(i) + extensions.at(format);
 	}
-	if (ui.cbFormat->currentIndex() == 2) {
+	if (format == LaTeX) {
 		ui.cbSeparator->hide();
 		ui.lSeparator->hide();
 
@@ -342,7 +373,7 @@ void ExportSpreadsheetDialog::formatChanged(int index) {
 		ui.lColumnAsUnits->hide();
 		ui.chkColumnsAsUnits->hide();
 		//FITS
-	} else if(ui.cbFormat->currentIndex() == 3) {
+	} else if (format == FITS) {
 		ui.lCaptions->hide();
 		ui.lEmptyRows->hide();
 		ui.lExportArea->hide();
@@ -369,8 +400,10 @@ void ExportSpreadsheetDialog::formatChanged(int index) {
 			ui.chkColumnsAsUnits->show();
 		}
 	} else {
-		ui.cbSeparator->show();
-		ui.lSeparator->show();
+		//the separator is used for ASCII only, binary, HDF5 and NetCDF files contain the numeric columns only
+		const bool ascii = (format == ASCII);
+		ui.cbSeparator->setVisible(ascii);
+		ui.lSeparator->setVisible(ascii);
 
 		ui.chkCaptions->hide();
 		ui.chkEmptyRows->hide();
@@ -401,12 +434,16 @@ void ExportSpreadsheetDialog::formatChanged(int index) {
 		ui.chkExportHeader->hide();
 		ui.lExportHeader->hide();
 	}
-	if (ui.cbFormat->currentIndex() == 3) {
+	if (format == FITS) {
 		ui.chkExportHeader->hide();
 		ui.lExportHeader->hide();
 	}
 
-	setFormat(static_cast<Format>(index));
+	//the compression level is used for HDF5 only
+	ui.lCompression->setVisible(format == HDF);
+	ui.sbCompression->setVisible(format == HDF);
+
+	setFormat(format);
 	ui.kleFileName->setText(path);
 }
 
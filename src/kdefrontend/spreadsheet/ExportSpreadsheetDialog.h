@@ -57,14 +57,18 @@ public:
 	QString separator() const;
 	int exportToFits() const;
 	bool commentsAsUnitsFits() const;
+	int compressionLevel() const;
 	void setExportTo(const QStringList& to);
 	void setExportToImage(bool possible);
+	void setNonNumericColumns(const QStringList&);
 
 	enum Format {
 		ASCII = 0,
 		Binary,
 		LaTeX,
 		FITS,
+		HDF,
+		NETCDF
 	};
 
 	Format format() const;
@@ -74,6 +78,7 @@ private:
 	bool m_showOptions;
 	bool m_matrixMode;
 	Format m_format;
+	QStringList m_nonNumericColumns;
 	KUrlCompletion *urlCompletion;
 
 private slots: